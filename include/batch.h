@@ -0,0 +1,904 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+
+#include <array>
+#include <vector>
+#include <random>
+#include <cmath>
+#include <algorithm>
+#include <iostream>
+#include <cstdlib>
+
+#include "neighbor.h"
+#include "site_order.h"
+#include "checkpoint.h"
+#include "time_series.h"
+#include "sincos.h"
+#include "exp_poly.h"
+#include "observables.h"
+#include "instrument.h"
+#include "progress.h"
+
+
+/* class : Batch
+ * Base class for engines which simulate n_lane disorder realizations of one lattice at once. All
+ * per site values are stored with the realizations (lanes) innermost:
+ *      spin[site * n_lane + lane]
+ *      J[(site * n_neigh + dir) * n_lane + lane]
+ * so one site is updated in every lane by the same vector instructions. The lanes share the
+ * sequence of visited sites but have their own bonds, spins, proposals and accept / reject
+ * decisions, so each lane is an independent Markov chain.
+ *
+ * Like Model2 and Model3, the base class runs the warmup and measurement sweeps and keeps their
+ * progress so a run can be checkpointed and resumed at any sweep.
+ *
+ * As with Neighbor and Exchange, the implamentation is in the header.
+ */
+template <std::size_t Dim>
+class Batch
+{
+    public:
+#if defined(__AVX512F__)
+        static const std::size_t n_lane = 8;
+#else
+        static const std::size_t n_lane = 4;
+#endif
+
+    protected:
+        static const std::size_t n_neigh = Dim * 2;
+        std::size_t warmup, measure, n_overrelax;
+        std::size_t size;
+        std::uniform_real_distribution<float> rand0;
+        std::vector<Neighbor<Dim>> neigh;
+        std::vector<double> J;
+        std::vector<std::size_t> site;
+        Visit visit = Visit::random;
+        std::vector<std::size_t> block;         // Blocks of a sweep in visiting order
+        std::vector<float> r_prop, r_acc;
+
+        Sweep_state state;
+        std::size_t checkpoint_every = 0;
+        Checkpoint_hook checkpoint;
+        Time_series *ts = nullptr;
+        int ts_chan = 0;
+        std::uint32_t ts_id = 0;
+        Counters counters;
+        std::size_t progress_mark = 0;      // Sweep of the last progress report
+
+        // Bonds counted by a site when measuring the energy (same as the models)
+        const std::array<int, 3> own_bond = {{1, 2, 4}};
+
+        typedef std::array<double, n_lane> Lane_array;
+
+        virtual void sweep_lattice(double beta, std::mt19937 &engine) = 0;
+        virtual void energy(Lane_array &E) const = 0;
+        virtual void magnetization2(Lane_array &M) const = 0;
+
+        /* tune_lattice()
+         * Called before the first and after every warmup sweep. See Model2::tune_lattice().
+         */
+        virtual void tune_lattice(std::size_t)
+        {
+        }
+
+        /* warmup_lattice()
+         * Performs the remaining warmup sweeps.
+         */
+        void warmup_lattice(double beta, std::mt19937 &engine)
+        {
+            INSTRUMENT_PHASE(timer, counters.t_warmup, counters);
+
+            if (state.n_sweep == 0)
+                tune_lattice(0);
+
+            while (state.n_sweep < warmup) {
+                sweep_lattice(beta, engine);
+                INSTRUMENT_ADD(counters, proposed, size * n_lane);
+                state.n_sweep++;
+                tune_lattice(state.n_sweep);
+                end_sweep(engine);
+            } // Warmup sweeps
+        }
+
+        /* push_series()
+         * Adds the observables of the current measurement sweep of every lane to its series.
+         */
+        void push_series(const Lane_array &E, const Lane_array &M2)
+        {
+            INSTRUMENT_TIMER(timer, counters.t_io);
+            for (std::size_t l = 0; l < n_lane; l++)
+                ts->push(ts_chan, ts_id + l, state.n_sweep - warmup, E[l], M2[l]);
+        }
+
+        /* end_sweep()
+         * Reports the progress and calls the checkpoint hook every checkpoint_every sweeps.
+         */
+        void end_sweep(const std::mt19937 &engine)
+        {
+            report_sweeps(state.n_sweep, warmup + measure, size * n_lane, progress_mark);
+            if (checkpoint && state.n_sweep % checkpoint_every == 0) {
+                INSTRUMENT_TIMER(timer, counters.t_io);
+                checkpoint(engine);
+            }
+        }
+
+        /* draw_sweep()
+         * Draws the sites and the random numbers for the proposals and acceptance of one sweep.
+         * Only random visits draw the sites (see site_order.h), all of them ahead of the sweep.
+         */
+        void draw_sweep(std::mt19937 &engine)
+        {
+            const std::size_t n_row = size / block.size();
+
+            if (visit == Visit::blocks)
+                std::shuffle(block.begin(), block.end(), engine);
+
+            for (std::size_t i = 0; i < size; i++) {
+                if (visit == Visit::random || visit == Visit::prefetch)
+                    site[i] = static_cast<std::size_t>(rand0(engine) * size);
+                else if (visit == Visit::blocks)
+                    site[i] = block[i / n_row] * n_row + i % n_row;
+                else
+                    site[i] = i;
+
+                for (std::size_t l = 0; l < n_lane; l++) {
+                    r_prop[i * n_lane + l] = rand0(engine);
+                    r_acc[i * n_lane + l]  = rand0(engine);
+                }
+            } // Loop over proposals
+        }
+
+        /* set_bond()
+         * Sets the bond between pos in direction dir and its neighbor for one lane.
+         */
+        void set_bond(std::size_t pos, int dir, int opp, std::size_t lane, double J_val)
+        {
+            J[(pos * n_neigh + dir) * n_lane + lane]                        = J_val;
+            J[(neigh[pos].neighbor[dir] * n_neigh + opp) * n_lane + lane] = J_val;
+        }
+
+    public:
+        Batch() = default;
+
+        Batch(const std::vector<Neighbor<Dim>> &Neigh, std::size_t Warmup, std::size_t Measure,
+                std::size_t N_over, Visit Visit_mode) :
+            warmup(Warmup), measure(Measure), n_overrelax(N_over), size(Neigh.size()),
+            rand0(0.0, 1.0), neigh(Neigh), visit(Visit_mode)
+        {
+            J.resize(size * n_neigh * n_lane);
+            site.resize(size);
+            block.resize(size / static_cast<std::size_t>(get_length()));
+            for (std::size_t b = 0; b < block.size(); b++)
+                block[b] = b;
+            r_prop.resize(size * n_lane);
+            r_acc.resize(size * n_lane);
+        }
+
+        virtual ~Batch() = default;
+
+        virtual void set_spin(std::mt19937 &engine) = 0;
+
+        /* set_spin()
+         * Sets the spins using an engine seeded by std::random_device.
+         */
+        void set_spin()
+        {
+            std::random_device rd;
+            std::mt19937 engine(rd());
+
+            set_spin(engine);
+        }
+
+        /* sweep_energy()
+         * Returns the energy per site of every lane.
+         */
+        Lane_array sweep_energy(double beta, std::mt19937 &engine)
+        {
+            Lane_array E_tot;
+
+            state.acc.resize(n_lane);
+            warmup_lattice(beta, engine);
+            INSTRUMENT_PHASE(timer, counters.t_measure, counters);
+
+            while (state.n_sweep < warmup + measure) {
+                sweep_lattice(beta, engine);
+                INSTRUMENT_ADD(counters, proposed, size * n_lane);
+
+                {
+                    INSTRUMENT_TIMER(observe, counters.t_observe);
+                    energy(E_tot);
+                }
+                for (std::size_t l = 0; l < n_lane; l++)
+                    state.acc[l] += E_tot[l];
+                if (ts) {
+                    Lane_array M;
+                    magnetization2(M);
+                    push_series(E_tot, M);
+                }
+                state.n_sweep++;
+                end_sweep(engine);
+            } // Measurement sweeps
+
+            for (std::size_t l = 0; l < n_lane; l++)
+                E_tot[l] = state.acc[l] / static_cast<double>(measure * size);
+            state = Sweep_state();
+
+            return E_tot;
+        }
+
+        /* sweep_binder()
+         * Returns the binder ratio of every lane.
+         */
+        Lane_array sweep_binder(double beta, std::mt19937 &engine)
+        {
+            Lane_array M, binder;
+
+            state.acc.resize(2 * n_lane);
+            warmup_lattice(beta, engine);
+            INSTRUMENT_PHASE(timer, counters.t_measure, counters);
+
+            while (state.n_sweep < warmup + measure) {
+                sweep_lattice(beta, engine);
+                INSTRUMENT_ADD(counters, proposed, size * n_lane);
+
+                {
+                    INSTRUMENT_TIMER(observe, counters.t_observe);
+                    magnetization2(M);
+                }
+                for (std::size_t l = 0; l < n_lane; l++) {
+                    state.acc[l]          += M[l];
+                    state.acc[n_lane + l] += M[l] * M[l];
+                }
+                if (ts) {
+                    Lane_array E;
+                    energy(E);
+                    push_series(E, M);
+                }
+                state.n_sweep++;
+                end_sweep(engine);
+            } // Measurement sweeps
+
+            for (std::size_t l = 0; l < n_lane; l++) {
+                double m2 = state.acc[l] / static_cast<double>(measure);
+                double m4 = state.acc[n_lane + l] / static_cast<double>(measure);
+                binder[l] = 1.0 - (m4 / (3.0 * m2 * m2));
+            }
+            state = Sweep_state();
+
+            return binder;
+        }
+
+        /* sweep_observables()
+         * Returns every observable of every lane from one run. See observables.h.
+         */
+        std::array<Observables, n_lane> sweep_observables(double beta, std::mt19937 &engine)
+        {
+            const std::size_t n_value = Observables::n_value;
+            std::array<Observables, n_lane> obs;
+            Lane_array E, M2;
+
+            state.acc.resize(n_value * n_lane);
+            warmup_lattice(beta, engine);
+            INSTRUMENT_PHASE(timer, counters.t_measure, counters);
+
+            while (state.n_sweep < warmup + measure) {
+                sweep_lattice(beta, engine);
+                INSTRUMENT_ADD(counters, proposed, size * n_lane);
+
+                {
+                    INSTRUMENT_TIMER(observe, counters.t_observe);
+                    energy(E);
+                    magnetization2(M2);
+                }
+                for (std::size_t l = 0; l < n_lane; l++) {
+                    double *sum = &state.acc[n_value * l];
+                    sum[0] += E[l];
+                    sum[1] += E[l] * E[l];
+                    sum[2] += std::sqrt(M2[l]);
+                    sum[3] += M2[l];
+                    sum[4] += M2[l] * M2[l];
+                }
+                if (ts)
+                    push_series(E, M2);
+                state.n_sweep++;
+                end_sweep(engine);
+            } // Measurement sweeps
+
+            for (std::size_t l = 0; l < n_lane; l++)
+                obs[l] = make_observables(beta, size, measure, &state.acc[n_value * l]);
+            state = Sweep_state();
+
+            return obs;
+        }
+
+        /* get_length()
+         * Returns the linear size L of the lattice.
+         */
+        int get_length() const
+        {
+            return static_cast<int>(std::lround(std::pow(static_cast<double>(size),
+                            1.0 / static_cast<double>(Dim))));
+        }
+
+        /* get_lattice()
+         * Returns the neighbor table, whose pages tell where the batch lives (see placement.h).
+         */
+        const void* get_lattice() const
+        {
+            return neigh.data();
+        }
+
+        /* get_counters()
+         * Returns the counters and phase timers of all lanes. See instrument.h.
+         */
+        const Counters& get_counters() const
+        {
+            return counters;
+        }
+
+        /* reset_counters()
+         * Zeroes the counters and phase timers.
+         */
+        void reset_counters()
+        {
+            counters = Counters();
+        }
+
+        /* set_exchange()
+         * Sets independent exchange tables using an engine seeded by std::random_device.
+         */
+        void set_exchange(double delta)
+        {
+            std::random_device rd;
+            std::mt19937 engine(rd());
+
+            set_exchange(delta, engine);
+        }
+
+        /* set_exchange()
+         * Sets an independent exchange table in every lane. Follows the convention of
+         * Model2::set_exchange() and Model3::set_exchange().
+         */
+        void set_exchange(double delta, std::mt19937 &engine)
+        {
+            const std::array<int, 3> dir = {0, 1, 4};
+            const std::array<int, 3> opp = {2, 3, 5};
+
+            for (std::size_t l = 0; l < n_lane; l++) {
+                for (std::size_t i = 0; i < size; i++) {
+                    for (std::size_t b = 0; b < Dim; b++) {
+                        double J_val, r_val = rand0(engine);
+                        if (rand0(engine) > 0.5) J_val = 1.0 - (delta * r_val / 2.0);
+                        else                     J_val = 1.0 + (delta * r_val / 2.0);
+                        set_bond(i, dir[b], opp[b], l, J_val);
+                    } // Loop over bonds owned by the site
+                } // Loop over sites
+            } // Loop over lanes
+        }
+
+        /* set_checkpoint()
+         * Sets a hook which is called every `every` sweeps. See Model2::set_checkpoint().
+         */
+        void set_checkpoint(std::size_t every, const Checkpoint_hook &hook)
+        {
+            checkpoint_every = every;
+            checkpoint       = hook;
+        }
+
+        /* set_time_series()
+         * Streams the observables of the next temperature to one new series per lane. See
+         * Model2::set_time_series().
+         */
+        void set_time_series(Time_series *series, int chan, double beta, int run, int idx)
+        {
+            ts = series;
+            if (ts) {
+                ts_chan = chan;
+                ts_id   = ts->begin_series(chan, beta, run, idx, static_cast<int>(n_lane));
+            }
+        }
+
+        /* save()
+         * Writes the run parameters and sweep progress in binary. Like those of the models, the
+         * exchange tables are drawn again from the seed of the realization and are not stored.
+         */
+        virtual void save(std::ostream &os) const
+        {
+            write_binary(os, warmup);
+            write_binary(os, measure);
+            write_binary(os, n_overrelax);
+            write_binary(os, size);
+            write_binary(os, state);
+        }
+
+        /* load()
+         * Reads back the data written by save().
+         */
+        virtual void load(std::istream &is)
+        {
+            std::size_t Size = 0;
+
+            read_binary(is, warmup);
+            read_binary(is, measure);
+            read_binary(is, n_overrelax);
+            read_binary(is, Size);
+            read_binary(is, state);
+
+            if (!is || Size != size) {
+                std::cerr << "Error: Saved batch does not match the lattice." << std::endl;
+                exit(EXIT_FAILURE);
+            }
+        }
+};
+
+
+/* class : Clock_batch
+ * Clock model on n_lane disorder realizations. The new angle is drawn uniformly from the q - 1
+ * other angles without a rejection loop so the proposal is branch free.
+ */
+template <std::size_t Dim>
+class Clock_batch : public Batch<Dim>
+{
+    private:
+        typedef Batch<Dim> Base;
+        typedef typename Base::Lane_array Lane_array;
+        using Base::n_neigh;
+        using Base::size;
+        using Base::neigh;
+        using Base::J;
+        using Base::site;
+        using Base::r_prop;
+        using Base::r_acc;
+
+        int q;
+        std::vector<int> spin;
+        std::vector<double> cos_val, sin_val;
+
+        /* sweep_lattice_disorder()
+         * Performs one Metropolis sweep in every lane.
+         */
+        void sweep_lattice_disorder(double beta, std::mt19937 &engine)
+        {
+            std::uint64_t n_acc = 0;
+            this->draw_sweep(engine);
+
+            for (std::size_t i = 0; i < size; i++) {
+                const std::size_t pos = site[i];
+                const int *nb         = neigh[pos].neighbor.data();
+                const double *J_pos   = &J[pos * n_neigh * n_lane];
+                int *sp               = &spin[pos * n_lane];
+
+#ifdef INSTRUMENT
+                #pragma omp simd reduction(+:n_acc)
+#else
+                #pragma omp simd
+#endif
+                for (std::size_t l = 0; l < n_lane; l++) {
+                    int old_angle = sp[l];
+                    int new_angle = old_angle + 1 +
+                        static_cast<int>(r_prop[i * n_lane + l] * static_cast<float>(q - 1));
+                    new_angle -= (new_angle >= q) ? q : 0;
+
+                    // Compute local field
+                    double hx = 0.0, hy = 0.0;
+                    for (std::size_t d = 0; d < n_neigh; d++) {
+                        int neigh_angle = spin[nb[d] * n_lane + l];
+                        hx += J_pos[d * n_lane + l] * cos_val[neigh_angle];
+                        hy += J_pos[d * n_lane + l] * sin_val[neigh_angle];
+                    }
+
+                    double delta_E = (cos_val[old_angle] - cos_val[new_angle]) * hx +
+                                     (sin_val[old_angle] - sin_val[new_angle]) * hy;
+                    double arg     = -beta * delta_E;
+                    arg            = (arg > 0.0) ? 0.0 : arg;
+
+                    // Accept / reject new spin
+                    sp[l] = (r_acc[i * n_lane + l] < exp_poly(arg)) ? new_angle : old_angle;
+#ifdef INSTRUMENT
+                    n_acc += (sp[l] == new_angle) ? 1 : 0;
+#endif
+                } // Loop over lanes
+            } // Loop over sites
+
+            INSTRUMENT_ADD(this->counters, accepted, n_acc);
+        }
+
+        /* sweep_overrelax_disorder()
+         * Over-relaxation sweep in every lane, the reflections accepted with the Metropolis
+         * probability. See Clock2::sweep_overrelax_disorder().
+         */
+        void sweep_overrelax_disorder(double beta, std::mt19937 &engine)
+        {
+            const double dq = 2.0 * M_PI / static_cast<double>(q);
+
+            for (auto &&r : r_acc)
+                r = this->rand0(engine);
+
+            for (std::size_t pos = 0; pos < size; pos++) {
+                const int *nb       = neigh[pos].neighbor.data();
+                const double *J_pos = &J[pos * n_neigh * n_lane];
+
+                for (std::size_t l = 0; l < n_lane; l++) {
+                    double hx = 0.0, hy = 0.0;
+                    for (std::size_t d = 0; d < n_neigh; d++) {
+                        int neigh_angle = spin[nb[d] * n_lane + l];
+                        hx += J_pos[d * n_lane + l] * cos_val[neigh_angle];
+                        hy += J_pos[d * n_lane + l] * sin_val[neigh_angle];
+                    }
+
+                    int m         = static_cast<int>(lround(2.0 * atan2(hy, hx) / dq));
+                    int old_angle = spin[pos * n_lane + l];
+                    int new_angle = ((m - old_angle) % q + q) % q;
+
+                    double delta_E = (cos_val[old_angle] - cos_val[new_angle]) * hx +
+                                     (sin_val[old_angle] - sin_val[new_angle]) * hy;
+                    double arg     = -beta * delta_E;
+                    arg            = (arg > 0.0) ? 0.0 : arg;
+
+                    if (r_acc[pos * n_lane + l] < exp_poly(arg))
+                        spin[pos * n_lane + l] = new_angle;
+                } // Loop over lanes
+            } // Loop over sites
+        }
+
+        /* sweep_lattice()
+         * Performs one Metropolis sweep followed by the over-relaxation sweeps.
+         */
+        void sweep_lattice(double beta, std::mt19937 &engine)
+        {
+            sweep_lattice_disorder(beta, engine);
+            for (std::size_t i = 0; i < this->n_overrelax; i++)
+                sweep_overrelax_disorder(beta, engine);
+        }
+
+        /* energy()
+         * Computes the total energy of every lane.
+         */
+        void energy(Lane_array &E_tot) const
+        {
+            E_tot.fill(0.0);
+
+            for (std::size_t j = 0; j < size; j++) {
+                const int *nb = neigh[j].neighbor.data();
+
+                #pragma omp simd
+                for (std::size_t l = 0; l < n_lane; l++) {
+                    int angle = spin[j * n_lane + l];
+                    double hx = 0.0, hy = 0.0;
+
+                    for (std::size_t b = 0; b < Dim; b++) {
+                        int d           = this->own_bond[b];
+                        int neigh_angle = spin[nb[d] * n_lane + l];
+                        hx += J[(j * n_neigh + d) * n_lane + l] * cos_val[neigh_angle];
+                        hy += J[(j * n_neigh + d) * n_lane + l] * sin_val[neigh_angle];
+                    }
+
+                    E_tot[l] += -(cos_val[angle] * hx + sin_val[angle] * hy);
+                } // Loop over lanes
+            } // Compute energy of lattice
+        }
+
+        /* magnetization2()
+         * Computes the square of the total magnetization of every lane.
+         */
+        void magnetization2(Lane_array &M2) const
+        {
+            Lane_array Mx = {0}, My = {0};
+
+            for (std::size_t j = 0; j < size; j++) {
+                #pragma omp simd
+                for (std::size_t l = 0; l < n_lane; l++) {
+                    Mx[l] += cos_val[spin[j * n_lane + l]];
+                    My[l] += sin_val[spin[j * n_lane + l]];
+                }
+            }
+
+            for (std::size_t l = 0; l < n_lane; l++)
+                M2[l] = Mx[l] * Mx[l] + My[l] * My[l];
+        }
+
+    public:
+        using Base::n_lane;
+        using Base::set_spin;
+
+        Clock_batch() = default;
+
+        /* Constructor
+         * Takes the lattice, run parameters and number of spins from a Clock2 or Clock3 model.
+         */
+        template <typename Model>
+        explicit Clock_batch(const Model &model) :
+            Base(model.get_neighbors(), model.get_warmup(), model.get_measure(),
+                    model.get_overrelax(), model.get_visit()), q(model.get_q())
+        {
+            spin.resize(size * n_lane);
+            cos_val.resize(q);
+            sin_val.resize(q);
+
+            double dq = 2.0 * M_PI / static_cast<double>(q);
+            for (int i = 0; i < q; i++) {
+                cos_val[i] = cos(i * dq);
+                sin_val[i] = sin(i * dq);
+            }
+        }
+
+        /* set_spin()
+         * Sets random angles in every lane.
+         */
+        void set_spin(std::mt19937 &engine)
+        {
+            for (auto &&ele : spin)
+                ele = static_cast<int>(this->rand0(engine) * q);
+        }
+
+        /* save()
+         * Writes the batch and its spins in binary.
+         */
+        void save(std::ostream &os) const
+        {
+            Base::save(os);
+            write_binary(os, q);
+            write_binary(os, spin);
+        }
+
+        /* load()
+         * Reads back the data written by save().
+         */
+        void load(std::istream &is)
+        {
+            Base::load(is);
+            read_binary(is, q);
+            read_binary(is, spin);
+        }
+};
+
+
+/* class : XY_batch
+ * Continuous XY model on n_lane disorder realizations. Every lane tunes its own proposal window
+ * during the warmup sweeps as in XY2 and XY3.
+ */
+template <std::size_t Dim>
+class XY_batch : public Batch<Dim>
+{
+    private:
+        typedef Batch<Dim> Base;
+        typedef typename Base::Lane_array Lane_array;
+        using Base::n_neigh;
+        using Base::size;
+        using Base::neigh;
+        using Base::J;
+        using Base::site;
+        using Base::r_prop;
+        using Base::r_acc;
+
+        static const std::size_t tune_every = 100;
+        double target_acc;
+        std::array<double, Base::n_lane> window;
+        std::array<std::size_t, Base::n_lane> n_accept;
+        std::vector<double> sx, sy;
+        std::vector<double> d_angle, d_cos, d_sin;
+
+        /* sweep_lattice_disorder()
+         * Performs one Metropolis sweep in every lane.
+         */
+        void sweep_lattice_disorder(double beta, std::mt19937 &engine)
+        {
+            this->draw_sweep(engine);
+
+            for (std::size_t i = 0; i < size * n_lane; i++)
+                d_angle[i] = window[i % n_lane] * (2.0 * r_prop[i] - 1.0);
+            sincos_array(d_angle.data(), d_sin.data(), d_cos.data(), size * n_lane);
+
+            std::uint64_t n_acc = 0;
+            for (std::size_t i = 0; i < size; i++) {
+                const std::size_t pos = site[i];
+                const int *nb         = neigh[pos].neighbor.data();
+                const double *J_pos   = &J[pos * n_neigh * n_lane];
+                double *x             = &sx[pos * n_lane];
+                double *y             = &sy[pos * n_lane];
+
+#ifdef INSTRUMENT
+                #pragma omp simd reduction(+:n_acc)
+#else
+                #pragma omp simd
+#endif
+                for (std::size_t l = 0; l < n_lane; l++) {
+                    // Compute local field
+                    double hx = 0.0, hy = 0.0;
+                    for (std::size_t d = 0; d < n_neigh; d++) {
+                        hx += J_pos[d * n_lane + l] * sx[nb[d] * n_lane + l];
+                        hy += J_pos[d * n_lane + l] * sy[nb[d] * n_lane + l];
+                    }
+
+                    // Rotate spin
+                    double c     = d_cos[i * n_lane + l];
+                    double s     = d_sin[i * n_lane + l];
+                    double new_x = c * x[l] - s * y[l];
+                    double new_y = s * x[l] + c * y[l];
+
+                    double delta_E = (x[l] - new_x) * hx + (y[l] - new_y) * hy;
+                    double arg     = -beta * delta_E;
+                    arg            = (arg > 0.0) ? 0.0 : arg;
+
+                    // Accept / reject new spin
+                    bool accept  = r_acc[i * n_lane + l] < exp_poly(arg);
+                    x[l]         = accept ? new_x : x[l];
+                    y[l]         = accept ? new_y : y[l];
+                    n_accept[l] += accept ? 1 : 0;
+#ifdef INSTRUMENT
+                    n_acc       += accept ? 1 : 0;
+#endif
+                } // Loop over lanes
+            } // Loop over sites
+
+            INSTRUMENT_ADD(this->counters, accepted, n_acc);
+        }
+
+        /* sweep_overrelax_disorder()
+         * Over-relaxation sweep in every lane. See XY2::sweep_overrelax_clean().
+         */
+        void sweep_overrelax_disorder()
+        {
+            for (std::size_t pos = 0; pos < size; pos++) {
+                const int *nb       = neigh[pos].neighbor.data();
+                const double *J_pos = &J[pos * n_neigh * n_lane];
+                double *x           = &sx[pos * n_lane];
+                double *y           = &sy[pos * n_lane];
+
+                #pragma omp simd
+                for (std::size_t l = 0; l < n_lane; l++) {
+                    double hx = 0.0, hy = 0.0;
+                    for (std::size_t d = 0; d < n_neigh; d++) {
+                        hx += J_pos[d * n_lane + l] * sx[nb[d] * n_lane + l];
+                        hy += J_pos[d * n_lane + l] * sy[nb[d] * n_lane + l];
+                    }
+
+                    double h2   = hx * hx + hy * hy;
+                    double proj = (h2 > 0.0) ? 2.0 * (x[l] * hx + y[l] * hy) / h2 : 0.0;
+                    x[l]        = (h2 > 0.0) ? proj * hx - x[l] : x[l];
+                    y[l]        = (h2 > 0.0) ? proj * hy - y[l] : y[l];
+                } // Loop over lanes
+            } // Loop over sites
+        }
+
+        /* sweep_lattice()
+         * Performs one Metropolis sweep followed by the over-relaxation sweeps.
+         */
+        void sweep_lattice(double beta, std::mt19937 &engine)
+        {
+            sweep_lattice_disorder(beta, engine);
+            for (std::size_t i = 0; i < this->n_overrelax; i++)
+                sweep_overrelax_disorder();
+        }
+
+        /* tune_lattice()
+         * Tunes the proposal window of every lane every tune_every warmup sweeps. See
+         * XY2::tune_lattice().
+         */
+        void tune_lattice(std::size_t n_sweep)
+        {
+            if (n_sweep != 0 && n_sweep % tune_every == 0) {
+                for (std::size_t l = 0; l < n_lane; l++) {
+                    double acc = static_cast<double>(n_accept[l]) /
+                                 static_cast<double>(tune_every * size);
+                    window[l] *= std::min(2.0, std::max(0.5, acc / target_acc));
+                    window[l]  = std::min(window[l], M_PI);
+                }
+            } // Tune windows
+
+            if (n_sweep % tune_every == 0)
+                n_accept.fill(0);
+        }
+
+        /* energy()
+         * Computes the total energy of every lane.
+         */
+        void energy(Lane_array &E_tot) const
+        {
+            E_tot.fill(0.0);
+
+            for (std::size_t j = 0; j < size; j++) {
+                const int *nb = neigh[j].neighbor.data();
+
+                #pragma omp simd
+                for (std::size_t l = 0; l < n_lane; l++) {
+                    double hx = 0.0, hy = 0.0;
+
+                    for (std::size_t b = 0; b < Dim; b++) {
+                        int d = this->own_bond[b];
+                        hx += J[(j * n_neigh + d) * n_lane + l] * sx[nb[d] * n_lane + l];
+                        hy += J[(j * n_neigh + d) * n_lane + l] * sy[nb[d] * n_lane + l];
+                    }
+
+                    E_tot[l] += -(sx[j * n_lane + l] * hx + sy[j * n_lane + l] * hy);
+                } // Loop over lanes
+            } // Compute energy of lattice
+        }
+
+        /* magnetization2()
+         * Computes the square of the total magnetization of every lane.
+         */
+        void magnetization2(Lane_array &M2) const
+        {
+            Lane_array Mx = {0}, My = {0};
+
+            for (std::size_t j = 0; j < size; j++) {
+                #pragma omp simd
+                for (std::size_t l = 0; l < n_lane; l++) {
+                    Mx[l] += sx[j * n_lane + l];
+                    My[l] += sy[j * n_lane + l];
+                }
+            }
+
+            for (std::size_t l = 0; l < n_lane; l++)
+                M2[l] = Mx[l] * Mx[l] + My[l] * My[l];
+        }
+
+    public:
+        using Base::n_lane;
+        using Base::set_spin;
+
+        XY_batch() = default;
+
+        /* Constructor
+         * Takes the lattice and run parameters from an XY2 or XY3 model.
+         */
+        template <typename Model>
+        explicit XY_batch(const Model &model) :
+            Base(model.get_neighbors(), model.get_warmup(), model.get_measure(),
+                    model.get_overrelax(), model.get_visit()),
+            target_acc(model.get_target_acceptance())
+        {
+            window.fill(M_PI);
+            n_accept.fill(0);
+            sx.resize(size * n_lane);
+            sy.resize(size * n_lane);
+            d_angle.resize(size * n_lane);
+            d_cos.resize(size * n_lane);
+            d_sin.resize(size * n_lane);
+        }
+
+        /* set_spin()
+         * Sets random angles in every lane and resets the proposal windows.
+         */
+        void set_spin(std::mt19937 &engine)
+        {
+            for (std::size_t i = 0; i < size * n_lane; i++) {
+                double angle = 2.0 * M_PI * this->rand0(engine);
+                sx[i] = cos(angle);
+                sy[i] = sin(angle);
+            }
+
+            window.fill(M_PI);
+            n_accept.fill(0);
+        }
+
+        /* save()
+         * Writes the batch, its spins and proposal windows in binary.
+         */
+        void save(std::ostream &os) const
+        {
+            Base::save(os);
+            write_binary(os, target_acc);
+            write_binary(os, window);
+            write_binary(os, n_accept);
+            write_binary(os, sx);
+            write_binary(os, sy);
+        }
+
+        /* load()
+         * Reads back the data written by save().
+         */
+        void load(std::istream &is)
+        {
+            Base::load(is);
+            read_binary(is, target_acc);
+            read_binary(is, window);
+            read_binary(is, n_accept);
+            read_binary(is, sx);
+            read_binary(is, sy);
+        }
+};
+
+#endif
@@ -0,0 +1,118 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <random>
+#include <functional>
+
+
+/* struct : Sweep_state
+ * Progress of the sweeps of one temperature. Stored by the models so a run can be stopped and
+ * resumed in the middle of the warmup or measurement sweeps.
+ */
+struct Sweep_state
+{
+    size_t n_sweep = 0;
+    std::vector<double> acc;
+};
+
+
+/* Called by the models every few sweeps with the current random number engine.
+ */
+typedef std::function<void(const std::mt19937 &)> Checkpoint_hook;
+
+
+/* Binary IO helpers used by the save() and load() methods. Vectors are stored with their length,
+ * the engine is stored with its standard text representation.
+ */
+template <typename T>
+void write_binary(std::ostream &os, const T &val)
+{
+    os.write(reinterpret_cast<const char *>(&val), sizeof(T));
+}
+
+template <typename T>
+void read_binary(std::istream &is, T &val)
+{
+    is.read(reinterpret_cast<char *>(&val), sizeof(T));
+}
+
+template <typename T>
+void write_binary(std::ostream &os, const std::vector<T> &vec)
+{
+    size_t n = vec.size();
+    write_binary(os, n);
+    os.write(reinterpret_cast<const char *>(vec.data()), n * sizeof(T));
+}
+
+template <typename T>
+void read_binary(std::istream &is, std::vector<T> &vec)
+{
+    size_t n = 0;
+    read_binary(is, n);
+    vec.resize(n);
+    is.read(reinterpret_cast<char *>(vec.data()), n * sizeof(T));
+}
+
+void write_binary(std::ostream &os, const std::string &str);
+void read_binary(std::istream &is, std::string &str);
+void write_binary(std::ostream &os, const Sweep_state &state);
+void read_binary(std::istream &is, Sweep_state &state);
+void write_binary(std::ostream &os, const std::mt19937 &engine);
+void read_binary(std::istream &is, std::mt19937 &engine);
+
+
+/* class : Checkpoint
+ * Binary checkpoint of a disorder averaged run. The file holds the master seed, the current
+ * realization and the output accumulated over the finished realizations, and is only written when
+ * a realization begins and when the run finishes. Every thread stores its slot in a file of its
+ * own next to it (file.slot<thread id>). A slot holds the position of the thread in its
+ * temperature chunk, the values it already produced for the current realization and, if it is in
+ * the middle of a temperature, the model (spins, sweep progress) and the state of its random
+ * number engine.
+ *
+ * Every random number of a run is derived from the master seed, so a restarted run reproduces
+ * the uninterrupted run bit for bit. The exchange table is drawn again from the seed of the
+ * realization and is not part of the slots. Slots carry the stamp of the realization they belong
+ * to, so slots left behind by another run or realization are ignored. Files are written to a
+ * temporary file, flushed to the disk and renamed, so a crash while writing leaves the previous
+ * checkpoint intact. A finished series keeps its checkpoint with the final result, so restarting
+ * skips the series that are already done.
+ */
+class Checkpoint
+{
+    private:
+        std::string filename;
+        size_t every;
+        bool restart;
+        unsigned seed;
+        unsigned stamp;                     // Identifies the slots of the current realization
+        int run;
+        bool complete;
+        std::vector<double> acc;
+        int n_slot;                         // Slot files written by this process
+
+        std::string slot_file(int thd_id) const;
+        void write(const std::string &file, const std::string &data) const;
+        void write_image();
+        void remove_slots();
+
+    public:
+        Checkpoint(const std::string &file, size_t Every, bool Restart, unsigned Seed = 0);
+        bool load(size_t n_pts);
+        void begin_run(int Run, const std::vector<double> &Acc);
+        void set_slot(int thd_id, const std::string &data);
+        void finish(const std::vector<double> &Result);
+        bool is_complete() const;
+        bool get_slot(int thd_id, std::string &data) const;
+        int get_run() const;
+        const std::vector<double>& get_acc() const;
+        size_t get_every() const;
+        std::mt19937 make_engine(int Run, int stream) const;
+};
+
+#endif
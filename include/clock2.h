@@ -10,25 +10,39 @@
 /* Class : Clock2
  * Class for handeling Monte Carlo simulation of a clock model. Stores the values of the spin
  * (we only need the cosine values) into a table to be accessed by an index in the spin array.
+ * Each Metropolis sweep can be followed by a number of over-relaxation sweeps.
  */
 class Clock2 : public Model2
 {
     private:
         int q;
+        size_t n_overrelax;
         std::vector<int> spin;
+        int proposal;                       // Angle of the last multicanonical proposal
         std::vector<double> cos_val;
         std::vector<double> sin_val;
 
-        void sweep_lattice_clean(float beta, std::mt19937 &engine);
-        void sweep_lattice_disorder(float beta, std::mt19937 &engine);
+        template <Visit V> void sweep_lattice_clean(float beta, std::mt19937 &engine);
+        template <Visit V> void sweep_lattice_disorder(float beta, std::mt19937 &engine);
+        void sweep_overrelax_clean();
+        void sweep_overrelax_disorder(float beta, std::mt19937 &engine);
+        void sweep_lattice(float beta, std::mt19937 &engine);
+        double energy() const;
+        double magnetization2() const;
+        double propose(size_t pos, std::mt19937 &engine);
+        void accept(size_t pos);
 
     public:
         Clock2() = default;
         Clock2(const int L, const int _q);
         Clock2(const Clock2 &rhs);
-        void set_spin();
-        double sweep_energy(double beta, std::mt19937 &engine);
-        double sweep_binder(double beta, std::mt19937 &engine);
+        using Model2::set_spin;
+        void set_spin(std::mt19937 &engine);
+        void set_overrelax(size_t n_over);
+        int get_q() const;
+        size_t get_overrelax() const;
+        void save(std::ostream &os) const;
+        void load(std::istream &is);
 };
 
 #endif
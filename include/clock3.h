@@ -4,6 +4,7 @@
 
 #include <vector>
 #include <random>
+#include <cstdint>
 
 #include "model3.h"
 
@@ -11,24 +12,49 @@
 /* Class : Clock3
  * Class for handeling Monte Carlo simulation of a clock model. Stores the values of the spin
  * (we only need the cosine values) into a table to be accessed by an index in the spin array.
+ * Each Metropolis sweep can be followed by a number of over-relaxation sweeps.
  */
 class Clock3 : public Model3
 {
     private:
         int q;
+        size_t n_overrelax;
         std::vector<int> spin;
+        int proposal;                       // Angle of the last multicanonical proposal
         std::vector<double> cos_val, sin_val;
 
-        void sweep_lattice_clean(float beta, std::mt19937 &engine);
-        void sweep_lattice_disorder(float beta, std::mt19937 &engine);
+        int draw_angle(size_t pos, std::mt19937 &engine, std::uint64_t &n_draw);
+        template <bool clean> double change_energy(size_t pos, int new_angle) const;
+        template <bool clean> bool metropolis_site(size_t pos, float beta, std::mt19937 &engine,
+                std::uint64_t &n_draw);
+        template <bool clean> void reflect_site(size_t pos, float beta, std::mt19937 &engine);
+        template <Visit V> void sweep_lattice_clean(float beta, std::mt19937 &engine);
+        template <Visit V> void sweep_lattice_disorder(float beta, std::mt19937 &engine);
+        void sweep_overrelax_clean(float beta, std::mt19937 &engine);
+        void sweep_overrelax_disorder(float beta, std::mt19937 &engine);
+        void sweep_lattice(float beta, std::mt19937 &engine);
+        double energy() const;
+        double magnetization2() const;
+        double propose(size_t pos, std::mt19937 &engine);
+        void accept(size_t pos);
+        double energy_sites(size_t first, size_t last) const;
+        void magnetization_sites(size_t first, size_t last, double &Mx, double &My) const;
+        bool update_site(size_t pos, float beta, std::mt19937 &engine);
+        void prefetch_spins(size_t pos) const;
+        void overrelax_site(size_t pos, float beta, std::mt19937 &engine);
+        size_t overrelax_sweeps() const;
 
     public:
         Clock3() = default;
         Clock3(const int L, const int _q);
         Clock3(const Clock3 &rhs);
-        void set_spin();
-        double sweep_energy(double beta, std::mt19937 &engine);
-        double sweep_binder(double beta, std::mt19937 &engine);
+        using Model3::set_spin;
+        void set_spin(std::mt19937 &engine);
+        void set_overrelax(size_t n_over);
+        int get_q() const;
+        size_t get_overrelax() const;
+        void save(std::ostream &os) const;
+        void load(std::istream &is);
 };
 
 #endif
@@ -0,0 +1,44 @@
+#ifndef CROSSING_H
+#define CROSSING_H
+
+
+#include <cstddef>
+#include <vector>
+
+
+/* Binder crossings
+ *
+ * The Binder ratios of two lattice sizes cross at T_c up to corrections to scaling. Below T_c
+ * the ratio of the larger lattice is higher, above it lower. binder_crossings() locates, for
+ * every pair of consecutive L, the highest temperature interval of the grid where the difference
+ * of the two curves changes sign while their mean is above binder_floor (see refine.h), which
+ * skips the noise of the ordered phase, where both ratios sit at 2/3, and of the paramagnet,
+ * where both go to 0. The crossing is interpolated linearly within the interval.
+ *
+ * With per realization curves the crossing of the disorder averaged curves is bootstrapped:
+ * each resample draws the realizations of every L with replacement, and err is the standard
+ * deviation of the crossings of n_boot resamples, run in parallel. With a single realization per
+ * L (clean runs or averaged data), err is 0 and n_found is 0.
+ */
+
+
+/* struct : Crossing
+ * Binder crossing of two lattice sizes. n_found counts the resamples that had a crossing.
+ */
+struct Crossing
+{
+    int L1, L2;
+    double T_c;
+    double err;
+    bool found;
+    std::size_t n_found;
+};
+
+
+bool find_crossing(const std::vector<double> &T, const std::vector<double> &U1,
+        const std::vector<double> &U2, double &T_c);
+std::vector<Crossing> binder_crossings(const std::vector<double> &T, const std::vector<int> &L,
+        const std::vector<std::vector<std::vector<double>>> &binder, std::size_t n_boot,
+        unsigned seed);
+
+#endif
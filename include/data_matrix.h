@@ -3,25 +3,43 @@
 
 #include <cstddef>
 #include <iostream>
+#include <string>
+#include <vector>
 
 
 /* Data_matrix class
- * Matrix for storing multiple columns of data.
- * Provides only methods for inserting data and outputing with an ostream operator.
+ * Table of equally long, optionally named columns. Each column is stored contiguously, one after
+ * another, so a column can be read or written as a single block. The storage is owned by the
+ * matrix and copies, moves and assignments behave like those of a std::vector.
+ * Provides methods for inserting columns, reading single values or whole columns, and a text
+ * output which formats every row into one buffer. See result_file.h for the binary output.
  */
 class Data_matrix
 {
     private:
         size_t N_row, N_col;
-        int filled_row;
-        double *data;
+        size_t filled_col;
+        std::vector<double> data;
+        std::vector<std::string> name;
+
+        std::string format(int precision) const;
 
     public:
         Data_matrix();
         Data_matrix(size_t r, size_t c);
-        Data_matrix(const Data_matrix &rhs);
-        ~Data_matrix();
-        void insert_array(const double *input);
+        Data_matrix(const Data_matrix &rhs) = default;
+        Data_matrix(Data_matrix &&rhs) noexcept;
+        Data_matrix& operator=(const Data_matrix &rhs) = default;
+        Data_matrix& operator=(Data_matrix &&rhs) noexcept;
+        void insert_array(const double *input, const std::string &col_name = "");
+        size_t rows() const;
+        size_t cols() const;
+        double get(size_t row, size_t col) const;
+        const double* column(size_t col) const;
+        const double* column(const std::string &col_name) const;
+        const std::string& get_name(size_t col) const;
+        bool has_names() const;
+        void write_text(const std::string &filename, int precision = 17) const;
         friend std::ostream& operator<<(std::ostream &os, const Data_matrix &rhs);
 };
 
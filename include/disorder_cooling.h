@@ -4,6 +4,7 @@
 
 #include <array>
 #include <string>
+#include <vector>
 
 #include "ising2.h"
 #include "clock2.h"
@@ -11,26 +12,122 @@
 #include "ising3.h"
 #include "clock3.h"
 #include "xy3.h"
+#include "batch.h"
+#include "checkpoint.h"
+#include "time_series.h"
+#include "observables.h"
+#include "grid.h"
 #include "data_matrix.h"
+#include "entropy.h"
 
 
 /* Header file for Monte Carlo simulations of classical spin models.
  *
  * Provides functions for running the simulation, gathering data, and processing data to a file.
+ * The compute functions take an optional Checkpoint. With a checkpoint the run is reproducible
+ * from its master seed and can be restarted after it was interrupted. With a Time_series the
+ * observables of every measurement sweep are streamed to a file for later reweighting.
  */
 template <typename TT, typename Model, size_t N>
-std::array<TT, N> compute_energy(const std::array<TT, N> &T, Model &model);
+std::array<TT, N> compute_energy(const std::array<TT, N> &T, Model &model,
+        Checkpoint *ckpt = nullptr, Time_series *ts = nullptr);
 
 template <typename TT, typename Model, size_t N>
-std::array<TT, N> compute_binder(const std::array<TT, N> &T, Model &model);
+std::array<TT, N> compute_binder(const std::array<TT, N> &T, Model &model,
+        Checkpoint *ckpt = nullptr, Time_series *ts = nullptr);
 
 template <typename TT, typename Model, size_t N>
 std::array<TT, N> compute_energy(const std::array<TT, N> &T, Model &model,
-        double delta, int n_run);
+        double delta, int n_run, Checkpoint *ckpt = nullptr, Time_series *ts = nullptr);
 
 template <typename TT, typename Model, size_t N>
 std::array<TT, N> compute_binder(const std::array<TT, N> &T, Model &model,
-        double delta, int n_run);
+        double delta, int n_run, Checkpoint *ckpt = nullptr, Time_series *ts = nullptr);
+
+/* Disorder averages of the clock and XY models are computed Batch<Dim>::n_lane realizations at a
+ * time with the batched engines in batch.h.
+ */
+template <typename TT, size_t N>
+std::array<TT, N> compute_energy(const std::array<TT, N> &T, Clock2 &model,
+        double delta, int n_run, Checkpoint *ckpt = nullptr, Time_series *ts = nullptr);
+
+template <typename TT, size_t N>
+std::array<TT, N> compute_energy(const std::array<TT, N> &T, Clock3 &model,
+        double delta, int n_run, Checkpoint *ckpt = nullptr, Time_series *ts = nullptr);
+
+template <typename TT, size_t N>
+std::array<TT, N> compute_energy(const std::array<TT, N> &T, XY2 &model,
+        double delta, int n_run, Checkpoint *ckpt = nullptr, Time_series *ts = nullptr);
+
+template <typename TT, size_t N>
+std::array<TT, N> compute_energy(const std::array<TT, N> &T, XY3 &model,
+        double delta, int n_run, Checkpoint *ckpt = nullptr, Time_series *ts = nullptr);
+
+template <typename TT, size_t N>
+std::array<TT, N> compute_binder(const std::array<TT, N> &T, Clock2 &model,
+        double delta, int n_run, Checkpoint *ckpt = nullptr, Time_series *ts = nullptr);
+
+template <typename TT, size_t N>
+std::array<TT, N> compute_binder(const std::array<TT, N> &T, Clock3 &model,
+        double delta, int n_run, Checkpoint *ckpt = nullptr, Time_series *ts = nullptr);
+
+template <typename TT, size_t N>
+std::array<TT, N> compute_binder(const std::array<TT, N> &T, XY2 &model,
+        double delta, int n_run, Checkpoint *ckpt = nullptr, Time_series *ts = nullptr);
+
+template <typename TT, size_t N>
+std::array<TT, N> compute_binder(const std::array<TT, N> &T, XY3 &model,
+        double delta, int n_run, Checkpoint *ckpt = nullptr, Time_series *ts = nullptr);
+
+/* compute_observables() measures E, C, |M|, chi and the binder ratio together in one run, which
+ * is cheaper than calling compute_energy() and compute_binder() when more than one is needed.
+ * The temperature grid can be a std::array or a std::vector (see job.h for runtime grids); the
+ * result has the same kind of container. With runs the disorder averages also keep the
+ * observables of every realization, (*runs)[r] for realization r, to bootstrap the errors (see
+ * crossing.h); a checkpoint stores them with the average.
+ */
+template <typename Grid, typename Model>
+typename Grid_output<Grid, Observables>::type compute_observables(const Grid &T, Model &model,
+        Checkpoint *ckpt = nullptr, Time_series *ts = nullptr);
+
+template <typename Grid, typename Model>
+typename Grid_output<Grid, Observables>::type compute_observables(const Grid &T, Model &model,
+        double delta, int n_run, Checkpoint *ckpt = nullptr, Time_series *ts = nullptr,
+        std::vector<typename Grid_output<Grid, Observables>::type> *runs = nullptr);
+
+template <typename Grid>
+typename Grid_output<Grid, Observables>::type compute_observables(const Grid &T, Clock2 &model,
+        double delta, int n_run, Checkpoint *ckpt = nullptr, Time_series *ts = nullptr,
+        std::vector<typename Grid_output<Grid, Observables>::type> *runs = nullptr);
+
+template <typename Grid>
+typename Grid_output<Grid, Observables>::type compute_observables(const Grid &T, Clock3 &model,
+        double delta, int n_run, Checkpoint *ckpt = nullptr, Time_series *ts = nullptr,
+        std::vector<typename Grid_output<Grid, Observables>::type> *runs = nullptr);
+
+template <typename Grid>
+typename Grid_output<Grid, Observables>::type compute_observables(const Grid &T, XY2 &model,
+        double delta, int n_run, Checkpoint *ckpt = nullptr, Time_series *ts = nullptr,
+        std::vector<typename Grid_output<Grid, Observables>::type> *runs = nullptr);
+
+template <typename Grid>
+typename Grid_output<Grid, Observables>::type compute_observables(const Grid &T, XY3 &model,
+        double delta, int n_run, Checkpoint *ckpt = nullptr, Time_series *ts = nullptr,
+        std::vector<typename Grid_output<Grid, Observables>::type> *runs = nullptr);
+
+/* compute_observables_slabs() runs one temperature and realization at a time, with the lattice
+ * split into slabs over all threads (see model3.h). It is meant for the 3D lattices too large to
+ * run one per thread. The exchange table of realization r and the spins at T[i] are drawn from
+ * seed_seq{seed, r, 0} and seed_seq{seed, r, 1 + i}, seed 0 draws a seed.
+ */
+template <typename Grid, typename Model>
+typename Grid_output<Grid, Observables>::type compute_observables_slabs(const Grid &T,
+        Model &model, double delta, int n_run, unsigned seed, Time_series *ts = nullptr,
+        std::vector<typename Grid_output<Grid, Observables>::type> *runs = nullptr);
+
+template <typename Obs_grid>
+typename Grid_output<Obs_grid, double>::type observable_column(const Obs_grid &obs,
+        double Observables::*field);
 
 template <typename TT, size_t N>
 void compute_entropy(const std::array<TT, N> &E, const std::array<TT, N> &T, int n_spin,
@@ -44,14 +141,49 @@ void write_energy(const std::array<TT, N> &E, const std::array<TT, N> &T,
  * Intended Helper functions
  *-----------------------------------------------------------------------------------------------*/
 
-template <typename TT, typename Model, size_t N>
-void run_mc_energy(const std::array<TT, N> &T, std::array<TT, N> &E, Model model);
+template <typename Out>
+int start_checkpoint(Checkpoint *ckpt, Out &out, std::vector<Out> *runs = nullptr);
 
-template <typename TT, typename Model, size_t N>
-void run_mc_binder(const std::array<TT, N> &T, std::array<TT, N> &binder, Model model);
+template <typename Out>
+std::vector<double> acc_vector(const Out &out, const std::vector<Out> *runs = nullptr);
 
-template <typename TT, size_t N>
-double trapezoid(const std::array<TT, N> &x, const std::array<TT, N> &y, int idx);
+template <typename Out>
+void set_acc(Out &out, std::vector<Out> *runs, const std::vector<double> &acc);
+
+template <typename V>
+void append_acc(std::vector<double> &acc, const V &val);
+
+template <typename V>
+size_t read_acc(V &val, const double *acc);
+
+template <typename Grid, typename Out, typename Model, typename Measure>
+void disorder_average(const Grid &T, Out &out, Model &model, double delta, int n_run,
+        int n_step, Measure measure, Checkpoint *ckpt, Time_series *ts,
+        std::vector<Out> *runs = nullptr);
+
+template <typename S, typename Out, typename V>
+void add_run(S &sum, std::vector<Out> *runs, int run, size_t i, const V &val, int n_real);
+
+template <typename S, typename Out, typename V, size_t N>
+void add_run(S &sum, std::vector<Out> *runs, int run, size_t i, const std::array<V, N> &val,
+        int n_real);
+
+template <typename Grid, typename Out, typename Model, typename Measure>
+void run_mc(const Grid &T, Out &out, Model model, Measure measure, Checkpoint *ckpt,
+        Time_series *ts, int run);
+
+template <typename TT, typename Batch_model, size_t N>
+std::array<TT, N> compute_energy_batch(const std::array<TT, N> &T, Batch_model batch,
+        double delta, int n_run, Checkpoint *ckpt, Time_series *ts);
+
+template <typename TT, typename Batch_model, size_t N>
+std::array<TT, N> compute_binder_batch(const std::array<TT, N> &T, Batch_model batch,
+        double delta, int n_run, Checkpoint *ckpt, Time_series *ts);
+
+template <typename Grid, typename Batch_model>
+typename Grid_output<Grid, Observables>::type compute_observables_batch(const Grid &T,
+        Batch_model batch, double delta, int n_run, Checkpoint *ckpt, Time_series *ts,
+        std::vector<typename Grid_output<Grid, Observables>::type> *runs);
 
 
 #include "../src/disorder_cooling.cpp"
@@ -0,0 +1,66 @@
+#ifndef ENTROPY_H
+#define ENTROPY_H
+
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "reweight.h"
+
+
+/* Entropy from the energy
+ *
+ * The entropy per site follows from E(T) by thermodynamic integration down from infinite
+ * temperature, where every spin is free:
+ *      S(T) = S_inf + E(T) / T - int_T^T_max E(T') / T'^2 dT'
+ * with S_inf = ln 2 for Ising, ln q for the clock models and ln 2pi for XY. Above the top of the
+ * grid T_max the integral is neglected, so the grid has to reach well into the paramagnet.
+ *
+ * The integral is a reverse cumulative sum over the intervals of the grid, so all of S(T) costs
+ * O(N) on grids of any size and spacing. Each interval is integrated with weights over a few
+ * neighboring points:
+ *      trapezoid   the straight line through its ends
+ *      simpson     the parabola through its ends and the next point (the previous one at the top
+ *                  of the grid), which is Simpson's rule on non-uniform grids
+ *      cubic       the cubic through the two points on either side (shifted inward at the ends)
+ * simpson and cubic need at least 3 and 4 points and fall back to the lower order otherwise.
+ *
+ * S is linear in the E of the grid, so independent errors of E (the standard error over the
+ * disorder realizations) propagate exactly: the weight of E(T_j) in S(T_i) is the same for every
+ * i well below j, and the variance is a reverse cumulative sum as well.
+ */
+
+
+/* enum : Quadrature
+ * Integration rule of one interval.
+ */
+enum class Quadrature
+{
+    trapezoid,
+    simpson,
+    cubic
+};
+
+
+/* struct : Entropy_point
+ * Entropy per site at one temperature with its statistical error.
+ */
+struct Entropy_point
+{
+    double T;
+    double S;
+    double err;
+};
+
+
+bool parse_quadrature(const std::string &name, Quadrature &rule);
+std::vector<double> tail_integral(const std::vector<double> &x, const std::vector<double> &y,
+        Quadrature rule);
+std::vector<Entropy_point> entropy(const std::vector<double> &T, const std::vector<double> &E,
+        const std::vector<double> &E_err, double S_inf, Quadrature rule);
+std::vector<Entropy_point> entropy(const std::vector<Rw_point> &pts, double S_inf,
+        Quadrature rule);
+void write_entropy(const std::vector<Entropy_point> &S, const std::string &filename);
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef EXP_POLY_H
+#define EXP_POLY_H
+
+
+#include <cstdint>
+#include <cstring>
+
+
+/* exp_poly()
+ * Computes exp(x) for x <= 0 without branches or library calls, so it can be inlined into loops
+ * marked with omp simd (std::exp is only vectorized by GCC with -ffast-math). The argument is
+ * reduced to x = k * ln(2) + r with |r| <= ln(2)/2, exp(r) is evaluated with its Taylor series and
+ * 2^k is built directly in the exponent bits. Arguments below -700 are clamped, which is far
+ * below any acceptance probability that can be resolved by a float random number.
+ */
+inline double exp_poly(double x)
+{
+    const double log2e       = 1.44269504088896338700;
+    const double ln2_hi      = 6.93145751953125e-1;  // ln(2) split for exact reduction
+    const double ln2_lo      = 1.42860682030941723212e-6;
+    const double round_magic = 6755399441055744.0;
+
+    x = (x < -700.0) ? -700.0 : x;
+
+    double k = (x * log2e + round_magic) - round_magic;
+    double r = (x - k * ln2_hi) - k * ln2_lo;
+
+    double p = 1.0 + r * (1.0 + r * (1.0 / 2.0 + r * (1.0 / 6.0 + r * (1.0 / 24.0 +
+               r * (1.0 / 120.0 + r * (1.0 / 720.0 + r * (1.0 / 5040.0 + r * (1.0 / 40320.0 +
+               r * (1.0 / 362880.0 + r * (1.0 / 3628800.0 + r * (1.0 / 39916800.0 +
+               r * (1.0 / 479001600.0))))))))))));
+
+    std::int64_t bits = (static_cast<std::int64_t>(k) + 1023) << 52;
+    double scale;
+    std::memcpy(&scale, &bits, sizeof(scale));
+
+    return p * scale;
+}
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef GRID_H
+#define GRID_H
+
+
+#include <cstddef>
+#include <array>
+#include <vector>
+
+
+/* struct : Grid_output
+ * Container of the output for a temperature grid: a std::array of the same length for a
+ * std::array grid and a std::vector of the same size for a std::vector grid. make() returns a
+ * zeroed container.
+ */
+template <typename Grid, typename V>
+struct Grid_output;
+
+template <typename TT, size_t N, typename V>
+struct Grid_output<std::array<TT, N>, V>
+{
+    typedef std::array<V, N> type;
+    static type make(const std::array<TT, N> &) { return type{}; }
+};
+
+template <typename TT, typename V>
+struct Grid_output<std::vector<TT>, V>
+{
+    typedef std::vector<V> type;
+    static type make(const std::vector<TT> &T) { return type(T.size(), V{}); }
+};
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef INSTRUMENT_H
+#define INSTRUMENT_H
+
+
+#include <cstdint>
+#include <string>
+#include <chrono>
+
+
+/* Instrumentation
+ *
+ * Built with INSTRUMENT (make INSTRUMENT=1), the models count their Metropolis proposals,
+ * accepted moves and the draws of the angle rejection loop of the clock models, and time their
+ * warmup, their measurement sweeps, the measurement of the observables inside them and the
+ * checkpoint writes and time series pushes of both phases. Without it the macros compile to
+ * nothing and the hot loops are unchanged.
+ *
+ * The runs record the counters of every (L, T, realization) under a label, usually the name of
+ * the result file, and instrument_write() exports the records of a label as JSON next to it:
+ *
+ *      {"label": "...", "records": [{"L": 8, "T": 2.27, "run": 0, "proposed": ...,
+ *       "accepted": ..., "acceptance": ..., "angle_draws": ..., "t_warmup": ...,
+ *       "t_measure": ..., "t_observe": ..., "t_io": ...}, ...]}
+ *
+ * Times are in seconds. t_measure includes t_observe, while t_warmup and t_measure leave out the
+ * I/O counted in t_io.
+ */
+
+
+/* struct : Counters
+ * Counters and phase timers of one model.
+ */
+struct Counters
+{
+    std::uint64_t proposed    = 0;
+    std::uint64_t accepted    = 0;
+    std::uint64_t angle_draws = 0;      // Angles drawn by the clock rejection loop
+    double t_warmup           = 0.0;
+    double t_measure          = 0.0;
+    double t_observe          = 0.0;
+    double t_io               = 0.0;    // Checkpoint writes and time series pushes
+};
+
+
+#ifdef INSTRUMENT
+/* class : Phase_timer
+ * Adds the seconds from its construction to its destruction to a sink, less the seconds an
+ * optional exclude timer gained meanwhile.
+ */
+class Phase_timer
+{
+    private:
+        std::chrono::steady_clock::time_point t0;
+        double &sink;
+        const double *exclude;
+        double exclude0;
+
+    public:
+        explicit Phase_timer(double &Sink, const double *Exclude = nullptr)
+            : t0(std::chrono::steady_clock::now()), sink(Sink), exclude(Exclude),
+              exclude0(Exclude ? *Exclude : 0.0)
+        {
+        }
+
+        ~Phase_timer()
+        {
+            sink += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+            if (exclude)
+                sink -= *exclude - exclude0;
+        }
+};
+
+#define INSTRUMENT_ADD(counters, field, n)  ((counters).field += (n))
+#define INSTRUMENT_TIMER(name, sink)        Phase_timer name(sink)
+#define INSTRUMENT_PHASE(name, sink, counters)  Phase_timer name(sink, &(counters).t_io)
+
+void instrument_label(const std::string &label);
+void instrument_record(const std::string &label, int L, double T, int run, const Counters &c);
+void instrument_record(int L, double T, int run, const Counters &c);
+void instrument_write(const std::string &label, const std::string &filename);
+
+#else
+#define INSTRUMENT_ADD(counters, field, n)  ((void) (n))
+#define INSTRUMENT_TIMER(name, sink)        ((void) 0)
+#define INSTRUMENT_PHASE(name, sink, counters)  ((void) 0)
+
+inline void instrument_label(const std::string &) {}
+inline void instrument_record(const std::string &, int, double, int, const Counters &) {}
+inline void instrument_record(int, double, int, const Counters &) {}
+inline void instrument_write(const std::string &, const std::string &) {}
+#endif
+
+#endif
@@ -15,16 +15,24 @@ class Ising2 : public Model2
 {
     private:
         std::vector<int> spin;
-        void sweep_lattice_clean(float beta, std::mt19937 &engine);
-        void sweep_lattice_disorder(float beta, std::mt19937 &engine);
+        template <Visit V> void sweep_lattice_clean(float beta, std::mt19937 &engine);
+        template <Visit V> void sweep_lattice_disorder(float beta, std::mt19937 &engine);
+        void sweep_lattice(float beta, std::mt19937 &engine);
+        double energy() const;
+        double magnetization2() const;
+        double propose(size_t pos, std::mt19937 &engine);
+        void accept(size_t pos);
 
     public:
         Ising2() = default;
         Ising2(const int L);
         Ising2(const Ising2 &rhs);
-        void set_spin();
-        double sweep_energy(double beta, std::mt19937 &engine);
-        double sweep_binder(double beta, std::mt19937 &engine);
+        using Model2::set_spin;
+        void set_spin(std::mt19937 &engine);
+        double flip_energy(size_t pos) const;
+        void flip(size_t pos);
+        void save(std::ostream &os) const;
+        void load(std::istream &is);
 };
 
 #endif
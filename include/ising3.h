@@ -16,16 +16,28 @@ class Ising3 : public Model3
 {
     private:
         std::vector<int> spin;
-        void sweep_lattice_clean(float beta, std::mt19937 &engine);
-        void sweep_lattice_disorder(float beta, std::mt19937 &engine);
+        template <Visit V> void sweep_lattice_clean(float beta, std::mt19937 &engine);
+        template <Visit V> void sweep_lattice_disorder(float beta, std::mt19937 &engine);
+        void sweep_lattice(float beta, std::mt19937 &engine);
+        double energy() const;
+        double magnetization2() const;
+        double propose(size_t pos, std::mt19937 &engine);
+        void accept(size_t pos);
+        double energy_sites(size_t first, size_t last) const;
+        void magnetization_sites(size_t first, size_t last, double &Mx, double &My) const;
+        bool update_site(size_t pos, float beta, std::mt19937 &engine);
+        void prefetch_spins(size_t pos) const;
 
     public:
         Ising3() = default;
         Ising3(const int L);
         Ising3(const Ising3 &rhs);
-        void set_spin();
-        double sweep_energy(double beta, std::mt19937 &engine);
-        double sweep_binder(double beta, std::mt19937 &engine);
+        using Model3::set_spin;
+        void set_spin(std::mt19937 &engine);
+        double flip_energy(size_t pos) const;
+        void flip(size_t pos);
+        void save(std::ostream &os) const;
+        void load(std::istream &is);
 };
 
 #endif
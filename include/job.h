@@ -0,0 +1,178 @@
+#ifndef JOB_H
+#define JOB_H
+
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <istream>
+
+#include "time_series.h"
+#include "observables.h"
+#include "crossing.h"
+#include "entropy.h"
+#include "site_order.h"
+#include "wang_landau.h"
+#include "reweight.h"
+#include "muca.h"
+
+
+/* Job files
+ *
+ * A job file lists simulations to run without recompiling. Each line holds a key and its values,
+ * '#' starts a comment. A job starts with "job <name>" and ends at an "end" line, the next "job"
+ * line or the end of the input:
+ *
+ *      job ising_small
+ *      model ising2                # ising2, ising3, clock2, clock3, xy2 or xy3
+ *      L 4 6 8
+ *      T linear 0.1 6.0 60         # 60 evenly spaced points, both ends included
+ *      T log 2.0 3.0 20            # 20 log spaced points
+ *      T list 2.25 2.27 2.29       # explicit points
+ *      delta 0 0.5                 # 0 runs the clean model
+ *      n_run 3                     # realizations of every delta > 0
+ *      warmup 30000
+ *      measure 50000
+ *      q 6                         # clock models
+ *      overrelax 2                 # clock and XY models
+ *      seed 7                      # master seed of the checkpoints, 0 draws one
+ *      checkpoint 10000            # sweeps between checkpoints
+ *      refine 4 0.005              # up to 4 adaptive passes, down to a spacing of 0.005
+ *      bootstrap 1000              # resamples of the Binder crossings
+ *      entropy simpson             # write S(T), integrated with trapezoid, simpson or cubic
+ *      decompose                   # sweep one lattice with all threads (3D models, even L)
+ *      order hilbert               # store the sites in row_major, morton or hilbert order
+ *      visit sequential            # random, sequential, blocks or prefetch (see site_order.h)
+ *      wang_landau 4 4.0           # density of states in 4 windows, bins of width 4 (Ising)
+ *      reweight multi              # reweight the --series file, single or multi histogram
+ *      muca 2.0 3.0 40 20          # multicanonical over [2, 3], 40 bins, 20 learning iterations
+ *      end
+ *
+ * T lines add to the grid, which is sorted and cleared of duplicates, so dense regions can be
+ * added to a coarse grid. Every (delta) of a job is written to "<name>_d<delta>.bin" with the
+ * columns T, and E, C, M, chi and binder of every L (see result_file.h). The Binder crossings of
+ * consecutive L (see crossing.h) are stored as the parameters T_c_L<a>_L<b>, T_c_err_L<a>_L<b>
+ * and T_c_boot_L<a>_L<b>, the errors bootstrapped over the realizations. With "entropy" the
+ * columns S and S_err of every L follow (see entropy.h); S_err propagates the standard error of E
+ * over the realizations, so it is 0 for clean runs.
+ *
+ * An adaptive job ("refine") treats the grid as a coarse start. After each pass it adds the
+ * midpoints of the intervals where the Binder ratios cross or C and chi peak (see refine.h)
+ * and writes the merged grid. The scheduler does not run adaptive jobs.
+ *
+ * A "decompose" job runs its temperatures and realizations one after another, each on a single
+ * lattice split into slabs over all threads (see model3.h), for sizes too large to run one
+ * lattice per thread. These runs are not checkpointed and not scheduled.
+ *
+ * A "wang_landau" job estimates the density of states of every L and realization instead (see
+ * wang_landau.h), with the given number of windows and bin width, both optional. Its result file
+ * holds the columns T, and F, E, S and C of every L, per site and averaged over the realizations.
+ * It needs an Ising model with delta < 2 and is neither refined, decomposed nor scheduled.
+ *
+ * A "reweight" job runs no simulation. It reads the time series file given by --series (see
+ * time_series.h) and reweights the series of every realization to its grid (see reweight.h). The
+ * series do not record the lattice, so the job names the model, its single L and delta as they
+ * were simulated, and the file should hold the series of that run only. Its result file holds
+ * the columns T, and E, C, chi and binder of the L, averaged over the realizations. A job file can
+ * simulate and reweight in one run: the series file is only opened for writing by the first job
+ * which simulates and is complete once a reweight job reads it.
+ *
+ * A "muca" job learns a multicanonical weight covering [T_lo, T_hi] for every L and realization
+ * (see muca.h) and reweights one production run to every temperature of its grid, which must lie
+ * within [T_lo, T_hi]. The canonical runs at both ends and each of the n_iter learning iterations
+ * take warmup sweeps, the production run warmup and measure sweeps. With a seed the exchange
+ * table and the sweeps of realization r are drawn from seed_seq{seed, r, 0} and
+ * seed_seq{seed, r, 1}. Its result file holds the columns T, and E, C, chi and binder of every L,
+ * averaged over the realizations. It is neither refined, decomposed nor scheduled.
+ *
+ * "order" stores the sites of every lattice along a space filling curve (see site_order.h), for
+ * lattices too large for the caches. It changes where the sites live in memory, not the model.
+ * "visit" sets the order the Metropolis sweeps visit the sites in; every order samples the same
+ * distribution (see site_order.h).
+ */
+
+
+/* enum : Method
+ * How a job finds the thermodynamics of its grid.
+ */
+enum class Method
+{
+    metropolis,
+    wang_landau,
+    reweight,
+    muca
+};
+
+
+/* struct : Job
+ * One job of a job file.
+ */
+struct Job
+{
+    std::string name;
+    std::string model;
+    int q = 6;
+    std::vector<int> L;
+    std::vector<double> T;
+    std::vector<double> delta = {0.0};
+    int n_run = 1;
+    size_t warmup = 30000;
+    size_t measure = 50000;
+    size_t overrelax = 0;
+    unsigned seed = 0;
+    size_t ckpt_every = 10000;
+    size_t refine = 0;              // Adaptive refinement passes
+    double dT_min = 0.0;            // Smallest spacing the refinement splits
+    size_t n_boot = 1000;           // Bootstrap resamples of the Binder crossings
+    bool entropy = false;           // Write S(T)
+    Quadrature quadrature = Quadrature::trapezoid;
+    bool decompose = false;         // Split each lattice over all threads
+    Site_order order = Site_order::row_major;
+    Visit visit = Visit::random;
+    Method method = Method::metropolis;
+    size_t n_window = 4;            // Wang-Landau windows
+    double wl_width = 4.0;          // Wang-Landau bin width
+    bool rw_multi = true;           // Multiple histogram reweighting, else single histogram
+    double muca_lo = 0.0;           // Temperature range of the multicanonical weight
+    double muca_hi = 0.0;
+    size_t muca_bins = 0;           // Energy bins of the multicanonical weight
+    size_t muca_iter = 0;           // Learning iterations of the multicanonical weight
+};
+
+
+/* class : Job_reader
+ * Reads jobs one at a time, so jobs piped into a running binary start as soon as their "end"
+ * line arrives.
+ */
+class Job_reader
+{
+    private:
+        std::istream &is;
+        std::string pending;            // "job" line read while finishing the previous job
+        size_t line_no;
+
+        void check(const Job &job) const;
+
+    public:
+        Job_reader(std::istream &In);
+        bool next(Job &job);
+};
+
+
+std::vector<double> linear_grid(double lo, double hi, size_t n);
+std::vector<double> log_grid(double lo, double hi, size_t n);
+std::string job_tag(const Job &job, double delta);
+void write_job_result(const Job &job, double delta,
+        const std::vector<std::vector<Observables>> &obs,
+        const std::vector<Crossing> &cross = std::vector<Crossing>(),
+        const std::vector<std::vector<double>> &E_err = std::vector<std::vector<double>>());
+void write_job_result(const Job &job, double delta, const std::vector<std::vector<Wl_point>> &wl);
+void write_job_result(const Job &job, double delta, const std::vector<std::vector<Rw_point>> &rw,
+        size_t n_run);
+void write_realizations(const Job &job, double delta,
+        const std::vector<std::vector<Observables>> &obs,
+        const std::vector<std::vector<std::vector<Observables>>> &runs);
+void run_job(const Job &job, bool restart, Time_series *ts);
+void reweight_job(const Job &job, const std::string &series_file);
+
+#endif
@@ -4,13 +4,37 @@
 
 #include <vector>
 #include <random>
+#include <iostream>
+#include <algorithm>
+#include <type_traits>
 #include "neighbor.h"
+#include "site_order.h"
 #include "exchange.h"
+#include "checkpoint.h"
+#include "time_series.h"
+#include "muca.h"
+#include "observables.h"
+#include "instrument.h"
+#include "progress.h"
 
 
 /* Base class for 2D Classical spin models.
+ * Runs the warmup and measurement sweeps. The models provide a single sweep of the lattice and
+ * the energy and magnetization of the current configuration. The progress of the sweeps is kept
+ * in the model so a run can be checkpointed and resumed at any sweep.
+ *
+ * For multicanonical runs the models also provide single site proposals (propose() returns the
+ * energy change and accept() applies the last proposal), which learn_muca() and sweep_muca() of
+ * muca.h accept with the multicanonical weight instead of the Boltzmann weight. Multicanonical
+ * runs are not checkpointed.
+ *
+ * The sites can be stored along a space filling curve instead of in row major order for better
+ * locality on large lattices (set_site_order(), see site_order.h). The exchange table is drawn in
+ * row major order, so a seed gives the same disorder realization in every order.
+ * The sweeps visit the sites at random, in order or in shuffled blocks, or draw random sites
+ * ahead and prefetch them (set_visit()).
  */
-class Model2
+class Model2 : public Muca_lattice
 {
     protected:
         size_t warmup  = 30000;
@@ -21,17 +45,127 @@ class Model2
         std::uniform_real_distribution<float> rand0;
         std::vector<Neighbor<2>> neigh;
         std::vector<Exchange<2>> J;
+        Site_order order = Site_order::row_major;
+        std::vector<size_t> index;              // Stored site of every row major index
+        Visit visit = Visit::random;
+        std::vector<size_t> block;              // Blocks of a sweep in visiting order
+        std::vector<size_t> ahead;              // Sites of the next updates (Visit::prefetch)
+        static const size_t n_ahead = 16;
+        Sweep_state state;
+        size_t checkpoint_every;
+        Checkpoint_hook checkpoint;
+        Time_series *ts;
+        int ts_chan;
+        std::uint32_t ts_id;
+        Counters counters;
+        size_t progress_mark = 0;               // Sweep of the last progress report
+
+        virtual void sweep_lattice(float beta, std::mt19937 &engine) = 0;
+        virtual void tune_lattice(size_t n_sweep);
+        virtual double energy() const = 0;
+        virtual double magnetization2() const = 0;
+        virtual double propose(size_t pos, std::mt19937 &engine) = 0;
+        virtual void accept(size_t pos) = 0;
+        size_t stored_site(size_t r) const;
+        void prefetch_neighbors(size_t pos) const;
+        size_t upcoming_site(size_t i) const;
+        void warmup_lattice(float beta, std::mt19937 &engine);
+        void push_series(double E, double M2);
+        void end_sweep(const std::mt19937 &engine);
+
+        /* visit_site()
+         * Returns the site of update i of a sweep in the visiting order V (see site_order.h).
+         * The blocks are shuffled, and the first sites to prefetch drawn, at the first update of
+         * every sweep. V is a template parameter so the random order is the plain draw.
+         */
+        template <Visit V>
+        size_t visit_site(size_t i, std::mt19937 &engine)
+        {
+            if (V == Visit::sequential)
+                return i;
+
+            if (V == Visit::blocks) {
+                const size_t n_row = size / block.size();
+                if (i == 0)
+                    std::shuffle(block.begin(), block.end(), engine);
+                return block[i / n_row] * n_row + i % n_row;
+            }
+
+            if (V == Visit::prefetch) {
+                if (i == 0) {
+                    for (size_t k = 0; k < n_ahead && k < size; k++) {
+                        ahead[k] = static_cast<size_t>(rand0(engine) * size);
+                        prefetch_neighbors(ahead[k]);
+                    }
+                }
+
+                const size_t pos = ahead[i % n_ahead];
+                if (i + n_ahead < size) {
+                    ahead[i % n_ahead] = static_cast<size_t>(rand0(engine) * size);
+                    prefetch_neighbors(ahead[i % n_ahead]);
+                }
+                return pos;
+            }
+
+            return static_cast<size_t>(rand0(engine) * size);
+        }
+
+        /* dispatch_visit()
+         * Calls f with std::integral_constant<Visit, visit>. The sweeps instantiate their loop for
+         * each visiting order through it, so the order is picked once per sweep.
+         */
+        template <typename F>
+        void dispatch_visit(F f) const
+        {
+            switch (visit) {
+                case Visit::sequential:
+                    f(std::integral_constant<Visit, Visit::sequential>());
+                    break;
+                case Visit::blocks:
+                    f(std::integral_constant<Visit, Visit::blocks>());
+                    break;
+                case Visit::prefetch:
+                    f(std::integral_constant<Visit, Visit::prefetch>());
+                    break;
+                default:
+                    f(std::integral_constant<Visit, Visit::random>());
+            }
+        }
 
     public:
         Model2();
         Model2(const int L);
         Model2(const Model2 &rhs);
-        virtual void set_spin() = 0;
-        virtual double sweep_energy(double beta, std::mt19937 &engine) = 0;
-        virtual double sweep_binder(double beta, std::mt19937 &engine) = 0;
+        virtual ~Model2() = default;
+        void set_spin();
+        virtual void set_spin(std::mt19937 &engine) = 0;
+        double sweep_energy(double beta, std::mt19937 &engine);
+        double sweep_binder(double beta, std::mt19937 &engine);
+        Observables sweep_observables(double beta, std::mt19937 &engine);
+        Muca_weight learn_muca(double T_lo, double T_hi, size_t n_bin, size_t n_iter,
+                size_t n_sweep, std::mt19937 &engine);
+        Muca_sample sweep_muca(const Muca_weight &W, std::mt19937 &engine);
+        int get_length() const;
+        const void* get_lattice() const;
+        const Counters& get_counters() const;
+        void reset_counters();
         void set_exchange(double delta);
+        void set_exchange(double delta, std::mt19937 &engine);
         std::vector<Exchange<2>> get_exchange() const;
+        std::vector<Neighbor<2>> get_neighbors() const;
+        Site_order get_site_order() const;
+        Visit get_visit() const;
+        size_t get_warmup() const;
+        size_t get_measure() const;
+        size_t get_size() const;
+        double get_energy() const;
         void set_run_param(size_t Warmup, size_t Measure);
+        void set_site_order(Site_order Order);
+        void set_visit(Visit Visit_mode);
+        void set_checkpoint(size_t every, const Checkpoint_hook &hook);
+        void set_time_series(Time_series *series, int chan, double beta, int run, int idx);
+        virtual void save(std::ostream &os) const;
+        virtual void load(std::istream &is);
 };
 
 #endif
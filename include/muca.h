@@ -0,0 +1,84 @@
+#ifndef MUCA_H
+#define MUCA_H
+
+
+#include <cstddef>
+#include <vector>
+#include <random>
+
+#include "reweight.h"
+
+
+/* class : Muca_weight
+ * Multicanonical weight ln W(E) of the total energy. Between the centers of the first and last
+ * bin of [E_lo, E_hi], ln W is piecewise linear with one slope per pair of neighboring bins. Below
+ * and above, it continues as the canonical weight of beta_lo and beta_hi, so the walker samples
+ * the energies of every temperature in [T_lo, T_hi] with roughly the same probability.
+ *
+ * The slopes start as -beta_hi (a canonical run at T_hi) and are refined from the histogram of
+ * each iteration with Berg's accumulated recursion: the correction of a slope is weighted by the
+ * statistics of the two bins it joins relative to all earlier iterations, so poorly sampled
+ * iterations do not undo the earlier ones. The slopes are kept in [-beta_lo, -beta_hi].
+ */
+class Muca_weight
+{
+    private:
+        double E_lo, E_hi, width;
+        double beta_lo, beta_hi;
+        std::vector<double> slope;          // Slope between the centers of bin k and k + 1
+        std::vector<double> g_acc;          // Accumulated statistics of each slope
+        std::vector<double> ln_w;           // ln W at the center of every bin
+
+        void set_ln_w();
+
+    public:
+        Muca_weight() = default;
+        Muca_weight(double E_Lo, double E_Hi, size_t n_bin, double Beta_lo, double Beta_hi);
+        double operator()(double E) const;
+        size_t bin(double E) const;
+        size_t get_bins() const;
+        double get_lo() const;
+        double get_hi() const;
+        void update(const std::vector<size_t> &hist);
+};
+
+
+/* struct : Muca_sample
+ * Samples of a multicanonical production run. ln_w holds ln W of every sample, which is removed
+ * again when reweighting to a temperature.
+ */
+struct Muca_sample
+{
+    std::vector<double> E, M, M2, ln_w;
+    size_t n_tunnel;                        // Number of trips between E_lo and E_hi
+};
+
+
+/* class : Muca_lattice
+ * What a multicanonical run needs of a model: canonical sweeps to find the energy range, single
+ * site proposals (propose() returns the energy change and accept() applies the last proposal)
+ * and the energy and M^2 of the current configuration. Model2 and Model3 implement it, so
+ * learn_muca() and sweep_muca() run the same code on every lattice.
+ */
+class Muca_lattice
+{
+    public:
+        virtual ~Muca_lattice() = default;
+        virtual size_t get_size() const = 0;
+        virtual void sweep_lattice(float beta, std::mt19937 &engine) = 0;
+        virtual void tune_lattice(size_t n_sweep) = 0;
+        virtual double energy() const = 0;
+        virtual double magnetization2() const = 0;
+        virtual double propose(size_t pos, std::mt19937 &engine) = 0;
+        virtual void accept(size_t pos) = 0;
+};
+
+
+Muca_weight learn_muca(Muca_lattice &lattice, double T_lo, double T_hi, size_t n_bin,
+        size_t n_iter, size_t n_sweep, std::mt19937 &engine);
+Muca_sample sweep_muca(Muca_lattice &lattice, const Muca_weight &W, size_t warmup,
+        size_t measure, std::mt19937 &engine);
+std::vector<Rw_point> muca_reweight(const Muca_sample &sample, size_t n_site,
+        const std::vector<double> &T);
+
+#endif
@@ -3,6 +3,7 @@
 
 
 #include <array>
+#include <vector>
 
 /* struct : Neighbor
  * Provides neighboring indeces to a lattice site. Uses template to determine the dimension of the
@@ -67,6 +68,17 @@ struct Neighbor
             } // Set 3D layer (if needed)
         } // Set 2D layer
     }
+
+    /* Sets the neighbors of the site with row major index pos on a lattice stored in another
+     * order, where index maps row major indices to stored sites (see site_order.h).
+     */
+    void set_neighbors(int pos, int L, const std::vector<std::size_t> &index)
+    {
+        set_neighbors(pos, L);
+
+        for (auto &&ele : neighbor)
+            ele = static_cast<int>(index[ele]);
+    }
 };
 
 #endif
@@ -0,0 +1,59 @@
+#ifndef OBSERVABLES_H
+#define OBSERVABLES_H
+
+
+#include <cstddef>
+
+
+/* struct : Observables
+ * Every observable of one temperature, measured in a single run. E, M (= <|M|>), C and chi are
+ * per site. C and chi come from the fluctuations of E and |M| of the same run. Disorder averages
+ * average every field over the realizations.
+ */
+struct Observables
+{
+    static const std::size_t n_value = 5;   // Number of fields, and of accumulated moments
+
+    double E;
+    double C;
+    double M;
+    double chi;
+    double binder;
+
+    Observables& operator+=(const Observables &rhs)
+    {
+        E += rhs.E; C += rhs.C; M += rhs.M; chi += rhs.chi; binder += rhs.binder;
+        return *this;
+    }
+
+    Observables& operator/=(double rhs)
+    {
+        E /= rhs; C /= rhs; M /= rhs; chi /= rhs; binder /= rhs;
+        return *this;
+    }
+};
+
+
+/* make_observables()
+ * Computes the observables from the sums of E, E^2, |M|, M^2 and M^4 over n_sample measurement
+ * sweeps of a lattice of n_site sites.
+ */
+inline Observables make_observables(double beta, std::size_t n_site, std::size_t n_sample,
+        const double *sum)
+{
+    const double n  = static_cast<double>(n_sample);
+    const double N  = static_cast<double>(n_site);
+    const double E  = sum[0] / n, E2 = sum[1] / n;
+    const double M  = sum[2] / n, M2 = sum[3] / n, M4 = sum[4] / n;
+
+    Observables obs;
+    obs.E      = E / N;
+    obs.C      = beta * beta * (E2 - E * E) / N;
+    obs.M      = M / N;
+    obs.chi    = beta * (M2 - M * M) / N;
+    obs.binder = 1.0 - (M4 / (3.0 * M2 * M2));
+
+    return obs;
+}
+
+#endif
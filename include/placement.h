@@ -0,0 +1,43 @@
+#ifndef PLACEMENT_H
+#define PLACEMENT_H
+
+
+#include <string>
+#include <ostream>
+
+
+/* Thread and replica placement
+ *
+ * On machines with several NUMA nodes a page lives on the node of the thread that first touches
+ * it. The sweeps are bound by the bandwidth to the spin, neighbor and exchange arrays, so each
+ * replica should live on the node of the thread that sweeps it, and that thread should not move.
+ *
+ * set_pinning() reads the CPUs the process may run on and their nodes (from /sys), and
+ * pin_thread() binds the calling OpenMP thread to one of them: thread t gets the t-th CPU of the
+ * order, wrapping around when there are more threads than CPUs.
+ *      compact     fill the CPUs of node 0 first, then node 1, ...
+ *      spread      one CPU of each node in turn, which spreads few threads over all nodes
+ *      none        do not pin, only report the placement
+ * The threads pin themselves before they copy or build their replicas (run_mc(), the scheduler),
+ * so the replicas are first touched, and allocated, on the node they are swept on.
+ *
+ * note_placement() records the CPU and node of the calling thread and the node holding a replica,
+ * and write_placement() reports them per thread along with the replicas that ended up on another
+ * node. The node of a page is looked up with move_pages(2); where that is not available it is -1.
+ */
+enum class Pin
+{
+    off,
+    none,
+    compact,
+    spread
+};
+
+
+bool parse_pin(const std::string &name, Pin &mode);
+void set_pinning(Pin mode);
+void pin_thread();
+void note_placement(const void *replica);
+void write_placement(std::ostream &os);
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef PROGRESS_H
+#define PROGRESS_H
+
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <ostream>
+
+
+/* class : Progress
+ * Live progress of a run. The sweep threads add their sweeps every batch sweeps (see
+ * report_sweeps()) and their finished tasks with relaxed atomic adds, and a reporter thread
+ * prints the progress, the throughput in sweeps/s and site updates/s, the finished tasks and an
+ * ETA every interval seconds. The runs add the work they are about to do to the totals, which
+ * gives the fraction done and the ETA; without totals only the throughput is printed.
+ *
+ * The models find the reporter through Progress::active, which is set while one exists. Without
+ * a reporter a sweep costs one extra test of a null pointer.
+ */
+class Progress
+{
+    private:
+        std::atomic<std::uint64_t> n_sweep, n_update, n_task;
+        std::atomic<std::uint64_t> total_update, total_task;
+        double interval;
+        std::ostream &os;
+        std::chrono::steady_clock::time_point t0;
+        std::mutex mtx;
+        std::condition_variable cv;
+        bool stop;
+        std::thread reporter;
+
+        void report_loop();
+        void report();
+
+    public:
+        static const std::size_t batch = 64;    // Sweeps between reports of a model
+        static Progress *active;
+
+        Progress(double Interval, std::ostream &Os);
+        Progress(const Progress &rhs) = delete;
+        Progress& operator=(const Progress &rhs) = delete;
+        ~Progress();
+
+        void add_total(std::uint64_t updates, std::uint64_t tasks);
+
+        /* add_sweeps()
+         * Adds sweeps of a total of updates site updates.
+         */
+        void add_sweeps(std::uint64_t sweeps, std::uint64_t updates)
+        {
+            n_sweep.fetch_add(sweeps, std::memory_order_relaxed);
+            n_update.fetch_add(updates, std::memory_order_relaxed);
+        }
+
+        /* finish_task()
+         * Counts a finished task.
+         */
+        void finish_task()
+        {
+            n_task.fetch_add(1, std::memory_order_relaxed);
+        }
+};
+
+
+/* report_sweeps()
+ * Called by the models after every sweep n_sweep of a run of n_total sweeps of n_site site
+ * updates. Reports the sweeps since the last report (mark) every Progress::batch sweeps and at
+ * the end of the run.
+ */
+inline void report_sweeps(std::size_t n_sweep, std::size_t n_total, std::size_t n_site,
+        std::size_t &mark)
+{
+    if (Progress::active && (n_sweep % Progress::batch == 0 || n_sweep == n_total)) {
+        Progress::active->add_sweeps(n_sweep - mark, (n_sweep - mark) * n_site);
+        mark = (n_sweep == n_total) ? 0 : n_sweep;
+    }
+}
+
+
+/* report_task()
+ * Called by the runs after every task.
+ */
+inline void report_task()
+{
+    if (Progress::active)
+        Progress::active->finish_task();
+}
+
+#endif
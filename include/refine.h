@@ -0,0 +1,27 @@
+#ifndef REFINE_H
+#define REFINE_H
+
+
+#include <vector>
+
+#include "observables.h"
+
+
+/* Adaptive temperature grids
+ *
+ * A run starts from a coarse grid and adds temperatures where the physics is. refine_points()
+ * flags the intervals of the grid where the Binder ratios of two consecutive L cross, and the
+ * intervals next to the peak of C(T) and chi(T) of every L, and returns their midpoints. Only
+ * intervals wider than dT_min are split, so repeated refinement stops at that resolution.
+ *
+ * In the paramagnet the Binder ratios of all L scatter around zero and cross at random, so a
+ * crossing only counts where the mean ratio of the interval is above binder_floor.
+ */
+const double binder_floor = 0.2;
+
+std::vector<double> refine_points(const std::vector<double> &T,
+        const std::vector<std::vector<Observables>> &obs, double dT_min);
+void merge_grid(std::vector<double> &T, std::vector<std::vector<Observables>> &obs,
+        const std::vector<double> &T_new, const std::vector<std::vector<Observables>> &obs_new);
+
+#endif
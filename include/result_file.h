@@ -0,0 +1,93 @@
+#ifndef RESULT_FILE_H
+#define RESULT_FILE_H
+
+
+#include <cstddef>
+#include <string>
+#include <sstream>
+#include <vector>
+#include <utility>
+
+#include "data_matrix.h"
+
+
+/* Binary result format
+ *
+ * Self describing columnar file for the output of a run. All integers are 64 bit and all values
+ * are stored in the native (little endian) byte order:
+ *
+ *      offset  0   char[8]     magic "DCRES01"
+ *      offset  8   uint64      data_offset, a multiple of 64
+ *      offset 16   uint64      n_row
+ *      offset 24   uint64      n_col
+ *      offset 32   uint64      meta_len
+ *      offset 40   char[]      meta, one entry per line:
+ *                                  "column\t<name>\n" for every column in order
+ *                                  "param\t<key>\t<value>\n" for every run parameter
+ *      data_offset double[]    n_col columns of n_row doubles, one after another
+ *
+ * Each column is a contiguous, aligned array of doubles, so the file can be memory mapped and read
+ * without copies, by Result_file in C++ or from Python with numpy.memmap, or as memoryviews where
+ * numpy is not installed (see script/result_file.py).
+ */
+
+
+/* class : Result_header
+ * Column names and run parameters written with the data.
+ */
+class Result_header
+{
+    private:
+        std::vector<std::string> column;
+        std::vector<std::pair<std::string, std::string>> param;
+
+    public:
+        void add_column(const std::string &name);
+
+        /* set_param()
+         * Adds a run parameter. Numbers are written with enough digits to be read back exactly.
+         */
+        template <typename T>
+        void set_param(const std::string &key, const T &value)
+        {
+            std::ostringstream ss;
+            ss.precision(17);
+            ss << value;
+            param.emplace_back(key, ss.str());
+        }
+
+        const std::vector<std::string>& get_columns() const;
+        const std::vector<std::pair<std::string, std::string>>& get_params() const;
+};
+
+
+void write_result(const std::string &filename, const Data_matrix &data,
+        const Result_header &header);
+
+
+/* class : Result_file
+ * Read only memory mapping of a result file. The columns point directly into the mapping and stay
+ * valid for the lifetime of the object.
+ */
+class Result_file
+{
+    private:
+        void *map;
+        size_t map_len;
+        size_t N_row, N_col;
+        Result_header header;
+
+    public:
+        Result_file(const std::string &filename);
+        Result_file(const Result_file &rhs) = delete;
+        Result_file& operator=(const Result_file &rhs) = delete;
+        ~Result_file();
+        size_t rows() const;
+        size_t cols() const;
+        const double* column(size_t col) const;
+        const double* column(const std::string &name) const;
+        const Result_header& get_header() const;
+        std::string get_param(const std::string &key) const;
+};
+
+#endif
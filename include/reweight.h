@@ -0,0 +1,69 @@
+#ifndef REWEIGHT_H
+#define REWEIGHT_H
+
+
+#include <cstddef>
+#include <vector>
+
+#include "time_series.h"
+
+
+/* struct : Rw_point
+ * Observables at one temperature. E, C and chi are per site.
+ */
+struct Rw_point
+{
+    double T;
+    double E;
+    double C;
+    double chi;
+    double binder;
+};
+
+
+/* class : Reweight
+ * Histogram reweighting of the time series of one disorder realization (or of a clean model).
+ *
+ * Single histogram (Ferrenberg-Swendsen): the samples of the simulation closest in beta are
+ * reweighted with exp(-(beta - beta_k) E).
+ *
+ * Multiple histogram (WHAM): the samples of all simulations are combined. The free energies f_k
+ * of the simulations are found self consistently from
+ *      exp(-f_k) = sum_i exp(-beta_k E_i) / sum_j N_j exp(f_j - beta_j E_i)
+ * and the weight of sample i at beta is exp(-beta E_i) / sum_j N_j exp(f_j - beta_j E_i).
+ *
+ * All sums are done in log space, so any beta can be evaluated without overflow. The samples
+ * should be roughly independent (measured every few sweeps) for the error estimates of WHAM to
+ * hold; the averages are unbiased either way.
+ */
+class Reweight
+{
+    private:
+        size_t n_site;
+        std::vector<double> beta;
+        std::vector<size_t> first;          // Index of the first sample of each simulation
+        std::vector<double> E, M, M2;
+        std::vector<double> f;              // WHAM free energies
+        std::vector<double> log_den;        // log of the WHAM denominator of each sample
+        bool solved;
+
+        void solve(double tol, size_t max_iter);
+        Rw_point average(double T, int k) const;
+
+    public:
+        Reweight(size_t N_site);
+        void add_series(double Beta, const std::vector<double> &E_s,
+                const std::vector<double> &M_s, const std::vector<double> &M2_s);
+        void add_series(const Ts_series &series);
+        Rw_point single(double T) const;
+        Rw_point multi(double T, double tol = 1e-10, size_t max_iter = 10000);
+        std::vector<Rw_point> single(const std::vector<double> &T) const;
+        std::vector<Rw_point> multi(const std::vector<double> &T, double tol = 1e-10,
+                size_t max_iter = 10000);
+};
+
+
+std::vector<Rw_point> reweight_disorder(const std::vector<Ts_series> &series, size_t n_site,
+        const std::vector<double> &T, bool multi);
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "job.h"
+#include "time_series.h"
+
+
+/* struct : Task
+ * One unit of work of the scheduler: n_real realizations of one lattice size at one temperature.
+ * The disordered clock and XY models run Batch<Dim>::n_lane realizations per task, all others
+ * one. The indices point into the jobs.
+ */
+struct Task
+{
+    size_t job, delta, L, T;
+    int run;
+    int n_real;
+    double cost;
+};
+
+
+/* Scheduler
+ *
+ * Expands every (model, L, delta, realization, T) of a list of jobs into one queue of tasks and
+ * runs them on all cores, the most expensive first (longest processing time first), so the
+ * cheap tasks fill the tails instead of every size and model waiting at its own barrier. The
+ * cost of a task is estimated as L^d * (warmup + measure) * model factor * realizations.
+ *
+ * Every task draws its exchange table and spins from the master seed of its job, its L, delta,
+ * realization and temperature, so the result does not depend on the number of threads or the
+ * order of the tasks. A result file is written as soon as the last task of its (job, delta)
+ * finishes. Scheduled runs are not checkpointed; use run_job() for restartable runs.
+ *
+ * Built with USE_MPI (make MPI=1), run_distributed() spreads the same tasks over the ranks of
+ * MPI_COMM_WORLD: rank 0 hands out the tasks, largest first, and reduces the results. On every
+ * other rank the master thread keeps a small local queue of tasks filled as its OpenMP threads
+ * take them, so the threads never wait for each other. Test it on one machine with
+ * "mpirun -np 3 bin/disorder_cooling --job FILE". The instrumentation records of the workers
+ * (see instrument.h) stay on their ranks and are not exported, and rank 0 reports the progress
+ * (see progress.h) one finished task at a time.
+ */
+std::vector<Task> expand_tasks(const std::vector<Job> &jobs);
+double task_cost(const Job &job, int L, int n_real);
+std::uint64_t task_work(const Job &job, const Task &task);
+void add_progress_total(const std::vector<Job> &jobs, const std::vector<Task> &tasks);
+void run_scheduled(std::vector<Job> jobs, Time_series *ts);
+#ifdef USE_MPI
+void run_distributed(std::vector<Job> jobs, Time_series *ts);
+#endif
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef SITE_ORDER_H
+#define SITE_ORDER_H
+
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+
+/* Site orderings
+ *
+ * The lattices store their sites in row major order (x fastest, then y, then z), so the y and z
+ * neighbors of a site are L and L^2 sites away. Once the spins, neighbor and exchange tables no
+ * longer fit in the caches, almost every proposal at a random site misses on those neighbors.
+ * A space filling curve stores sites which are close on the lattice close in memory instead:
+ *      row_major   the default layout
+ *      morton      Z order, the bits of the coordinates interleaved
+ *      hilbert     the Hilbert curve, which unlike Z order never jumps between far apart blocks
+ * For L which is not a power of 2 the curve of the enclosing power of 2 is used and the sites
+ * are numbered in the order the curve visits them.
+ *
+ * The ordering only renames the sites: site_index() maps the row major index of every site to
+ * where it is stored (an empty map is the row major order), and the models build their neighbor
+ * tables through it (see Neighbor::set_neighbors()). The spins and exchange tables are indexed by
+ * the stored site, so the sweeps, energies and the batches built from a model do not change. Only
+ * code which walks the lattice by its coordinates (the exchange tables of the models, the slab
+ * sweeps) looks up the stored site. The batches draw their exchange tables in stored order, so
+ * their realizations depend on the order.
+ */
+enum class Site_order
+{
+    row_major,
+    morton,
+    hilbert
+};
+
+
+/* Visiting orders
+ *
+ * A Metropolis sweep makes size single site updates. Each update leaves the Boltzmann
+ * distribution unchanged whichever site it picks, so the sites need not be drawn at random; a
+ * fixed order satisfies balance (though not detailed balance) and samples the same distribution:
+ *      random      every update draws its site (the default)
+ *      sequential  the stored sites in order, which saves a random number per update and reads
+ *                  the spin, neighbor and exchange tables as streams the hardware prefetches
+ *      blocks      the blocks of L consecutive stored sites in an order shuffled every sweep,
+ *                  each block in order
+ *      prefetch    random sites like random, drawn n_ahead updates ahead so the memory of a site
+ *                  is prefetched while the updates before it run
+ * The orders visit the stored sites, so combined with a space filling curve (see above) the
+ * sequential sweep walks the lattice along the curve. A fixed order correlates consecutive
+ * sweeps differently, so autocorrelation times differ between the orders. The multicanonical
+ * sweeps always draw their sites.
+ *
+ * On lattices far larger than the caches every random update waits on memory for the neighbor
+ * entry of its site, then again for the spins of its neighbors. prefetch keeps the sites of the
+ * next n_ahead updates: the neighbor entry of a site is prefetched when it is drawn, and the
+ * sweeps which support it (the disordered Ising3 and Clock3 sweeps) prefetch the spins of the
+ * site and its neighbors halfway to its update, once the neighbor entry has arrived, so the
+ * misses of many updates overlap. Prefetching the exchange entries as well made the sweeps
+ * slower in tests, so they are loaded on demand. The sites are drawn from the same engine as the
+ * proposals but earlier, so the chain differs from the one of random but samples the same
+ * distribution. The batches draw all the sites of a sweep ahead anyway and treat it as random.
+ */
+enum class Visit
+{
+    random,
+    sequential,
+    blocks,
+    prefetch
+};
+
+
+bool parse_site_order(const std::string &name, Site_order &order);
+std::string site_order_name(Site_order order);
+std::vector<std::size_t> site_index(int L, std::size_t dim, Site_order order);
+bool parse_visit(const std::string &name, Visit &visit);
+std::string visit_name(Visit visit);
+
+#endif
@@ -0,0 +1,113 @@
+#ifndef TIME_SERIES_H
+#define TIME_SERIES_H
+
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <thread>
+
+
+/* struct : Ts_record
+ * One record of a time series file. A series is opened by a record with sweep == Ts_record::begin
+ * holding the inverse temperature, the disorder realization and the temperature index in v.
+ * Every following record of the series holds the energy, |M| and M^2 of one measurement sweep,
+ * except records with sweep == Ts_record::dropped, which hold in v[0] the number of samples of
+ * the series dropped since its last record because the writer could not keep up.
+ */
+struct Ts_record
+{
+    static const std::uint32_t begin   = 0xffffffff;
+    static const std::uint32_t dropped = 0xfffffffe;
+
+    std::uint32_t series;
+    std::uint32_t sweep;
+    double v[3];
+};
+
+
+/* struct : Ts_series
+ * A series read back from a time series file.
+ */
+struct Ts_series
+{
+    std::uint32_t id;
+    double beta;
+    int run;
+    int idx;
+    std::size_t n_dropped = 0;          // Samples lost to a full channel
+    std::vector<double> E, M, M2;
+};
+
+
+/* class : Ts_channel
+ * Lock-free single producer, single consumer ring buffer of records. The ring is only full when
+ * the disk can not keep up. The producer (a sweep thread) then drops the samples it offers and
+ * counts them, and the count goes into the ring as a Ts_record::dropped record ahead of the next
+ * sample which fits. Only the records opening a series wait for room.
+ */
+class Ts_channel
+{
+    private:
+        std::vector<Ts_record> ring;
+        std::size_t mask;
+        std::atomic<std::size_t> head;      // Next record to read
+        char pad[64];                       // Keeps head and tail on separate cache lines
+        std::atomic<std::size_t> tail;      // Next record to write
+        std::uint32_t drop_series;          // Series of the pending drops
+        std::size_t n_drop;                 // Dropped samples not in the ring yet
+        std::size_t n_lost;                 // Dropped samples in total
+
+        bool try_push(const Ts_record &rec);
+        Ts_record drop_record() const;
+
+    public:
+        Ts_channel(std::size_t n_record);
+        void push(const Ts_record &rec);
+        bool offer(const Ts_record &rec);
+        std::size_t pop(Ts_record *out, std::size_t n_max);
+        bool take_drops(Ts_record &rec);
+        std::size_t get_lost() const;
+};
+
+
+/* class : Time_series
+ * Streams the per sweep observables of a run to a binary file. Each sweep thread pushes its
+ * records into its own channel and a background thread moves them to the file, so the sweeps
+ * never wait on I/O. Samples which find their channel full are dropped and counted in the file
+ * (see Ts_channel), and the total is reported when the file is closed. The file starts with the
+ * magic "DCTS01" and the record size, followed by Ts_record structs in native byte order (see
+ * script/time_series.py).
+ *
+ * Series ids are unique within a file. The time series is not part of a checkpoint, so a
+ * restarted run starts new series for the temperatures it resumes.
+ */
+class Time_series
+{
+    private:
+        std::FILE *file;
+        std::vector<std::unique_ptr<Ts_channel>> channel;
+        std::atomic<std::uint32_t> n_series;
+        std::atomic<bool> stop;
+        std::thread writer;
+
+        void write_loop();
+
+    public:
+        Time_series(const std::string &filename, std::size_t n_channel = 8,
+                std::size_t n_record = 1 << 16);
+        Time_series(const Time_series &rhs) = delete;
+        Time_series& operator=(const Time_series &rhs) = delete;
+        ~Time_series();
+        std::uint32_t begin_series(int chan, double beta, int run, int idx, int n = 1);
+        void push(int chan, std::uint32_t series, std::size_t sweep, double E, double M2);
+};
+
+
+std::vector<Ts_series> read_time_series(const std::string &filename);
+
+#endif
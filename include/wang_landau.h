@@ -0,0 +1,575 @@
+#ifndef WANG_LANDAU_H
+#define WANG_LANDAU_H
+
+
+#include <cstddef>
+#include <cstdlib>
+#include <cmath>
+#include <iostream>
+#include <vector>
+#include <random>
+#include <limits>
+#include <algorithm>
+
+
+/* struct : Wl_point
+ * Thermodynamics at one temperature from the density of states. All values are per site.
+ */
+struct Wl_point
+{
+    double T;
+    double F;
+    double E;
+    double S;
+    double C;
+};
+
+
+/* class : Wang_landau
+ * Wang-Landau estimate of the density of states g(E) of an Ising2 or Ising3 model, clean or with
+ * the exchange table of the model. The energy range [E_min, -E_min], where E_min is the energy of
+ * the ferromagnetic ground state, is split into bins of the given width and into n_window
+ * overlapping windows. Each window runs its own walker on its own thread.
+ *
+ * Every round, each walker performs exchange_every sweeps. Then neighboring windows try a replica
+ * exchange of their configurations, which lets the walkers leave the regions where they got
+ * stuck. The modification factor ln_f is halved whenever the histogram of a window is flat, until
+ * it drops below 1/t (t is the number of moves per visited bin). From then on ln_f = 1/t, which
+ * avoids the saturation of the error of the plain Wang-Landau algorithm. A window is done when
+ * ln_f < ln_f_final.
+ *
+ * The windows are joined where the slopes of their ln g agree best, and ln g is normalized so the
+ * total number of states is 2^N. Only bins that were visited take part, so bins of energies that
+ * can not occur (like E_min + 4 in the clean model) are ignored. Neighboring windows must share
+ * visited bins.
+ *
+ * With disorder the energies of a bin spread over its width. In the 1/t stage the walkers sample
+ * the states of a bin uniformly, so they record how the states of every bin spread over n_sub
+ * slices of it and their mean E and E^2 in every slice. The thermodynamics sum over the slices,
+ * each holding its share of g of the bin at its mean energy, in place of the bin centers. In the
+ * clean model every bin holds a single energy and this is exact.
+ *
+ * Requires ferromagnetic bonds (delta < 2). As with batch.h, the implementation is in the header.
+ */
+template <typename Model>
+class Wang_landau
+{
+    private:
+        struct Window
+        {
+            size_t m;                   // Index of the configuration in models
+            size_t lo, hi;              // Bins covered by the window
+            double E;
+            double ln_f;
+            double n_move;
+            bool one_over_t;
+            bool done;
+            std::mt19937 engine;
+            std::vector<double> ln_g;
+            std::vector<size_t> hist;
+            std::vector<char> visited;
+            std::vector<double> e_sum, e2_sum, e_n;     // Samples of the slices in the 1/t stage
+        };
+
+        struct Level
+        {
+            double ln_g, E, E2;         // Slice of a bin: its ln g and mean E and E^2
+        };
+
+        static const size_t n_sub = 16; // Slices of a bin
+
+        size_t n_site;
+        double E_min, width;
+        size_t n_bin;
+        double flat, ln_f_final;
+        size_t exchange_every;
+        size_t n_exchange, n_swap;
+        std::uniform_real_distribution<double> rand0;
+        std::vector<Model> models;
+        std::vector<Window> win;
+        std::vector<double> ln_g;
+        std::vector<char> visited;
+        std::vector<double> E_bin;                  // Mean E of every bin
+        std::vector<Level> level;
+
+        /* bin()
+         * Returns the bin of an energy. Bins are centered on E_min + b * width.
+         */
+        size_t bin(double E) const
+        {
+            return static_cast<size_t>(floor((E - E_min) / width + 0.5));
+        }
+
+        /* in_window()
+         * Checks if an energy lies in a window.
+         */
+        bool in_window(const Window &w, double E) const
+        {
+            return E > E_min - 0.5 * width && bin(E) >= w.lo && bin(E) <= w.hi;
+        }
+
+        /* n_visited()
+         * Returns the number of visited bins of a window.
+         */
+        size_t n_visited(const Window &w) const
+        {
+            return std::count(w.visited.begin(), w.visited.end(), 1);
+        }
+
+        /* enter_window()
+         * Moves the walker from the ground state into its window, accepting only flips which do
+         * not move it away from the window.
+         */
+        void enter_window(Window &w)
+        {
+            Model &model = models[w.m];
+            const double target = E_min + width * static_cast<double>(w.lo + w.hi) / 2.0;
+
+            while (!in_window(w, w.E)) {
+                size_t pos = static_cast<size_t>(rand0(w.engine) * n_site);
+                double E_new = w.E + model.flip_energy(pos);
+
+                if (fabs(E_new - target) <= fabs(w.E - target)) {
+                    model.flip(pos);
+                    w.E = E_new;
+                }
+            }
+        }
+
+        /* sweep()
+         * Performs n_site Wang-Landau moves and updates ln g and the histogram after each move. In
+         * the 1/t stage it also samples the energies of the bins.
+         */
+        void sweep(Window &w)
+        {
+            Model &model       = models[w.m];
+            double E           = w.E;   // Kept local, the windows share cache lines
+            const bool sample  = w.one_over_t;
+
+            for (size_t i = 0; i < n_site; i++) {
+                size_t pos   = static_cast<size_t>(rand0(w.engine) * n_site);
+                double E_new = E + model.flip_energy(pos);
+
+                if (in_window(w, E_new)) {
+                    double d_ln_g = w.ln_g[bin(E) - w.lo] - w.ln_g[bin(E_new) - w.lo];
+                    if (d_ln_g >= 0.0 || rand0(w.engine) < exp(d_ln_g)) {
+                        model.flip(pos);
+                        E = E_new;
+                    }
+                } // Reject moves leaving the window
+
+                size_t b = bin(E) - w.lo;
+                w.ln_g[b] += w.ln_f;
+                w.hist[b]++;
+                w.visited[b] = 1;
+                if (sample) {
+                    const double u = (E - E_min) / width + 0.5 - static_cast<double>(b + w.lo);
+                    const size_t k = b * n_sub + std::min(n_sub - 1,
+                                     static_cast<size_t>(std::max(0.0, u * n_sub)));
+                    w.e_sum[k]  += E;
+                    w.e2_sum[k] += E * E;
+                    w.e_n[k]    += 1.0;
+                }
+            } // Loop over moves
+
+            w.E       = E;
+            w.n_move += static_cast<double>(n_site);
+            if (w.one_over_t)
+                w.ln_f = static_cast<double>(n_visited(w)) / w.n_move;
+        }
+
+        /* is_flat()
+         * Checks if every visited bin of a window has at least flat times the mean count.
+         */
+        bool is_flat(const Window &w) const
+        {
+            size_t n = 0, h_min = std::numeric_limits<size_t>::max();
+            double h_sum = 0.0;
+
+            for (size_t b = 0; b < w.hist.size(); b++) {
+                if (w.visited[b]) {
+                    n++;
+                    h_sum += static_cast<double>(w.hist[b]);
+                    h_min  = std::min(h_min, w.hist[b]);
+                }
+            }
+
+            return n > 0 && static_cast<double>(h_min) >= flat * h_sum / static_cast<double>(n);
+        }
+
+        /* update_window()
+         * Refines ln_f at the end of a round.
+         */
+        void update_window(Window &w)
+        {
+            const double inv_t = static_cast<double>(n_visited(w)) / w.n_move;
+
+            if (!w.one_over_t && is_flat(w)) {
+                w.ln_f /= 2.0;
+                std::fill(w.hist.begin(), w.hist.end(), 0);
+            } // Plain Wang-Landau stage
+
+            if (!w.one_over_t && w.ln_f < inv_t) {
+                w.one_over_t = true;
+                w.ln_f       = inv_t;
+            }
+
+            w.done = w.ln_f < ln_f_final;
+        }
+
+        /* exchange()
+         * Tries to swap the configurations of windows i and i + 1.
+         */
+        void exchange(size_t i, std::mt19937 &engine)
+        {
+            Window &a = win[i], &b = win[i + 1];
+
+            if (a.done || b.done || !in_window(a, b.E) || !in_window(b, a.E))
+                return;
+
+            n_exchange++;
+            double ln_p = a.ln_g[bin(a.E) - a.lo] - a.ln_g[bin(b.E) - a.lo] +
+                          b.ln_g[bin(b.E) - b.lo] - b.ln_g[bin(a.E) - b.lo];
+
+            if (ln_p >= 0.0 || rand0(engine) < exp(ln_p)) {
+                std::swap(a.m, b.m);
+                std::swap(a.E, b.E);
+                n_swap++;
+            }
+        }
+
+        /* merge()
+         * Joins the windows into ln_g and normalizes it, and pools the energy samples of the
+         * windows into the slices of every visited bin. A bin without samples is a single slice
+         * at its center.
+         */
+        void merge()
+        {
+            ln_g.assign(n_bin, 0.0);
+            visited.assign(n_bin, 0);
+
+            double shift = 0.0;
+            size_t start = 0;
+
+            for (size_t i = 0; i < win.size(); i++) {
+                const Window &w = win[i];
+                size_t join     = w.hi;
+
+                if (i + 1 < win.size()) {
+                    const Window &n = win[i + 1];
+                    double best     = std::numeric_limits<double>::infinity();
+
+                    for (size_t b = n.lo; b < w.hi; b++) {
+                        if (!w.visited[b - w.lo] || !w.visited[b + 1 - w.lo] ||
+                                !n.visited[b - n.lo] || !n.visited[b + 1 - n.lo])
+                            continue;
+
+                        double diff = fabs((w.ln_g[b + 1 - w.lo] - w.ln_g[b - w.lo]) -
+                                           (n.ln_g[b + 1 - n.lo] - n.ln_g[b - n.lo]));
+                        if (diff < best) {
+                            best = diff;
+                            join = b;
+                        }
+                    } // Find the bin where the slopes agree best
+
+                    if (std::isinf(best)) {
+                        std::cerr << "Error: Wang-Landau windows " << i << " and " << i + 1
+                                  << " share no visited bins. Use fewer windows or a wider bin."
+                                  << std::endl;
+                        exit(EXIT_FAILURE);
+                    }
+                }
+
+                for (size_t b = start; b <= join; b++) {
+                    ln_g[b]    = w.ln_g[b - w.lo] + shift;
+                    visited[b] = w.visited[b - w.lo];
+                }
+
+                if (i + 1 < win.size()) {
+                    const Window &n = win[i + 1];
+                    shift = ln_g[join] - n.ln_g[join - n.lo];
+                    start = join + 1;
+                }
+            } // Loop over windows
+
+            // Normalize to 2^N states
+            double a_max = -std::numeric_limits<double>::infinity();
+            for (size_t b = 0; b < n_bin; b++)
+                if (visited[b])
+                    a_max = std::max(a_max, ln_g[b]);
+
+            double sum = 0.0;
+            for (size_t b = 0; b < n_bin; b++)
+                if (visited[b])
+                    sum += exp(ln_g[b] - a_max);
+
+            double norm = static_cast<double>(n_site) * log(2.0) - (a_max + log(sum));
+            for (auto &&ele : ln_g)
+                ele += norm;
+
+            std::vector<double> e_sum(n_bin * n_sub, 0.0), e2_sum(n_bin * n_sub, 0.0),
+                                e_n(n_bin * n_sub, 0.0);
+            for (auto &&w : win) {
+                for (size_t k = 0; k < w.e_n.size(); k++) {
+                    e_sum[w.lo * n_sub + k]  += w.e_sum[k];
+                    e2_sum[w.lo * n_sub + k] += w.e2_sum[k];
+                    e_n[w.lo * n_sub + k]    += w.e_n[k];
+                }
+            } // Pool the energy samples
+
+            E_bin.resize(n_bin);
+            level.clear();
+            for (size_t b = 0; b < n_bin; b++) {
+                const double center = E_min + width * static_cast<double>(b);
+                double n_b = 0.0, e_b = 0.0;
+
+                for (size_t k = b * n_sub; k < (b + 1) * n_sub; k++) {
+                    n_b += e_n[k];
+                    e_b += e_sum[k];
+                }
+                E_bin[b] = n_b > 0.0 ? e_b / n_b : center;
+
+                if (!visited[b])
+                    continue;
+                if (!(n_b > 0.0)) {
+                    level.push_back(Level{ln_g[b], center, center * center});
+                    continue;
+                }
+                for (size_t k = b * n_sub; k < (b + 1) * n_sub; k++)
+                    if (e_n[k] > 0.0)
+                        level.push_back(Level{ln_g[b] + log(e_n[k] / n_b), e_sum[k] / e_n[k],
+                                              e2_sum[k] / e_n[k]});
+            } // Loop over bins
+        }
+
+    public:
+        /* Constructor
+         * Uses the lattice and exchange table of model. The windows overlap by the fraction
+         * overlap of their width. A seed of 0 draws a seed from std::random_device.
+         */
+        Wang_landau(const Model &model, size_t n_window = 4, double overlap = 0.5,
+                double Width = 4.0, unsigned seed = 0) :
+            n_site(model.get_size()), width(Width), flat(0.8), ln_f_final(1e-6),
+            exchange_every(100), n_exchange(0), n_swap(0), rand0(0.0, 1.0)
+        {
+            if (seed == 0) {
+                std::random_device rd;
+                seed = rd();
+            }
+
+            // Ferromagnetic ground state
+            Model ground(model);
+            std::mt19937 engine(seed);
+            ground.set_spin(engine);
+            E_min = ground.get_energy();
+            n_bin = bin(-E_min) + 1;
+
+            const double len = static_cast<double>(n_bin) /
+                (static_cast<double>(n_window) - static_cast<double>(n_window - 1) * overlap);
+
+            for (size_t i = 0; i < n_window; i++) {
+                Window w;
+                w.m          = i;
+                w.lo         = static_cast<size_t>(static_cast<double>(i) * (1.0 - overlap) * len);
+                w.hi         = (i + 1 == n_window) ? n_bin - 1 :
+                               std::min(n_bin - 1, static_cast<size_t>(w.lo + len));
+                w.E          = E_min;
+                w.ln_f       = 1.0;
+                w.n_move     = 0.0;
+                w.one_over_t = false;
+                w.done       = false;
+                std::seed_seq seq{seed, static_cast<unsigned>(i + 1)};
+                w.engine.seed(seq);
+                w.ln_g.assign(w.hi - w.lo + 1, 0.0);
+                w.hist.assign(w.hi - w.lo + 1, 0);
+                w.visited.assign(w.hi - w.lo + 1, 0);
+                w.e_sum.assign((w.hi - w.lo + 1) * n_sub, 0.0);
+                w.e2_sum.assign((w.hi - w.lo + 1) * n_sub, 0.0);
+                w.e_n.assign((w.hi - w.lo + 1) * n_sub, 0.0);
+
+                models.push_back(ground);
+                win.push_back(w);
+            } // Set up windows
+        }
+
+        /* set_flatness()
+         * Sets the fraction of the mean count every bin needs for the histogram to be flat.
+         */
+        void set_flatness(double Flat)
+        {
+            flat = Flat;
+        }
+
+        /* set_final()
+         * Sets the modification factor at which the windows stop.
+         */
+        void set_final(double ln_f)
+        {
+            ln_f_final = ln_f;
+        }
+
+        /* set_exchange_every()
+         * Sets the number of sweeps between replica exchanges.
+         */
+        void set_exchange_every(size_t n_sweep)
+        {
+            exchange_every = n_sweep;
+        }
+
+        /* run()
+         * Runs the walkers until every window is done and joins the windows.
+         */
+        void run()
+        {
+            const long n_win = static_cast<long>(win.size());
+            std::mt19937 engine(win[0].engine());
+            bool all_done    = false;
+            size_t round     = 0;
+
+            #pragma omp parallel for schedule(dynamic, 1)
+            for (long i = 0; i < n_win; i++)
+                enter_window(win[i]);
+
+            while (!all_done) {
+                #pragma omp parallel for schedule(dynamic, 1)
+                for (long i = 0; i < n_win; i++) {
+                    if (win[i].done)
+                        continue;
+                    for (size_t s = 0; s < exchange_every; s++)
+                        sweep(win[i]);
+                    update_window(win[i]);
+                } // Loop over windows
+
+                // Alternate between the even and odd pairs of windows
+                for (size_t i = round % 2; i + 1 < win.size(); i += 2)
+                    exchange(i, engine);
+
+                all_done = std::all_of(win.begin(), win.end(),
+                        [](const Window &w) { return w.done; });
+                round++;
+            } // Rounds
+
+            merge();
+        }
+
+        /* get_ln_g()
+         * Returns ln g(E) of every bin. Bins which were never visited hold no information.
+         */
+        const std::vector<double>& get_ln_g() const
+        {
+            return ln_g;
+        }
+
+        /* get_energy()
+         * Returns the mean energy of the states of a bin.
+         */
+        double get_energy(size_t b) const
+        {
+            return E_bin[b];
+        }
+
+        /* get_exchange_rate()
+         * Returns the fraction of accepted replica exchanges.
+         */
+        double get_exchange_rate() const
+        {
+            return n_exchange ? static_cast<double>(n_swap) / static_cast<double>(n_exchange) :
+                                0.0;
+        }
+
+        /* thermo()
+         * Returns the free energy, energy, entropy and specific heat per site at T.
+         */
+        Wl_point thermo(double T) const
+        {
+            const double beta = 1.0 / T;
+            double a_max      = -std::numeric_limits<double>::infinity();
+
+            for (auto &&lev : level)
+                a_max = std::max(a_max, lev.ln_g - beta * lev.E);
+
+            double Z = 0.0, U = 0.0, U2 = 0.0;
+            for (auto &&lev : level) {
+                double p = exp(lev.ln_g - beta * lev.E - a_max);
+                Z  += p;
+                U  += p * lev.E;
+                U2 += p * lev.E2;
+            }
+
+            U  /= Z;
+            U2 /= Z;
+
+            const double N = static_cast<double>(n_site);
+            Wl_point pt;
+            pt.T = T;
+            pt.F = -T * (a_max + log(Z)) / N;
+            pt.E = U / N;
+            pt.S = (pt.E - pt.F) / T;
+            pt.C = beta * beta * (U2 - U * U) / N;
+
+            return pt;
+        }
+
+        /* thermo()
+         * Returns the thermodynamics on a grid of temperatures.
+         */
+        std::vector<Wl_point> thermo(const std::vector<double> &T) const
+        {
+            std::vector<Wl_point> out;
+
+            for (auto ele : T)
+                out.push_back(thermo(ele));
+
+            return out;
+        }
+};
+
+
+/* compute_wang_landau()
+ * Averages the Wang-Landau thermodynamics over n_run realizations of the disorder. With delta = 0
+ * the clean model is used and n_run should be 1. With a seed the exchange table and the walkers
+ * of realization r are drawn from seed_seq{seed, r, 0} and seed_seq{seed, r, 1}, seed 0 draws them
+ * from std::random_device.
+ */
+template <typename Model>
+std::vector<Wl_point> compute_wang_landau(Model &model, double delta, int n_run,
+        const std::vector<double> &T, size_t n_window = 4, double width = 4.0,
+        unsigned seed = 0)
+{
+    std::vector<Wl_point> avg(T.size(), Wl_point{0.0, 0.0, 0.0, 0.0, 0.0});
+
+    for (int run = 0; run < n_run; run++) {
+        unsigned wl_seed = 0;
+
+        if (seed != 0) {
+            std::seed_seq ex_seq{seed, static_cast<unsigned>(run), 0u};
+            std::seed_seq wl_seq{seed, static_cast<unsigned>(run), 1u};
+            std::mt19937 ex_engine(ex_seq);
+            std::mt19937 wl_engine(wl_seq);
+
+            if (delta > 0.0)
+                model.set_exchange(delta, ex_engine);
+            wl_seed = std::max(1u, static_cast<unsigned>(wl_engine()));
+        } else if (delta > 0.0) {
+            model.set_exchange(delta);
+        }
+
+        Wang_landau<Model> wl(model, n_window, 0.5, width, wl_seed);
+        wl.run();
+
+        auto pts = wl.thermo(T);
+        for (size_t i = 0; i < T.size(); i++) {
+            avg[i].F += pts[i].F / n_run;
+            avg[i].E += pts[i].E / n_run;
+            avg[i].S += pts[i].S / n_run;
+            avg[i].C += pts[i].C / n_run;
+        }
+    } // Loop over runs
+
+    for (size_t i = 0; i < T.size(); i++)
+        avg[i].T = T[i];
+
+    return avg;
+}
+
+#endif
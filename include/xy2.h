@@ -2,22 +2,57 @@
 #define XY2_H
 
 
-#include "clock2.h"
+#include <vector>
+#include <random>
+#include "model2.h"
 
 
 /* class : XY2
- * Class for handeling monte carlo simulations for the XY Model. Esentially the Clock2 class
- * with spins set to 50 (determined to converge to the XY Model at 50 spins).
+ * Class for handeling monte carlo simulations for the continuous XY Model. Spins are stored as
+ * unit vectors in two seperate arrays (x and y components) so the measurements vectorize and no
+ * trig functions are needed outside of the proposals. A proposal rotates a spin by a random angle
+ * in [-window, window]. The window is tuned during the warmup sweeps to reach a target acceptance
+ * rate and kept fixed during the measurement sweeps. Each Metropolis sweep can be followed by a
+ * number of over-relaxation sweeps.
  */
-class XY2 : public Clock2
+class XY2 : public Model2
 {
+    private:
+        static const size_t tune_every = 100;
+        double window;
+        double target_acc;
+        size_t n_accept;
+        size_t n_overrelax;
+        std::vector<double> sx, sy;
+        double prop_x, prop_y;              // Spin of the last multicanonical proposal
+        std::vector<double> d_angle, d_cos, d_sin;
+
+        void set_proposal(std::mt19937 &engine);
+        void tune_window();
+        template <Visit V> void sweep_lattice_clean(float beta, std::mt19937 &engine);
+        template <Visit V> void sweep_lattice_disorder(float beta, std::mt19937 &engine);
+        void sweep_overrelax_clean();
+        void sweep_overrelax_disorder();
+        void sweep_lattice(float beta, std::mt19937 &engine);
+        void tune_lattice(size_t n_sweep);
+        double energy() const;
+        double magnetization2() const;
+        double propose(size_t pos, std::mt19937 &engine);
+        void accept(size_t pos);
+
     public:
         XY2() = default;
         XY2(const int L);
         XY2(const XY2 &rhs);
-        void set_spin();
-        double sweep_energy(double beta, std::mt19937 &engine);
-        double sweep_binder(double beta, std::mt19937 &engine);
+        using Model2::set_spin;
+        void set_spin(std::mt19937 &engine);
+        void set_target_acceptance(double acc);
+        void set_overrelax(size_t n_over);
+        double get_target_acceptance() const;
+        size_t get_overrelax() const;
+        double get_window() const;
+        void save(std::ostream &os) const;
+        void load(std::istream &is);
 };
 
 
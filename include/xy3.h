@@ -2,22 +2,69 @@
 #define XY3_H
 
 
-#include "clock3.h"
+#include <vector>
+#include <random>
+#include "model3.h"
 
 
 /* class : XY3
- * Class for handeling monte carlo simulations for the XY Model. Esentially the Clock2 class
- * with spins set to 50 (determined to converge to the XY Model at 50 spins).
+ * Class for handeling monte carlo simulations for the continuous XY Model. Spins are stored as
+ * unit vectors in two seperate arrays (x and y components) so the measurements vectorize and no
+ * trig functions are needed outside of the proposals. A proposal rotates a spin by a random angle
+ * in [-window, window]. The window is tuned during the warmup sweeps to reach a target acceptance
+ * rate and kept fixed during the measurement sweeps. Each Metropolis sweep can be followed by a
+ * number of over-relaxation sweeps.
  */
-class XY3 : public Clock3
+class XY3 : public Model3
 {
+    private:
+        static const size_t tune_every = 100;
+        double window;
+        double target_acc;
+        size_t n_accept;
+        size_t n_overrelax;
+        std::vector<double> sx, sy;
+        double prop_x, prop_y;              // Spin of the last multicanonical proposal
+        std::vector<double> d_angle, d_cos, d_sin;
+
+        void set_proposal(std::mt19937 &engine);
+        void tune_window();
+        template <bool clean> void local_field(size_t pos, double &hx, double &hy) const;
+        template <bool clean> double rotate_energy(size_t pos, double c, double s, double &new_x,
+                double &new_y) const;
+        template <bool clean> bool rotate_site(size_t pos, double c, double s, float beta,
+                std::mt19937 &engine);
+        template <bool clean> void reflect_site(size_t pos);
+        template <Visit V> void sweep_lattice_clean(float beta, std::mt19937 &engine);
+        template <Visit V> void sweep_lattice_disorder(float beta, std::mt19937 &engine);
+        void sweep_overrelax_clean();
+        void sweep_overrelax_disorder();
+        void sweep_lattice(float beta, std::mt19937 &engine);
+        void tune_lattice(size_t n_sweep);
+        double energy() const;
+        double magnetization2() const;
+        double propose(size_t pos, std::mt19937 &engine);
+        void accept(size_t pos);
+        double energy_sites(size_t first, size_t last) const;
+        void magnetization_sites(size_t first, size_t last, double &Mx, double &My) const;
+        bool update_site(size_t pos, float beta, std::mt19937 &engine);
+        void overrelax_site(size_t pos, float beta, std::mt19937 &engine);
+        size_t overrelax_sweeps() const;
+        void count_accepted(size_t n_acc);
+
     public:
         XY3() = default;
         XY3(const int L);
         XY3(const XY3 &rhs);
-        void set_spin();
-        double sweep_energy(double beta, std::mt19937 &engine);
-        double sweep_binder(double beta, std::mt19937 &engine);
+        using Model3::set_spin;
+        void set_spin(std::mt19937 &engine);
+        void set_target_acceptance(double acc);
+        void set_overrelax(size_t n_over);
+        double get_target_acceptance() const;
+        size_t get_overrelax() const;
+        double get_window() const;
+        void save(std::ostream &os) const;
+        void load(std::istream &is);
 };
 
 
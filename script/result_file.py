@@ -0,0 +1,60 @@
+###################################################################################################
+### Program: result_file.py
+### Purpose: Read the binary result files written by write_result() (see include/result_file.h)
+###          without parsing text. The columns are memory mapped, so loading a file only reads
+###          its header. numpy is optional: without it the columns are memoryviews of doubles.
+###################################################################################################
+
+
+import mmap
+import os
+import struct
+
+try:
+    import numpy as np
+except ImportError:
+    np = None
+
+
+MAGIC = b"DCRES01\0"
+HEAD_LEN = 40
+ALIGNMENT = 64
+
+
+def load_result(filename):
+    """Returns (columns, params) of a result file.
+
+    columns maps every column name to a read only numpy.memmap of its values (a read only
+    memoryview of doubles without numpy) and params maps the run parameters to their values as
+    strings. Raises ValueError on files which Result_file would reject.
+    """
+    with open(filename, "rb") as f:
+        head = f.read(HEAD_LEN)
+        if len(head) != HEAD_LEN or head[:8] != MAGIC:
+            raise ValueError(filename + " is not a result file")
+
+        offset, n_row, n_col, meta_len = struct.unpack("<4Q", head[8:])
+        n_byte = 8 * n_row * n_col
+        if (offset % ALIGNMENT != 0 or HEAD_LEN + meta_len > offset or
+                offset + n_byte > os.fstat(f.fileno()).st_size):
+            raise ValueError(filename + " is not a valid result file")
+
+        meta = f.read(meta_len).decode()
+        if np is None:
+            flat = memoryview(mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ))
+            flat = flat[offset:offset + n_byte].cast("d")
+
+    names, params = [], {}
+    for line in meta.splitlines():
+        entry = line.split("\t")
+        if entry[0] == "column":
+            names.append(entry[1])
+        elif entry[0] == "param":
+            params[entry[1]] = entry[2]
+
+    if np is not None:
+        data = np.memmap(filename, dtype="<f8", mode="r", offset=offset, shape=(n_col, n_row))
+    else:
+        data = [flat[j * n_row:(j + 1) * n_row] for j in range(n_col)]
+
+    return dict(zip(names, data)), params
@@ -0,0 +1,57 @@
+###################################################################################################
+### Program: time_series.py
+### Purpose: Read the per sweep time series written by Time_series (see include/time_series.h).
+###################################################################################################
+
+
+import numpy as np
+
+
+MAGIC = b"DCTS01\0\0"
+BEGIN = 0xffffffff
+DROPPED = 0xfffffffe
+
+RECORD = np.dtype([("series", "<u4"), ("sweep", "<u4"), ("v", "<f8", (3,))])
+
+
+def load_time_series(filename):
+    """Returns a dict mapping every series id to (info, samples).
+
+    info holds beta, run, the temperature index and the number of samples dropped because the
+    writer could not keep up. samples is a structured array with the fields sweep, E, M (= |M|)
+    and M2, sorted by sweep.
+    """
+    with open(filename, "rb") as f:
+        head = f.read(16)
+    if head[:8] != MAGIC or np.frombuffer(head, dtype="<u8", offset=8)[0] != RECORD.itemsize:
+        raise ValueError(filename + " is not a time series file")
+
+    rec = np.memmap(filename, dtype=RECORD, mode="r", offset=16)
+    begin = rec["sweep"] == BEGIN
+    dropped = rec["sweep"] == DROPPED
+
+    series = {}
+    for r in rec[begin]:
+        info = {"beta": r["v"][0], "run": int(r["v"][1]), "idx": int(r["v"][2]), "dropped": 0}
+        series[int(r["series"])] = info
+    for r in rec[dropped]:
+        series[int(r["series"])]["dropped"] += int(r["v"][0])
+
+    data = rec[~(begin | dropped)]
+    order = np.lexsort((data["sweep"], data["series"]))
+    data = data[order]
+    ids, start = np.unique(data["series"], return_index=True)
+    end = np.append(start[1:], len(data))
+
+    out = {}
+    for sid, a, b in zip(ids, start, end):
+        chunk = data[a:b]
+        samples = np.zeros(b - a, dtype=[("sweep", "<u4"), ("E", "<f8"), ("M", "<f8"),
+                                         ("M2", "<f8")])
+        samples["sweep"] = chunk["sweep"]
+        samples["E"] = chunk["v"][:, 0]
+        samples["M"] = chunk["v"][:, 1]
+        samples["M2"] = chunk["v"][:, 2]
+        out[int(sid)] = (series.get(int(sid)), samples)
+
+    return out
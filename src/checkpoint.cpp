@@ -0,0 +1,341 @@
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "../include/checkpoint.h"
+
+
+// Identifies checkpoint files
+static const char magic[8]      = {'D', 'C', 'C', 'K', 'P', 'T', '2', '\0'};
+static const char slot_magic[8] = {'D', 'C', 'S', 'L', 'O', 'T', '1', '\0'};
+
+
+/*-------------------------------------------------------------------------------------------------
+ * BINARY IO HELPERS
+ *-----------------------------------------------------------------------------------------------*/
+
+void write_binary(std::ostream &os, const std::string &str)
+{
+    size_t n = str.size();
+    write_binary(os, n);
+    os.write(str.data(), n);
+}
+
+
+void read_binary(std::istream &is, std::string &str)
+{
+    size_t n = 0;
+    read_binary(is, n);
+    str.resize(n);
+    is.read(&str[0], n);
+}
+
+
+void write_binary(std::ostream &os, const Sweep_state &state)
+{
+    write_binary(os, state.n_sweep);
+    write_binary(os, state.acc);
+}
+
+
+void read_binary(std::istream &is, Sweep_state &state)
+{
+    read_binary(is, state.n_sweep);
+    read_binary(is, state.acc);
+}
+
+
+void write_binary(std::ostream &os, const std::mt19937 &engine)
+{
+    std::ostringstream ss;
+    ss << engine;
+    write_binary(os, ss.str());
+}
+
+
+void read_binary(std::istream &is, std::mt19937 &engine)
+{
+    std::string str;
+    read_binary(is, str);
+    std::istringstream ss(str);
+    ss >> engine;
+}
+
+
+/*-------------------------------------------------------------------------------------------------
+ * PRIVATE METHODS
+ *-----------------------------------------------------------------------------------------------*/
+
+/* sync_file()
+ * Writes data to a new file and flushes it to the disk. Returns false on failure.
+ */
+static bool sync_file(const std::string &file, const std::string &data)
+{
+    int fd = open(file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return false;
+
+    const char *ptr = data.data();
+    size_t left     = data.size();
+    while (left > 0) {
+        ssize_t n = ::write(fd, ptr, left);
+        if (n < 0) {
+            close(fd);
+            return false;
+        }
+        ptr  += n;
+        left -= static_cast<size_t>(n);
+    } // Loop over partial writes
+
+    bool ok = fsync(fd) == 0;
+    return close(fd) == 0 && ok;
+}
+
+
+/* sync_dir()
+ * Flushes the directory of a file to the disk, so a rename into it survives a crash.
+ */
+static void sync_dir(const std::string &file)
+{
+    const size_t slash    = file.find_last_of('/');
+    const std::string dir = slash == std::string::npos ? "." :
+                            slash == 0 ? "/" : file.substr(0, slash);
+
+    int fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+}
+
+
+/* slot_file()
+ * Returns the name of the slot file of a thread.
+ */
+std::string Checkpoint::slot_file(int thd_id) const
+{
+    return filename + ".slot" + std::to_string(thd_id);
+}
+
+
+/* write()
+ * Writes data to a temporary file, flushes it to the disk and renames it over file, then flushes
+ * the directory. Every file has a temporary file of its own, so the threads write their slots in
+ * parallel.
+ */
+void Checkpoint::write(const std::string &file, const std::string &data) const
+{
+    const std::string tmp = file + ".tmp";
+
+    if (!sync_file(tmp, data)) {
+        std::cerr << "Error: Could not write checkpoint " << tmp << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    if (std::rename(tmp.c_str(), file.c_str()) != 0) {
+        std::cerr << "Error: Could not rename checkpoint " << tmp << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    sync_dir(file);
+}
+
+
+/* write_image()
+ * Writes the seed, the realization and the accumulated output to the checkpoint file.
+ */
+void Checkpoint::write_image()
+{
+    std::ostringstream os;
+
+    os.write(magic, sizeof(magic));
+    write_binary(os, seed);
+    write_binary(os, stamp);
+    write_binary(os, run);
+    write_binary(os, complete);
+    write_binary(os, acc);
+
+    write(filename, os.str());
+}
+
+
+/* remove_slots()
+ * Removes the slot files written by this process.
+ */
+void Checkpoint::remove_slots()
+{
+    for (int thd_id = 0; thd_id < n_slot; thd_id++)
+        std::remove(slot_file(thd_id).c_str());
+    n_slot = 0;
+}
+
+
+/*-------------------------------------------------------------------------------------------------
+ * PUBLIC METHODS
+ *-----------------------------------------------------------------------------------------------*/
+
+/* Constructor
+ * every is the number of sweeps between checkpoints. If Seed is 0 a seed is drawn from
+ * std::random_device. When Restart is set, load() reads back an existing checkpoint.
+ */
+Checkpoint::Checkpoint(const std::string &file, size_t Every, bool Restart, unsigned Seed) :
+    filename(file), every(Every), restart(Restart), seed(Seed), stamp(0), run(0),
+    complete(false), n_slot(0)
+{
+    if (seed == 0) {
+        std::random_device rd;
+        seed = rd();
+    }
+}
+
+
+/* load()
+ * Reads the checkpoint if the run is restarted and the file exists. Returns false if there is
+ * nothing to resume. n_pts is the number of temperatures, used to validate the file.
+ */
+bool Checkpoint::load(size_t n_pts)
+{
+    if (!restart)
+        return false;
+
+    std::ifstream is(filename, std::ios::binary);
+    if (!is)
+        return false;
+
+    char head[sizeof(magic)];
+
+    is.read(head, sizeof(head));
+    read_binary(is, seed);
+    read_binary(is, stamp);
+    read_binary(is, run);
+    read_binary(is, complete);
+    read_binary(is, acc);
+
+    if (!is || std::memcmp(head, magic, sizeof(magic)) != 0 || acc.size() != n_pts) {
+        std::cerr << "Error: Checkpoint " << filename << " is corrupt or from another run."
+                  << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    return true;
+}
+
+
+/* begin_run()
+ * Starts a new realization. Acc holds the output accumulated over the finished realizations. The
+ * realization gets a new stamp, which leaves the slots of the previous one behind.
+ */
+void Checkpoint::begin_run(int Run, const std::vector<double> &Acc)
+{
+    std::random_device rd;
+
+    stamp = rd();
+    run   = Run;
+    acc   = Acc;
+    write_image();
+}
+
+
+/* set_slot()
+ * Writes the state of a thread to its slot file. Safe to call from a parallel region: every
+ * thread writes a file of its own.
+ */
+void Checkpoint::set_slot(int thd_id, const std::string &data)
+{
+    std::ostringstream os;
+
+    os.write(slot_magic, sizeof(slot_magic));
+    write_binary(os, stamp);
+    write_binary(os, run);
+    write_binary(os, data);
+    write(slot_file(thd_id), os.str());
+
+    #pragma omp critical(checkpoint)
+    n_slot = std::max(n_slot, thd_id + 1);
+}
+
+
+/* finish()
+ * Marks the run as complete, stores its final result and removes the slot files.
+ */
+void Checkpoint::finish(const std::vector<double> &Result)
+{
+    complete = true;
+    acc      = Result;
+    write_image();
+    remove_slots();
+}
+
+
+/* is_complete()
+ * Checks if the loaded checkpoint holds the final result of a finished run.
+ */
+bool Checkpoint::is_complete() const
+{
+    return complete;
+}
+
+
+/* get_slot()
+ * Reads the stored state of a thread into data. Returns false if the thread has no slot of the
+ * current realization.
+ */
+bool Checkpoint::get_slot(int thd_id, std::string &data) const
+{
+    std::ifstream is(slot_file(thd_id), std::ios::binary);
+    char head[sizeof(slot_magic)];
+    unsigned Stamp = 0;
+    int Run        = -1;
+
+    if (complete || !is)
+        return false;
+
+    is.read(head, sizeof(head));
+    read_binary(is, Stamp);
+    read_binary(is, Run);
+    read_binary(is, data);
+
+    return is && std::memcmp(head, slot_magic, sizeof(slot_magic)) == 0 && Stamp == stamp &&
+           Run == run;
+}
+
+
+/* get_run()
+ * Returns the realization to resume.
+ */
+int Checkpoint::get_run() const
+{
+    return run;
+}
+
+
+/* get_acc()
+ * Returns the output accumulated over the finished realizations.
+ */
+const std::vector<double>& Checkpoint::get_acc() const
+{
+    return acc;
+}
+
+
+/* get_every()
+ * Returns the number of sweeps between checkpoints.
+ */
+size_t Checkpoint::get_every() const
+{
+    return every;
+}
+
+
+/* make_engine()
+ * Returns the engine of a stream within a realization. Stream 0 is used for the exchange table,
+ * stream 1 + thread id for the sweeps of a thread.
+ */
+std::mt19937 Checkpoint::make_engine(int Run, int stream) const
+{
+    std::seed_seq seq{seed, static_cast<unsigned>(Run), static_cast<unsigned>(stream)};
+    return std::mt19937(seq);
+}
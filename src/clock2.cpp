@@ -1,25 +1,29 @@
 #include <cmath>
+#include <cstdlib>
 
 #include "../include/clock2.h"
 
 
 /*-------------------------------------------------------------------------------------------------
- * PUBLIC METHOD
+ * PRIVATE METHODS
  *-----------------------------------------------------------------------------------------------*/
 
 /* sweep_lattice_clean()
- * Performans Monte Carlo sweeps. Sweeps the lattice once by choosing a random position and
- * proposing a spin flip using the Meteropolis Algorithm. This is done for the lattice size.
+ * Performans Monte Carlo sweeps. Sweeps the lattice once by choosing a position (at random or in
+ * order, see visit_site()) and proposing a spin flip using the Meteropolis Algorithm. This is done
+ * for the lattice size.
  */
+template <Visit V>
 void Clock2::sweep_lattice_clean(float beta, std::mt19937 &engine)
 {
     for (size_t i = 0; i < size; i++) {
-        size_t pos = static_cast<size_t>(rand0(engine) * size);
+        size_t pos = visit_site<V>(i, engine);
 
         // compute new angle
         int new_angle;
         do {
             new_angle = static_cast<int>(rand0(engine) * q);
+            INSTRUMENT_ADD(counters, angle_draws, 1);
         } while(new_angle == spin[pos]);
 
         // Compute the energy change
@@ -35,25 +39,30 @@ void Clock2::sweep_lattice_clean(float beta, std::mt19937 &engine)
         } // Loop to compute total cos value
 
         // Accept / reject new spin
-        if (rand0(engine) < exp(-beta * delta_E))
+        if (rand0(engine) < exp(-beta * delta_E)) {
             spin[pos] = new_angle;
+            INSTRUMENT_ADD(counters, accepted, 1);
+        }
     } // Loop over sites
 }
 
 
 /* sweep_lattice_disorder()
- * Performans Monte Carlo sweeps. Sweeps the lattice once by choosing a random position and
- * proposing a spin flip using the Meteropolis Algorithm. This is done for the lattice size.
+ * Performans Monte Carlo sweeps. Sweeps the lattice once by choosing a position (at random or in
+ * order, see visit_site()) and proposing a spin flip using the Meteropolis Algorithm. This is done
+ * for the lattice size.
  */
+template <Visit V>
 void Clock2::sweep_lattice_disorder(float beta, std::mt19937 &engine)
 {
     for (size_t i = 0; i < size; i++) {
-        size_t pos = static_cast<size_t>(rand0(engine) * size);
+        size_t pos = visit_site<V>(i, engine);
 
         // Compute new angle
         int new_angle;
         do {
             new_angle = static_cast<int>(rand0(engine) * q);
+            INSTRUMENT_ADD(counters, angle_draws, 1);
         } while(new_angle == spin[pos]);
 
         // Compute energy change
@@ -70,9 +79,163 @@ void Clock2::sweep_lattice_disorder(float beta, std::mt19937 &engine)
 
 
         // Accept / reject new spin
-        if (rand0(engine) < exp(-beta * delta_E))
+        if (rand0(engine) < exp(-beta * delta_E)) {
             spin[pos] = new_angle;
+            INSTRUMENT_ADD(counters, accepted, 1);
+        }
+    }
+}
+
+/* sweep_overrelax_clean()
+ * Performs an over-relaxation sweep. Each site is reflected about the clock axis closest to its
+ * local field. The reflection is only kept if it leaves the energy unchanged, so the move needs
+ * no random numbers and no exponential. The sites are visited in order.
+ */
+void Clock2::sweep_overrelax_clean()
+{
+    const double dq = 2.0 * M_PI / static_cast<double>(q);
+
+    for (size_t pos = 0; pos < size; pos++) {
+        // Compute local field
+        double hx = 0.0, hy = 0.0;
+        for (size_t i = 0; i < n_neigh; i++) {
+            hx += cos_val[spin[neigh[pos].neighbor[i]]];
+            hy += sin_val[spin[neigh[pos].neighbor[i]]];
+        }
+
+        // Reflect about the axis closest to the local field
+        int m         = static_cast<int>(lround(2.0 * atan2(hy, hx) / dq));
+        int old_angle = spin[pos];
+        int new_angle = ((m - old_angle) % q + q) % q;
+
+        double delta_E = (cos_val[old_angle] - cos_val[new_angle]) * hx +
+                         (sin_val[old_angle] - sin_val[new_angle]) * hy;
+
+        if (fabs(delta_E) < 1.0e-10)
+            spin[pos] = new_angle;
+    } // Loop over sites
+}
+
+
+/* sweep_overrelax_disorder()
+ * Performs an over-relaxation sweep with the disordered exchange table. With random bonds a
+ * reflection almost never leaves the energy exactly unchanged, so it is accepted with the
+ * Metropolis probability instead. The reflection about the axis closest to the field is its own
+ * inverse and the axis does not depend on the spin itself, so the move keeps detailed balance.
+ */
+void Clock2::sweep_overrelax_disorder(float beta, std::mt19937 &engine)
+{
+    const double dq = 2.0 * M_PI / static_cast<double>(q);
+
+    for (size_t pos = 0; pos < size; pos++) {
+        // Compute local field
+        double hx = 0.0, hy = 0.0;
+        for (size_t i = 0; i < n_neigh; i++) {
+            hx += J[pos].J_arr[i] * cos_val[spin[neigh[pos].neighbor[i]]];
+            hy += J[pos].J_arr[i] * sin_val[spin[neigh[pos].neighbor[i]]];
+        }
+
+        // Reflect about the axis closest to the local field
+        int m         = static_cast<int>(lround(2.0 * atan2(hy, hx) / dq));
+        int old_angle = spin[pos];
+        int new_angle = ((m - old_angle) % q + q) % q;
+
+        double delta_E = (cos_val[old_angle] - cos_val[new_angle]) * hx +
+                         (sin_val[old_angle] - sin_val[new_angle]) * hy;
+
+        if (delta_E <= 0.0 || rand0(engine) < exp(-beta * delta_E))
+            spin[pos] = new_angle;
+    } // Loop over sites
+}
+
+
+/* sweep_lattice()
+ * Performs one Metropolis sweep followed by n_overrelax over-relaxation sweeps.
+ */
+void Clock2::sweep_lattice(float beta, std::mt19937 &engine)
+{
+    if (isClean) {
+        dispatch_visit([&](auto v) { sweep_lattice_clean<decltype(v)::value>(beta, engine); });
+        for (size_t i = 0; i < n_overrelax; i++)
+            sweep_overrelax_clean();
+    } else {
+        dispatch_visit([&](auto v) { sweep_lattice_disorder<decltype(v)::value>(beta, engine); });
+        for (size_t i = 0; i < n_overrelax; i++)
+            sweep_overrelax_disorder(beta, engine);
+    }
+}
+
+
+/* propose()
+ * Proposes a new random angle for the spin at pos and returns the energy change.
+ */
+double Clock2::propose(size_t pos, std::mt19937 &engine)
+{
+    do {
+        proposal = static_cast<int>(rand0(engine) * q);
+    } while (proposal == spin[pos]);
+
+    double delta_E = 0.0;
+    for (size_t i = 0; i < n_neigh; i++) {
+        size_t neigh_angle = spin[neigh[pos].neighbor[i]];
+        size_t old_idx     = (spin[pos] - neigh_angle + q) % q;
+        size_t new_idx     = (proposal - neigh_angle + q) % q;
+        double J_val       = isClean ? 1.0 : J[pos].J_arr[i];
+
+        delta_E += J_val * (cos_val[old_idx] - cos_val[new_idx]);
+    } // Loop over neighbors
+
+    return delta_E;
+}
+
+
+/* accept()
+ * Sets the spin at pos to the last proposed angle.
+ */
+void Clock2::accept(size_t pos)
+{
+    spin[pos] = proposal;
+}
+
+
+/* energy()
+ * Returns the total energy of the lattice.
+ */
+double Clock2::energy() const
+{
+    double E_tot = 0.0;
+
+    for (size_t j = 0; j < size; j++) {
+        size_t pos_angle = spin[j];
+        size_t neigh1    = spin[neigh[j].neighbor[1]];
+        size_t neigh2    = spin[neigh[j].neighbor[2]];
+
+        size_t E_idx1 = (pos_angle - neigh1 + q) % q;
+        size_t E_idx2 = (pos_angle - neigh2 + q) % q;
+
+        if (isClean)
+            E_tot += -(cos_val[E_idx1] + cos_val[E_idx2]);
+        else
+            E_tot += -(J[j].J_arr[1] * cos_val[E_idx1] + J[j].J_arr[2] * cos_val[E_idx2]);
+    } // Compute energy of lattice
+
+    return E_tot;
+}
+
+
+/* magnetization2()
+ * Returns the square of the total magnetization of the lattice.
+ */
+double Clock2::magnetization2() const
+{
+    double Mx = 0.0, My = 0.0;
+    #pragma omp simd reduction(+:Mx, My)
+    for (size_t j = 0; j < size; j++) {
+        Mx += cos_val[spin[j]];
+        My += sin_val[spin[j]];
     }
+
+    return Mx * Mx + My * My;
 }
 
 
@@ -82,7 +245,7 @@ void Clock2::sweep_lattice_disorder(float beta, std::mt19937 &engine)
 
 /* Constructor with arguments
  */
-Clock2::Clock2(const int L, const int _q) : Model2(L), q(_q)
+Clock2::Clock2(const int L, const int _q) : Model2(L), q(_q), n_overrelax(0)
 {
     spin.resize(size);
     cos_val.resize(q);
@@ -100,7 +263,8 @@ Clock2::Clock2(const int L, const int _q) : Model2(L), q(_q)
 /* Copy constructor
  */
 Clock2::Clock2(const Clock2 &rhs) :
-    Model2(rhs), q(rhs.q), spin(rhs.spin), cos_val(rhs.cos_val) ,sin_val(rhs.sin_val)
+    Model2(rhs), q(rhs.q), n_overrelax(rhs.n_overrelax), spin(rhs.spin), cos_val(rhs.cos_val),
+    sin_val(rhs.sin_val)
 {
 }
 
@@ -108,109 +272,59 @@ Clock2::Clock2(const Clock2 &rhs) :
 /* set_spin()
  * Sets the angle index representing the spin
  */
-void Clock2::set_spin()
+void Clock2::set_spin(std::mt19937 &engine)
 {
-    std::random_device rd;
-    std::mt19937 engine(rd());
     for (size_t i = 0; i < size; i++)
         spin[i] = static_cast<int>(rand0(engine) * q);
 }
 
 
-/* sweep_energy()
+/* set_overrelax()
+ * Sets the number of over-relaxation sweeps performed after each Metropolis sweep.
  */
-double Clock2::sweep_energy(double beta, std::mt19937 &engine)
+void Clock2::set_overrelax(size_t n_over)
 {
-    double E_tot = 0.0;
-
-    if (isClean) {
-        for (size_t i = 0; i < warmup; i++)
-            sweep_lattice_clean(beta, engine);
-
-        for (size_t i = 0; i < measure; i++) {
-            sweep_lattice_clean(beta, engine);
-
-            for (size_t j = 0; j < size; j++) {
-                size_t pos_angle = spin[j];
-                size_t neigh1    = spin[neigh[j].neighbor[1]];
-                size_t neigh2    = spin[neigh[j].neighbor[2]];
-
-                size_t E_idx1 = (pos_angle - neigh1 + q) % q;
-                size_t E_idx2 = (pos_angle - neigh2 + q) % q;
-
-                E_tot += -(cos_val[E_idx1] + cos_val[E_idx2]);
-            } // Compute energy of lattice
-        } // Measurement sweeps
-    } else {
-        for (size_t i = 0; i < warmup; i++)
-            sweep_lattice_disorder(beta, engine);
-
-        for (size_t i = 0; i < measure; i++) {
-            sweep_lattice_disorder(beta, engine);
+    n_overrelax = n_over;
+}
 
-            for (size_t j = 0; j < size; j++) {
-                size_t pos_angle = spin[j];
-                size_t neigh1    = spin[neigh[j].neighbor[1]];
-                size_t neigh2    = spin[neigh[j].neighbor[2]];
 
-                size_t E_idx1 = (pos_angle - neigh1 + q) % q;
-                size_t E_idx2 = (pos_angle - neigh2 + q) % q;
+/* get_q()
+ * Returns the number of spin states.
+ */
+int Clock2::get_q() const
+{
+    return q;
+}
 
-                E_tot += -(J[j].J_arr[1] * cos_val[E_idx1] + J[j].J_arr[2] * cos_val[E_idx2]);
-            } // Compute energy of lattice
-        } // Measurement sweeps
-    } // Choose if there is or isn't disorder
 
-    return E_tot / static_cast<double>(measure * size);
+/* get_overrelax()
+ * Returns the number of over-relaxation sweeps performed after each Metropolis sweep.
+ */
+size_t Clock2::get_overrelax() const
+{
+    return n_overrelax;
 }
 
 
-/* sweep_binder()
+/* save()
+ * Writes the model and its spins in binary.
  */
-double Clock2::sweep_binder(double beta, std::mt19937 &engine)
+void Clock2::save(std::ostream &os) const
 {
-    double M2 = 0.0, M4 = 0.0;
-
-    if (isClean) {
-        for (size_t i = 0; i < warmup; i++)
-            sweep_lattice_clean(beta, engine);
-
-        for (size_t i = 0; i < measure; i++) {
-            sweep_lattice_clean(beta, engine);
-
-            double Mx = 0.0, My = 0.0;
-            #pragma omp simd reduction(+:Mx, My)
-            for (size_t j = 0; j < size; j++) {
-                Mx += cos_val[spin[j]];
-                My += sin_val[spin[j]];
-            }
-
-            double M = sqrt(Mx * Mx + My * My);
-            M2 += M * M;
-            M4 += M * M * M * M;
-        }
-    } else {
-        for (size_t i = 0; i < warmup; i++)
-            sweep_lattice_disorder(beta, engine);
-
-        for (size_t i = 0; i < measure; i++) {
-            sweep_lattice_disorder(beta, engine);
-
-            double Mx = 0.0, My = 0.0;
-            #pragma omp simd reduction(+:Mx, My)
-            for (size_t j = 0; j < size; j++) {
-                Mx += cos_val[spin[j]];
-                My += sin_val[spin[j]];
-            }
-
-            double M = sqrt(Mx * Mx + My * My);
-            M2 += M * M;
-            M4 += M * M * M * M;
-        }
-    }
+    Model2::save(os);
+    write_binary(os, q);
+    write_binary(os, n_overrelax);
+    write_binary(os, spin);
+}
 
-    M2 /= static_cast<double>(measure);
-    M4 /= static_cast<double>(measure);
 
-    return 1.0 - (M4 / (3.0 * M2 * M2));
+/* load()
+ * Reads back the data written by save().
+ */
+void Clock2::load(std::istream &is)
+{
+    Model2::load(is);
+    read_binary(is, q);
+    read_binary(is, n_overrelax);
+    read_binary(is, spin);
 }
@@ -1,78 +1,321 @@
 #include <cmath>
+#include <cstdlib>
 
 #include "../include/clock3.h"
 
 
 /*-------------------------------------------------------------------------------------------------
- * PUBLIC METHOD
+ * PRIVATE METHODS
  *-----------------------------------------------------------------------------------------------*/
 
-/* sweep_lattice_clean()
- * Performans Monte Carlo sweeps. Sweeps the lattice once by choosing a random position and
- * proposing a spin flip using the Meteropolis Algorithm. This is done for the lattice size.
+/* draw_angle()
+ * Draws a new angle for the spin at pos, different from the current one. Adds the number of
+ * angles drawn to n_draw.
  */
-void Clock3::sweep_lattice_clean(float beta, std::mt19937 &engine)
+int Clock3::draw_angle(size_t pos, std::mt19937 &engine, std::uint64_t &n_draw)
 {
-    for (size_t i = 0; i < size; i++) {
-        size_t pos = static_cast<size_t>(rand0(engine) * size);
+    int new_angle;
 
-        // compute new angle
-        int new_angle;
-        do {
-            new_angle = static_cast<int>(rand0(engine) * q);
-        } while(new_angle == spin[pos]);
+    do {
+        new_angle = static_cast<int>(rand0(engine) * q);
+        n_draw++;
+    } while (new_angle == spin[pos]);
 
-        // Compute the energy change
-        float delta_E = 0.0;
-        for (size_t i = 0; i < n_neigh; i++) {
-            size_t neigh_angle = spin[neigh[pos].neighbor[i]];
-            size_t old_angle   = spin[pos];
+    return new_angle;
+}
+
+
+/* change_energy()
+ * Returns the energy change of setting the spin at pos to new_angle. clean selects the uniform
+ * couplings at compile time.
+ */
+template <bool clean>
+double Clock3::change_energy(size_t pos, int new_angle) const
+{
+    double delta_E = 0.0;
 
-            size_t old_idx = (old_angle - neigh_angle + q) % q;
-            size_t new_idx = (new_angle - neigh_angle + q) % q;
+    for (size_t i = 0; i < n_neigh; i++) {
+        size_t neigh_angle = spin[neigh[pos].neighbor[i]];
+        size_t old_idx     = (spin[pos] - neigh_angle + q) % q;
+        size_t new_idx     = (new_angle - neigh_angle + q) % q;
 
+        if (clean)
             delta_E += cos_val[old_idx] - cos_val[new_idx];
-        } // Loop to compute total cos value
+        else
+            delta_E += J[pos].J_arr[i] * (cos_val[old_idx] - cos_val[new_idx]);
+    } // Loop over neighbors
+
+    return delta_E;
+}
+
 
-        // Accept / reject new spin
-        if (rand0(engine) < exp(-beta * delta_E))
-            spin[pos] = new_angle;
+/* metropolis_site()
+ * Proposes a new random angle for the spin at pos with the Metropolis Algorithm. Returns true if
+ * it was accepted.
+ */
+template <bool clean>
+bool Clock3::metropolis_site(size_t pos, float beta, std::mt19937 &engine, std::uint64_t &n_draw)
+{
+    int new_angle = draw_angle(pos, engine, n_draw);
+
+    if (rand0(engine) < exp(-beta * change_energy<clean>(pos, new_angle))) {
+        spin[pos] = new_angle;
+        return true;
+    }
+
+    return false;
+}
+
+
+/* reflect_site()
+ * Reflects the spin at pos about the clock axis closest to its local field. On the clean lattice
+ * the reflection is only kept if it leaves the energy unchanged, so the move needs no random
+ * numbers and no exponential. With random bonds that almost never happens, so the reflection is
+ * accepted with the Metropolis probability instead. The reflection is its own inverse and the
+ * axis does not depend on the spin itself, so either rule keeps detailed balance.
+ */
+template <bool clean>
+void Clock3::reflect_site(size_t pos, float beta, std::mt19937 &engine)
+{
+    const double dq = 2.0 * M_PI / static_cast<double>(q);
+
+    // Compute local field
+    double hx = 0.0, hy = 0.0;
+    for (size_t i = 0; i < n_neigh; i++) {
+        double J_val = clean ? 1.0 : J[pos].J_arr[i];
+        hx += J_val * cos_val[spin[neigh[pos].neighbor[i]]];
+        hy += J_val * sin_val[spin[neigh[pos].neighbor[i]]];
+    }
+
+    // Reflect about the axis closest to the local field
+    int m         = static_cast<int>(lround(2.0 * atan2(hy, hx) / dq));
+    int old_angle = spin[pos];
+    int new_angle = ((m - old_angle) % q + q) % q;
+
+    double delta_E = (cos_val[old_angle] - cos_val[new_angle]) * hx +
+                     (sin_val[old_angle] - sin_val[new_angle]) * hy;
+
+    if (clean ? fabs(delta_E) < 1.0e-10 :
+                delta_E <= 0.0 || rand0(engine) < exp(-beta * delta_E))
+        spin[pos] = new_angle;
+}
+
+
+/* sweep_lattice_clean()
+ * Performans Monte Carlo sweeps. Sweeps the lattice once by choosing a position (at random or in
+ * order, see visit_site()) and proposing a spin flip using the Meteropolis Algorithm. This is done
+ * for the lattice size.
+ */
+template <Visit V>
+void Clock3::sweep_lattice_clean(float beta, std::mt19937 &engine)
+{
+    std::uint64_t n_draw = 0;
+
+    for (size_t i = 0; i < size; i++) {
+        if (metropolis_site<true>(visit_site<V>(i, engine), beta, engine, n_draw))
+            INSTRUMENT_ADD(counters, accepted, 1);
     } // Loop over sites
+
+    INSTRUMENT_ADD(counters, angle_draws, n_draw);
 }
 
 
 /* sweep_lattice_disorder()
- * Performans Monte Carlo sweeps. Sweeps the lattice once by choosing a random position and
- * proposing a spin flip using the Meteropolis Algorithm. This is done for the lattice size.
+ * Performans Monte Carlo sweeps. Sweeps the lattice once by choosing a position (at random or in
+ * order, see visit_site()) and proposing a spin flip using the Meteropolis Algorithm. This is done
+ * for the lattice size.
  */
+template <Visit V>
 void Clock3::sweep_lattice_disorder(float beta, std::mt19937 &engine)
 {
+    std::uint64_t n_draw = 0;
+
     for (size_t i = 0; i < size; i++) {
-        size_t pos = static_cast<size_t>(rand0(engine) * size);
+        size_t pos = visit_site<V>(i, engine);
 
-        // Compute new angle
-        int new_angle;
-        do {
-            new_angle = static_cast<int>(rand0(engine) * q);
-        } while(new_angle == spin[pos]);
+        // Spins of a later update, whose neighbor entries are prefetched by now
+        if (V == Visit::prefetch)
+            prefetch_spins(upcoming_site(i));
 
-        // Compute energy change
-        float delta_E = 0.0;
-        for (size_t i = 0; i < n_neigh; i++) {
-            size_t neigh_angle = spin[neigh[pos].neighbor[i]];
-            size_t old_angle   = spin[pos];
+        if (metropolis_site<false>(pos, beta, engine, n_draw))
+            INSTRUMENT_ADD(counters, accepted, 1);
+    } // Loop over sites
 
-            size_t old_idx = (old_angle - neigh_angle + q) % q;
-            size_t new_idx = (new_angle - neigh_angle + q) % q;
+    INSTRUMENT_ADD(counters, angle_draws, n_draw);
+}
 
-            delta_E += J[pos].J_arr[i] * (cos_val[old_idx] - cos_val[new_idx]);
-        }
+/* sweep_overrelax_clean()
+ * Performs an over-relaxation sweep (see reflect_site()). The sites are visited in order.
+ */
+void Clock3::sweep_overrelax_clean(float beta, std::mt19937 &engine)
+{
+    for (size_t pos = 0; pos < size; pos++)
+        reflect_site<true>(pos, beta, engine);
+}
+
+
+/* sweep_overrelax_disorder()
+ * Performs an over-relaxation sweep with the disordered exchange table.
+ */
+void Clock3::sweep_overrelax_disorder(float beta, std::mt19937 &engine)
+{
+    for (size_t pos = 0; pos < size; pos++)
+        reflect_site<false>(pos, beta, engine);
+}
+
+
+/* sweep_lattice()
+ * Performs one Metropolis sweep followed by n_overrelax over-relaxation sweeps.
+ */
+void Clock3::sweep_lattice(float beta, std::mt19937 &engine)
+{
+    if (isClean) {
+        dispatch_visit([&](auto v) { sweep_lattice_clean<decltype(v)::value>(beta, engine); });
+        for (size_t i = 0; i < n_overrelax; i++)
+            sweep_overrelax_clean(beta, engine);
+    } else {
+        dispatch_visit([&](auto v) { sweep_lattice_disorder<decltype(v)::value>(beta, engine); });
+        for (size_t i = 0; i < n_overrelax; i++)
+            sweep_overrelax_disorder(beta, engine);
+    }
+}
+
+
+/* propose()
+ * Proposes a new random angle for the spin at pos and returns the energy change.
+ */
+double Clock3::propose(size_t pos, std::mt19937 &engine)
+{
+    std::uint64_t n_draw = 0;
+    proposal             = draw_angle(pos, engine, n_draw);
+
+    return isClean ? change_energy<true>(pos, proposal) : change_energy<false>(pos, proposal);
+}
+
+
+/* accept()
+ * Sets the spin at pos to the last proposed angle.
+ */
+void Clock3::accept(size_t pos)
+{
+    spin[pos] = proposal;
+}
 
 
-        // Accept / reject new spin
-        if (rand0(engine) < exp(-beta * delta_E))
-            spin[pos] = new_angle;
+/* energy()
+ * Returns the total energy of the lattice.
+ */
+double Clock3::energy() const
+{
+    return energy_sites(0, size);
+}
+
+
+/* magnetization2()
+ * Returns the square of the total magnetization of the lattice.
+ */
+double Clock3::magnetization2() const
+{
+    double Mx, My;
+    magnetization_sites(0, size, Mx, My);
+
+    return Mx * Mx + My * My;
+}
+
+
+/* energy_sites()
+ * Returns the energy of the bonds 1, 2 and 4 of the sites in [first, last).
+ */
+double Clock3::energy_sites(size_t first, size_t last) const
+{
+    double E_tot = 0.0;
+
+    for (size_t j = first; j < last; j++) {
+        // Compute energy using the 1, 2, and 4 neighboring bonds
+        size_t pos_angle = spin[j];
+        size_t neigh1    = spin[neigh[j].neighbor[1]];
+        size_t neigh2    = spin[neigh[j].neighbor[2]];
+        size_t neigh3    = spin[neigh[j].neighbor[4]];
+
+        size_t E_idx1 = (pos_angle - neigh1 + q) % q;
+        size_t E_idx2 = (pos_angle - neigh2 + q) % q;
+        size_t E_idx3 = (pos_angle - neigh3 + q) % q;
+
+        if (isClean)
+            E_tot += -(cos_val[E_idx1] + cos_val[E_idx2] + cos_val[E_idx3]);
+        else
+            E_tot += -(J[j].J_arr[1] * cos_val[E_idx1] + J[j].J_arr[2] * cos_val[E_idx2] +
+                       J[j].J_arr[4] * cos_val[E_idx3]);
+    } // Compute energy of lattice
+
+    return E_tot;
+}
+
+
+/* magnetization_sites()
+ * Computes the magnetization of the sites in [first, last).
+ */
+void Clock3::magnetization_sites(size_t first, size_t last, double &Mx, double &My) const
+{
+    double mx = 0.0, my = 0.0;
+    #pragma omp simd reduction(+:mx, my)
+    for (size_t j = first; j < last; j++) {
+        mx += cos_val[spin[j]];
+        my += sin_val[spin[j]];
     }
+
+    Mx = mx;
+    My = my;
+}
+
+
+/* update_site()
+ * Proposes a new random angle for the spin at pos with the Metropolis Algorithm (see
+ * metropolis_site()). Returns true if it was accepted.
+ */
+bool Clock3::update_site(size_t pos, float beta, std::mt19937 &engine)
+{
+    std::uint64_t n_draw = 0;
+
+    if (isClean)
+        return metropolis_site<true>(pos, beta, engine, n_draw);
+    else
+        return metropolis_site<false>(pos, beta, engine, n_draw);
+}
+
+
+/* overrelax_site()
+ * Over-relaxes the spin at pos (see reflect_site()).
+ */
+void Clock3::overrelax_site(size_t pos, float beta, std::mt19937 &engine)
+{
+    if (isClean)
+        reflect_site<true>(pos, beta, engine);
+    else
+        reflect_site<false>(pos, beta, engine);
+}
+
+
+/* overrelax_sweeps()
+ * Returns the number of over-relaxation sweeps after each Metropolis sweep.
+ */
+size_t Clock3::overrelax_sweeps() const
+{
+    return n_overrelax;
+}
+
+
+/* prefetch_spins()
+ * Prefetches the spins of pos and its neighbors for the update of pos (see site_order.h).
+ */
+void Clock3::prefetch_spins(size_t pos) const
+{
+    if (pos >= size)
+        return;
+
+    __builtin_prefetch(&spin[pos], 1);
+    for (size_t k = 0; k < n_neigh; k++)
+        __builtin_prefetch(&spin[neigh[pos].neighbor[k]]);
 }
 
 
@@ -82,7 +325,7 @@ void Clock3::sweep_lattice_disorder(float beta, std::mt19937 &engine)
 
 /* Constructor with arguments
  */
-Clock3::Clock3(const int L, const int _q) : Model3(L), q(_q)
+Clock3::Clock3(const int L, const int _q) : Model3(L), q(_q), n_overrelax(0)
 {
     spin.resize(size);
     cos_val.resize(q);
@@ -100,7 +343,8 @@ Clock3::Clock3(const int L, const int _q) : Model3(L), q(_q)
 /* Copy constructor
  */
 Clock3::Clock3(const Clock3 &rhs) :
-    Model3(rhs), q(rhs.q), spin(rhs.spin), cos_val(rhs.cos_val), sin_val(rhs.sin_val)
+    Model3(rhs), q(rhs.q), n_overrelax(rhs.n_overrelax), spin(rhs.spin), cos_val(rhs.cos_val),
+    sin_val(rhs.sin_val)
 {
 }
 
@@ -108,116 +352,59 @@ Clock3::Clock3(const Clock3 &rhs) :
 /* set_spin()
  * Sets the angle index representing the spin
  */
-void Clock3::set_spin()
+void Clock3::set_spin(std::mt19937 &engine)
 {
-    std::random_device rd;
-    std::mt19937 engine(rd());
     for (size_t i = 0; i < size; i++)
         spin[i] = static_cast<int>(rand0(engine) * q);
 }
 
 
-/* sweep_energy()
+/* set_overrelax()
+ * Sets the number of over-relaxation sweeps performed after each Metropolis sweep.
  */
-double Clock3::sweep_energy(double beta, std::mt19937 &engine)
+void Clock3::set_overrelax(size_t n_over)
 {
-    double E_tot = 0.0;
-
-    if (isClean) {
-        for (size_t i = 0; i < warmup; i++)
-            sweep_lattice_clean(beta, engine);
-
-        for (size_t i = 0; i < measure; i++) {
-            sweep_lattice_clean(beta, engine);
-
-            for (size_t j = 0; j < size; j++) {
-                // Compute energy using the 1, 2, and 4 neighboring bonds
-                size_t pos_angle = spin[j];
-                size_t neigh1    = spin[neigh[j].neighbor[1]];
-                size_t neigh2    = spin[neigh[j].neighbor[2]];
-                size_t neigh3    = spin[neigh[j].neighbor[4]];
-
-                size_t E_idx1 = (pos_angle - neigh1 + q) % q;
-                size_t E_idx2 = (pos_angle - neigh2 + q) % q;
-                size_t E_idx3 = (pos_angle - neigh3 + q) % q;
-
-                E_tot += -(cos_val[E_idx1] + cos_val[E_idx2] + cos_val[E_idx3]);
-            } // Compute energy of lattice
-        } // Measurement sweeps
-    } else {
-        for (size_t i = 0; i < warmup; i++)
-            sweep_lattice_disorder(beta, engine);
-
-        for (size_t i = 0; i < measure; i++) {
-            sweep_lattice_disorder(beta, engine);
+    n_overrelax = n_over;
+}
 
-            for (size_t j = 0; j < size; j++) {
-                // Compute energy using the 1, 2, and 4 neighboring bonds
-                size_t pos_angle = spin[j];
-                size_t neigh1    = spin[neigh[j].neighbor[1]];
-                size_t neigh2    = spin[neigh[j].neighbor[2]];
-                size_t neigh3    = spin[neigh[j].neighbor[4]];
 
-                size_t E_idx1 = (pos_angle - neigh1 + q) % q;
-                size_t E_idx2 = (pos_angle - neigh2 + q) % q;
-                size_t E_idx3 = (pos_angle - neigh3 + q) % q;
+/* get_q()
+ * Returns the number of spin states.
+ */
+int Clock3::get_q() const
+{
+    return q;
+}
 
-                E_tot += -(J[j].J_arr[1] * cos_val[E_idx1] + J[j].J_arr[2] * cos_val[E_idx2] +
-                           J[j].J_arr[4] * cos_val[E_idx3]);
-            } // Compute energy of lattice
-        } // Measurement sweeps
-    } // Choose if there is or isn't disorder
 
-    return E_tot / static_cast<double>(measure * size);
+/* get_overrelax()
+ * Returns the number of over-relaxation sweeps performed after each Metropolis sweep.
+ */
+size_t Clock3::get_overrelax() const
+{
+    return n_overrelax;
 }
 
-/* sweep_binder()
- * Performs binder sweep.
+
+/* save()
+ * Writes the model and its spins in binary.
  */
-double Clock3::sweep_binder(double beta, std::mt19937 &engine)
+void Clock3::save(std::ostream &os) const
 {
-    double M2 = 0.0, M4 = 0.0;
-
-    if (isClean) {
-        for (size_t i = 0; i < warmup; i++)
-            sweep_lattice_clean(beta, engine);
-
-        for (size_t i = 0; i < measure; i++) {
-            sweep_lattice_clean(beta, engine);
-
-            double Mx = 0.0, My = 0.0;
-            #pragma omp simd reduction(+:Mx, My)
-            for (size_t j = 0; j < size; j++) {
-                Mx += cos_val[spin[j]];
-                My += sin_val[spin[j]];
-            }
-
-            double M = sqrt(Mx * Mx + My * My);
-            M2 += M * M;
-            M4 += M * M * M * M;
-        }
-    } else {
-        for (size_t i = 0; i < warmup; i++)
-            sweep_lattice_disorder(beta, engine);
-
-        for (size_t i = 0; i < measure; i++) {
-            sweep_lattice_disorder(beta, engine);
-
-            double Mx = 0.0, My = 0.0;
-            #pragma omp simd reduction(+:Mx, My)
-            for (size_t j = 0; j < size; j++) {
-                Mx += cos_val[spin[j]];
-                My += sin_val[spin[j]];
-            }
-
-            double M = sqrt(Mx * Mx + My * My);
-            M2 += M * M;
-            M4 += M * M * M * M;
-        }
-    }
+    Model3::save(os);
+    write_binary(os, q);
+    write_binary(os, n_overrelax);
+    write_binary(os, spin);
+}
 
-    M2 /= static_cast<double>(measure);
-    M4 /= static_cast<double>(measure);
 
-    return 1.0 - (M4 / (3.0 * M2 * M2));
+/* load()
+ * Reads back the data written by save().
+ */
+void Clock3::load(std::istream &is)
+{
+    Model3::load(is);
+    read_binary(is, q);
+    read_binary(is, n_overrelax);
+    read_binary(is, spin);
 }
@@ -0,0 +1,133 @@
+#include <cmath>
+#include <algorithm>
+#include <random>
+
+#include "../include/crossing.h"
+#include "../include/refine.h"
+
+
+/*-------------------------------------------------------------------------------------------------
+ * HELPER FUNCTIONS
+ *-----------------------------------------------------------------------------------------------*/
+
+/* mean_curve()
+ * Averages the curves of the realizations listed in pick.
+ */
+static std::vector<double> mean_curve(const std::vector<std::vector<double>> &curve,
+        const std::vector<std::size_t> &pick)
+{
+    std::vector<double> mean(curve[0].size(), 0.0);
+
+    for (auto r : pick)
+        for (std::size_t k = 0; k < mean.size(); k++)
+            mean[k] += curve[r][k];
+
+    for (auto &&ele : mean)
+        ele /= static_cast<double>(pick.size());
+
+    return mean;
+}
+
+
+/*-------------------------------------------------------------------------------------------------
+ * CROSSINGS
+ *-----------------------------------------------------------------------------------------------*/
+
+/* find_crossing()
+ * Finds the crossing of the Binder ratios U1 of the smaller and U2 of the larger lattice on the
+ * grid T. Returns false if there is none.
+ */
+bool find_crossing(const std::vector<double> &T, const std::vector<double> &U1,
+        const std::vector<double> &U2, double &T_c)
+{
+    if (T.size() < 2)
+        return false;
+
+    for (std::size_t k = T.size() - 1; k-- > 0;) {
+        const double d0   = U1[k] - U2[k];
+        const double d1   = U1[k + 1] - U2[k + 1];
+        const double mean = 0.25 * (U1[k] + U2[k] + U1[k + 1] + U2[k + 1]);
+
+        if ((d0 < 0.0) != (d1 < 0.0) && mean > binder_floor) {
+            T_c = T[k] + (T[k + 1] - T[k]) * d0 / (d0 - d1);
+            return true;
+        }
+    } // Loop over intervals from high T
+
+    return false;
+}
+
+
+/* binder_crossings()
+ * Returns the crossings of every pair of consecutive L. binder holds the Binder ratio of every
+ * L, realization and temperature.
+ */
+std::vector<Crossing> binder_crossings(const std::vector<double> &T, const std::vector<int> &L,
+        const std::vector<std::vector<std::vector<double>>> &binder, std::size_t n_boot,
+        unsigned seed)
+{
+    const std::size_t n_L    = L.size();
+    const std::size_t n_pair = n_L > 0 ? n_L - 1 : 0;
+    std::vector<Crossing> cross(n_pair);
+    std::vector<std::vector<double>> mean(n_L);
+    bool resample = n_boot > 0;
+
+    for (std::size_t i = 0; i < n_L; i++) {
+        std::vector<std::size_t> all(binder[i].size());
+        for (std::size_t r = 0; r < all.size(); r++)
+            all[r] = r;
+        mean[i] = mean_curve(binder[i], all);
+        resample = resample && binder[i].size() > 1;
+    } // Loop over L
+
+    for (std::size_t p = 0; p < n_pair; p++) {
+        cross[p] = Crossing{L[p], L[p + 1], 0.0, 0.0, false, 0};
+        cross[p].found = find_crossing(T, mean[p], mean[p + 1], cross[p].T_c);
+    } // Loop over pairs
+
+    if (!resample)
+        return cross;
+
+    // Crossings of every resample, NAN where a resample has none
+    std::vector<std::vector<double>> boot(n_pair, std::vector<double>(n_boot, NAN));
+
+    #pragma omp parallel for schedule(static)
+    for (long b = 0; b < static_cast<long>(n_boot); b++) {
+        std::seed_seq seq{seed, static_cast<unsigned>(b)};
+        std::mt19937 engine(seq);
+        std::vector<std::vector<double>> curve(n_L);
+
+        for (std::size_t i = 0; i < n_L; i++) {
+            std::uniform_int_distribution<std::size_t> draw(0, binder[i].size() - 1);
+            std::vector<std::size_t> pick(binder[i].size());
+            for (auto &&r : pick)
+                r = draw(engine);
+            curve[i] = mean_curve(binder[i], pick);
+        } // Loop over L
+
+        for (std::size_t p = 0; p < n_pair; p++) {
+            double T_c;
+            if (find_crossing(T, curve[p], curve[p + 1], T_c))
+                boot[p][b] = T_c;
+        } // Loop over pairs
+    } // Loop over resamples
+
+    for (std::size_t p = 0; p < n_pair; p++) {
+        double sum = 0.0, sum2 = 0.0;
+
+        for (auto val : boot[p]) {
+            if (std::isnan(val))
+                continue;
+            sum  += val;
+            sum2 += val * val;
+            cross[p].n_found++;
+        } // Loop over resamples
+
+        if (cross[p].n_found > 1) {
+            const double n = static_cast<double>(cross[p].n_found);
+            cross[p].err   = std::sqrt(std::max(0.0, (sum2 - sum * sum / n) / (n - 1.0)));
+        }
+    } // Loop over pairs
+
+    return cross;
+}
@@ -1,62 +1,207 @@
+#include <cstdio>
+#include <cstdlib>
+#include <utility>
+#include <algorithm>
+
 #include "../include/data_matrix.h"
 
 
+/*-------------------------------------------------------------------------------------------------
+ * PRIVATE METHODS
+ *-----------------------------------------------------------------------------------------------*/
+
+/* format()
+ * Formats the matrix as text, one row per line, with precision significant digits. If every
+ * column has a name, a "#" line of the names comes first.
+ */
+std::string Data_matrix::format(int precision) const
+{
+    const size_t width = static_cast<size_t>(precision) + 9;    // Sign, point, exponent, space
+    std::string out;
+    char buf[64];
+
+    if (has_names()) {
+        out += '#';
+        for (auto &&ele : name)
+            out += ' ' + ele;
+        out += '\n';
+    }
+
+    out.reserve(out.size() + N_row * (N_col * width + 1));
+    for (size_t i = 0; i < N_row; i++) {
+        for (size_t j = 0; j < N_col; j++) {
+            const int n = snprintf(buf, sizeof(buf), "%.*g ", precision, data[j * N_row + i]);
+            out.append(buf, static_cast<size_t>(n));
+        }
+        out += '\n';
+    } // Loop over rows
+
+    return out;
+}
+
+
+/*-------------------------------------------------------------------------------------------------
+ * PUBLIC METHODS
+ *-----------------------------------------------------------------------------------------------*/
+
 /* Default constructor
  */
-Data_matrix::Data_matrix() : N_row(0), N_col(0), filled_row(0), data(nullptr)
+Data_matrix::Data_matrix() : N_row(0), N_col(0), filled_col(0)
 {
 }
 
 
 /* Constructor with arguments
  */
-Data_matrix::Data_matrix(size_t r, size_t c) : N_row(r), N_col(c), filled_row(0)
+Data_matrix::Data_matrix(size_t r, size_t c) : N_row(r), N_col(c), filled_col(0), data(r * c),
+    name(c)
 {
-    data = new double[r * c];
 }
 
 
-/* Copy constructor
+/* Move constructor
+ * Takes the storage of rhs and leaves it empty.
  */
-Data_matrix::Data_matrix(const Data_matrix &rhs) :
-    N_row(rhs.N_row), N_col(rhs.N_col), filled_row(rhs.filled_row), data(rhs.data)
+Data_matrix::Data_matrix(Data_matrix &&rhs) noexcept :
+    N_row(rhs.N_row), N_col(rhs.N_col), filled_col(rhs.filled_col), data(std::move(rhs.data)),
+    name(std::move(rhs.name))
 {
+    rhs.N_row = rhs.N_col = rhs.filled_col = 0;
 }
 
 
-/* Destuctor
+/* Move assignment
  */
-Data_matrix::~Data_matrix()
+Data_matrix& Data_matrix::operator=(Data_matrix &&rhs) noexcept
 {
-    if (data)
-        delete[] data;
+    if (this != &rhs) {
+        N_row      = rhs.N_row;
+        N_col      = rhs.N_col;
+        filled_col = rhs.filled_col;
+        data       = std::move(rhs.data);
+        name       = std::move(rhs.name);
+        rhs.N_row  = rhs.N_col = rhs.filled_col = 0;
+    }
+
+    return *this;
 }
 
 
 /* insert_array()
- * Takes a pointer to an array of data and inserts data. Assumes that the
- * input has N_row amount of data. Note that the data is stored in column major ordering.
+ * Takes a pointer to an array of data and inserts it as the next column. Assumes that the
+ * input has N_row amount of data.
  */
-void Data_matrix::insert_array(const double *input)
+void Data_matrix::insert_array(const double *input, const std::string &col_name)
 {
-    for (size_t i = 0; i < N_row; i++)
-        data[i * N_col + filled_row] = input[i];
+    if (filled_col >= N_col) {
+        std::cerr << "Error: Data_matrix has only " << N_col << " columns." << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    std::copy(input, input + N_row, data.begin() + filled_col * N_row);
+    name[filled_col] = col_name;
 
-    filled_row++;
+    filled_col++;
+}
+
+
+/* rows()
+ * Returns the number of rows.
+ */
+size_t Data_matrix::rows() const
+{
+    return N_row;
+}
+
+
+/* cols()
+ * Returns the number of columns.
+ */
+size_t Data_matrix::cols() const
+{
+    return N_col;
+}
+
+
+/* get()
+ * Returns a single value.
+ */
+double Data_matrix::get(size_t row, size_t col) const
+{
+    return data[col * N_row + row];
+}
+
+
+/* column()
+ * Returns the N_row contiguous values of a column.
+ */
+const double* Data_matrix::column(size_t col) const
+{
+    return data.data() + col * N_row;
+}
+
+
+/* column()
+ * Returns the values of the column with a name, or nullptr if there is none.
+ */
+const double* Data_matrix::column(const std::string &col_name) const
+{
+    for (size_t j = 0; j < N_col; j++)
+        if (name[j] == col_name)
+            return column(j);
+
+    return nullptr;
+}
+
+
+/* get_name()
+ * Returns the name of a column, empty if it has none.
+ */
+const std::string& Data_matrix::get_name(size_t col) const
+{
+    return name[col];
+}
+
+
+/* has_names()
+ * Returns true if every column has a name.
+ */
+bool Data_matrix::has_names() const
+{
+    if (N_col == 0)
+        return false;
+
+    for (auto &&ele : name)
+        if (ele.empty())
+            return false;
+
+    return true;
+}
+
+
+/* write_text()
+ * Writes the matrix as text to a file with a single write.
+ */
+void Data_matrix::write_text(const std::string &filename, int precision) const
+{
+    const std::string out = format(precision);
+    FILE *fp = fopen(filename.c_str(), "w");
+
+    if (!fp || fwrite(out.data(), 1, out.size(), fp) != out.size() || fclose(fp) != 0) {
+        std::cerr << "Error: Could not write " << filename << std::endl;
+        exit(EXIT_FAILURE);
+    }
 }
 
 
 /* overload <<
- * Outputs columns of data as a matrix.
+ * Outputs columns of data as a matrix, with the precision of the stream.
  */
 std::ostream& operator<<(std::ostream &os, const Data_matrix &rhs)
 {
-    for (size_t i = 0; i < rhs.N_row; i++) {
-        for (size_t j = 0; j < rhs.N_col; j++) {
-            os << rhs.data[i * rhs.N_col + j] << ' ';
-        }
-        os << '\n';
-    }
+    const std::string out = rhs.format(static_cast<int>(os.precision()));
+
+    os.write(out.data(), static_cast<std::streamsize>(out.size()));
     os << std::flush;
 
     return os;
@@ -4,14 +4,30 @@
 #include <algorithm>
 #include <random>
 #include <type_traits>
+#include <sstream>
+#include <vector>
 #include <omp.h>
 
+#include "../include/clock2.h"
+#include "../include/clock3.h"
+#include "../include/xy2.h"
+#include "../include/xy3.h"
+#include "../include/batch.h"
+#include "../include/checkpoint.h"
+#include "../include/observables.h"
+#include "../include/grid.h"
+#include "../include/entropy.h"
+#include "../include/placement.h"
+#include "../include/instrument.h"
+#include "../include/progress.h"
+
 
 /* compute_energy()
  * Finds the energy of a clean model.
  */
 template <typename TT, typename Model, size_t N>
-std::array<TT, N> compute_energy(const std::array<TT, N> &T, Model &model)
+std::array<TT, N> compute_energy(const std::array<TT, N> &T, Model &model, Checkpoint *ckpt,
+        Time_series *ts)
 {
     if (!(std::is_same<double, TT>::value || std::is_same<float, TT>::value)) {
         std::cerr << "Error: Expected array of floar or double." << std::endl;
@@ -20,7 +36,19 @@ std::array<TT, N> compute_energy(const std::array<TT, N> &T, Model &model)
 
     std::array<TT, N> E = {0};
 
-    run_mc_energy(T, E, model);
+    int first = start_checkpoint(ckpt, E);
+
+    if (ckpt && first >= 0 && ckpt->is_complete())
+        return E;
+    else if (ckpt && first < 0)
+        ckpt->begin_run(0, std::vector<double>(E.begin(), E.end()));
+
+    run_mc(T, E, model, [](Model &m, double beta, std::mt19937 &engine) {
+            return m.sweep_energy(beta, engine);
+    }, ckpt, ts, 0);
+
+    if (ckpt)
+        ckpt->finish(std::vector<double>(E.begin(), E.end()));
 
     return E;
 }
@@ -30,7 +58,8 @@ std::array<TT, N> compute_energy(const std::array<TT, N> &T, Model &model)
  * Finds the binder ratio for a clean model.
  */
 template <typename TT, typename Model, size_t N>
-std::array<TT, N> compute_binder(const std::array<TT, N> &T, Model &model)
+std::array<TT, N> compute_binder(const std::array<TT, N> &T, Model &model, Checkpoint *ckpt,
+        Time_series *ts)
 {
     if ((!std::is_same<double, TT>::value || std::is_same<float, TT>::value)) {
         std::cerr << "Error: Expected array of float or double." << std::endl;
@@ -39,7 +68,19 @@ std::array<TT, N> compute_binder(const std::array<TT, N> &T, Model &model)
 
     std::array<TT, N> binder = {0};
 
-    run_mc_binder(T, binder, model);
+    int first = start_checkpoint(ckpt, binder);
+
+    if (ckpt && first >= 0 && ckpt->is_complete())
+        return binder;
+    else if (ckpt && first < 0)
+        ckpt->begin_run(0, std::vector<double>(binder.begin(), binder.end()));
+
+    run_mc(T, binder, model, [](Model &m, double beta, std::mt19937 &engine) {
+            return m.sweep_binder(beta, engine);
+    }, ckpt, ts, 0);
+
+    if (ckpt)
+        ckpt->finish(std::vector<double>(binder.begin(), binder.end()));
 
     return binder;
 }
@@ -50,25 +91,21 @@ std::array<TT, N> compute_binder(const std::array<TT, N> &T, Model &model)
  */
 template <typename TT, typename Model, size_t N>
 std::array<TT, N> compute_energy(const std::array<TT, N> &T, Model &model,
-        double delta, int n_run)
+        double delta, int n_run, Checkpoint *ckpt, Time_series *ts)
 {
     if (!(std::is_same<double, TT>::value || std::is_same<float, TT>::value)) {
         std::cerr << "Error: Expected array of floar or double." << std::endl;
         exit(EXIT_FAILURE);
     } // Check for correct inputs.
 
-    std::array<TT, N> E = {0};
-
-    for (int run = 0; run < n_run; run++) {
-        model.set_exchange(delta);
-        run_mc_energy(T, E, model);
-    } // Loop over runs
+    std::array<TT, N> out{};
 
-    // Normalize data
-    std::transform(E.begin(), E.end(), E.begin(),
-            [n_run](double val) { return val / static_cast<double>(n_run); });
+    disorder_average(T, out, model, delta, n_run, 1,
+            [](Model &m, double beta, std::mt19937 &engine, int) {
+                return m.sweep_energy(beta, engine);
+            }, ckpt, ts);
 
-    return E;
+    return out;
 }
 
 
@@ -77,44 +114,235 @@ std::array<TT, N> compute_energy(const std::array<TT, N> &T, Model &model,
  */
 template <typename TT, typename Model, size_t N>
 std::array<TT, N> compute_binder(const std::array<TT, N> &T, Model &model,
-        double delta, int n_run)
+        double delta, int n_run, Checkpoint *ckpt, Time_series *ts)
 {
     if (!(std::is_same<double, TT>::value || std::is_same<float, TT>::value)) {
         std::cerr << "Error: Expected array of floar or double." << std::endl;
         exit(EXIT_FAILURE);
     } // Check for correct inputs.
 
-    std::array<TT, N> binder = {0};
+    std::array<TT, N> out{};
 
-    for (int run = 0; run < n_run; run++) {
-        model.set_exchange(delta);
-        run_mc_binder(T, binder, model);
-    } // Loop over runs
+    disorder_average(T, out, model, delta, n_run, 1,
+            [](Model &m, double beta, std::mt19937 &engine, int) {
+                return m.sweep_binder(beta, engine);
+            }, ckpt, ts);
 
-    std::transform(binder.begin(), binder.end(), binder.begin(),
-            [n_run](double val) { return val / static_cast<double>(n_run); });
+    return out;
+}
 
-    return binder;
+/* compute_energy()
+ * Disorder average of the energy for the Clock2 model, computed with Clock_batch<2>.
+ */
+template <typename TT, size_t N>
+std::array<TT, N> compute_energy(const std::array<TT, N> &T, Clock2 &model,
+        double delta, int n_run, Checkpoint *ckpt, Time_series *ts)
+{
+    return compute_energy_batch(T, Clock_batch<2>(model), delta, n_run, ckpt, ts);
+}
+
+
+/* compute_energy()
+ * Disorder average of the energy for the Clock3 model, computed with Clock_batch<3>.
+ */
+template <typename TT, size_t N>
+std::array<TT, N> compute_energy(const std::array<TT, N> &T, Clock3 &model,
+        double delta, int n_run, Checkpoint *ckpt, Time_series *ts)
+{
+    return compute_energy_batch(T, Clock_batch<3>(model), delta, n_run, ckpt, ts);
+}
+
+
+/* compute_energy()
+ * Disorder average of the energy for the XY2 model, computed with XY_batch<2>.
+ */
+template <typename TT, size_t N>
+std::array<TT, N> compute_energy(const std::array<TT, N> &T, XY2 &model,
+        double delta, int n_run, Checkpoint *ckpt, Time_series *ts)
+{
+    return compute_energy_batch(T, XY_batch<2>(model), delta, n_run, ckpt, ts);
+}
+
+
+/* compute_energy()
+ * Disorder average of the energy for the XY3 model, computed with XY_batch<3>.
+ */
+template <typename TT, size_t N>
+std::array<TT, N> compute_energy(const std::array<TT, N> &T, XY3 &model,
+        double delta, int n_run, Checkpoint *ckpt, Time_series *ts)
+{
+    return compute_energy_batch(T, XY_batch<3>(model), delta, n_run, ckpt, ts);
+}
+
+
+/* compute_binder()
+ * Disorder average of the binder for the Clock2 model, computed with Clock_batch<2>.
+ */
+template <typename TT, size_t N>
+std::array<TT, N> compute_binder(const std::array<TT, N> &T, Clock2 &model,
+        double delta, int n_run, Checkpoint *ckpt, Time_series *ts)
+{
+    return compute_binder_batch(T, Clock_batch<2>(model), delta, n_run, ckpt, ts);
+}
+
+
+/* compute_binder()
+ * Disorder average of the binder for the Clock3 model, computed with Clock_batch<3>.
+ */
+template <typename TT, size_t N>
+std::array<TT, N> compute_binder(const std::array<TT, N> &T, Clock3 &model,
+        double delta, int n_run, Checkpoint *ckpt, Time_series *ts)
+{
+    return compute_binder_batch(T, Clock_batch<3>(model), delta, n_run, ckpt, ts);
+}
+
+
+/* compute_binder()
+ * Disorder average of the binder for the XY2 model, computed with XY_batch<2>.
+ */
+template <typename TT, size_t N>
+std::array<TT, N> compute_binder(const std::array<TT, N> &T, XY2 &model,
+        double delta, int n_run, Checkpoint *ckpt, Time_series *ts)
+{
+    return compute_binder_batch(T, XY_batch<2>(model), delta, n_run, ckpt, ts);
+}
+
+
+/* compute_binder()
+ * Disorder average of the binder for the XY3 model, computed with XY_batch<3>.
+ */
+template <typename TT, size_t N>
+std::array<TT, N> compute_binder(const std::array<TT, N> &T, XY3 &model,
+        double delta, int n_run, Checkpoint *ckpt, Time_series *ts)
+{
+    return compute_binder_batch(T, XY_batch<3>(model), delta, n_run, ckpt, ts);
+}
+
+/* compute_observables()
+ * Finds every observable of a clean model in one run per temperature.
+ */
+template <typename Grid, typename Model>
+typename Grid_output<Grid, Observables>::type compute_observables(const Grid &T, Model &model,
+        Checkpoint *ckpt, Time_series *ts)
+{
+    auto obs = Grid_output<Grid, Observables>::make(T);
+
+    int first = start_checkpoint(ckpt, obs);
+
+    if (ckpt && first >= 0 && ckpt->is_complete())
+        return obs;
+    else if (ckpt && first < 0)
+        ckpt->begin_run(0, acc_vector(obs));
+
+    run_mc(T, obs, model, [](Model &m, double beta, std::mt19937 &engine) {
+            return m.sweep_observables(beta, engine);
+    }, ckpt, ts, 0);
+
+    if (ckpt)
+        ckpt->finish(acc_vector(obs));
+
+    return obs;
+}
+
+
+/* compute_observables()
+ * Disorder average of every observable in one run per temperature and realization.
+ */
+template <typename Grid, typename Model>
+typename Grid_output<Grid, Observables>::type compute_observables(const Grid &T, Model &model,
+        double delta, int n_run, Checkpoint *ckpt, Time_series *ts,
+        std::vector<typename Grid_output<Grid, Observables>::type> *runs)
+{
+    auto out = Grid_output<Grid, Observables>::make(T);
+
+    disorder_average(T, out, model, delta, n_run, 1,
+            [](Model &m, double beta, std::mt19937 &engine, int) {
+                return m.sweep_observables(beta, engine);
+            }, ckpt, ts, runs);
+
+    return out;
+}
+
+
+/* compute_observables()
+ * Disorder average of the observables for the Clock2 model, computed with Clock_batch<2>.
+ */
+template <typename Grid>
+typename Grid_output<Grid, Observables>::type compute_observables(const Grid &T, Clock2 &model,
+        double delta, int n_run, Checkpoint *ckpt, Time_series *ts,
+        std::vector<typename Grid_output<Grid, Observables>::type> *runs)
+{
+    return compute_observables_batch(T, Clock_batch<2>(model), delta, n_run, ckpt, ts, runs);
+}
+
+
+/* compute_observables()
+ * Disorder average of the observables for the Clock3 model, computed with Clock_batch<3>.
+ */
+template <typename Grid>
+typename Grid_output<Grid, Observables>::type compute_observables(const Grid &T, Clock3 &model,
+        double delta, int n_run, Checkpoint *ckpt, Time_series *ts,
+        std::vector<typename Grid_output<Grid, Observables>::type> *runs)
+{
+    return compute_observables_batch(T, Clock_batch<3>(model), delta, n_run, ckpt, ts, runs);
+}
+
+
+/* compute_observables()
+ * Disorder average of the observables for the XY2 model, computed with XY_batch<2>.
+ */
+template <typename Grid>
+typename Grid_output<Grid, Observables>::type compute_observables(const Grid &T, XY2 &model,
+        double delta, int n_run, Checkpoint *ckpt, Time_series *ts,
+        std::vector<typename Grid_output<Grid, Observables>::type> *runs)
+{
+    return compute_observables_batch(T, XY_batch<2>(model), delta, n_run, ckpt, ts, runs);
+}
+
+
+/* compute_observables()
+ * Disorder average of the observables for the XY3 model, computed with XY_batch<3>.
+ */
+template <typename Grid>
+typename Grid_output<Grid, Observables>::type compute_observables(const Grid &T, XY3 &model,
+        double delta, int n_run, Checkpoint *ckpt, Time_series *ts,
+        std::vector<typename Grid_output<Grid, Observables>::type> *runs)
+{
+    return compute_observables_batch(T, XY_batch<3>(model), delta, n_run, ckpt, ts, runs);
+}
+
+
+/* observable_column()
+ * Returns one field of the observables of every temperature, e.g. &Observables::binder.
+ */
+template <typename Obs_grid>
+typename Grid_output<Obs_grid, double>::type observable_column(const Obs_grid &obs,
+        double Observables::*field)
+{
+    auto col = Grid_output<Obs_grid, double>::make(obs);
+
+    for (size_t i = 0; i < obs.size(); i++)
+        col[i] = obs[i].*field;
+
+    return col;
 }
 
 /* compute_entropy()
  * Takes in an energy and a tempearture array, computes the entropy, and outputs to a file.
- * There will be N-1 points in the output file due to the integration.
+ * There will be N-1 points in the output file, the last one has nothing to integrate. See
+ * entropy.h for other rules, errors and runtime sized grids.
  */
 template <typename TT, size_t N>
 void compute_entropy(const std::array<TT, N> &E, const std::array<TT, N> &T, int n_spin,
         const std::string &filename)
 {
     std::ofstream of(filename);
-    const double ln = log(n_spin);
+    const std::vector<Entropy_point> S = entropy(std::vector<double>(T.begin(), T.end()),
+            std::vector<double>(E.begin(), E.end()), std::vector<double>(), log(n_spin),
+            Quadrature::trapezoid);
 
-    std::array<TT, N> integral_values;
-
-    for (size_t i = 0; i < N; i++)
-        integral_values[i] = E[i] / (T[i] * T[i]);
-
-    for (size_t i = 0; i < N - 1; i++)
-        of << T[i] << ' ' << ln + (E[i] / T[i]) - trapezoid(T, integral_values, i) << '\n';
+    for (size_t i = 0; i + 1 < N; i++)
+        of << S[i].T << ' ' << S[i].S << '\n';
 
     of.close();
 }
@@ -140,70 +368,396 @@ void write_energy(const std::array<TT, N> &E, const std::array<TT, N> &T,
  * Intended Helper functions
  *-----------------------------------------------------------------------------------------------*/
 
-/* run_mc_energy()
- * Performs Monte Carlo runs which computes the energy.
+/* start_checkpoint()
+ * Loads the checkpoint if the run is restarted and restores the output accumulated over the
+ * finished realizations, and the realizations kept in runs. Returns the realization to resume or
+ * -1 if there is nothing to resume.
  */
-template <typename TT, typename Model, size_t N>
-void run_mc_energy(const std::array<TT, N> &T, std::array<TT, N> &E, Model model)
+template <typename Out>
+int start_checkpoint(Checkpoint *ckpt, Out &out, std::vector<Out> *runs)
 {
-    int chunk;
+    if (!ckpt || !ckpt->load(acc_vector(out, runs).size()))
+        return -1;
 
-    // TODO: implament omp parallel for arbituary thread count
-    #pragma omp parallel shared(chunk) firstprivate(model) num_threads(4)
-    {
-        #pragma omp single
-        chunk = N / omp_get_num_threads();
+    set_acc(out, runs, ckpt->get_acc());
 
+    return ckpt->get_run();
+}
 
-        int thd_id = omp_get_thread_num();
-        std::random_device rd;
-        std::mt19937 engine(rd());
 
-        for (int i = chunk * thd_id; i < (chunk * (thd_id + 1)); i++) {
-            model.set_spin();
-            E[i] += model.sweep_energy(1.0 / T[i], engine);
-        } // Loop over all temperatures
-    } // Parallel region
+/* acc_vector()
+ * Returns the output as the values stored in a checkpoint. Observables are stored one field
+ * after another, the realizations kept in runs follow the output one after another.
+ */
+template <typename Out>
+std::vector<double> acc_vector(const Out &out, const std::vector<Out> *runs)
+{
+    std::vector<double> acc;
+
+    for (auto &&ele : out)
+        append_acc(acc, ele);
+
+    if (runs)
+        for (auto &&run : *runs)
+            for (auto &&ele : run)
+                append_acc(acc, ele);
+
+    return acc;
 }
 
-/* run_mc_binder()
- * Runs the computation to find the binder ratio.
+
+/* set_acc()
+ * Restores the output, and the realizations kept in runs, from the values stored in a
+ * checkpoint.
  */
-template <typename TT, typename Model, size_t N>
-void run_mc_binder(const std::array<TT, N> &T, std::array<TT, N> &binder, Model model)
+template <typename Out>
+void set_acc(Out &out, std::vector<Out> *runs, const std::vector<double> &acc)
+{
+    const double *pos = acc.data();
+
+    for (auto &&ele : out)
+        pos += read_acc(ele, pos);
+
+    if (runs)
+        for (auto &&run : *runs)
+            for (auto &&ele : run)
+                pos += read_acc(ele, pos);
+}
+
+
+/* append_acc()
+ * Appends one value of the output to the values stored in a checkpoint.
+ */
+template <typename V>
+void append_acc(std::vector<double> &acc, const V &val)
+{
+    acc.push_back(val);
+}
+
+inline void append_acc(std::vector<double> &acc, const Observables &obs)
+{
+    acc.insert(acc.end(), {obs.E, obs.C, obs.M, obs.chi, obs.binder});
+}
+
+
+/* read_acc()
+ * Reads one value of the output from the values stored in a checkpoint. Returns the number of
+ * values read.
+ */
+template <typename V>
+size_t read_acc(V &val, const double *acc)
+{
+    val = acc[0];
+
+    return 1;
+}
+
+inline size_t read_acc(Observables &obs, const double *acc)
+{
+    obs = Observables{acc[0], acc[1], acc[2], acc[3], acc[4]};
+
+    return Observables::n_value;
+}
+
+
+/* disorder_average()
+ * Averages the output of measure over n_run realizations of the disorder into out, which starts
+ * zeroed. Each call of run_mc simulates n_step realizations into a grid of its own, which is then
+ * added to out. A batched measure returns the values of its lanes, of which the first n_real are
+ * realizations. With runs, (*runs)[run] keeps the output of every realization on its own. With a
+ * checkpoint the exchange table of every realization is drawn from the master seed and a
+ * restarted run resumes from the last checkpoint.
+ */
+template <typename Grid, typename Out, typename Model, typename Measure>
+void disorder_average(const Grid &T, Out &out, Model &model,
+        double delta, int n_run, int n_step, Measure measure, Checkpoint *ckpt,
+        Time_series *ts, std::vector<Out> *runs)
+{
+    typedef typename std::decay<decltype(measure(model, 1.0, std::declval<std::mt19937 &>(),
+                1))>::type V;
+
+    if (runs)
+        runs->assign(n_run, out);
+
+    int first = start_checkpoint(ckpt, out, runs);
+
+    if (ckpt && first >= 0 && ckpt->is_complete())
+        return;
+
+    for (int run = std::max(first, 0); run < n_run; run += n_step) {
+        if (ckpt) {
+            if (run != first)
+                ckpt->begin_run(run, acc_vector(out, runs));
+
+            std::mt19937 engine = ckpt->make_engine(run, 0);
+            model.set_exchange(delta, engine);
+        } else {
+            model.set_exchange(delta);
+        }
+
+        const int n_real = std::min(n_step, n_run - run);
+        auto step        = Grid_output<Grid, V>::make(T);
+        run_mc(T, step, model, [&measure, n_real](Model &m, double beta, std::mt19937 &engine) {
+                return measure(m, beta, engine, n_real);
+        }, ckpt, ts, run);
+
+        for (size_t i = 0; i < T.size(); i++)
+            add_run(out[i], runs, run, i, step[i], n_real);
+    } // Loop over runs
+
+    // Normalize data
+    for (auto &&ele : out)
+        ele /= static_cast<double>(n_run);
+
+    if (ckpt)
+        ckpt->finish(acc_vector(out, runs));
+}
+
+
+/* add_run()
+ * Adds the output of the realizations of one call of run_mc at T[i] to the sum, and keeps every
+ * realization in runs. A batch adds its first n_real lanes, realizations run, run + 1, ...
+ */
+template <typename S, typename Out, typename V>
+void add_run(S &sum, std::vector<Out> *runs, int run, size_t i, const V &val, int)
+{
+    sum += val;
+
+    if (runs)
+        (*runs)[run][i] = val;
+}
+
+template <typename S, typename Out, typename V, size_t N>
+void add_run(S &sum, std::vector<Out> *runs, int run, size_t i, const std::array<V, N> &val,
+        int n_real)
 {
-    int chunk;
+    V step{};
+
+    for (int l = 0; l < n_real; l++) {
+        step += val[l];
+        if (runs)
+            (*runs)[run + l][i] = val[l];
+    } // Loop over lanes
+
+    sum += step;
+}
+
 
-    #pragma omp parallel shared(chunk) firstprivate(model) num_threads(4)
+/* run_mc()
+ * Performs the Monte Carlo runs of one realization. Each thread sweeps a chunk of the
+ * temperatures and stores the value returned by measure(model, beta, engine) in out. The team
+ * has the size OpenMP picks (OMP_NUM_THREADS), and the chunks of the threads differ by at most
+ * one temperature.
+ *
+ * With a checkpoint, each thread uses an engine derived from the master seed and stores its slot
+ * after every temperature and every few sweeps. A slot holds the next temperature, the values
+ * already stored by the thread, the engine, and the model if a temperature is in progress. When
+ * the checkpoint was loaded, the threads store their values again and resume from the slot.
+ *
+ * Each thread pins itself (see placement.h) before it copies its replica of model, so the replica
+ * is first touched, and allocated, on the node of the thread.
+ */
+template <typename Grid, typename Out, typename Model, typename Measure>
+void run_mc(const Grid &T, Out &out, Model model, Measure measure, Checkpoint *ckpt,
+        Time_series *ts, int run)
+{
+    typedef typename std::decay<decltype(out[0])>::type V;
+    const int n_T = static_cast<int>(T.size());
+    int n_thd;
+
+    #pragma omp parallel shared(n_thd, model)
     {
+        pin_thread();
+        Model replica(model);
+        note_placement(replica.get_lattice());
+
         #pragma omp single
-        chunk = N / omp_get_num_threads();
+        n_thd = omp_get_num_threads();
+
+        int thd_id   = omp_get_thread_num();
+        int first    = n_T * thd_id / n_thd;
+        int i        = first;
+        int end      = n_T * (thd_id + 1) / n_thd;
+        bool in_task = false;
+        std::vector<V> done;
+        std::mt19937 engine;
+
+        // Stores the slot of the thread
+        auto save_slot = [&](int next, bool task, const std::mt19937 &eng) {
+            std::ostringstream os;
+            write_binary(os, next);
+            write_binary(os, done);
+            write_binary(os, eng);
+            write_binary(os, task);
+            if (task)
+                replica.save(os);
+            ckpt->set_slot(thd_id, os.str());
+        };
+
+        if (ckpt) {
+            engine = ckpt->make_engine(run, thd_id + 1);
+
+            std::string slot;
+            if (ckpt->get_slot(thd_id, slot)) {
+                std::istringstream is(slot);
+                read_binary(is, i);
+                read_binary(is, done);
+                read_binary(is, engine);
+                read_binary(is, in_task);
+                if (in_task)
+                    replica.load(is);
+
+                for (size_t k = 0; k < done.size(); k++)
+                    out[first + k] = done[k];
+            } // Resume from the checkpoint
+
+            replica.set_checkpoint(ckpt->get_every(),
+                    [&](const std::mt19937 &eng) { save_slot(i, true, eng); });
+        } else {
+            std::random_device rd;
+            engine.seed(rd());
+        }
+
+        for (; i < end; i++) {
+            if (!in_task)
+                replica.set_spin(engine);
+            if (ts)
+                replica.set_time_series(ts, thd_id, 1.0 / T[i], run, i);
+            in_task = false;
+
+            auto val = measure(replica, 1.0 / T[i], engine);
+            out[i] = val;
+            done.push_back(val);
+
+            instrument_record(replica.get_length(), T[i], run, replica.get_counters());
+            replica.reset_counters();
+            report_task();
+
+            if (ckpt)
+                save_slot(i + 1, false, engine);
+        } // Loop over thread chunk for temperatures
+    } // Parallel region
+}
+
+
+/* compute_energy_batch()
+ * Disorder average of the energy using a batched engine. Realizations are simulated n_lane at a
+ * time. Lanes past n_run in the last batch are simulated but not counted.
+ */
+template <typename TT, typename Batch_model, size_t N>
+std::array<TT, N> compute_energy_batch(const std::array<TT, N> &T, Batch_model batch,
+        double delta, int n_run, Checkpoint *ckpt, Time_series *ts)
+{
+    if (!(std::is_same<double, TT>::value || std::is_same<float, TT>::value)) {
+        std::cerr << "Error: Expected array of floar or double." << std::endl;
+        exit(EXIT_FAILURE);
+    } // Check for correct inputs.
+
+    const int n_lane = static_cast<int>(Batch_model::n_lane);
+
+    std::array<TT, N> out{};
+
+    disorder_average(T, out, batch, delta, n_run, n_lane,
+            [](Batch_model &b, double beta, std::mt19937 &engine, int) {
+                return b.sweep_energy(beta, engine);
+            }, ckpt, ts);
+
+    return out;
+}
+
+
+/* compute_binder_batch()
+ * Disorder average of the binder ratio using a batched engine.
+ */
+template <typename TT, typename Batch_model, size_t N>
+std::array<TT, N> compute_binder_batch(const std::array<TT, N> &T, Batch_model batch,
+        double delta, int n_run, Checkpoint *ckpt, Time_series *ts)
+{
+    if (!(std::is_same<double, TT>::value || std::is_same<float, TT>::value)) {
+        std::cerr << "Error: Expected array of floar or double." << std::endl;
+        exit(EXIT_FAILURE);
+    } // Check for correct inputs.
 
-        int thd_id = omp_get_thread_num();
+    const int n_lane = static_cast<int>(Batch_model::n_lane);
+
+    std::array<TT, N> out{};
+
+    disorder_average(T, out, batch, delta, n_run, n_lane,
+            [](Batch_model &b, double beta, std::mt19937 &engine, int) {
+                return b.sweep_binder(beta, engine);
+            }, ckpt, ts);
+
+    return out;
+}
+
+
+/* compute_observables_slabs()
+ * Average of every observable over the realizations (one without disorder), each temperature
+ * swept by all threads at once. With runs, (*runs)[r] keeps the observables of realization r.
+ */
+template <typename Grid, typename Model>
+typename Grid_output<Grid, Observables>::type compute_observables_slabs(const Grid &T,
+        Model &model, double delta, int n_run, unsigned seed, Time_series *ts,
+        std::vector<typename Grid_output<Grid, Observables>::type> *runs)
+{
+    auto out         = Grid_output<Grid, Observables>::make(T);
+    const int n_real = delta > 0.0 ? n_run : 1;
+
+    if (runs)
+        runs->assign(n_real, out);
+
+    if (seed == 0) {
         std::random_device rd;
-        std::mt19937 engine(rd());
+        seed = rd();
+    }
 
-        for (int i = chunk * thd_id; i < (chunk * (thd_id + 1)); i++) {
-            model.set_spin();
-            binder[i] += model.sweep_binder(1.0 / T[i], engine);
-        } // Loop over thread chunk for temperatures.
-    } // Parallel region
+    for (int run = 0; run < n_real; run++) {
+        if (delta > 0.0) {
+            std::seed_seq seq{seed, static_cast<unsigned>(run), 0u};
+            std::mt19937 ex_engine(seq);
+            model.set_exchange(delta, ex_engine);
+        }
+
+        for (size_t i = 0; i < T.size(); i++) {
+            std::seed_seq seq{seed, static_cast<unsigned>(run), static_cast<unsigned>(1 + i)};
+            std::mt19937 engine(seq);
+
+            model.set_spin(engine);
+            if (ts)
+                model.set_time_series(ts, 0, 1.0 / T[i], run, static_cast<int>(i));
+            const Observables val = model.sweep_observables_slabs(1.0 / T[i], engine);
+            out[i] += val;
+            if (runs)
+                (*runs)[run][i] = val;
+
+            instrument_record(model.get_length(), T[i], run, model.get_counters());
+            model.reset_counters();
+            report_task();
+        } // Loop over temperatures
+    } // Loop over realizations
+
+    for (auto &&ele : out)
+        ele /= static_cast<double>(n_real);
+
+    return out;
 }
 
 
-/* trapezoid()
- * Perfroms integration with the trapezoidal rule with arbituary step sizes.
+/* compute_observables_batch()
+ * Disorder average of every observable using a batched engine.
  */
-template <typename TT, size_t N>
-double trapezoid(const std::array<TT, N> &x, const std::array<TT, N> &y, int idx)
+template <typename Grid, typename Batch_model>
+typename Grid_output<Grid, Observables>::type compute_observables_batch(const Grid &T,
+        Batch_model batch, double delta, int n_run, Checkpoint *ckpt, Time_series *ts,
+        std::vector<typename Grid_output<Grid, Observables>::type> *runs)
 {
-    double sum = 0.0;
+    const int n_lane = static_cast<int>(Batch_model::n_lane);
+    auto out         = Grid_output<Grid, Observables>::make(T);
 
-    #pragma omp simd reduction(+:sum)
-    for (size_t i = idx; i < N - 1; i++) {
-        double dx = x[i + 1] - x[i];
-        sum += dx * (y[i] + y[i + 1]);
-    } // Loop to compute the integral
+    disorder_average(T, out, batch, delta, n_run, n_lane,
+            [](Batch_model &b, double beta, std::mt19937 &engine, int) {
+                return b.sweep_observables(beta, engine);
+            }, ckpt, ts, runs);
 
-    return 0.5 * sum;
+    return out;
 }
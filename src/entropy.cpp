@@ -0,0 +1,235 @@
+#include <iostream>
+#include <fstream>
+#include <cstdlib>
+#include <algorithm>
+#include <cmath>
+
+#include "../include/entropy.h"
+
+
+/*-------------------------------------------------------------------------------------------------
+ * HELPER FUNCTIONS
+ *-----------------------------------------------------------------------------------------------*/
+
+/* struct : Panel
+ * Weights of the points first, ..., first + n - 1 in the integral over one interval.
+ */
+struct Panel
+{
+    size_t first;
+    size_t n;
+    double w[4];
+};
+
+
+/* lagrange_weight()
+ * Returns the integral over [0, h] of the Lagrange polynomial of node m of the n nodes t.
+ */
+static double lagrange_weight(const double *t, size_t n, size_t m, double h)
+{
+    double c[4] = {1.0, 0.0, 0.0, 0.0};     // Coefficients of the powers of t
+    size_t deg  = 0;
+
+    for (size_t j = 0; j < n; j++) {
+        if (j == m)
+            continue;
+
+        const double den = t[m] - t[j];
+        deg++;
+        for (size_t d = deg; d > 0; d--)
+            c[d] = (c[d - 1] - t[j] * c[d]) / den;
+        c[0] = -t[j] * c[0] / den;
+    } // Loop over the other nodes
+
+    double sum = 0.0, h_pow = h;
+    for (size_t d = 0; d <= deg; d++) {
+        sum   += c[d] * h_pow / static_cast<double>(d + 1);
+        h_pow *= h;
+    }
+
+    return sum;
+}
+
+
+/* make_panels()
+ * Returns the weights of every interval of the grid x for the rule.
+ */
+static std::vector<Panel> make_panels(const std::vector<double> &x, Quadrature rule)
+{
+    const size_t n_pt = x.size();
+    size_t width      = rule == Quadrature::cubic ? 4 : rule == Quadrature::simpson ? 3 : 2;
+    std::vector<Panel> panel(n_pt > 1 ? n_pt - 1 : 0);
+
+    width = std::min(width, n_pt);
+    const size_t lead = width == 4 ? 1 : 0;     // Points of the stencil below the interval
+
+    for (size_t k = 0; k < panel.size(); k++) {
+        double t[4];
+
+        panel[k].first = std::min(k >= lead ? k - lead : 0, n_pt - width);
+        panel[k].n     = width;
+        for (size_t m = 0; m < width; m++)
+            t[m] = x[panel[k].first + m] - x[k];
+        for (size_t m = 0; m < width; m++)
+            panel[k].w[m] = lagrange_weight(t, width, m, x[k + 1] - x[k]);
+    } // Loop over intervals
+
+    return panel;
+}
+
+
+/* panel_integral()
+ * Returns the integral of y over one interval.
+ */
+static double panel_integral(const Panel &p, const std::vector<double> &y)
+{
+    double sum = 0.0;
+
+    for (size_t m = 0; m < p.n; m++)
+        sum += p.w[m] * y[p.first + m];
+
+    return sum;
+}
+
+
+/* point_weight()
+ * Returns the weight of point j in the integral over the intervals from k_lo on.
+ */
+static double point_weight(const std::vector<Panel> &panel, size_t k_lo, size_t j)
+{
+    double w = 0.0;
+
+    for (size_t k = std::max(k_lo, j >= 3 ? j - 3 : 0); k <= j + 2 && k < panel.size(); k++)
+        if (j >= panel[k].first && j < panel[k].first + panel[k].n)
+            w += panel[k].w[j - panel[k].first];
+
+    return w;
+}
+
+
+/*-------------------------------------------------------------------------------------------------
+ * INTEGRATION
+ *-----------------------------------------------------------------------------------------------*/
+
+/* parse_quadrature()
+ * Reads the name of a rule. Returns false if it is unknown.
+ */
+bool parse_quadrature(const std::string &name, Quadrature &rule)
+{
+    if (name == "trapezoid")
+        rule = Quadrature::trapezoid;
+    else if (name == "simpson")
+        rule = Quadrature::simpson;
+    else if (name == "cubic")
+        rule = Quadrature::cubic;
+    else
+        return false;
+
+    return true;
+}
+
+
+/* tail_integral()
+ * Returns the integral of y from every point of the grid x to its last point.
+ */
+std::vector<double> tail_integral(const std::vector<double> &x, const std::vector<double> &y,
+        Quadrature rule)
+{
+    const std::vector<Panel> panel = make_panels(x, rule);
+    std::vector<double> I(x.size(), 0.0);
+
+    for (size_t k = panel.size(); k-- > 0;)
+        I[k] = I[k + 1] + panel_integral(panel[k], y);
+
+    return I;
+}
+
+
+/*-------------------------------------------------------------------------------------------------
+ * ENTROPY
+ *-----------------------------------------------------------------------------------------------*/
+
+/* entropy()
+ * Returns S(T) of the energies E on the ascending grid T. E_err holds the errors of E, or is
+ * empty.
+ */
+std::vector<Entropy_point> entropy(const std::vector<double> &T, const std::vector<double> &E,
+        const std::vector<double> &E_err, double S_inf, Quadrature rule)
+{
+    const size_t n_pt = T.size();
+
+    if (E.size() != n_pt || (!E_err.empty() && E_err.size() != n_pt)) {
+        std::cerr << "Error: entropy() needs E and its errors on every temperature" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    if (n_pt == 0 || T[0] <= 0.0 || !std::is_sorted(T.begin(), T.end())) {
+        std::cerr << "Error: entropy() needs a positive ascending temperature grid" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    const std::vector<Panel> panel = make_panels(T, rule);
+    std::vector<Entropy_point> S(n_pt);
+    std::vector<double> y(n_pt);
+
+    for (size_t j = 0; j < n_pt; j++)
+        y[j] = E[j] / (T[j] * T[j]);
+
+    const std::vector<double> I = tail_integral(T, y, rule);
+
+    for (size_t i = 0; i < n_pt; i++)
+        S[i] = Entropy_point{T[i], S_inf + E[i] / T[i] - I[i], 0.0};
+
+    if (E_err.empty())
+        return S;
+
+    // Variance of the points whose weight does not depend on where the integral starts
+    std::vector<double> tail(n_pt + 3, 0.0);
+    for (size_t j = n_pt; j-- > 0;) {
+        const double c = point_weight(panel, 0, j) * E_err[j] / (T[j] * T[j]);
+        tail[j]        = tail[j + 1] + c * c;
+    }
+
+    for (size_t i = 0; i < n_pt; i++) {
+        double var = tail[i + 3];
+
+        for (size_t j = i >= 2 ? i - 2 : 0; j <= i + 2 && j < n_pt; j++) {
+            double c = -point_weight(panel, i, j) / (T[j] * T[j]);
+            if (j == i)
+                c += 1.0 / T[i];
+            var += c * c * E_err[j] * E_err[j];
+        } // Loop over the points near T_i
+
+        S[i].err = std::sqrt(var);
+    } // Loop over temperatures
+
+    return S;
+}
+
+
+/* entropy()
+ * Returns S(T) of reweighted points, which carry no errors.
+ */
+std::vector<Entropy_point> entropy(const std::vector<Rw_point> &pts, double S_inf,
+        Quadrature rule)
+{
+    std::vector<double> T(pts.size()), E(pts.size());
+
+    for (size_t i = 0; i < pts.size(); i++) {
+        T[i] = pts[i].T;
+        E[i] = pts[i].E;
+    }
+
+    return entropy(T, E, std::vector<double>(), S_inf, rule);
+}
+
+
+/* write_entropy()
+ * Writes T, S and the error of S, one temperature per line.
+ */
+void write_entropy(const std::vector<Entropy_point> &S, const std::string &filename)
+{
+    std::ofstream of(filename);
+
+    for (auto &&pt : S)
+        of << pt.T << ' ' << pt.S << ' ' << pt.err << '\n';
+}
@@ -0,0 +1,106 @@
+#ifdef INSTRUMENT
+
+#include <iostream>
+#include <fstream>
+#include <cstdlib>
+#include <vector>
+#include <mutex>
+#include <algorithm>
+
+#include "../include/instrument.h"
+
+
+/*-------------------------------------------------------------------------------------------------
+ * RECORDS
+ *-----------------------------------------------------------------------------------------------*/
+
+/* struct : Record
+ * Counters of one (L, T, realization) of a label.
+ */
+struct Record
+{
+    std::string label;
+    int L;
+    double T;
+    int run;
+    Counters c;
+};
+
+static std::mutex mtx;
+static std::string current;
+static std::vector<Record> records;
+
+
+/* instrument_label()
+ * Sets the label of the records which do not name one.
+ */
+void instrument_label(const std::string &label)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    current = label;
+}
+
+
+/* instrument_record()
+ * Records the counters of one (L, T, realization) under a label.
+ */
+void instrument_record(const std::string &label, int L, double T, int run, const Counters &c)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    records.push_back(Record{label, L, T, run, c});
+}
+
+
+/* instrument_record()
+ * Records the counters of one (L, T, realization) under the current label.
+ */
+void instrument_record(int L, double T, int run, const Counters &c)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    records.push_back(Record{current, L, T, run, c});
+}
+
+
+/* instrument_write()
+ * Writes the records of a label as JSON, sorted by L, T and realization, and drops them.
+ */
+void instrument_write(const std::string &label, const std::string &filename)
+{
+    std::vector<Record> out;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto mid = std::stable_partition(records.begin(), records.end(),
+                [&label](const Record &rec) { return rec.label != label; });
+        out.assign(mid, records.end());
+        records.erase(mid, records.end());
+    }
+
+    std::sort(out.begin(), out.end(), [](const Record &a, const Record &b) {
+            if (a.L != b.L) return a.L < b.L;
+            if (a.T < b.T || b.T < a.T) return a.T < b.T;
+            return a.run < b.run;
+    });
+
+    std::ofstream os(filename);
+    if (!os) {
+        std::cerr << "Error: Could not open " << filename << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    os << "{\"label\": \"" << label << "\", \"records\": [\n";
+    for (size_t i = 0; i < out.size(); i++) {
+        const Counters &c = out[i].c;
+        const double acc  = c.proposed ? static_cast<double>(c.accepted) /
+                                         static_cast<double>(c.proposed) : 0.0;
+
+        os << "  {\"L\": " << out[i].L << ", \"T\": " << out[i].T << ", \"run\": " << out[i].run
+           << ", \"proposed\": " << c.proposed << ", \"accepted\": " << c.accepted
+           << ", \"acceptance\": " << acc << ", \"angle_draws\": " << c.angle_draws
+           << ", \"t_warmup\": " << c.t_warmup << ", \"t_measure\": " << c.t_measure
+           << ", \"t_observe\": " << c.t_observe << ", \"t_io\": " << c.t_io << "}"
+           << (i + 1 < out.size() ? ",\n" : "\n");
+    } // Loop over records
+    os << "]}\n";
+}
+
+#endif
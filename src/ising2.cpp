@@ -8,151 +8,190 @@
  *-----------------------------------------------------------------------------------------------*/
 
 /* sweep_lattice_clean()
- * Performans Monte Carlo sweeps. Sweeps the lattice once by choosing a random position and
- * proposing a spin flip using the Meteropolis Algorithm. This is done for the lattice size.
+ * Performans Monte Carlo sweeps. Sweeps the lattice once by choosing a position (at random or in
+ * order, see visit_site()) and proposing a spin flip using the Meteropolis Algorithm. This is done
+ * for the lattice size.
  */
+template <Visit V>
 void Ising2::sweep_lattice_clean(float beta, std::mt19937 &engine)
 {
     for (size_t i = 0; i < size; i++) {
-        int pos       = static_cast<int>(rand0(engine) * size);
+        int pos       = static_cast<int>(visit_site<V>(i, engine));
         float delta_E = 2.0 * spin[pos] * (spin[neigh[pos].neighbor[0]] +
                                            spin[neigh[pos].neighbor[1]] +
                                            spin[neigh[pos].neighbor[2]] +
                                            spin[neigh[pos].neighbor[3]]);
 
         // Accept / reject flip
-        if (rand0(engine) < exp(-beta * delta_E))
+        if (rand0(engine) < exp(-beta * delta_E)) {
             spin[pos] = -spin[pos];
+            INSTRUMENT_ADD(counters, accepted, 1);
+        }
     } // Sweep over sites
 }
 
 
 /* sweep_lattice_clean()
- * Performans Monte Carlo sweeps. Sweeps the lattice once by choosing a random position and
- * proposing a spin flip using the Meteropolis Algorithm. This is done for the lattice size.
+ * Performans Monte Carlo sweeps. Sweeps the lattice once by choosing a position (at random or in
+ * order, see visit_site()) and proposing a spin flip using the Meteropolis Algorithm. This is done
+ * for the lattice size.
  */
+template <Visit V>
 void Ising2::sweep_lattice_disorder(float beta, std::mt19937 &engine)
 {
 
     for (size_t i = 0; i < size; i++) {
-        int pos       = static_cast<int>(rand0(engine) * size);
+        int pos       = static_cast<int>(visit_site<V>(i, engine));
         float delta_E = 2.0 * spin[pos] * (J[pos].J_arr[0] * spin[neigh[pos].neighbor[0]] +
                                            J[pos].J_arr[1] * spin[neigh[pos].neighbor[1]] +
                                            J[pos].J_arr[2] * spin[neigh[pos].neighbor[2]] +
                                            J[pos].J_arr[3] * spin[neigh[pos].neighbor[3]]);
 
         // Accept / reject flip
-        if (rand0(engine) < exp(-beta * delta_E))
+        if (rand0(engine) < exp(-beta * delta_E)) {
             spin[pos] = -spin[pos];
+            INSTRUMENT_ADD(counters, accepted, 1);
+        }
     } // Sweep over sites
 }
 
 
-/*-------------------------------------------------------------------------------------------------
- * PUBLIC METHOD
- *-----------------------------------------------------------------------------------------------*/
-
-/* Constructor with arguments
+/* sweep_lattice()
+ * Performs one sweep of the lattice with or without disorder.
  */
-Ising2::Ising2(const int L) : Model2(L)
+void Ising2::sweep_lattice(float beta, std::mt19937 &engine)
 {
-    spin.resize(size);
+    if (isClean)
+        dispatch_visit([&](auto v) { sweep_lattice_clean<decltype(v)::value>(beta, engine); });
+    else
+        dispatch_visit([&](auto v) { sweep_lattice_disorder<decltype(v)::value>(beta, engine); });
 }
 
 
-/* Copy constructor
+/* propose()
+ * Proposes flipping the spin at pos and returns the energy change.
  */
-Ising2::Ising2(const Ising2 &rhs) : Model2(rhs), spin(rhs.spin)
+double Ising2::propose(size_t pos, std::mt19937 &)
 {
+    return flip_energy(pos);
 }
 
 
-/* set_spin()
- * Sets the spin lattice to 1.
+/* accept()
+ * Flips the spin at pos.
  */
-void Ising2::set_spin()
+void Ising2::accept(size_t pos)
 {
-    for (auto &&ele : spin)
-        ele = 1;
+    flip(pos);
 }
 
 
-/* sweep_energy()
- * Performs monte carlo sweeps and calcuates the energy
+/* energy()
+ * Returns the total energy of the lattice.
  */
-double Ising2::sweep_energy(double beta, std::mt19937 &engine)
+double Ising2::energy() const
 {
     double E_tot = 0.0;
 
     if (isClean) {
-        for (size_t i = 0; i < warmup; i++)
-            sweep_lattice_clean(beta, engine);
+        #pragma omp simd reduction(+:E_tot)
+        for (size_t j = 0; j < size; j++)
+            E_tot += -spin[j] * (spin[neigh[j].neighbor[0]] + spin[neigh[j].neighbor[1]]);
+    } else {
+        for (size_t j = 0; j < size; j++)
+            E_tot += -spin[j] * (J[j].J_arr[0] * spin[neigh[j].neighbor[0]] +
+                                 J[j].J_arr[1] * spin[neigh[j].neighbor[1]]);
+    } // Choose wheather to use disorder or no disorder
 
-        for (size_t i = 0; i < measure; i++) {
-            sweep_lattice_clean(beta, engine);
+    return E_tot;
+}
 
-            #pragma omp simd reduction(+:E_tot)
-            for (size_t j = 0; j < size; j++)
-                E_tot += -spin[j] * (spin[neigh[j].neighbor[0]] + spin[neigh[j].neighbor[1]]);
-        } // Perform measurement sweeps
-    } else {
-        for (size_t i = 0; i < warmup; i++)
-            sweep_lattice_disorder(beta, engine);
 
-        for (size_t i = 0; i < measure; i++) {
-            sweep_lattice_disorder(beta, engine);
+/* magnetization2()
+ * Returns the square of the total magnetization of the lattice.
+ */
+double Ising2::magnetization2() const
+{
+    double M = 0.0;
+    #pragma omp simd reduction(+:M)
+    for (size_t j = 0; j < size; j++)
+        M += spin[j];
+
+    return M * M;
+}
 
-            for (size_t j = 0; j < size; j++)
-                E_tot += -spin[j] * (J[j].J_arr[0] * spin[neigh[j].neighbor[0]] +
-                                     J[j].J_arr[1] * spin[neigh[j].neighbor[1]]);
-        } // Perform measurement sweeps
-    } // Choose wheather to sweep with disorder or no disorder
 
-    return E_tot / static_cast<double>(measure * size);
+/*-------------------------------------------------------------------------------------------------
+ * PUBLIC METHOD
+ *-----------------------------------------------------------------------------------------------*/
+
+/* Constructor with arguments
+ */
+Ising2::Ising2(const int L) : Model2(L)
+{
+    spin.resize(size);
 }
 
 
-/* sweep_binder()
- * Performs lattice sweeps and computes the binder ratio.
+/* Copy constructor
  */
-double Ising2::sweep_binder(double beta, std::mt19937 &engine)
+Ising2::Ising2(const Ising2 &rhs) : Model2(rhs), spin(rhs.spin)
 {
-    double M2 = 0.0, M4 = 0.0;
+}
 
-    if (isClean) {
-        for (size_t i = 0; i < warmup; i++)
-            sweep_lattice_clean(beta, engine);
 
-        for (size_t i = 0; i < measure; i++) {
-            sweep_lattice_clean(beta, engine);
+/* set_spin()
+ * Sets the spin lattice to 1.
+ */
+void Ising2::set_spin(std::mt19937 &)
+{
+    for (auto &&ele : spin)
+        ele = 1;
+}
+
 
-            double M = 0.0;
-            #pragma omp simd reduction(+:M)
-            for (size_t j = 0; j < size; j++)
-                M += spin[j];
+/* flip_energy()
+ * Returns the energy change of flipping the spin at pos.
+ */
+double Ising2::flip_energy(size_t pos) const
+{
+    if (isClean)
+        return 2.0 * spin[pos] * (spin[neigh[pos].neighbor[0]] +
+                                  spin[neigh[pos].neighbor[1]] +
+                                  spin[neigh[pos].neighbor[2]] +
+                                  spin[neigh[pos].neighbor[3]]);
+    else
+        return 2.0 * spin[pos] * (J[pos].J_arr[0] * spin[neigh[pos].neighbor[0]] +
+                                  J[pos].J_arr[1] * spin[neigh[pos].neighbor[1]] +
+                                  J[pos].J_arr[2] * spin[neigh[pos].neighbor[2]] +
+                                  J[pos].J_arr[3] * spin[neigh[pos].neighbor[3]]);
+}
 
-            M2 += M * M;
-            M4 += M * M * M * M;
-        } // Measurement sweep
-    } else {
-        for (size_t i = 0; i < warmup; i++)
-            sweep_lattice_disorder(beta, engine);
 
-        for (size_t i = 0; i < measure; i++) {
-            sweep_lattice_disorder(beta, engine);
+/* flip()
+ * Flips the spin at pos.
+ */
+void Ising2::flip(size_t pos)
+{
+    spin[pos] = -spin[pos];
+}
 
-            double M = 0.0;
-            #pragma omp simd reduction(+:M)
-            for (size_t j = 0; j < size; j++)
-                M += spin[j];
 
-            M2 += M * M;
-            M4 += M * M * M * M;
-        } // Measuremet sweep
-    }
+/* save()
+ * Writes the model and its spins in binary.
+ */
+void Ising2::save(std::ostream &os) const
+{
+    Model2::save(os);
+    write_binary(os, spin);
+}
 
-    M2 /= static_cast<double>(measure);
-    M4 /= static_cast<double>(measure);
 
-    return 1.0 - (M4 / (3.0 * M2 * M2));
+/* load()
+ * Reads back the data written by save().
+ */
+void Ising2::load(std::istream &is)
+{
+    Model2::load(is);
+    read_binary(is, spin);
 }
@@ -7,13 +7,15 @@
  *-----------------------------------------------------------------------------------------------*/
 
 /* sweep_lattice_clean()
- * Performans Monte Carlo sweeps. Sweeps the lattice once by choosing a random position and
- * proposing a spin flip using the Meteropolis Algorithm. This is done for the lattice size.
+ * Performans Monte Carlo sweeps. Sweeps the lattice once by choosing a position (at random or in
+ * order, see visit_site()) and proposing a spin flip using the Meteropolis Algorithm. This is done
+ * for the lattice size.
  */
+template <Visit V>
 void Ising3::sweep_lattice_clean(float beta, std::mt19937 &engine)
 {
     for (size_t i = 0; i < size; i++) {
-        int pos       = static_cast<int>(rand0(engine) * size);
+        int pos       = static_cast<int>(visit_site<V>(i, engine));
         float delta_E = 2.0 * spin[pos] * (spin[neigh[pos].neighbor[0]] +
                                            spin[neigh[pos].neighbor[1]] +
                                            spin[neigh[pos].neighbor[2]] +
@@ -22,20 +24,24 @@ void Ising3::sweep_lattice_clean(float beta, std::mt19937 &engine)
                                            spin[neigh[pos].neighbor[5]]);
 
         // Accept / Reject
-        if (rand0(engine) < exp(-beta * delta_E))
+        if (rand0(engine) < exp(-beta * delta_E)) {
             spin[pos] = -spin[pos];
+            INSTRUMENT_ADD(counters, accepted, 1);
+        }
     } // Sweep over sites
 }
 
 
 /* sweep_lattice_clean()
- * Performans Monte Carlo sweeps. Sweeps the lattice once by choosing a random position and
- * proposing a spin flip using the Meteropolis Algorithm. This is done for the lattice size.
+ * Performans Monte Carlo sweeps. Sweeps the lattice once by choosing a position (at random or in
+ * order, see visit_site()) and proposing a spin flip using the Meteropolis Algorithm. This is done
+ * for the lattice size.
  */
+template <Visit V>
 void Ising3::sweep_lattice_disorder(float beta, std::mt19937 &engine)
 {
     for (size_t i = 0; i < size; i++) {
-        int pos       = static_cast<int>(rand0(engine) * size);
+        int pos       = static_cast<int>(visit_site<V>(i, engine));
         float delta_E = 2.0 * spin[pos] * (J[pos].J_arr[0] * spin[neigh[pos].neighbor[0]] +
                                            J[pos].J_arr[1] * spin[neigh[pos].neighbor[1]] +
                                            J[pos].J_arr[2] * spin[neigh[pos].neighbor[2]] +
@@ -43,13 +49,137 @@ void Ising3::sweep_lattice_disorder(float beta, std::mt19937 &engine)
                                            J[pos].J_arr[4] * spin[neigh[pos].neighbor[4]] +
                                            J[pos].J_arr[5] * spin[neigh[pos].neighbor[5]]);
 
+        // Spins of a later update, whose neighbor entries are prefetched by now
+        if (V == Visit::prefetch)
+            prefetch_spins(upcoming_site(i));
+
         // Accept / Reject
-        if (rand0(engine) < exp(-beta * delta_E))
+        if (rand0(engine) < exp(-beta * delta_E)) {
             spin[pos] = -spin[pos];
+            INSTRUMENT_ADD(counters, accepted, 1);
+        }
     } // Sweep over sites
 }
 
 
+/* sweep_lattice()
+ * Performs one sweep of the lattice with or without disorder.
+ */
+void Ising3::sweep_lattice(float beta, std::mt19937 &engine)
+{
+    if (isClean)
+        dispatch_visit([&](auto v) { sweep_lattice_clean<decltype(v)::value>(beta, engine); });
+    else
+        dispatch_visit([&](auto v) { sweep_lattice_disorder<decltype(v)::value>(beta, engine); });
+}
+
+
+/* propose()
+ * Proposes flipping the spin at pos and returns the energy change.
+ */
+double Ising3::propose(size_t pos, std::mt19937 &)
+{
+    return flip_energy(pos);
+}
+
+
+/* accept()
+ * Flips the spin at pos.
+ */
+void Ising3::accept(size_t pos)
+{
+    flip(pos);
+}
+
+
+/* energy()
+ * Returns the total energy of the lattice.
+ */
+double Ising3::energy() const
+{
+    return energy_sites(0, size);
+}
+
+
+/* magnetization2()
+ * Returns the square of the total magnetization of the lattice.
+ */
+double Ising3::magnetization2() const
+{
+    double Mx, My;
+    magnetization_sites(0, size, Mx, My);
+
+    return Mx * Mx;
+}
+
+
+/* energy_sites()
+ * Returns the energy of the bonds 0, 1 and 4 of the sites in [first, last).
+ */
+double Ising3::energy_sites(size_t first, size_t last) const
+{
+    double E_tot = 0.0;
+
+    // Compute the Total energy of lattice with 0, 1, and 4 bonds
+    if (isClean) {
+        #pragma omp simd reduction(+:E_tot)
+        for (size_t j = first; j < last; j++)
+            E_tot += -spin[j] * (spin[neigh[j].neighbor[0]] + spin[neigh[j].neighbor[1]] +
+                                 spin[neigh[j].neighbor[4]]);
+    } else {
+        for (size_t j = first; j < last; j++)
+            E_tot += -spin[j] * (J[j].J_arr[0] * spin[neigh[j].neighbor[0]] +
+                                 J[j].J_arr[1] * spin[neigh[j].neighbor[1]] +
+                                 J[j].J_arr[4] * spin[neigh[j].neighbor[4]]);
+    } // Choose wheather to use disorder or no disorder
+
+    return E_tot;
+}
+
+
+/* magnetization_sites()
+ * Computes the magnetization of the sites in [first, last). My is 0.
+ */
+void Ising3::magnetization_sites(size_t first, size_t last, double &Mx, double &My) const
+{
+    double M = 0.0;
+    #pragma omp simd reduction(+:M)
+    for (size_t j = first; j < last; j++)
+        M += spin[j];
+
+    Mx = M;
+    My = 0.0;
+}
+
+
+/* update_site()
+ * Proposes flipping the spin at pos with the Metropolis Algorithm. Returns true if it flipped.
+ */
+bool Ising3::update_site(size_t pos, float beta, std::mt19937 &engine)
+{
+    if (rand0(engine) < exp(-beta * flip_energy(pos))) {
+        spin[pos] = -spin[pos];
+        return true;
+    }
+
+    return false;
+}
+
+
+/* prefetch_spins()
+ * Prefetches the spins of pos and its neighbors for the update of pos (see site_order.h).
+ */
+void Ising3::prefetch_spins(size_t pos) const
+{
+    if (pos >= size)
+        return;
+
+    __builtin_prefetch(&spin[pos], 1);
+    for (size_t k = 0; k < n_neigh; k++)
+        __builtin_prefetch(&spin[neigh[pos].neighbor[k]]);
+}
+
+
 /*-------------------------------------------------------------------------------------------------
  * PUBLIC METHOD
  *-----------------------------------------------------------------------------------------------*/
@@ -72,90 +202,59 @@ Ising3::Ising3(const Ising3 &rhs) : Model3(rhs), spin(rhs.spin)
 /* set_spin()
  * Sets the spin lattice to 1.
  */
-void Ising3::set_spin()
+void Ising3::set_spin(std::mt19937 &)
 {
     for (auto &&ele : spin)
         ele = 1;
 }
 
 
-/* sweep_energy()
- * Performs monte carlo sweeps and calcuates the energy
+/* flip_energy()
+ * Returns the energy change of flipping the spin at pos.
  */
-double Ising3::sweep_energy(double beta, std::mt19937 &engine)
+double Ising3::flip_energy(size_t pos) const
 {
-    double E_tot = 0.0;
-
-    if (isClean) {
-        for (size_t i = 0; i < warmup; i++)
-            sweep_lattice_clean(beta, engine);
-
-        for (size_t i = 0; i < measure; i++) {
-            sweep_lattice_clean(beta, engine);
-
-            // Compute the Total energy of lattice with 0, 1, and 4 bonds
-            #pragma omp simd reduction(+:E_tot)
-            for (size_t j = 0; j < size; j++)
-                E_tot += -spin[j] * (spin[neigh[j].neighbor[0]] + spin[neigh[j].neighbor[1]] +
-                                     spin[neigh[j].neighbor[4]]);
-        } // Perform measurement sweeps
-    } else {
-        for (size_t i = 0; i < warmup; i++)
-            sweep_lattice_disorder(beta, engine);
-
-        for (size_t i = 0; i < measure; i++) {
-            sweep_lattice_disorder(beta, engine);
+    if (isClean)
+        return 2.0 * spin[pos] * (spin[neigh[pos].neighbor[0]] +
+                                  spin[neigh[pos].neighbor[1]] +
+                                  spin[neigh[pos].neighbor[2]] +
+                                  spin[neigh[pos].neighbor[3]] +
+                                  spin[neigh[pos].neighbor[4]] +
+                                  spin[neigh[pos].neighbor[5]]);
+    else
+        return 2.0 * spin[pos] * (J[pos].J_arr[0] * spin[neigh[pos].neighbor[0]] +
+                                  J[pos].J_arr[1] * spin[neigh[pos].neighbor[1]] +
+                                  J[pos].J_arr[2] * spin[neigh[pos].neighbor[2]] +
+                                  J[pos].J_arr[3] * spin[neigh[pos].neighbor[3]] +
+                                  J[pos].J_arr[4] * spin[neigh[pos].neighbor[4]] +
+                                  J[pos].J_arr[5] * spin[neigh[pos].neighbor[5]]);
+}
 
-            // Compute the Total energy of lattice with 0, 1, and 4 bonds
-            for (size_t j = 0; j < size; j++)
-                E_tot += -spin[j] * (J[j].J_arr[0] * spin[neigh[j].neighbor[0]] +
-                                     J[j].J_arr[1] * spin[neigh[j].neighbor[1]] +
-                                     J[j].J_arr[4] * spin[neigh[j].neighbor[4]]);
-        } // Perform measurement sweeps
-    } // Choose wheather to sweep with disorder or no disorder
 
-    return E_tot / static_cast<double>(measure * size);
+/* flip()
+ * Flips the spin at pos.
+ */
+void Ising3::flip(size_t pos)
+{
+    spin[pos] = -spin[pos];
 }
 
-/* sweep_energy()
- * Performs binder ratio sweep.
+
+/* save()
+ * Writes the model and its spins in binary.
  */
-double Ising3::sweep_binder(double beta, std::mt19937 &engine)
+void Ising3::save(std::ostream &os) const
 {
-    double M2 = 0.0, M4 = 0.0;
-
-    if (isClean) {
-        for (size_t i = 0; i < warmup; i++)
-            sweep_lattice_clean(beta, engine);
-
-        for (size_t i = 0; i < measure; i++) {
-            sweep_lattice_clean(beta, engine);
-
-            double M = 0.0;
-            #pragma omp simd reduction(+:M)
-            for (size_t j = 0; j < size; j++)
-                M += spin[j];
-            M2 += M * M;
-            M4 += M * M * M * M;
-        } // Measurement sweep
-    } else {
-        for (size_t i = 0; i < warmup; i++)
-            sweep_lattice_disorder(beta, engine);
-
-        for (size_t i = 0; i < measure; i++) {
-            sweep_lattice_disorder(beta, engine);
-
-            double M = 0.0;
-            #pragma omp simd reduction(+:M)
-            for (size_t j = 0; j < size; j++)
-                M += spin[j];
-            M2 += M * M;
-            M4 += M * M * M * M;
-        }
-    }
+    Model3::save(os);
+    write_binary(os, spin);
+}
 
-    M2 /= static_cast<double>(measure);
-    M4 /= static_cast<double>(measure);
 
-    return 1.0 - (M4 / (3.0 * M2 * M2));
+/* load()
+ * Reads back the data written by save().
+ */
+void Ising3::load(std::istream &is)
+{
+    Model3::load(is);
+    read_binary(is, spin);
 }
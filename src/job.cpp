@@ -0,0 +1,917 @@
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <sstream>
+#include <algorithm>
+
+#include "../include/job.h"
+#include "../include/disorder_cooling.h"
+#include "../include/result_file.h"
+#include "../include/instrument.h"
+#include "../include/scheduler.h"
+#include "../include/refine.h"
+
+
+/*-------------------------------------------------------------------------------------------------
+ * HELPER FUNCTIONS
+ *-----------------------------------------------------------------------------------------------*/
+
+/* job_error()
+ * Reports an error in a job file and exits.
+ */
+static void job_error(size_t line_no, const std::string &msg)
+{
+    std::cerr << "Error: Job file line " << line_no << ": " << msg << std::endl;
+    exit(EXIT_FAILURE);
+}
+
+
+/* read_values()
+ * Reads the remaining values of a line. Fails if there are none or if one does not parse.
+ */
+template <typename V>
+static std::vector<V> read_values(std::istringstream &ss, size_t line_no)
+{
+    std::vector<V> vals;
+    V val;
+
+    while (ss >> val)
+        vals.push_back(val);
+
+    if (vals.empty() || !ss.eof())
+        job_error(line_no, "expected a list of numbers");
+
+    return vals;
+}
+
+
+/* read_value()
+ * Reads the single value of a line.
+ */
+template <typename V>
+static V read_value(std::istringstream &ss, size_t line_no)
+{
+    std::vector<V> vals = read_values<V>(ss, line_no);
+
+    if (vals.size() != 1)
+        job_error(line_no, "expected a single number");
+
+    return vals[0];
+}
+
+
+/* read_grid()
+ * Reads a "T" line and adds its points to the grid.
+ */
+static void read_grid(std::istringstream &ss, size_t line_no, std::vector<double> &T)
+{
+    std::string kind;
+    ss >> kind;
+
+    if (kind == "list") {
+        std::vector<double> pts = read_values<double>(ss, line_no);
+        T.insert(T.end(), pts.begin(), pts.end());
+        return;
+    }
+
+    double lo, hi;
+    size_t n;
+    if (!(ss >> lo >> hi >> n) || !(ss >> std::ws).eof())
+        job_error(line_no, "expected T linear|log <lo> <hi> <n> or T list <values>");
+
+    std::vector<double> pts;
+    if (kind == "linear")
+        pts = linear_grid(lo, hi, n);
+    else if (kind == "log")
+        pts = log_grid(lo, hi, n);
+    else
+        job_error(line_no, "unknown grid '" + kind + "'");
+
+    T.insert(T.end(), pts.begin(), pts.end());
+}
+
+
+/* read_refine()
+ * Reads a "refine" line.
+ */
+static void read_refine(std::istringstream &ss, size_t line_no, Job &job)
+{
+    if (!(ss >> job.refine >> job.dT_min) || !(ss >> std::ws).eof() || !(job.dT_min > 0.0))
+        job_error(line_no, "expected refine <passes> <dT_min> with dT_min > 0");
+}
+
+
+/* read_entropy()
+ * Reads the integration rule of an entropy line.
+ */
+static void read_entropy(std::istringstream &ss, size_t line_no, Job &job)
+{
+    std::string name;
+
+    if (!(ss >> name) || !parse_quadrature(name, job.quadrature))
+        job_error(line_no, "expected entropy trapezoid, simpson or cubic");
+    job.entropy = true;
+}
+
+
+/* read_order()
+ * Reads the site ordering of an order line.
+ */
+static void read_order(std::istringstream &ss, size_t line_no, Job &job)
+{
+    std::string name;
+
+    if (!(ss >> name) || !parse_site_order(name, job.order))
+        job_error(line_no, "expected order row_major, morton or hilbert");
+}
+
+
+/* read_visit()
+ * Reads the visiting order of a visit line.
+ */
+static void read_visit(std::istringstream &ss, size_t line_no, Job &job)
+{
+    std::string name;
+
+    if (!(ss >> name) || !parse_visit(name, job.visit))
+        job_error(line_no, "expected visit random, sequential, blocks or prefetch");
+}
+
+
+/* read_wang_landau()
+ * Reads the optional number of windows and bin width of a wang_landau line.
+ */
+static void read_wang_landau(std::istringstream &ss, size_t line_no, Job &job)
+{
+    job.method = Method::wang_landau;
+
+    if (!(ss >> std::ws).eof() && (!(ss >> job.n_window) || (!(ss >> std::ws).eof() &&
+                !(ss >> job.wl_width)) || !(ss >> std::ws).eof()))
+        job_error(line_no, "expected wang_landau [<n_window> [<width>]]");
+    if (job.n_window < 1 || !(job.wl_width > 0.0))
+        job_error(line_no, "wang_landau needs n_window >= 1 and width > 0");
+}
+
+
+/* read_reweight()
+ * Reads the kind of histogram reweighting of a reweight line.
+ */
+static void read_reweight(std::istringstream &ss, size_t line_no, Job &job)
+{
+    std::string kind;
+
+    if (!(ss >> kind) || (kind != "single" && kind != "multi") || !(ss >> std::ws).eof())
+        job_error(line_no, "expected reweight single or multi");
+    job.method   = Method::reweight;
+    job.rw_multi = kind == "multi";
+}
+
+
+/* read_muca()
+ * Reads the temperature range, bins and learning iterations of a muca line.
+ */
+static void read_muca(std::istringstream &ss, size_t line_no, Job &job)
+{
+    if (!(ss >> job.muca_lo >> job.muca_hi >> job.muca_bins >> job.muca_iter) ||
+            !(ss >> std::ws).eof())
+        job_error(line_no, "expected muca <T_lo> <T_hi> <n_bin> <n_iter>");
+    if (!(job.muca_lo > 0.0) || !(job.muca_hi > job.muca_lo) || job.muca_bins < 2 ||
+            job.muca_iter < 1)
+        job_error(line_no, "muca needs 0 < T_lo < T_hi, n_bin >= 2 and n_iter >= 1");
+    job.method = Method::muca;
+}
+
+
+/*-------------------------------------------------------------------------------------------------
+ * JOB READER
+ *-----------------------------------------------------------------------------------------------*/
+
+/* check()
+ * Validates a finished job.
+ */
+void Job_reader::check(const Job &job) const
+{
+    static const std::vector<std::string> models = {"ising2", "ising3", "clock2", "clock3",
+                                                    "xy2", "xy3"};
+
+    if (std::find(models.begin(), models.end(), job.model) == models.end())
+        job_error(line_no, "job '" + job.name + "' has no valid model");
+    if (job.L.empty() || *std::min_element(job.L.begin(), job.L.end()) < 2)
+        job_error(line_no, "job '" + job.name + "' needs L values of at least 2");
+    if (job.T.empty() || job.T.front() <= 0.0)
+        job_error(line_no, "job '" + job.name + "' needs positive temperatures");
+    if (*std::min_element(job.delta.begin(), job.delta.end()) < 0.0 || job.n_run < 1)
+        job_error(line_no, "job '" + job.name + "' needs delta >= 0 and n_run >= 1");
+    if (job.q < 2 || job.measure == 0 || job.ckpt_every == 0)
+        job_error(line_no, "job '" + job.name + "' needs q >= 2 and nonzero sweep counts");
+    if (job.decompose && (job.model.back() != '3' ||
+                std::any_of(job.L.begin(), job.L.end(), [](int L) { return L % 2 != 0; })))
+        job_error(line_no, "job '" + job.name + "' can only decompose 3D models with even L");
+    if (job.method == Method::wang_landau && (job.model.compare(0, 5, "ising") != 0 ||
+                *std::max_element(job.delta.begin(), job.delta.end()) >= 2.0))
+        job_error(line_no, "job '" + job.name + "' needs an Ising model and delta < 2 for "
+                "Wang-Landau");
+    if (job.method == Method::wang_landau && (job.refine > 0 || job.decompose || job.entropy))
+        job_error(line_no, "job '" + job.name + "' can not refine, decompose or integrate the "
+                "entropy with Wang-Landau");
+    if (job.method == Method::reweight && (job.L.size() != 1 || job.delta.size() != 1))
+        job_error(line_no, "job '" + job.name + "' needs a single L and delta to reweight");
+    if (job.method == Method::reweight && (job.refine > 0 || job.decompose || job.entropy))
+        job_error(line_no, "job '" + job.name + "' can not refine, decompose or integrate the "
+                "entropy when reweighting");
+    if (job.method == Method::muca && (job.T.front() < job.muca_lo || job.T.back() > job.muca_hi))
+        job_error(line_no, "job '" + job.name + "' has temperatures outside the muca range");
+    if (job.method == Method::muca && (job.refine > 0 || job.decompose || job.entropy))
+        job_error(line_no, "job '" + job.name + "' can not refine, decompose or integrate the "
+                "entropy with multicanonical runs");
+}
+
+
+/* Constructor
+ */
+Job_reader::Job_reader(std::istream &In) : is(In), line_no(0)
+{
+}
+
+
+/* next()
+ * Reads the next job. Returns false at the end of the input.
+ */
+bool Job_reader::next(Job &job)
+{
+    bool started = false;
+    std::string line;
+
+    job = Job();
+
+    while (!pending.empty() || std::getline(is, line)) {
+        if (!pending.empty()) {
+            line = pending;
+            pending.clear();
+        } else {
+            line_no++;
+        }
+
+        std::istringstream ss(line.substr(0, line.find('#')));
+        std::string key;
+
+        if (!(ss >> key))
+            continue;
+
+        if (key == "job") {
+            if (started) {
+                pending = line;
+                break;
+            }
+            if (!(ss >> job.name))
+                job_error(line_no, "a job needs a name");
+            started = true;
+            continue;
+        }
+
+        if (!started)
+            job_error(line_no, "expected 'job <name>'");
+
+        if (key == "end")
+            break;
+        else if (key == "model")
+            ss >> job.model;
+        else if (key == "q")
+            job.q = read_value<int>(ss, line_no);
+        else if (key == "L")
+            job.L = read_values<int>(ss, line_no);
+        else if (key == "T")
+            read_grid(ss, line_no, job.T);
+        else if (key == "delta")
+            job.delta = read_values<double>(ss, line_no);
+        else if (key == "n_run")
+            job.n_run = read_value<int>(ss, line_no);
+        else if (key == "warmup")
+            job.warmup = read_value<size_t>(ss, line_no);
+        else if (key == "measure")
+            job.measure = read_value<size_t>(ss, line_no);
+        else if (key == "overrelax")
+            job.overrelax = read_value<size_t>(ss, line_no);
+        else if (key == "seed")
+            job.seed = read_value<unsigned>(ss, line_no);
+        else if (key == "checkpoint")
+            job.ckpt_every = read_value<size_t>(ss, line_no);
+        else if (key == "bootstrap")
+            job.n_boot = read_value<size_t>(ss, line_no);
+        else if (key == "refine")
+            read_refine(ss, line_no, job);
+        else if (key == "entropy")
+            read_entropy(ss, line_no, job);
+        else if (key == "decompose")
+            job.decompose = true;
+        else if (key == "order")
+            read_order(ss, line_no, job);
+        else if (key == "visit")
+            read_visit(ss, line_no, job);
+        else if (key == "wang_landau")
+            read_wang_landau(ss, line_no, job);
+        else if (key == "reweight")
+            read_reweight(ss, line_no, job);
+        else if (key == "muca")
+            read_muca(ss, line_no, job);
+        else
+            job_error(line_no, "unknown key '" + key + "'");
+    } // Read lines
+
+    if (!started)
+        return false;
+
+    std::sort(job.T.begin(), job.T.end());
+    job.T.erase(std::unique(job.T.begin(), job.T.end()), job.T.end());
+    check(job);
+
+    return true;
+}
+
+
+/*-------------------------------------------------------------------------------------------------
+ * GRIDS
+ *-----------------------------------------------------------------------------------------------*/
+
+/* linear_grid()
+ * Returns n evenly spaced points from lo to hi.
+ */
+std::vector<double> linear_grid(double lo, double hi, size_t n)
+{
+    std::vector<double> pts;
+
+    for (size_t i = 0; i < n; i++)
+        pts.push_back(n == 1 ? lo : lo + (hi - lo) * static_cast<double>(i) /
+                                          static_cast<double>(n - 1));
+
+    return pts;
+}
+
+
+/* log_grid()
+ * Returns n log spaced points from lo to hi, which are denser at low temperatures.
+ */
+std::vector<double> log_grid(double lo, double hi, size_t n)
+{
+    if (lo <= 0.0 || hi <= 0.0) {
+        std::cerr << "Error: A log spaced grid needs positive ends." << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    std::vector<double> pts = linear_grid(log(lo), log(hi), n);
+    for (auto &&ele : pts)
+        ele = exp(ele);
+
+    return pts;
+}
+
+
+/*-------------------------------------------------------------------------------------------------
+ * RUNNING JOBS
+ *-----------------------------------------------------------------------------------------------*/
+
+/* run_model()
+ * Runs one lattice size of a job and returns the observables on the grid T. runs receives the
+ * observables of every realization, the average itself for a clean run.
+ */
+template <typename Model>
+static std::vector<Observables> run_model(const Job &job, const std::vector<double> &T,
+        Model model, double delta, Checkpoint &ckpt, Time_series *ts,
+        std::vector<std::vector<Observables>> &runs)
+{
+    model.set_run_param(job.warmup, job.measure);
+
+    if (delta > 0.0)
+        return compute_observables(T, model, delta, job.n_run, &ckpt, ts, &runs);
+
+    std::vector<Observables> obs = compute_observables(T, model, &ckpt, ts);
+    runs = {obs};
+
+    return obs;
+}
+
+
+/* run_slabs()
+ * Runs one lattice size of a job with every lattice split over all threads.
+ */
+template <typename Model>
+static std::vector<Observables> run_slabs(const Job &job, const std::vector<double> &T,
+        Model model, double delta, Time_series *ts, std::vector<std::vector<Observables>> &runs)
+{
+    model.set_run_param(job.warmup, job.measure);
+
+    return compute_observables_slabs(T, model, delta, job.n_run, job.seed, ts, &runs);
+}
+
+
+/* run_grid()
+ * Runs every L of one delta of a job on the grid T and returns the observables of every L.
+ * runs[L][r] receives the observables of realization r. Refinement pass p > 0 of an adaptive job
+ * checkpoints to its own files.
+ */
+static std::vector<std::vector<Observables>> run_grid(const Job &job,
+        const std::vector<double> &T, double delta, bool restart, size_t p, Time_series *ts,
+        std::vector<std::vector<std::vector<Observables>>> &runs)
+{
+    std::vector<std::vector<Observables>> obs;
+
+    runs.assign(job.L.size(), std::vector<std::vector<Observables>>());
+
+    for (size_t k = 0; k < job.L.size(); k++) {
+        const int L = job.L[k];
+        std::cout << "\tL = " << L << "... " << std::flush;
+
+        std::string name = job_tag(job, delta) + "_L" + std::to_string(L);
+        if (p > 0)
+            name += "_r" + std::to_string(p);
+        Checkpoint ckpt(name + ".ckpt", job.ckpt_every, restart, job.seed);
+
+        if (job.model == "ising2") {
+            Ising2 model(L);
+            model.set_site_order(job.order);
+            model.set_visit(job.visit);
+            obs.push_back(run_model(job, T, model, delta, ckpt, ts, runs[k]));
+        } else if (job.model == "ising3") {
+            Ising3 model(L);
+            model.set_site_order(job.order);
+            model.set_visit(job.visit);
+            obs.push_back(job.decompose ? run_slabs(job, T, model, delta, ts, runs[k]) :
+                                          run_model(job, T, model, delta, ckpt, ts, runs[k]));
+        } else if (job.model == "clock2") {
+            Clock2 model(L, job.q);
+            model.set_site_order(job.order);
+            model.set_visit(job.visit);
+            model.set_overrelax(job.overrelax);
+            obs.push_back(run_model(job, T, model, delta, ckpt, ts, runs[k]));
+        } else if (job.model == "clock3") {
+            Clock3 model(L, job.q);
+            model.set_site_order(job.order);
+            model.set_visit(job.visit);
+            model.set_overrelax(job.overrelax);
+            obs.push_back(job.decompose ? run_slabs(job, T, model, delta, ts, runs[k]) :
+                                          run_model(job, T, model, delta, ckpt, ts, runs[k]));
+        } else if (job.model == "xy2") {
+            XY2 model(L);
+            model.set_site_order(job.order);
+            model.set_visit(job.visit);
+            model.set_overrelax(job.overrelax);
+            obs.push_back(run_model(job, T, model, delta, ckpt, ts, runs[k]));
+        } else {
+            XY3 model(L);
+            model.set_site_order(job.order);
+            model.set_visit(job.visit);
+            model.set_overrelax(job.overrelax);
+            obs.push_back(job.decompose ? run_slabs(job, T, model, delta, ts, runs[k]) :
+                                          run_model(job, T, model, delta, ckpt, ts, runs[k]));
+        }
+        std::cout << "done\n";
+    } // Loop over L
+
+    return obs;
+}
+
+
+/* entropy_limit()
+ * Returns the entropy per site of the model at infinite temperature.
+ */
+static double entropy_limit(const Job &job)
+{
+    if (job.model == "ising2" || job.model == "ising3")
+        return log(2.0);
+    else if (job.model == "clock2" || job.model == "clock3")
+        return log(static_cast<double>(job.q));
+    else
+        return log(2.0 * M_PI);
+}
+
+
+/* write_job_result()
+ * Writes the observables of every L of one delta of a job to "<name>_d<delta>.bin". E_err holds
+ * the errors of E of every L for the entropy, or is empty.
+ */
+void write_job_result(const Job &job, double delta,
+        const std::vector<std::vector<Observables>> &obs, const std::vector<Crossing> &cross,
+        const std::vector<std::vector<double>> &E_err)
+{
+    const size_t n_entropy = job.entropy ? 2 * job.L.size() : 0;
+    Data_matrix data(job.T.size(), 1 + Observables::n_value * job.L.size() + n_entropy);
+    Result_header header;
+
+    data.insert_array(job.T.data(), "T");
+
+    for (size_t i = 0; i < job.L.size(); i++) {
+        const std::string suffix = "_L=" + std::to_string(job.L[i]);
+
+        data.insert_array(observable_column(obs[i], &Observables::E).data(), "E" + suffix);
+        data.insert_array(observable_column(obs[i], &Observables::C).data(), "C" + suffix);
+        data.insert_array(observable_column(obs[i], &Observables::M).data(), "M" + suffix);
+        data.insert_array(observable_column(obs[i], &Observables::chi).data(), "chi" + suffix);
+        data.insert_array(observable_column(obs[i], &Observables::binder).data(),
+                "binder" + suffix);
+    } // Loop over L
+
+    for (size_t i = 0; i < n_entropy / 2; i++) {
+        const std::vector<Entropy_point> S = entropy(job.T,
+                observable_column(obs[i], &Observables::E),
+                E_err.empty() ? std::vector<double>(job.T.size(), 0.0) : E_err[i],
+                entropy_limit(job), job.quadrature);
+        std::vector<double> S_val(S.size()), S_err(S.size());
+
+        for (size_t k = 0; k < S.size(); k++) {
+            S_val[k] = S[k].S;
+            S_err[k] = S[k].err;
+        }
+        data.insert_array(S_val.data(), "S_L=" + std::to_string(job.L[i]));
+        data.insert_array(S_err.data(), "S_err_L=" + std::to_string(job.L[i]));
+    } // Loop over L
+
+    header.set_param("job", job.name);
+    header.set_param("model", job.model);
+    header.set_param("q", job.q);
+    header.set_param("warmup", job.warmup);
+    header.set_param("measure", job.measure);
+    header.set_param("overrelax", job.overrelax);
+    header.set_param("order", site_order_name(job.order));
+    header.set_param("visit", visit_name(job.visit));
+    header.set_param("delta", delta);
+    header.set_param("n_run", delta > 0.0 ? job.n_run : 1);
+    header.set_param("seed", job.seed);
+
+    for (auto &&c : cross) {
+        if (!c.found)
+            continue;
+
+        const std::string pair = "_L" + std::to_string(c.L1) + "_L" + std::to_string(c.L2);
+        header.set_param("T_c" + pair, c.T_c);
+        header.set_param("T_c_err" + pair, c.err);
+        header.set_param("T_c_boot" + pair, c.n_found);
+    } // Loop over Binder crossings
+
+    write_result(job_tag(job, delta) + ".bin", data, header);
+}
+
+
+/* write_realizations()
+ * Writes the result file of one delta of a job from the averaged observables and those of every
+ * realization, runs[L][r]. The Binder crossings are bootstrapped over the realizations and E_err
+ * is the standard error of E over them.
+ */
+void write_realizations(const Job &job, double delta,
+        const std::vector<std::vector<Observables>> &obs,
+        const std::vector<std::vector<std::vector<Observables>>> &runs)
+{
+    std::vector<std::vector<std::vector<double>>> binder(job.L.size());
+    std::vector<std::vector<double>> E_err(job.L.size(), std::vector<double>(job.T.size(), 0.0));
+
+    for (size_t i = 0; i < job.L.size(); i++) {
+        const size_t n_run = runs[i].size();
+
+        for (auto &&run : runs[i])
+            binder[i].push_back(observable_column(run, &Observables::binder));
+
+        if (n_run < 2)
+            continue;
+
+        for (size_t k = 0; k < job.T.size(); k++) {
+            double E2 = 0.0;
+            for (auto &&run : runs[i])
+                E2 += run[k].E * run[k].E;
+
+            E_err[i][k] = std::sqrt(std::max(0.0, (E2 / n_run - obs[i][k].E * obs[i][k].E) /
+                        (n_run - 1)));
+        } // Loop over temperatures
+    } // Loop over L
+
+    write_job_result(job, delta, obs, binder_crossings(job.T, job.L, binder, job.n_boot,
+                job.seed), E_err);
+}
+
+
+/* write_job_result()
+ * Writes the Wang-Landau thermodynamics of every L of one delta of a job to
+ * "<name>_d<delta>.bin".
+ */
+void write_job_result(const Job &job, double delta, const std::vector<std::vector<Wl_point>> &wl)
+{
+    Data_matrix data(job.T.size(), 1 + 4 * job.L.size());
+    Result_header header;
+
+    data.insert_array(job.T.data(), "T");
+
+    for (size_t i = 0; i < job.L.size(); i++) {
+        const std::string suffix = "_L=" + std::to_string(job.L[i]);
+        std::vector<double> F, E, S, C;
+
+        for (auto &&pt : wl[i]) {
+            F.push_back(pt.F);
+            E.push_back(pt.E);
+            S.push_back(pt.S);
+            C.push_back(pt.C);
+        }
+        data.insert_array(F.data(), "F" + suffix);
+        data.insert_array(E.data(), "E" + suffix);
+        data.insert_array(S.data(), "S" + suffix);
+        data.insert_array(C.data(), "C" + suffix);
+    } // Loop over L
+
+    header.set_param("job", job.name);
+    header.set_param("model", job.model);
+    header.set_param("method", "wang_landau");
+    header.set_param("n_window", job.n_window);
+    header.set_param("width", job.wl_width);
+    header.set_param("delta", delta);
+    header.set_param("n_run", delta > 0.0 ? job.n_run : 1);
+    header.set_param("seed", job.seed);
+
+    write_result(job_tag(job, delta) + ".bin", data, header);
+}
+
+
+/* write_job_result()
+ * Writes the reweighted observables of every L of one delta of a reweight or muca job to
+ * "<name>_d<delta>.bin". n_run is the number of realizations.
+ */
+void write_job_result(const Job &job, double delta, const std::vector<std::vector<Rw_point>> &rw,
+        size_t n_run)
+{
+    Data_matrix data(job.T.size(), 1 + 4 * job.L.size());
+    Result_header header;
+
+    data.insert_array(job.T.data(), "T");
+
+    for (size_t i = 0; i < job.L.size(); i++) {
+        const std::string suffix = "_L=" + std::to_string(job.L[i]);
+        std::vector<double> E, C, chi, binder;
+
+        for (auto &&pt : rw[i]) {
+            E.push_back(pt.E);
+            C.push_back(pt.C);
+            chi.push_back(pt.chi);
+            binder.push_back(pt.binder);
+        }
+        data.insert_array(E.data(), "E" + suffix);
+        data.insert_array(C.data(), "C" + suffix);
+        data.insert_array(chi.data(), "chi" + suffix);
+        data.insert_array(binder.data(), "binder" + suffix);
+    } // Loop over L
+
+    header.set_param("job", job.name);
+    header.set_param("model", job.model);
+    if (job.method == Method::muca) {
+        header.set_param("method", "muca");
+        header.set_param("T_lo", job.muca_lo);
+        header.set_param("T_hi", job.muca_hi);
+        header.set_param("n_bin", job.muca_bins);
+        header.set_param("n_iter", job.muca_iter);
+        header.set_param("warmup", job.warmup);
+        header.set_param("measure", job.measure);
+        header.set_param("seed", job.seed);
+    } else {
+        header.set_param("method", "reweight");
+        header.set_param("histogram", job.rw_multi ? "multi" : "single");
+    }
+    header.set_param("delta", delta);
+    header.set_param("n_run", n_run);
+
+    write_result(job_tag(job, delta) + ".bin", data, header);
+}
+
+
+/* job_tag()
+ * Returns the prefix of the files of one delta of a job.
+ */
+std::string job_tag(const Job &job, double delta)
+{
+    std::ostringstream tag;
+    tag << job.name << "_d" << delta;
+
+    return tag.str();
+}
+
+
+/* run_wang_landau()
+ * Runs every delta and L of a Wang-Landau job in sequence and writes one result file per delta.
+ */
+static void run_wang_landau(const Job &job)
+{
+    for (auto delta : job.delta) {
+        const int n_run = delta > 0.0 ? job.n_run : 1;
+        std::vector<std::vector<Wl_point>> wl;
+
+        std::cout << "Performing " << job.name << " (" << job.model << ", Wang-Landau, delta = "
+                  << delta << ")\n";
+
+        for (auto L : job.L) {
+            std::cout << "\tL = " << L << "... " << std::flush;
+
+            if (job.model == "ising2") {
+                Ising2 model(L);
+                wl.push_back(compute_wang_landau(model, delta, n_run, job.T, job.n_window,
+                            job.wl_width, job.seed));
+            } else {
+                Ising3 model(L);
+                wl.push_back(compute_wang_landau(model, delta, n_run, job.T, job.n_window,
+                            job.wl_width, job.seed));
+            }
+            std::cout << "done\n";
+        } // Loop over L
+
+        write_job_result(job, delta, wl);
+    } // Loop over delta
+}
+
+
+/* compute_muca()
+ * Averages the multicanonical observables of one L over n_run realizations of the disorder and
+ * returns them with the number of tunnels between the ends of the energy range. With delta = 0
+ * the clean model is used and n_run should be 1.
+ */
+template <typename Model>
+static std::vector<Rw_point> compute_muca(const Job &job, Model &model, double delta, int n_run,
+        size_t &n_tunnel)
+{
+    std::vector<Rw_point> avg(job.T.size(), Rw_point{0.0, 0.0, 0.0, 0.0, 0.0});
+
+    model.set_run_param(job.warmup, job.measure);
+    n_tunnel = 0;
+
+    for (int run = 0; run < n_run; run++) {
+        std::mt19937 engine;
+
+        if (job.seed != 0) {
+            std::seed_seq ex_seq{job.seed, static_cast<unsigned>(run), 0u};
+            std::seed_seq mc_seq{job.seed, static_cast<unsigned>(run), 1u};
+            std::mt19937 ex_engine(ex_seq);
+
+            if (delta > 0.0)
+                model.set_exchange(delta, ex_engine);
+            engine.seed(mc_seq);
+        } else {
+            if (delta > 0.0)
+                model.set_exchange(delta);
+            engine.seed(std::random_device{}());
+        }
+        model.set_spin(engine);
+
+        Muca_weight W = model.learn_muca(job.muca_lo, job.muca_hi, job.muca_bins, job.muca_iter,
+                job.warmup, engine);
+        Muca_sample sample = model.sweep_muca(W, engine);
+        n_tunnel += sample.n_tunnel;
+
+        auto pts = muca_reweight(sample, model.get_size(), job.T);
+        for (size_t i = 0; i < job.T.size(); i++) {
+            avg[i].E      += pts[i].E / n_run;
+            avg[i].C      += pts[i].C / n_run;
+            avg[i].chi    += pts[i].chi / n_run;
+            avg[i].binder += pts[i].binder / n_run;
+        }
+    } // Loop over runs
+
+    for (size_t i = 0; i < job.T.size(); i++)
+        avg[i].T = job.T[i];
+
+    return avg;
+}
+
+
+/* run_muca()
+ * Runs every delta and L of a multicanonical job in sequence and writes one result file per
+ * delta.
+ */
+static void run_muca(const Job &job)
+{
+    for (auto delta : job.delta) {
+        const int n_run = delta > 0.0 ? job.n_run : 1;
+        std::vector<std::vector<Rw_point>> rw;
+
+        std::cout << "Performing " << job.name << " (" << job.model << ", multicanonical, delta = "
+                  << delta << ")\n";
+
+        for (auto L : job.L) {
+            size_t n_tunnel;
+            std::cout << "\tL = " << L << "... " << std::flush;
+
+            if (job.model == "ising2") {
+                Ising2 model(L);
+                rw.push_back(compute_muca(job, model, delta, n_run, n_tunnel));
+            } else if (job.model == "ising3") {
+                Ising3 model(L);
+                rw.push_back(compute_muca(job, model, delta, n_run, n_tunnel));
+            } else if (job.model == "clock2") {
+                Clock2 model(L, job.q);
+                rw.push_back(compute_muca(job, model, delta, n_run, n_tunnel));
+            } else if (job.model == "clock3") {
+                Clock3 model(L, job.q);
+                rw.push_back(compute_muca(job, model, delta, n_run, n_tunnel));
+            } else if (job.model == "xy2") {
+                XY2 model(L);
+                rw.push_back(compute_muca(job, model, delta, n_run, n_tunnel));
+            } else {
+                XY3 model(L);
+                rw.push_back(compute_muca(job, model, delta, n_run, n_tunnel));
+            }
+            std::cout << "done (" << n_tunnel << " tunnels)\n";
+        } // Loop over L
+
+        write_job_result(job, delta, rw, static_cast<size_t>(n_run));
+    } // Loop over delta
+}
+
+
+/* run_job()
+ * Runs every delta and L of a job in sequence and writes one result file per delta. Adaptive
+ * jobs then refine the grid of every delta up to job.refine times (see refine.h) and write the
+ * merged grid.
+ */
+void run_job(const Job &job, bool restart, Time_series *ts)
+{
+    if (job.method == Method::wang_landau) {
+        run_wang_landau(job);
+        return;
+    } else if (job.method == Method::muca) {
+        run_muca(job);
+        return;
+    } else if (job.method == Method::reweight) {
+        std::cerr << "Error: Job '" << job.name << "' reweights a time series, see reweight_job()."
+                  << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    add_progress_total({job}, expand_tasks({job}));
+
+    for (auto delta : job.delta) {
+        std::vector<double> T = job.T;
+
+        std::cout << "Performing " << job.name << " (" << job.model << ", delta = " << delta
+                  << ")\n";
+        instrument_label(job_tag(job, delta));
+        std::vector<std::vector<std::vector<Observables>>> runs, pass_runs;
+        std::vector<std::vector<Observables>> obs = run_grid(job, T, delta, restart, 0, ts,
+                runs);
+
+        for (size_t p = 1; p <= job.refine; p++) {
+            Job pass   = job;
+            pass.T     = refine_points(T, obs, job.dT_min);
+            pass.delta = {delta};
+            if (pass.T.empty())
+                break;
+
+            std::cout << "\tRefining with " << pass.T.size() << " temperatures (pass " << p
+                      << ")\n";
+            add_progress_total({pass}, expand_tasks({pass}));
+            std::vector<std::vector<Observables>> pass_obs = run_grid(job, pass.T, delta,
+                    restart, p, ts, pass_runs);
+
+            // The realizations of every L are merged as the rows of a grid of their own
+            for (size_t i = 0; i < runs.size(); i++) {
+                std::vector<double> T_run = T;
+                merge_grid(T_run, runs[i], pass.T, pass_runs[i]);
+            }
+            merge_grid(T, obs, pass.T, pass_obs);
+        } // Refinement passes
+
+        Job out = job;
+        out.T   = T;
+        write_realizations(out, delta, obs, runs);
+        instrument_write(job_tag(job, delta), job_tag(job, delta) + ".instrument.json");
+    } // Loop over delta
+}
+
+
+/* reweight_job()
+ * Reweights the series of a time series file to the grid of a reweight job and writes its result
+ * file.
+ */
+void reweight_job(const Job &job, const std::string &series_file)
+{
+    if (series_file.empty()) {
+        std::cerr << "Error: Job '" << job.name << "' reweights the time series given with "
+                  << "--series." << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    const double delta = job.delta[0];
+    const int dim      = job.model.back() == '3' ? 3 : 2;
+    size_t n_site      = 1;
+    for (int d = 0; d < dim; d++)
+        n_site *= static_cast<size_t>(job.L[0]);
+
+    std::cout << "Reweighting " << series_file << " for " << job.name << " (" << job.model
+              << ", L = " << job.L[0] << ", delta = " << delta << ")\n";
+
+    std::vector<Ts_series> series = read_time_series(series_file);
+    std::vector<int> runs;
+    for (auto &&ele : series)
+        if (!ele.E.empty())
+            runs.push_back(ele.run);
+    std::sort(runs.begin(), runs.end());
+    runs.erase(std::unique(runs.begin(), runs.end()), runs.end());
+
+    if (runs.empty()) {
+        std::cerr << "Error: " << series_file << " holds no samples." << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    write_job_result(job, delta, {reweight_disorder(series, n_site, job.T, job.rw_multi)},
+            runs.size());
+}
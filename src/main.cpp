@@ -1,8 +1,22 @@
 #include <iostream>
 #include <array>
 #include <algorithm>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <memory>
+#include <fstream>
+#include <omp.h>
+#ifdef USE_MPI
+#include <mpi.h>
+#endif
 
 #include "../include/disorder_cooling.h"
+#include "../include/result_file.h"
+#include "../include/job.h"
+#include "../include/scheduler.h"
+#include "../include/progress.h"
+#include "../include/placement.h"
 
 
 /*-------------------------------------------------------------------------------------------------
@@ -14,6 +28,12 @@ const int N_run = 3;
 const std::array<int, N_L> L = {4, 6, 8};
 const double dT = 0.1;
 const double delta = 0.5;
+const size_t N_warmup = 30000;
+const size_t N_measure = 50000;
+const size_t ckpt_every = 10000;
+bool restart = false;
+unsigned seed = 0;
+Time_series *time_series = nullptr;
 
 
 /*-------------------------------------------------------------------------------------------------
@@ -22,15 +42,170 @@ const double delta = 0.5;
 void test_ising(const std::array<double, N_pts> &T);
 void test_clock(const std::array<double, N_pts> &T);
 void test_xy(const std::array<double, N_pts> &T);
+std::string ckpt_name(const std::string &series, int L);
+Result_header make_header(const std::string &model, bool disorder,
+        const std::string &observable);
+
+
+#ifdef USE_MPI
+/* struct : Mpi_session
+ * Initializes MPI for the lifetime of main(). Only the main thread of a rank calls MPI.
+ */
+struct Mpi_session
+{
+    int rank, n_rank;
+
+    Mpi_session(int *argc, char ***argv)
+    {
+        int provided;
+        MPI_Init_thread(argc, argv, MPI_THREAD_FUNNELED, &provided);
+        MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+        MPI_Comm_size(MPI_COMM_WORLD, &n_rank);
+    }
+
+    ~Mpi_session()
+    {
+        MPI_Finalize();
+    }
+};
+#endif
 
 
 /*-------------------------------------------------------------------------------------------------
  * MAIN
  *-----------------------------------------------------------------------------------------------*/
-int main(void)
+int main(int argc, char *argv[])
 {
     std::array<double, N_pts> T;
     int curr = 0;
+    int rank = 0, n_rank = 1;
+
+#ifdef USE_MPI
+    Mpi_session mpi(&argc, &argv);
+    rank   = mpi.rank;
+    n_rank = mpi.n_rank;
+#endif
+
+    std::string series_file, job_file;
+    bool schedule = false;
+    double progress_every = 0.0;
+    Pin pin = Pin::off;
+
+    // --restart resumes from the checkpoints of an interrupted run, --seed sets the master seed,
+    // --series streams the observables of every measurement sweep to a time series file, which
+    // reweight jobs read instead, --job runs the jobs of a job file (see job.h) instead of the
+    // built in runs, "-" reads stdin, --schedule runs all jobs of the file from one cost ordered
+    // task queue (see scheduler.h).
+    // Under mpirun with more than one rank, --job always runs distributed over the ranks.
+    // --progress N prints the progress, throughput and ETA to stderr every N seconds.
+    // --pin pins the threads compact or spread over the NUMA nodes (see placement.h) and reports
+    // the placement of the threads and their replicas at the end, "none" only reports it.
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--restart") == 0) {
+            restart = true;
+        } else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (std::strcmp(argv[i], "--series") == 0 && i + 1 < argc) {
+            series_file = argv[++i];
+        } else if (std::strcmp(argv[i], "--job") == 0 && i + 1 < argc) {
+            job_file = argv[++i];
+        } else if (std::strcmp(argv[i], "--schedule") == 0) {
+            schedule = true;
+        } else if (std::strcmp(argv[i], "--progress") == 0 && i + 1 < argc) {
+            progress_every = std::strtod(argv[++i], nullptr);
+        } else if (std::strcmp(argv[i], "--pin") == 0 && i + 1 < argc &&
+                parse_pin(argv[i + 1], pin)) {
+            i++;
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--restart] [--seed N] [--series FILE]"
+                      << " [--job FILE [--schedule]] [--progress SEC]"
+                      << " [--pin none|compact|spread]" << std::endl;
+            return EXIT_FAILURE;
+        }
+    } // Parse arguments
+
+    if (n_rank > 1) {
+        if (job_file.empty() || job_file == "-") {
+            std::cerr << "Error: MPI runs need a job file that every rank can read." << std::endl;
+            return EXIT_FAILURE;
+        }
+        schedule = true;
+    }
+
+    if (schedule && (job_file.empty() || restart)) {
+        std::cerr << "Error: --schedule needs --job and does not checkpoint." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Every rank of an MPI run writes its own time series file
+    // The file is opened for writing by the first run which simulates, so a job file of reweight
+    // jobs (see job.h) reads it instead. A reweight job closes it, which writes every record.
+    std::unique_ptr<Time_series> ts;
+    bool series_read = false;
+    if (!series_file.empty() && rank > 0)
+        series_file += "." + std::to_string(rank);
+
+    auto open_series = [&]() {
+        if (ts || series_file.empty())
+            return;
+        if (series_read) {
+            std::cerr << "Error: A job after a reweight job would overwrite " << series_file
+                      << "." << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        ts.reset(new Time_series(series_file,
+                    static_cast<size_t>(std::max(8, omp_get_max_threads()))));
+        time_series = ts.get();
+    };
+
+    set_pinning(pin);
+
+    // Only rank 0 of an MPI run reports the progress
+    std::unique_ptr<Progress> progress;
+    if (progress_every > 0.0 && rank == 0)
+        progress.reset(new Progress(progress_every, std::cerr));
+
+    if (!job_file.empty()) {
+        std::ifstream in;
+        if (job_file != "-") {
+            in.open(job_file);
+            if (!in) {
+                std::cerr << "Error: Could not open " << job_file << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+
+        Job_reader reader(job_file == "-" ? std::cin : in);
+        Job job;
+        if (schedule) {
+            std::vector<Job> jobs;
+            while (reader.next(job))
+                jobs.push_back(job);
+            open_series();
+#ifdef USE_MPI
+            run_distributed(jobs, time_series);
+#else
+            run_scheduled(jobs, time_series);
+#endif
+        } else {
+            while (reader.next(job)) {
+                if (job.method == Method::reweight) {
+                    ts.reset();
+                    time_series = nullptr;
+                    series_read = true;
+                    reweight_job(job, series_file);
+                } else {
+                    open_series();
+                    run_job(job, restart, time_series);
+                }
+            } // Loop over jobs
+        }
+
+        write_placement(std::cerr);
+        return EXIT_SUCCESS;
+    } // Run a job file
+
+    open_series();
 
     std::generate(T.begin(), T.end(), [&curr]() {
             curr++;
@@ -40,6 +215,7 @@ int main(void)
     test_ising(T);
     test_clock(T);
     test_xy(T);
+    write_placement(std::cerr);
 }
 
 
@@ -53,63 +229,84 @@ int main(void)
 void test_ising(const std::array<double, N_pts> &T)
 {
     Data_matrix data_clean2(N_pts, N_L+1);
+    Data_matrix energy_clean2(N_pts, N_L+1);
     Data_matrix data_clean3(N_pts, N_L+1);
+    Data_matrix energy_clean3(N_pts, N_L+1);
     Data_matrix data_disorder2(N_pts, N_L+1);
+    Data_matrix energy_disorder2(N_pts, N_L+1);
     Data_matrix data_disorder3(N_pts, N_L+1);
+    Data_matrix energy_disorder3(N_pts, N_L+1);
 
     data_clean2.insert_array(T.data());
+    energy_clean2.insert_array(T.data());
     data_clean3.insert_array(T.data());
+    energy_clean3.insert_array(T.data());
     data_disorder2.insert_array(T.data());
+    energy_disorder2.insert_array(T.data());
     data_disorder3.insert_array(T.data());
+    energy_disorder3.insert_array(T.data());
 
     std::cout << "Performing 2D Ising (clean)\n";
+    instrument_label("clean_ising2");
     for (int i = 0; i < N_L; i++) {
         std::cout << "\tL = " << L[i] << "... ";
         Ising2 ising(L[i]);
-        ising.set_run_param(30000, 50000);
-        auto binder = compute_binder(T, ising);
-        data_clean2.insert_array(binder.data());
+        ising.set_run_param(N_warmup, N_measure);
+        Checkpoint ckpt(ckpt_name("obs_clean_ising2", L[i]), ckpt_every, restart, seed);
+        auto obs = compute_observables(T, ising, &ckpt, time_series);
+        data_clean2.insert_array(observable_column(obs, &Observables::binder).data());
+        energy_clean2.insert_array(observable_column(obs, &Observables::E).data());
     }
 
     std::cout << "Performing 2D Ising (disorder)\n";
+    instrument_label("disorder_ising2");
     for (int i = 0; i < N_L; i++) {
         std::cout << "\tL = " << L[i] << "... ";
         Ising2 ising(L[i]);
-        ising.set_run_param(30000, 50000);
-        auto binder = compute_binder(T, ising, delta, N_run);
-        data_disorder2.insert_array(binder.data());
+        ising.set_run_param(N_warmup, N_measure);
+        Checkpoint ckpt(ckpt_name("obs_disorder_ising2", L[i]), ckpt_every, restart, seed);
+        auto obs = compute_observables(T, ising, delta, N_run, &ckpt, time_series);
+        data_disorder2.insert_array(observable_column(obs, &Observables::binder).data());
+        energy_disorder2.insert_array(observable_column(obs, &Observables::E).data());
     }
 
     std::cout << "Performing 3D Ising (clean)\n";
+    instrument_label("clean_ising3");
     for (int i = 0; i < N_L; i++) {
         std::cout << "\tL = " << L[i] << "... ";
         Ising3 ising(L[i]);
-        ising.set_run_param(30000, 50000);
-        auto binder = compute_binder(T, ising);
-        data_clean3.insert_array(binder.data());
+        ising.set_run_param(N_warmup, N_measure);
+        Checkpoint ckpt(ckpt_name("obs_clean_ising3", L[i]), ckpt_every, restart, seed);
+        auto obs = compute_observables(T, ising, &ckpt, time_series);
+        data_clean3.insert_array(observable_column(obs, &Observables::binder).data());
+        energy_clean3.insert_array(observable_column(obs, &Observables::E).data());
     }
 
     std::cout << "Performing 3D Ising (clean)\n";
+    instrument_label("disorder_ising3");
     for (int i = 0; i < N_L; i++) {
         std::cout << "\tL = " << L[i] << "... ";
         Ising3 ising(L[i]);
-        ising.set_run_param(30000, 50000);
-        auto binder = compute_binder(T, ising, delta, N_run);
-        data_disorder3.insert_array(binder.data());
+        ising.set_run_param(N_warmup, N_measure);
+        Checkpoint ckpt(ckpt_name("obs_disorder_ising3", L[i]), ckpt_every, restart, seed);
+        auto obs = compute_observables(T, ising, delta, N_run, &ckpt, time_series);
+        data_disorder3.insert_array(observable_column(obs, &Observables::binder).data());
+        energy_disorder3.insert_array(observable_column(obs, &Observables::E).data());
     }
 
-    std::ofstream of_clean2("binder_clean_ising2.dat"), of_disorder2("binder_disorder_ising2.dat"),
-        of_clean3("binder_clean_ising3.dat"), of_disorder3("binder_disorder_ising3.dat");
-
-    of_clean2 << data_clean2;
-    of_clean3 << data_clean3;
-    of_disorder2 << data_disorder2;
-    of_disorder3 << data_disorder3;
-
-    of_clean2.close();
-    of_clean3.close();
-    of_disorder2.close();
-    of_disorder3.close();
+    write_result("binder_clean_ising2.bin", data_clean2, make_header("ising2", false, "binder"));
+    write_result("binder_clean_ising3.bin", data_clean3, make_header("ising3", false, "binder"));
+    write_result("binder_disorder_ising2.bin", data_disorder2,
+            make_header("ising2", true, "binder"));
+    write_result("binder_disorder_ising3.bin", data_disorder3,
+            make_header("ising3", true, "binder"));
+    write_result("energy_clean_ising2.bin", energy_clean2, make_header("ising2", false, "E"));
+    write_result("energy_clean_ising3.bin", energy_clean3, make_header("ising3", false, "E"));
+    write_result("energy_disorder_ising2.bin", energy_disorder2, make_header("ising2", true, "E"));
+    write_result("energy_disorder_ising3.bin", energy_disorder3, make_header("ising3", true, "E"));
+
+    for (auto label : {"clean_ising2", "clean_ising3", "disorder_ising2", "disorder_ising3"})
+        instrument_write(label, std::string("instrument_") + label + ".json");
 }
 
 
@@ -119,63 +316,84 @@ void test_ising(const std::array<double, N_pts> &T)
 void test_clock(const std::array<double, N_pts> &T)
 {
     Data_matrix data_clean2(N_pts, N_L+1);
+    Data_matrix energy_clean2(N_pts, N_L+1);
     Data_matrix data_clean3(N_pts, N_L+1);
+    Data_matrix energy_clean3(N_pts, N_L+1);
     Data_matrix data_disorder2(N_pts, N_L+1);
+    Data_matrix energy_disorder2(N_pts, N_L+1);
     Data_matrix data_disorder3(N_pts, N_L+1);
+    Data_matrix energy_disorder3(N_pts, N_L+1);
 
     data_clean2.insert_array(T.data());
+    energy_clean2.insert_array(T.data());
     data_clean3.insert_array(T.data());
+    energy_clean3.insert_array(T.data());
     data_disorder2.insert_array(T.data());
+    energy_disorder2.insert_array(T.data());
     data_disorder3.insert_array(T.data());
+    energy_disorder3.insert_array(T.data());
 
     std::cout << "Performing 2D clock (2 spins) (clean)\n";
+    instrument_label("clean_clock2");
     for (int i = 0; i < N_L; i++) {
         std::cout << "\tL = " << L[i] << "... ";
         Clock2 clock(L[i], 2);
-        clock.set_run_param(30000, 50000);
-        auto binder = compute_binder(T, clock);
-        data_clean2.insert_array(binder.data());
+        clock.set_run_param(N_warmup, N_measure);
+        Checkpoint ckpt(ckpt_name("obs_clean_clock2", L[i]), ckpt_every, restart, seed);
+        auto obs = compute_observables(T, clock, &ckpt, time_series);
+        data_clean2.insert_array(observable_column(obs, &Observables::binder).data());
+        energy_clean2.insert_array(observable_column(obs, &Observables::E).data());
     }
 
     std::cout << "Performing 2D clock (2 spins) (disorder)\n";
+    instrument_label("disorder_clock2");
     for (int i = 0; i < N_L; i++) {
         std::cout << "\tL = " << L[i] << "... ";
         Clock2 clock(L[i], 2);
-        clock.set_run_param(30000, 50000);
-        auto binder = compute_binder(T, clock, delta, N_run);
-        data_disorder2.insert_array(binder.data());
+        clock.set_run_param(N_warmup, N_measure);
+        Checkpoint ckpt(ckpt_name("obs_disorder_clock2", L[i]), ckpt_every, restart, seed);
+        auto obs = compute_observables(T, clock, delta, N_run, &ckpt, time_series);
+        data_disorder2.insert_array(observable_column(obs, &Observables::binder).data());
+        energy_disorder2.insert_array(observable_column(obs, &Observables::E).data());
     }
 
     std::cout << "Performing 3D clock (2 spins) (clean)\n";
+    instrument_label("clean_clock3");
     for (int i = 0; i < N_L; i++) {
         std::cout << "\tL = " << L[i] << "... ";
         Clock3 clock(L[i], 2);
-        clock.set_run_param(30000, 50000);
-        auto binder = compute_binder(T, clock);
-        data_clean3.insert_array(binder.data());
+        clock.set_run_param(N_warmup, N_measure);
+        Checkpoint ckpt(ckpt_name("obs_clean_clock3", L[i]), ckpt_every, restart, seed);
+        auto obs = compute_observables(T, clock, &ckpt, time_series);
+        data_clean3.insert_array(observable_column(obs, &Observables::binder).data());
+        energy_clean3.insert_array(observable_column(obs, &Observables::E).data());
     }
 
     std::cout << "Performing 3D clock (2 spins) (clean)\n";
+    instrument_label("disorder_clock3");
     for (int i = 0; i < N_L; i++) {
         std::cout << "\tL = " << L[i] << "... ";
         Clock3 clock(L[i], 2);
-        clock.set_run_param(30000, 50000);
-        auto binder = compute_binder(T, clock, delta, N_run);
-        data_disorder3.insert_array(binder.data());
+        clock.set_run_param(N_warmup, N_measure);
+        Checkpoint ckpt(ckpt_name("obs_disorder_clock3", L[i]), ckpt_every, restart, seed);
+        auto obs = compute_observables(T, clock, delta, N_run, &ckpt, time_series);
+        data_disorder3.insert_array(observable_column(obs, &Observables::binder).data());
+        energy_disorder3.insert_array(observable_column(obs, &Observables::E).data());
     }
 
-    std::ofstream of_clean2("binder_clean_clock2.dat"), of_disorder2("binder_disorder_clock2.dat"),
-        of_clean3("binder_clean_clock3.dat"), of_disorder3("binder_disorder_clock3.dat");
-
-    of_clean2 << data_clean2;
-    of_clean3 << data_clean3;
-    of_disorder2 << data_disorder2;
-    of_disorder3 << data_disorder3;
-
-    of_clean2.close();
-    of_clean3.close();
-    of_disorder2.close();
-    of_disorder3.close();
+    write_result("binder_clean_clock2.bin", data_clean2, make_header("clock2", false, "binder"));
+    write_result("binder_clean_clock3.bin", data_clean3, make_header("clock3", false, "binder"));
+    write_result("binder_disorder_clock2.bin", data_disorder2,
+            make_header("clock2", true, "binder"));
+    write_result("binder_disorder_clock3.bin", data_disorder3,
+            make_header("clock3", true, "binder"));
+    write_result("energy_clean_clock2.bin", energy_clean2, make_header("clock2", false, "E"));
+    write_result("energy_clean_clock3.bin", energy_clean3, make_header("clock3", false, "E"));
+    write_result("energy_disorder_clock2.bin", energy_disorder2, make_header("clock2", true, "E"));
+    write_result("energy_disorder_clock3.bin", energy_disorder3, make_header("clock3", true, "E"));
+
+    for (auto label : {"clean_clock2", "clean_clock3", "disorder_clock2", "disorder_clock3"})
+        instrument_write(label, std::string("instrument_") + label + ".json");
 }
 
 
@@ -185,61 +403,113 @@ void test_clock(const std::array<double, N_pts> &T)
 void test_xy(const std::array<double, N_pts> &T)
 {
     Data_matrix data_clean2(N_pts, N_L+1);
+    Data_matrix energy_clean2(N_pts, N_L+1);
     Data_matrix data_clean3(N_pts, N_L+1);
+    Data_matrix energy_clean3(N_pts, N_L+1);
     Data_matrix data_disorder2(N_pts, N_L+1);
+    Data_matrix energy_disorder2(N_pts, N_L+1);
     Data_matrix data_disorder3(N_pts, N_L+1);
+    Data_matrix energy_disorder3(N_pts, N_L+1);
 
     data_clean2.insert_array(T.data());
+    energy_clean2.insert_array(T.data());
     data_clean3.insert_array(T.data());
+    energy_clean3.insert_array(T.data());
     data_disorder2.insert_array(T.data());
+    energy_disorder2.insert_array(T.data());
     data_disorder3.insert_array(T.data());
+    energy_disorder3.insert_array(T.data());
 
     std::cout << "Performing 2D XY (clean)\n";
+    instrument_label("clean_xy2");
     for (int i = 0; i < N_L; i++) {
         std::cout << "\tL = " << L[i] << "... ";
         XY2 xy(L[i]);
-        xy.set_run_param(30000, 50000);
-        auto binder = compute_binder(T, xy);
-        data_clean2.insert_array(binder.data());
+        xy.set_run_param(N_warmup, N_measure);
+        Checkpoint ckpt(ckpt_name("obs_clean_xy2", L[i]), ckpt_every, restart, seed);
+        auto obs = compute_observables(T, xy, &ckpt, time_series);
+        data_clean2.insert_array(observable_column(obs, &Observables::binder).data());
+        energy_clean2.insert_array(observable_column(obs, &Observables::E).data());
     }
 
     std::cout << "Performing 2D XY (disorder)\n";
+    instrument_label("disorder_xy2");
     for (int i = 0; i < N_L; i++) {
         std::cout << "\tL = " << L[i] << "... ";
         XY2 xy(L[i]);
-        xy.set_run_param(30000, 50000);
-        auto binder = compute_binder(T, xy, delta, N_run);
-        data_disorder2.insert_array(binder.data());
+        xy.set_run_param(N_warmup, N_measure);
+        Checkpoint ckpt(ckpt_name("obs_disorder_xy2", L[i]), ckpt_every, restart, seed);
+        auto obs = compute_observables(T, xy, delta, N_run, &ckpt, time_series);
+        data_disorder2.insert_array(observable_column(obs, &Observables::binder).data());
+        energy_disorder2.insert_array(observable_column(obs, &Observables::E).data());
     }
 
     std::cout << "Performing 3D XY (clean)\n";
+    instrument_label("clean_xy3");
     for (int i = 0; i < N_L; i++) {
         std::cout << "\tL = " << L[i] << "... ";
         XY3 xy(L[i]);
-        xy.set_run_param(30000, 50000);
-        auto binder = compute_binder(T, xy);
-        data_clean3.insert_array(binder.data());
+        xy.set_run_param(N_warmup, N_measure);
+        Checkpoint ckpt(ckpt_name("obs_clean_xy3", L[i]), ckpt_every, restart, seed);
+        auto obs = compute_observables(T, xy, &ckpt, time_series);
+        data_clean3.insert_array(observable_column(obs, &Observables::binder).data());
+        energy_clean3.insert_array(observable_column(obs, &Observables::E).data());
     }
 
     std::cout << "Performing 3D XY (clean)\n";
+    instrument_label("disorder_xy3");
     for (int i = 0; i < N_L; i++) {
         std::cout << "\tL = " << L[i] << "... ";
         XY3 xy(L[i]);
-        xy.set_run_param(30000, 50000);
-        auto binder = compute_binder(T, xy, delta, N_run);
-        data_disorder3.insert_array(binder.data());
+        xy.set_run_param(N_warmup, N_measure);
+        Checkpoint ckpt(ckpt_name("obs_disorder_xy3", L[i]), ckpt_every, restart, seed);
+        auto obs = compute_observables(T, xy, delta, N_run, &ckpt, time_series);
+        data_disorder3.insert_array(observable_column(obs, &Observables::binder).data());
+        energy_disorder3.insert_array(observable_column(obs, &Observables::E).data());
     }
 
-    std::ofstream of_clean2("binder_clean_xy2.dat"), of_disorder2("binder_disorder_xy2.dat"),
-        of_clean3("binder_clean_xy3.dat"), of_disorder3("binder_disorder_xy3.dat");
+    write_result("binder_clean_xy2.bin", data_clean2, make_header("xy2", false, "binder"));
+    write_result("binder_clean_xy3.bin", data_clean3, make_header("xy3", false, "binder"));
+    write_result("binder_disorder_xy2.bin", data_disorder2, make_header("xy2", true, "binder"));
+    write_result("binder_disorder_xy3.bin", data_disorder3, make_header("xy3", true, "binder"));
+    write_result("energy_clean_xy2.bin", energy_clean2, make_header("xy2", false, "E"));
+    write_result("energy_clean_xy3.bin", energy_clean3, make_header("xy3", false, "E"));
+    write_result("energy_disorder_xy2.bin", energy_disorder2, make_header("xy2", true, "E"));
+    write_result("energy_disorder_xy3.bin", energy_disorder3, make_header("xy3", true, "E"));
+
+    for (auto label : {"clean_xy2", "clean_xy3", "disorder_xy2", "disorder_xy3"})
+        instrument_write(label, std::string("instrument_") + label + ".json");
+}
+
+
+/* ckpt_name()
+ * Returns the name of the checkpoint file of one lattice size of a series.
+ */
+std::string ckpt_name(const std::string &series, int L)
+{
+    return series + "_L" + std::to_string(L) + ".ckpt";
+}
+
+
+/* make_header()
+ * Returns the column names and run parameters of a series of one observable.
+ */
+Result_header make_header(const std::string &model, bool disorder,
+        const std::string &observable)
+{
+    Result_header header;
+
+    header.add_column("T");
+    for (int i = 0; i < N_L; i++)
+        header.add_column("L=" + std::to_string(L[i]));
 
-    of_clean2 << data_clean2;
-    of_clean3 << data_clean3;
-    of_disorder2 << data_disorder2;
-    of_disorder3 << data_disorder3;
+    header.set_param("model", model);
+    header.set_param("observable", observable);
+    header.set_param("warmup", N_warmup);
+    header.set_param("measure", N_measure);
+    header.set_param("delta", disorder ? delta : 0.0);
+    header.set_param("n_run", disorder ? N_run : 1);
+    header.set_param("seed", seed);
 
-    of_clean2.close();
-    of_clean3.close();
-    of_disorder2.close();
-    of_disorder3.close();
+    return header;
 }
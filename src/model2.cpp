@@ -1,22 +1,112 @@
 #include <random>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
 
 #include "../include/model2.h"
 
 
+/*-------------------------------------------------------------------------------------------------
+ * PROTECTED METHODS
+ *-----------------------------------------------------------------------------------------------*/
+
+/* tune_lattice()
+ * Called before the first and after every warmup sweep with the number of sweeps done. Models
+ * with tunable proposals override this.
+ */
+void Model2::tune_lattice(size_t)
+{
+}
+
+
+/* stored_site()
+ * Returns where the site with row major index r is stored (see site_order.h).
+ */
+size_t Model2::stored_site(size_t r) const
+{
+    return index.empty() ? r : index[r];
+}
+
+
+/* prefetch_neighbors()
+ * Prefetches the neighbor entry of a site, which may straddle two cache lines.
+ */
+void Model2::prefetch_neighbors(size_t pos) const
+{
+    __builtin_prefetch(&neigh[pos]);
+    __builtin_prefetch(&neigh[pos].neighbor[n_neigh - 1]);
+}
+
+
+/* upcoming_site()
+ * Returns the site of update i + n_ahead / 2 of a prefetching sweep, or size if the sweep ends
+ * before. Sweeps prefetch its spins at update i, once its neighbor entries have arrived.
+ */
+size_t Model2::upcoming_site(size_t i) const
+{
+    return i + n_ahead / 2 < size ? ahead[(i + n_ahead / 2) % n_ahead] : size;
+}
+
+
+/* warmup_lattice()
+ * Performs the remaining warmup sweeps.
+ */
+void Model2::warmup_lattice(float beta, std::mt19937 &engine)
+{
+    INSTRUMENT_PHASE(timer, counters.t_warmup, counters);
+
+    if (state.n_sweep == 0)
+        tune_lattice(0);
+
+    while (state.n_sweep < warmup) {
+        sweep_lattice(beta, engine);
+        INSTRUMENT_ADD(counters, proposed, size);
+        state.n_sweep++;
+        tune_lattice(state.n_sweep);
+        end_sweep(engine);
+    } // Warmup sweeps
+}
+
+
+/* push_series()
+ * Adds the observables of the current measurement sweep to the time series.
+ */
+void Model2::push_series(double E, double M2)
+{
+    INSTRUMENT_TIMER(timer, counters.t_io);
+    ts->push(ts_chan, ts_id, state.n_sweep - warmup, E, M2);
+}
+
+
+/* end_sweep()
+ * Reports the progress and calls the checkpoint hook every checkpoint_every sweeps.
+ */
+void Model2::end_sweep(const std::mt19937 &engine)
+{
+    report_sweeps(state.n_sweep, warmup + measure, size, progress_mark);
+    if (checkpoint && state.n_sweep % checkpoint_every == 0) {
+        INSTRUMENT_TIMER(timer, counters.t_io);
+        checkpoint(engine);
+    }
+}
+
+
 /*-------------------------------------------------------------------------------------------------
  * PUBLIC METHODS
  *-----------------------------------------------------------------------------------------------*/
 
 /* Default constructor
  */
-Model2::Model2() : isClean(true), rand0(0.0, 1.0)
+Model2::Model2() : isClean(true), rand0(0.0, 1.0), checkpoint_every(0),
+    ts(nullptr), ts_chan(0), ts_id(0)
 {
 }
 
 
 /* Constructor with parameters
  */
-Model2::Model2(const int L) : isClean(true), rand0(0.0, 1.0)
+Model2::Model2(const int L) : isClean(true), rand0(0.0, 1.0), checkpoint_every(0),
+    ts(nullptr), ts_chan(0), ts_id(0)
 {
     size = L * L;
 
@@ -30,8 +120,186 @@ Model2::Model2(const int L) : isClean(true), rand0(0.0, 1.0)
 
 /* Copy constructor
  */
-Model2::Model2(const Model2 &rhs) : size(rhs.size), isClean(rhs.isClean), neigh(rhs.neigh), J(rhs.J)
+Model2::Model2(const Model2 &rhs) :
+    warmup(rhs.warmup), measure(rhs.measure), size(rhs.size), isClean(rhs.isClean),
+    rand0(0.0, 1.0), neigh(rhs.neigh), J(rhs.J), order(rhs.order), index(rhs.index),
+    visit(rhs.visit), block(rhs.block), ahead(rhs.ahead), state(rhs.state),
+    checkpoint_every(rhs.checkpoint_every), checkpoint(rhs.checkpoint), ts(rhs.ts),
+    ts_chan(rhs.ts_chan), ts_id(rhs.ts_id)
+{
+}
+
+
+/* set_spin()
+ * Sets the spins using an engine seeded by std::random_device.
+ */
+void Model2::set_spin()
+{
+    std::random_device rd;
+    std::mt19937 engine(rd());
+
+    set_spin(engine);
+}
+
+
+/* sweep_energy()
+ * Performs monte carlo sweeps and calcuates the energy per site.
+ */
+double Model2::sweep_energy(double beta, std::mt19937 &engine)
+{
+    state.acc.resize(1);
+
+    warmup_lattice(beta, engine);
+    INSTRUMENT_PHASE(timer, counters.t_measure, counters);
+
+    while (state.n_sweep < warmup + measure) {
+        sweep_lattice(beta, engine);
+        INSTRUMENT_ADD(counters, proposed, size);
+
+        double E;
+        {
+            INSTRUMENT_TIMER(observe, counters.t_observe);
+            E = energy();
+        }
+        state.acc[0] += E;
+        if (ts)
+            push_series(E, magnetization2());
+        state.n_sweep++;
+        end_sweep(engine);
+    } // Measurement sweeps
+
+    double E = state.acc[0] / static_cast<double>(measure * size);
+    state    = Sweep_state();
+
+    return E;
+}
+
+
+/* sweep_binder()
+ * Performs lattice sweeps and computes the binder ratio.
+ */
+double Model2::sweep_binder(double beta, std::mt19937 &engine)
+{
+    state.acc.resize(2);
+
+    warmup_lattice(beta, engine);
+    INSTRUMENT_PHASE(timer, counters.t_measure, counters);
+
+    while (state.n_sweep < warmup + measure) {
+        sweep_lattice(beta, engine);
+        INSTRUMENT_ADD(counters, proposed, size);
+
+        double M2;
+        {
+            INSTRUMENT_TIMER(observe, counters.t_observe);
+            M2 = magnetization2();
+        }
+        state.acc[0] += M2;
+        state.acc[1] += M2 * M2;
+        if (ts)
+            push_series(energy(), M2);
+        state.n_sweep++;
+        end_sweep(engine);
+    } // Measurement sweeps
+
+    double M2 = state.acc[0] / static_cast<double>(measure);
+    double M4 = state.acc[1] / static_cast<double>(measure);
+    state     = Sweep_state();
+
+    return 1.0 - (M4 / (3.0 * M2 * M2));
+}
+
+
+/* sweep_observables()
+ * Performs lattice sweeps and computes every observable in one run. See observables.h.
+ */
+Observables Model2::sweep_observables(double beta, std::mt19937 &engine)
+{
+    state.acc.resize(Observables::n_value);
+
+    warmup_lattice(beta, engine);
+    INSTRUMENT_PHASE(timer, counters.t_measure, counters);
+
+    while (state.n_sweep < warmup + measure) {
+        sweep_lattice(beta, engine);
+        INSTRUMENT_ADD(counters, proposed, size);
+
+        double E, M2;
+        {
+            INSTRUMENT_TIMER(observe, counters.t_observe);
+            E  = energy();
+            M2 = magnetization2();
+        }
+        state.acc[0] += E;
+        state.acc[1] += E * E;
+        state.acc[2] += sqrt(M2);
+        state.acc[3] += M2;
+        state.acc[4] += M2 * M2;
+        if (ts)
+            push_series(E, M2);
+        state.n_sweep++;
+        end_sweep(engine);
+    } // Measurement sweeps
+
+    Observables obs = make_observables(beta, size, measure, state.acc.data());
+    state           = Sweep_state();
+
+    return obs;
+}
+
+
+/* learn_muca()
+ * Learns the multicanonical weight for [T_lo, T_hi] (see muca.h).
+ */
+Muca_weight Model2::learn_muca(double T_lo, double T_hi, size_t n_bin, size_t n_iter,
+        size_t n_sweep, std::mt19937 &engine)
+{
+    return ::learn_muca(*this, T_lo, T_hi, n_bin, n_iter, n_sweep, engine);
+}
+
+
+/* sweep_muca()
+ * Performs the warmup and measurement multicanonical sweeps with the weight W (see muca.h).
+ */
+Muca_sample Model2::sweep_muca(const Muca_weight &W, std::mt19937 &engine)
+{
+    return ::sweep_muca(*this, W, warmup, measure, engine);
+}
+
+
+/* get_length()
+ * Returns the linear size L of the lattice.
+ */
+int Model2::get_length() const
+{
+    return static_cast<int>(lround(sqrt(static_cast<double>(size))));
+}
+
+
+/* get_lattice()
+ * Returns the neighbor table, whose pages tell where the replica lives (see placement.h).
+ */
+const void* Model2::get_lattice() const
+{
+    return neigh.data();
+}
+
+
+/* get_counters()
+ * Returns the counters and phase timers of the sweeps so far. See instrument.h.
+ */
+const Counters& Model2::get_counters() const
+{
+    return counters;
+}
+
+
+/* reset_counters()
+ * Zeroes the counters and phase timers.
+ */
+void Model2::reset_counters()
 {
+    counters = Counters();
 }
 
 
@@ -40,15 +308,28 @@ Model2::Model2(const Model2 &rhs) : size(rhs.size), isClean(rhs.isClean), neigh(
  * with a mean centered at 1. The range of random values is J = [1 - delta/2, 1 + delta/2].
  */
 void Model2::set_exchange(double delta)
+{
+    std::random_device rd;
+    std::mt19937 engine(rd());
+
+    set_exchange(delta, engine);
+}
+
+
+/* set_exchange()
+ * Sets the exchange table using the given engine.
+ */
+void Model2::set_exchange(double delta, std::mt19937 &engine)
 {
     if (isClean)
         isClean = false;
 
-    std::random_device rd;
-    std::mt19937 engine(rd());
     double J_val, r_val;
 
-    for (size_t i = 0; i < size; i++) {
+    // Drawn in row major order, so a seed gives the same bonds in every site order
+    for (size_t r = 0; r < size; r++) {
+        const size_t i = stored_site(r);
+
         // 0 - 2 bond
         r_val = rand0(engine);
         if (rand0(engine) > 0.5) J_val = 1.0 - (delta * r_val / 2.0);
@@ -75,6 +356,69 @@ std::vector<Exchange<2>> Model2::get_exchange() const
 }
 
 
+/* get_neighbors()
+ * Returns the vector which contains the neighbor table.
+ */
+std::vector<Neighbor<2>> Model2::get_neighbors() const
+{
+    return neigh;
+}
+
+
+/* get_site_order()
+ * Returns the order the sites are stored in.
+ */
+Site_order Model2::get_site_order() const
+{
+    return order;
+}
+
+
+/* get_visit()
+ * Returns the order the sweeps visit the sites in.
+ */
+Visit Model2::get_visit() const
+{
+    return visit;
+}
+
+
+/* get_warmup()
+ * Returns the number of warmup sweeps.
+ */
+size_t Model2::get_warmup() const
+{
+    return warmup;
+}
+
+
+/* get_measure()
+ * Returns the number of measurement sweeps.
+ */
+size_t Model2::get_measure() const
+{
+    return measure;
+}
+
+
+/* get_size()
+ * Returns the number of lattice sites.
+ */
+size_t Model2::get_size() const
+{
+    return size;
+}
+
+
+/* get_energy()
+ * Returns the total energy of the current configuration.
+ */
+double Model2::get_energy() const
+{
+    return energy();
+}
+
+
 /* set_run_param()
  * Overrides the default parameters for running simulations.
  */
@@ -83,3 +427,99 @@ void Model2::set_run_param(size_t Warmup, size_t Measure)
     warmup  = Warmup;
     measure = Measure;
 }
+
+
+/* set_site_order()
+ * Stores the sites in another order (see site_order.h) and rebuilds the neighbor table. Call
+ * before the spins and the exchange table are set.
+ */
+void Model2::set_site_order(Site_order Order)
+{
+    const int L = get_length();
+
+    order = Order;
+    index = site_index(L, 2, order);
+
+    for (size_t r = 0; r < size; r++) {
+        if (index.empty())
+            neigh[r].set_neighbors(r, L);
+        else
+            neigh[index[r]].set_neighbors(r, L, index);
+    } // Loop over sites
+}
+
+
+/* set_visit()
+ * Sets the order the sweeps visit the sites in (see site_order.h).
+ */
+void Model2::set_visit(Visit Visit_mode)
+{
+    const size_t L = static_cast<size_t>(get_length());
+
+    visit = Visit_mode;
+    ahead.resize(n_ahead);
+    block.resize(size / L);
+    for (size_t b = 0; b < block.size(); b++)
+        block[b] = b;
+}
+
+
+/* set_checkpoint()
+ * Sets a hook which is called every `every` sweeps, used to write checkpoints.
+ */
+void Model2::set_checkpoint(size_t every, const Checkpoint_hook &hook)
+{
+    checkpoint_every = every;
+    checkpoint       = hook;
+}
+
+
+/* set_time_series()
+ * Streams the observables of every measurement sweep of the next temperature to a new series of
+ * the time series through channel chan. Pass nullptr to stop streaming.
+ */
+void Model2::set_time_series(Time_series *series, int chan, double beta, int run, int idx)
+{
+    ts = series;
+    if (ts) {
+        ts_chan = chan;
+        ts_id   = ts->begin_series(chan, beta, run, idx);
+    }
+}
+
+
+/* save()
+ * Writes the run parameters and sweep progress in binary. The exchange table is drawn again from
+ * the seed of the realization (see checkpoint.h) and is not stored.
+ */
+void Model2::save(std::ostream &os) const
+{
+    write_binary(os, warmup);
+    write_binary(os, measure);
+    write_binary(os, size);
+    write_binary(os, order);
+    write_binary(os, isClean);
+    write_binary(os, state);
+}
+
+
+/* load()
+ * Reads back the data written by save().
+ */
+void Model2::load(std::istream &is)
+{
+    size_t Size = 0;
+    Site_order Order = Site_order::row_major;
+
+    read_binary(is, warmup);
+    read_binary(is, measure);
+    read_binary(is, Size);
+    read_binary(is, Order);
+    read_binary(is, isClean);
+    read_binary(is, state);
+
+    if (!is || Size != size || Order != order) {
+        std::cerr << "Error: Saved model does not match the lattice." << std::endl;
+        exit(EXIT_FAILURE);
+    }
+}
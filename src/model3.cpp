@@ -1,6 +1,159 @@
 #include <random>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include <iostream>
 
 #include "../include/model3.h"
+#include "../include/placement.h"
+
+
+/*-------------------------------------------------------------------------------------------------
+ * PROTECTED METHODS
+ *-----------------------------------------------------------------------------------------------*/
+
+/* tune_lattice()
+ * Called before the first and after every warmup sweep with the number of sweeps done. Models
+ * with tunable proposals override this.
+ */
+void Model3::tune_lattice(size_t)
+{
+}
+
+
+/* overrelax_site()
+ * Over-relaxes the spin at pos. Models without over-relaxation leave it alone.
+ */
+void Model3::overrelax_site(size_t, float, std::mt19937 &)
+{
+}
+
+
+/* overrelax_sweeps()
+ * Returns the number of over-relaxation sweeps after each Metropolis sweep.
+ */
+size_t Model3::overrelax_sweeps() const
+{
+    return 0;
+}
+
+
+/* count_accepted()
+ * Adds the accepted moves of a slab sweep for models which tune their proposals.
+ */
+void Model3::count_accepted(size_t)
+{
+}
+
+
+/* update_slab()
+ * Updates the sites of one color of a slab (two z planes) in order. Returns the number of
+ * accepted moves.
+ */
+size_t Model3::update_slab(size_t slab, int color, float beta, std::mt19937 &engine)
+{
+    const size_t L = static_cast<size_t>(get_length());
+    size_t n_acc   = 0;
+
+    for (size_t z = 2 * slab; z < 2 * slab + 2; z++) {
+        for (size_t y = 0; y < L; y++) {
+            const size_t row = (z * L + y) * L;
+            for (size_t x = (color + y + z) % 2; x < L; x += 2)
+                n_acc += update_site(stored_site(row + x), beta, engine);
+        } // Loop over rows
+    } // Loop over planes
+
+    return n_acc;
+}
+
+
+/* overrelax_slab()
+ * Over-relaxes the sites of one color of a slab in order.
+ */
+void Model3::overrelax_slab(size_t slab, int color, float beta, std::mt19937 &engine)
+{
+    const size_t L = static_cast<size_t>(get_length());
+
+    for (size_t z = 2 * slab; z < 2 * slab + 2; z++) {
+        for (size_t y = 0; y < L; y++) {
+            const size_t row = (z * L + y) * L;
+            for (size_t x = (color + y + z) % 2; x < L; x += 2)
+                overrelax_site(stored_site(row + x), beta, engine);
+        } // Loop over rows
+    } // Loop over planes
+}
+
+
+/* stored_site()
+ * Returns where the site with row major index r is stored (see site_order.h).
+ */
+size_t Model3::stored_site(size_t r) const
+{
+    return index.empty() ? r : index[r];
+}
+
+
+/* prefetch_neighbors()
+ * Prefetches the neighbor entry of a site, which may straddle two cache lines.
+ */
+void Model3::prefetch_neighbors(size_t pos) const
+{
+    __builtin_prefetch(&neigh[pos]);
+    __builtin_prefetch(&neigh[pos].neighbor[n_neigh - 1]);
+}
+
+
+/* upcoming_site()
+ * Returns the site of update i + n_ahead / 2 of a prefetching sweep, or size if the sweep ends
+ * before. Sweeps prefetch its spins at update i, once its neighbor entries have arrived.
+ */
+size_t Model3::upcoming_site(size_t i) const
+{
+    return i + n_ahead / 2 < size ? ahead[(i + n_ahead / 2) % n_ahead] : size;
+}
+
+
+/* warmup_lattice()
+ * Performs the remaining warmup sweeps.
+ */
+void Model3::warmup_lattice(float beta, std::mt19937 &engine)
+{
+    INSTRUMENT_PHASE(timer, counters.t_warmup, counters);
+
+    if (state.n_sweep == 0)
+        tune_lattice(0);
+
+    while (state.n_sweep < warmup) {
+        sweep_lattice(beta, engine);
+        INSTRUMENT_ADD(counters, proposed, size);
+        state.n_sweep++;
+        tune_lattice(state.n_sweep);
+        end_sweep(engine);
+    } // Warmup sweeps
+}
+
+
+/* push_series()
+ * Adds the observables of the current measurement sweep to the time series.
+ */
+void Model3::push_series(double E, double M2)
+{
+    INSTRUMENT_TIMER(timer, counters.t_io);
+    ts->push(ts_chan, ts_id, state.n_sweep - warmup, E, M2);
+}
+
+
+/* end_sweep()
+ * Reports the progress and calls the checkpoint hook every checkpoint_every sweeps.
+ */
+void Model3::end_sweep(const std::mt19937 &engine)
+{
+    report_sweeps(state.n_sweep, warmup + measure, size, progress_mark);
+    if (checkpoint && state.n_sweep % checkpoint_every == 0) {
+        INSTRUMENT_TIMER(timer, counters.t_io);
+        checkpoint(engine);
+    }
+}
 
 
 /*-------------------------------------------------------------------------------------------------
@@ -9,14 +162,16 @@
 
 /* Default constructor
  */
-Model3::Model3() : isClean(true), rand0(0.0, 1.0)
+Model3::Model3() : isClean(true), rand0(0.0, 1.0), checkpoint_every(0),
+    ts(nullptr), ts_chan(0), ts_id(0)
 {
 }
 
 
 /* Constructor with parameters
  */
-Model3::Model3(const int L) : isClean(true), rand0(0.0, 1.0)
+Model3::Model3(const int L) : isClean(true), rand0(0.0, 1.0), checkpoint_every(0),
+    ts(nullptr), ts_chan(0), ts_id(0)
 {
     size = L * L * L;
 
@@ -30,8 +185,290 @@ Model3::Model3(const int L) : isClean(true), rand0(0.0, 1.0)
 
 /* Copy constructor
  */
-Model3::Model3(const Model3 &rhs) : size(rhs.size), isClean(rhs.isClean), neigh(rhs.neigh), J(rhs.J)
+Model3::Model3(const Model3 &rhs) :
+    warmup(rhs.warmup), measure(rhs.measure), size(rhs.size), isClean(rhs.isClean),
+    rand0(0.0, 1.0), neigh(rhs.neigh), J(rhs.J), order(rhs.order), index(rhs.index),
+    visit(rhs.visit), block(rhs.block), ahead(rhs.ahead), state(rhs.state),
+    checkpoint_every(rhs.checkpoint_every), checkpoint(rhs.checkpoint), ts(rhs.ts),
+    ts_chan(rhs.ts_chan), ts_id(rhs.ts_id)
+{
+}
+
+
+/* set_spin()
+ * Sets the spins using an engine seeded by std::random_device.
+ */
+void Model3::set_spin()
+{
+    std::random_device rd;
+    std::mt19937 engine(rd());
+
+    set_spin(engine);
+}
+
+
+/* sweep_energy()
+ * Performs monte carlo sweeps and calcuates the energy per site.
+ */
+double Model3::sweep_energy(double beta, std::mt19937 &engine)
 {
+    state.acc.resize(1);
+
+    warmup_lattice(beta, engine);
+    INSTRUMENT_PHASE(timer, counters.t_measure, counters);
+
+    while (state.n_sweep < warmup + measure) {
+        sweep_lattice(beta, engine);
+        INSTRUMENT_ADD(counters, proposed, size);
+
+        double E;
+        {
+            INSTRUMENT_TIMER(observe, counters.t_observe);
+            E = energy();
+        }
+        state.acc[0] += E;
+        if (ts)
+            push_series(E, magnetization2());
+        state.n_sweep++;
+        end_sweep(engine);
+    } // Measurement sweeps
+
+    double E = state.acc[0] / static_cast<double>(measure * size);
+    state    = Sweep_state();
+
+    return E;
+}
+
+
+/* sweep_binder()
+ * Performs lattice sweeps and computes the binder ratio.
+ */
+double Model3::sweep_binder(double beta, std::mt19937 &engine)
+{
+    state.acc.resize(2);
+
+    warmup_lattice(beta, engine);
+    INSTRUMENT_PHASE(timer, counters.t_measure, counters);
+
+    while (state.n_sweep < warmup + measure) {
+        sweep_lattice(beta, engine);
+        INSTRUMENT_ADD(counters, proposed, size);
+
+        double M2;
+        {
+            INSTRUMENT_TIMER(observe, counters.t_observe);
+            M2 = magnetization2();
+        }
+        state.acc[0] += M2;
+        state.acc[1] += M2 * M2;
+        if (ts)
+            push_series(energy(), M2);
+        state.n_sweep++;
+        end_sweep(engine);
+    } // Measurement sweeps
+
+    double M2 = state.acc[0] / static_cast<double>(measure);
+    double M4 = state.acc[1] / static_cast<double>(measure);
+    state     = Sweep_state();
+
+    return 1.0 - (M4 / (3.0 * M2 * M2));
+}
+
+
+/* sweep_observables()
+ * Performs lattice sweeps and computes every observable in one run. See observables.h.
+ */
+Observables Model3::sweep_observables(double beta, std::mt19937 &engine)
+{
+    state.acc.resize(Observables::n_value);
+
+    warmup_lattice(beta, engine);
+    INSTRUMENT_PHASE(timer, counters.t_measure, counters);
+
+    while (state.n_sweep < warmup + measure) {
+        sweep_lattice(beta, engine);
+        INSTRUMENT_ADD(counters, proposed, size);
+
+        double E, M2;
+        {
+            INSTRUMENT_TIMER(observe, counters.t_observe);
+            E  = energy();
+            M2 = magnetization2();
+        }
+        state.acc[0] += E;
+        state.acc[1] += E * E;
+        state.acc[2] += sqrt(M2);
+        state.acc[3] += M2;
+        state.acc[4] += M2 * M2;
+        if (ts)
+            push_series(E, M2);
+        state.n_sweep++;
+        end_sweep(engine);
+    } // Measurement sweeps
+
+    Observables obs = make_observables(beta, size, measure, state.acc.data());
+    state           = Sweep_state();
+
+    return obs;
+}
+
+
+/* sweep_observables_slabs()
+ * Performs lattice sweeps with every thread on its own slabs and computes every observable in one
+ * run (see the class comment).
+ */
+Observables Model3::sweep_observables_slabs(double beta, std::mt19937 &engine)
+{
+    const int L          = get_length();
+    const long n_slab    = L / 2;
+    const size_t n_site  = 2 * static_cast<size_t>(L) * static_cast<size_t>(L);  // Per slab
+    const size_t n_over  = overrelax_sweeps();
+    const float beta_f   = static_cast<float>(beta);
+    std::vector<std::mt19937> slab_engine(n_slab);
+    std::vector<size_t> slab_acc(n_slab);
+    std::vector<double> slab_E(n_slab), slab_Mx(n_slab), slab_My(n_slab);
+
+    if (L % 2 != 0) {
+        std::cerr << "Error: Slab sweeps need an even L, not " << L << "." << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    for (long s = 0; s < n_slab; s++) {
+        std::seed_seq seq{static_cast<std::uint32_t>(engine()),
+                          static_cast<std::uint32_t>(engine()), static_cast<std::uint32_t>(s)};
+        slab_engine[s].seed(seq);
+    } // Seed the slabs
+
+    state = Sweep_state();
+    state.acc.resize(Observables::n_value);
+    tune_lattice(0);
+
+    #pragma omp parallel
+    {
+        pin_thread();
+
+        while (state.n_sweep < warmup + measure) {
+            const bool measuring = state.n_sweep >= warmup;
+
+            for (int color = 0; color < 2; color++) {
+                #pragma omp for schedule(static)
+                for (long s = 0; s < n_slab; s++) {
+                    if (color == 0)
+                        slab_acc[s] = 0;
+                    slab_acc[s] += update_slab(s, color, beta_f, slab_engine[s]);
+                }
+            } // Loop over the checkerboard
+
+            for (size_t o = 0; o < n_over; o++) {
+                for (int color = 0; color < 2; color++) {
+                    #pragma omp for schedule(static)
+                    for (long s = 0; s < n_slab; s++)
+                        overrelax_slab(s, color, beta_f, slab_engine[s]);
+                } // Loop over the checkerboard
+            } // Over-relaxation sweeps
+
+            if (measuring) {
+                #pragma omp for schedule(static)
+                for (long s = 0; s < n_slab; s++) {
+                    slab_E[s] = energy_sites(s * n_site, (s + 1) * n_site);
+                    magnetization_sites(s * n_site, (s + 1) * n_site, slab_Mx[s], slab_My[s]);
+                }
+            }
+
+            #pragma omp single
+            {
+                size_t n_acc = 0;
+                for (long s = 0; s < n_slab; s++)
+                    n_acc += slab_acc[s];
+                INSTRUMENT_ADD(counters, proposed, size);
+                INSTRUMENT_ADD(counters, accepted, n_acc);
+                count_accepted(n_acc);
+
+                if (measuring) {
+                    double E = 0.0, Mx = 0.0, My = 0.0;
+                    for (long s = 0; s < n_slab; s++) {
+                        E  += slab_E[s];
+                        Mx += slab_Mx[s];
+                        My += slab_My[s];
+                    }
+
+                    const double M2 = Mx * Mx + My * My;
+                    state.acc[0] += E;
+                    state.acc[1] += E * E;
+                    state.acc[2] += sqrt(M2);
+                    state.acc[3] += M2;
+                    state.acc[4] += M2 * M2;
+                    if (ts)
+                        push_series(E, M2);
+                }
+
+                state.n_sweep++;
+                if (state.n_sweep <= warmup)
+                    tune_lattice(state.n_sweep);
+                report_sweeps(state.n_sweep, warmup + measure, size, progress_mark);
+            } // Sums of the slabs
+        } // Sweeps
+    } // Parallel region
+
+    Observables obs = make_observables(beta, size, measure, state.acc.data());
+    state           = Sweep_state();
+
+    return obs;
+}
+
+
+/* learn_muca()
+ * Learns the multicanonical weight for [T_lo, T_hi] (see muca.h).
+ */
+Muca_weight Model3::learn_muca(double T_lo, double T_hi, size_t n_bin, size_t n_iter,
+        size_t n_sweep, std::mt19937 &engine)
+{
+    return ::learn_muca(*this, T_lo, T_hi, n_bin, n_iter, n_sweep, engine);
+}
+
+
+/* sweep_muca()
+ * Performs the warmup and measurement multicanonical sweeps with the weight W (see muca.h).
+ */
+Muca_sample Model3::sweep_muca(const Muca_weight &W, std::mt19937 &engine)
+{
+    return ::sweep_muca(*this, W, warmup, measure, engine);
+}
+
+
+/* get_length()
+ * Returns the linear size L of the lattice.
+ */
+int Model3::get_length() const
+{
+    return static_cast<int>(lround(cbrt(static_cast<double>(size))));
+}
+
+
+/* get_lattice()
+ * Returns the neighbor table, whose pages tell where the replica lives (see placement.h).
+ */
+const void* Model3::get_lattice() const
+{
+    return neigh.data();
+}
+
+
+/* get_counters()
+ * Returns the counters and phase timers of the sweeps so far. See instrument.h.
+ */
+const Counters& Model3::get_counters() const
+{
+    return counters;
+}
+
+
+/* reset_counters()
+ * Zeroes the counters and phase timers.
+ */
+void Model3::reset_counters()
+{
+    counters = Counters();
 }
 
 
@@ -40,15 +477,28 @@ Model3::Model3(const Model3 &rhs) : size(rhs.size), isClean(rhs.isClean), neigh(
  * with a mean centered at 1. The range of random values is J = [1 - delta/2, 1 + delta/2].
  */
 void Model3::set_exchange(double delta)
+{
+    std::random_device rd;
+    std::mt19937 engine(rd());
+
+    set_exchange(delta, engine);
+}
+
+
+/* set_exchange()
+ * Sets the exchange table using the given engine.
+ */
+void Model3::set_exchange(double delta, std::mt19937 &engine)
 {
     if (isClean)
         isClean = false;
 
-    std::random_device rd;
-    std::mt19937 engine(rd());
     double J_val, r_val;
 
-    for (size_t i = 0; i < size; i++) {
+    // Drawn in row major order, so a seed gives the same bonds in every site order
+    for (size_t r = 0; r < size; r++) {
+        const size_t i = stored_site(r);
+
         // 0 - 2 bond
         r_val = rand0(engine);
         if (rand0(engine) > 0.5) J_val = 1.0 - (delta * r_val / 2.0);
@@ -82,6 +532,69 @@ std::vector<Exchange<3>> Model3::get_exchange() const
 }
 
 
+/* get_neighbors()
+ * Returns the vector which contains the neighbor table.
+ */
+std::vector<Neighbor<3>> Model3::get_neighbors() const
+{
+    return neigh;
+}
+
+
+/* get_site_order()
+ * Returns the order the sites are stored in.
+ */
+Site_order Model3::get_site_order() const
+{
+    return order;
+}
+
+
+/* get_visit()
+ * Returns the order the sweeps visit the sites in.
+ */
+Visit Model3::get_visit() const
+{
+    return visit;
+}
+
+
+/* get_warmup()
+ * Returns the number of warmup sweeps.
+ */
+size_t Model3::get_warmup() const
+{
+    return warmup;
+}
+
+
+/* get_measure()
+ * Returns the number of measurement sweeps.
+ */
+size_t Model3::get_measure() const
+{
+    return measure;
+}
+
+
+/* get_size()
+ * Returns the number of lattice sites.
+ */
+size_t Model3::get_size() const
+{
+    return size;
+}
+
+
+/* get_energy()
+ * Returns the total energy of the current configuration.
+ */
+double Model3::get_energy() const
+{
+    return energy();
+}
+
+
 /* set_run_param()
  * Overrides the default parameters for running simulations.
  */
@@ -90,3 +603,99 @@ void Model3::set_run_param(size_t Warmup, size_t Measure)
     warmup  = Warmup;
     measure = Measure;
 }
+
+
+/* set_site_order()
+ * Stores the sites in another order (see site_order.h) and rebuilds the neighbor table. Call
+ * before the spins and the exchange table are set.
+ */
+void Model3::set_site_order(Site_order Order)
+{
+    const int L = get_length();
+
+    order = Order;
+    index = site_index(L, 3, order);
+
+    for (size_t r = 0; r < size; r++) {
+        if (index.empty())
+            neigh[r].set_neighbors(r, L);
+        else
+            neigh[index[r]].set_neighbors(r, L, index);
+    } // Loop over sites
+}
+
+
+/* set_visit()
+ * Sets the order the sweeps visit the sites in (see site_order.h).
+ */
+void Model3::set_visit(Visit Visit_mode)
+{
+    const size_t L = static_cast<size_t>(get_length());
+
+    visit = Visit_mode;
+    ahead.resize(n_ahead);
+    block.resize(size / L);
+    for (size_t b = 0; b < block.size(); b++)
+        block[b] = b;
+}
+
+
+/* set_checkpoint()
+ * Sets a hook which is called every `every` sweeps, used to write checkpoints.
+ */
+void Model3::set_checkpoint(size_t every, const Checkpoint_hook &hook)
+{
+    checkpoint_every = every;
+    checkpoint       = hook;
+}
+
+
+/* set_time_series()
+ * Streams the observables of every measurement sweep of the next temperature to a new series of
+ * the time series through channel chan. Pass nullptr to stop streaming.
+ */
+void Model3::set_time_series(Time_series *series, int chan, double beta, int run, int idx)
+{
+    ts = series;
+    if (ts) {
+        ts_chan = chan;
+        ts_id   = ts->begin_series(chan, beta, run, idx);
+    }
+}
+
+
+/* save()
+ * Writes the run parameters and sweep progress in binary. The exchange table is drawn again from
+ * the seed of the realization (see checkpoint.h) and is not stored.
+ */
+void Model3::save(std::ostream &os) const
+{
+    write_binary(os, warmup);
+    write_binary(os, measure);
+    write_binary(os, size);
+    write_binary(os, order);
+    write_binary(os, isClean);
+    write_binary(os, state);
+}
+
+
+/* load()
+ * Reads back the data written by save().
+ */
+void Model3::load(std::istream &is)
+{
+    size_t Size = 0;
+    Site_order Order = Site_order::row_major;
+
+    read_binary(is, warmup);
+    read_binary(is, measure);
+    read_binary(is, Size);
+    read_binary(is, Order);
+    read_binary(is, isClean);
+    read_binary(is, state);
+
+    if (!is || Size != size || Order != order) {
+        std::cerr << "Error: Saved model does not match the lattice." << std::endl;
+        exit(EXIT_FAILURE);
+    }
+}
@@ -0,0 +1,312 @@
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#include "../include/muca.h"
+
+
+/*-------------------------------------------------------------------------------------------------
+ * PRIVATE METHODS
+ *-----------------------------------------------------------------------------------------------*/
+
+/* set_ln_w()
+ * Integrates the slopes to ln W at the bin centers. ln W is zero at the first bin.
+ */
+void Muca_weight::set_ln_w()
+{
+    ln_w.assign(slope.size() + 1, 0.0);
+
+    for (size_t k = 0; k < slope.size(); k++)
+        ln_w[k + 1] = ln_w[k] + slope[k] * width;
+}
+
+
+/*-------------------------------------------------------------------------------------------------
+ * PUBLIC METHODS
+ *-----------------------------------------------------------------------------------------------*/
+
+/* Constructor
+ * Splits [E_Lo, E_Hi] into n_bin bins. Beta_lo is the inverse of the lowest temperature, so
+ * Beta_lo > Beta_hi.
+ */
+Muca_weight::Muca_weight(double E_Lo, double E_Hi, size_t n_bin, double Beta_lo,
+        double Beta_hi) :
+    E_lo(E_Lo), E_hi(E_Hi), width((E_Hi - E_Lo) / static_cast<double>(n_bin)),
+    beta_lo(Beta_lo), beta_hi(Beta_hi), slope(n_bin - 1, -Beta_hi), g_acc(n_bin - 1, 0.0)
+{
+    if (n_bin < 2 || !(E_Hi > E_Lo) || !(Beta_lo > Beta_hi)) {
+        std::cerr << "Error: Multicanonical weight needs E_lo < E_hi, beta_lo > beta_hi and at "
+                  << "least 2 bins." << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    set_ln_w();
+}
+
+
+/* operator()
+ * Returns ln W(E).
+ */
+double Muca_weight::operator()(double E) const
+{
+    const double c_first = E_lo + 0.5 * width;
+    const double c_last  = E_hi - 0.5 * width;
+
+    if (E <= c_first)
+        return ln_w.front() - beta_lo * (E - c_first);
+    if (E >= c_last)
+        return ln_w.back() - beta_hi * (E - c_last);
+
+    size_t k = std::min(slope.size() - 1, static_cast<size_t>((E - c_first) / width));
+
+    return ln_w[k] + slope[k] * (E - c_first - static_cast<double>(k) * width);
+}
+
+
+/* bin()
+ * Returns the bin of E, or get_bins() if E is outside of [E_lo, E_hi).
+ */
+size_t Muca_weight::bin(double E) const
+{
+    if (E < E_lo || E >= E_hi)
+        return ln_w.size();
+
+    return std::min(ln_w.size() - 1, static_cast<size_t>((E - E_lo) / width));
+}
+
+
+/* get_bins()
+ * Returns the number of bins.
+ */
+size_t Muca_weight::get_bins() const
+{
+    return ln_w.size();
+}
+
+
+/* get_lo()
+ * Returns the lower end of the energy range.
+ */
+double Muca_weight::get_lo() const
+{
+    return E_lo;
+}
+
+
+/* get_hi()
+ * Returns the upper end of the energy range.
+ */
+double Muca_weight::get_hi() const
+{
+    return E_hi;
+}
+
+
+/* update()
+ * Refines the slopes with the histogram of one iteration. Slopes outside of the sampled range are
+ * set to the slope at its edge, which lets the next iteration reach further.
+ */
+void Muca_weight::update(const std::vector<size_t> &hist)
+{
+    if (hist.size() != ln_w.size()) {
+        std::cerr << "Error: Histogram does not match the multicanonical weight." << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    size_t first = slope.size(), last = 0;
+
+    for (size_t k = 0; k < slope.size(); k++) {
+        if (hist[k] == 0 || hist[k + 1] == 0)
+            continue;
+
+        const double h0 = static_cast<double>(hist[k]);
+        const double h1 = static_cast<double>(hist[k + 1]);
+        const double g  = h0 * h1 / (h0 + h1);
+
+        g_acc[k] += g;
+        slope[k] += (g / g_acc[k]) * (log(h0) - log(h1)) / width;
+        slope[k]  = std::min(-beta_hi, std::max(-beta_lo, slope[k]));
+
+        first = std::min(first, k);
+        last  = k;
+    } // Loop over slopes
+
+    if (first < slope.size()) {
+        for (size_t k = 0; k < first; k++)
+            if (!(g_acc[k] > 0.0))
+                slope[k] = slope[first];
+        for (size_t k = last + 1; k < slope.size(); k++)
+            if (!(g_acc[k] > 0.0))
+                slope[k] = slope[last];
+    } // Extrapolate into the unsampled range
+
+    set_ln_w();
+}
+
+
+/*-------------------------------------------------------------------------------------------------
+ * MULTICANONICAL RUNS
+ *-----------------------------------------------------------------------------------------------*/
+
+/* sweep_muca_lattice()
+ * Performs a multicanonical sweep. E is the energy of the lattice and is updated with the
+ * accepted moves. A move from E to E' is accepted with min(1, W(E') / W(E)).
+ */
+static void sweep_muca_lattice(Muca_lattice &lattice, const Muca_weight &W, double &E,
+        std::mt19937 &engine)
+{
+    std::uniform_real_distribution<float> rand0(0.0, 1.0);
+    const size_t size = lattice.get_size();
+    double ln_w       = W(E);
+
+    for (size_t i = 0; i < size; i++) {
+        size_t pos      = static_cast<size_t>(rand0(engine) * size);
+        double E_new    = E + lattice.propose(pos, engine);
+        double ln_w_new = W(E_new);
+
+        if (ln_w_new >= ln_w || rand0(engine) < exp(ln_w_new - ln_w)) {
+            lattice.accept(pos);
+            E    = E_new;
+            ln_w = ln_w_new;
+        }
+    } // Loop over sites
+
+    E = lattice.energy();       // Drops the round off of the running sum
+}
+
+
+/* learn_muca()
+ * Learns the multicanonical weight for [T_lo, T_hi]. The energy range is set by the mean
+ * energies of canonical runs of n_sweep sweeps at T_hi and then at T_lo, split into n_bin bins.
+ * The weight is then refined in n_iter iterations of n_sweep multicanonical sweeps. The lattice
+ * is left in the last configuration, which is a good start for sweep_muca().
+ */
+Muca_weight learn_muca(Muca_lattice &lattice, double T_lo, double T_hi, size_t n_bin,
+        size_t n_iter, size_t n_sweep, std::mt19937 &engine)
+{
+    const double beta_lo = 1.0 / T_lo, beta_hi = 1.0 / T_hi;
+    double E_mean[2];
+
+    for (int e = 0; e < 2; e++) {
+        const float beta = static_cast<float>(e == 0 ? beta_hi : beta_lo);
+
+        lattice.tune_lattice(0);
+        for (size_t s = 0; s < n_sweep; s++) {
+            lattice.sweep_lattice(beta, engine);
+            lattice.tune_lattice(s + 1);
+        } // Warmup
+
+        E_mean[e] = 0.0;
+        for (size_t s = 0; s < n_sweep; s++) {
+            lattice.sweep_lattice(beta, engine);
+            E_mean[e] += lattice.energy() / static_cast<double>(n_sweep);
+        } // Measure
+    } // Canonical runs at both ends
+
+    Muca_weight W(E_mean[1], E_mean[0], n_bin, beta_lo, beta_hi);
+    std::vector<size_t> hist(n_bin);
+    double E = lattice.energy();
+
+    for (size_t iter = 0; iter < n_iter; iter++) {
+        std::fill(hist.begin(), hist.end(), 0);
+
+        for (size_t s = 0; s < n_sweep; s++) {
+            sweep_muca_lattice(lattice, W, E, engine);
+
+            size_t b = W.bin(E);
+            if (b < n_bin)
+                hist[b]++;
+        } // Sweeps
+
+        W.update(hist);
+    } // Iterations
+
+    return W;
+}
+
+
+/* sweep_muca()
+ * Performs warmup multicanonical sweeps with the weight W and returns the samples of the
+ * measurement sweeps. Reweight them to any temperature in [T_lo, T_hi] with muca_reweight().
+ */
+Muca_sample sweep_muca(Muca_lattice &lattice, const Muca_weight &W, size_t warmup,
+        size_t measure, std::mt19937 &engine)
+{
+    Muca_sample sample;
+    double E = lattice.energy();
+    int side = 0;               // Last end of the energy range visited
+
+    sample.n_tunnel = 0;
+
+    for (size_t s = 0; s < warmup; s++)
+        sweep_muca_lattice(lattice, W, E, engine);
+
+    for (size_t s = 0; s < measure; s++) {
+        sweep_muca_lattice(lattice, W, E, engine);
+
+        double M2 = lattice.magnetization2();
+        sample.E.push_back(E);
+        sample.M.push_back(sqrt(M2));
+        sample.M2.push_back(M2);
+        sample.ln_w.push_back(W(E));
+
+        if (E <= W.get_lo()) {
+            sample.n_tunnel += (side == 1);
+            side = -1;
+        } else if (E >= W.get_hi()) {
+            sample.n_tunnel += (side == -1);
+            side = 1;
+        }
+    } // Measurement sweeps
+
+    return sample;
+}
+
+
+/*-------------------------------------------------------------------------------------------------
+ * REWEIGHTING
+ *-----------------------------------------------------------------------------------------------*/
+
+/* muca_reweight()
+ * Canonical averages at every temperature of T from a multicanonical production run. The weight
+ * of sample i at beta is exp(-beta E_i - ln W(E_i)).
+ */
+std::vector<Rw_point> muca_reweight(const Muca_sample &sample, size_t n_site,
+        const std::vector<double> &T)
+{
+    std::vector<Rw_point> out(T.size());
+    const long n_T = static_cast<long>(T.size());
+
+    #pragma omp parallel for
+    for (long t = 0; t < n_T; t++) {
+        const double b = 1.0 / T[t];
+
+        double a_max = -std::numeric_limits<double>::infinity();
+        for (size_t i = 0; i < sample.E.size(); i++)
+            a_max = std::max(a_max, -b * sample.E[i] - sample.ln_w[i]);
+
+        double W = 0.0, sE = 0.0, sE2 = 0.0, sM = 0.0, sM2 = 0.0, sM4 = 0.0;
+        for (size_t i = 0; i < sample.E.size(); i++) {
+            double w = exp(-b * sample.E[i] - sample.ln_w[i] - a_max);
+            W   += w;
+            sE  += w * sample.E[i];
+            sE2 += w * sample.E[i] * sample.E[i];
+            sM  += w * sample.M[i];
+            sM2 += w * sample.M2[i];
+            sM4 += w * sample.M2[i] * sample.M2[i];
+        } // Loop over samples
+
+        sE /= W; sE2 /= W; sM /= W; sM2 /= W; sM4 /= W;
+
+        const double N = static_cast<double>(n_site);
+        out[t].T      = T[t];
+        out[t].E      = sE / N;
+        out[t].C      = b * b * (sE2 - sE * sE) / N;
+        out[t].chi    = b * (sM2 - sM * sM) / N;
+        out[t].binder = 1.0 - (sM4 / (3.0 * sM2 * sM2));
+    } // Loop over temperatures
+
+    return out;
+}
@@ -0,0 +1,219 @@
+#include <iostream>
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <omp.h>
+
+#include "../include/placement.h"
+
+
+/* struct : Thread_place
+ * Placement of one OpenMP thread and of the replicas it swept.
+ */
+struct Thread_place
+{
+    int cpu;
+    int node;
+    std::size_t n_replica;
+    std::size_t n_remote;           // Replicas on another node
+    std::size_t n_unknown;          // Replicas whose node could not be found
+};
+
+
+static Pin pin_mode = Pin::off;
+static std::vector<int> cpu_order;                  // CPU of every thread id
+static std::vector<int> cpu_node;                   // Node of every CPU
+static std::map<int, Thread_place> place;
+static std::mutex place_mtx;
+
+
+/*-------------------------------------------------------------------------------------------------
+ * HELPER FUNCTIONS
+ *-----------------------------------------------------------------------------------------------*/
+
+/* node_of_cpu()
+ * Returns the node of a CPU from the "node<n>" entry of its sysfs directory, 0 if there is none.
+ */
+static int node_of_cpu(int cpu)
+{
+    const std::string path = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+    DIR *dir = opendir(path.c_str());
+    int node = 0;
+
+    if (!dir)
+        return node;
+
+    while (dirent *ent = readdir(dir)) {
+        if (std::strncmp(ent->d_name, "node", 4) == 0 && ent->d_name[4] >= '0' &&
+                ent->d_name[4] <= '9') {
+            node = std::atoi(ent->d_name + 4);
+            break;
+        }
+    } // Loop over entries
+
+    closedir(dir);
+    return node;
+}
+
+
+/* node_of_page()
+ * Returns the node of the page holding addr, or -1 if it is unknown.
+ */
+static int node_of_page(const void *addr)
+{
+#ifdef SYS_move_pages
+    const std::uintptr_t page = static_cast<std::uintptr_t>(sysconf(_SC_PAGESIZE));
+    void *pages[1] = {reinterpret_cast<void *>(reinterpret_cast<std::uintptr_t>(addr) &
+                                               ~(page - 1))};
+    int status[1]  = {-1};
+
+    // With no target nodes move_pages() only reports where the pages are
+    if (syscall(SYS_move_pages, 0, 1UL, pages, nullptr, status, 0) == 0 && status[0] >= 0)
+        return status[0];
+#else
+    (void)addr;
+#endif
+    return -1;
+}
+
+
+/*-------------------------------------------------------------------------------------------------
+ * PLACEMENT
+ *-----------------------------------------------------------------------------------------------*/
+
+/* parse_pin()
+ * Reads the name of a pinning mode. Returns false if it is unknown.
+ */
+bool parse_pin(const std::string &name, Pin &mode)
+{
+    if (name == "none")
+        mode = Pin::none;
+    else if (name == "compact")
+        mode = Pin::compact;
+    else if (name == "spread")
+        mode = Pin::spread;
+    else
+        return false;
+
+    return true;
+}
+
+
+/* set_pinning()
+ * Sets the mode and orders the CPUs of the process for it. Call before the parallel regions.
+ */
+void set_pinning(Pin mode)
+{
+    cpu_set_t set;
+    std::vector<int> cpus;
+    std::map<int, std::vector<int>> by_node;
+
+    pin_mode = mode;
+    if (mode == Pin::off)
+        return;
+
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) {
+        std::cerr << "Error: Could not read the CPUs of the process." << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    for (int c = 0; c < CPU_SETSIZE; c++)
+        if (CPU_ISSET(c, &set))
+            cpus.push_back(c);
+
+    cpu_node.assign(cpus.empty() ? 0 : cpus.back() + 1, 0);
+    for (auto c : cpus) {
+        cpu_node[c] = node_of_cpu(c);
+        by_node[cpu_node[c]].push_back(c);
+    }
+
+    cpu_order.clear();
+    if (mode == Pin::spread) {
+        for (std::size_t k = 0; cpu_order.size() < cpus.size(); k++)
+            for (auto &&ele : by_node)
+                if (k < ele.second.size())
+                    cpu_order.push_back(ele.second[k]);
+    } else {
+        for (auto &&ele : by_node)
+            cpu_order.insert(cpu_order.end(), ele.second.begin(), ele.second.end());
+    }
+}
+
+
+/* pin_thread()
+ * Binds the calling OpenMP thread to its CPU. A thread is only pinned again if it runs under
+ * another thread id.
+ */
+void pin_thread()
+{
+    static thread_local int pinned_as = -1;
+    const int tid = omp_get_thread_num();
+
+    if ((pin_mode != Pin::compact && pin_mode != Pin::spread) || cpu_order.empty() ||
+            pinned_as == tid)
+        return;
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu_order[static_cast<std::size_t>(tid) % cpu_order.size()], &set);
+    if (sched_setaffinity(0, sizeof(set), &set) == 0)
+        pinned_as = tid;
+}
+
+
+/* note_placement()
+ * Records where the calling thread runs and where the replica it sweeps lives.
+ */
+void note_placement(const void *replica)
+{
+    if (pin_mode == Pin::off)
+        return;
+
+    const int cpu       = sched_getcpu();
+    const int node      = cpu >= 0 && cpu < static_cast<int>(cpu_node.size()) ? cpu_node[cpu] : -1;
+    const int data_node = node_of_page(replica);
+
+    std::lock_guard<std::mutex> lock(place_mtx);
+    Thread_place &p = place.emplace(omp_get_thread_num(), Thread_place{cpu, node, 0, 0, 0})
+                           .first->second;
+
+    p.cpu  = cpu;
+    p.node = node;
+    p.n_replica++;
+    if (data_node < 0)
+        p.n_unknown++;
+    else if (data_node != node)
+        p.n_remote++;
+}
+
+
+/* write_placement()
+ * Reports the placement of every thread that swept a replica.
+ */
+void write_placement(std::ostream &os)
+{
+    if (pin_mode == Pin::off)
+        return;
+
+    std::lock_guard<std::mutex> lock(place_mtx);
+
+    for (auto &&ele : place) {
+        const Thread_place &p = ele.second;
+
+        os << "[placement] thread " << ele.first << ": cpu " << p.cpu << ", node " << p.node
+           << ", " << p.n_replica << " replicas, " << p.n_remote << " on another node";
+        if (p.n_unknown > 0)
+            os << ", " << p.n_unknown << " unknown";
+        os << '\n';
+    } // Loop over threads
+    os << std::flush;
+}
@@ -0,0 +1,119 @@
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+#include "../include/progress.h"
+
+
+Progress *Progress::active = nullptr;
+
+
+/*-------------------------------------------------------------------------------------------------
+ * HELPER FUNCTIONS
+ *-----------------------------------------------------------------------------------------------*/
+
+/* format_time()
+ * Formats seconds as hours, minutes and seconds.
+ */
+static std::string format_time(double sec)
+{
+    const long s = static_cast<long>(sec + 0.5);
+    std::ostringstream os;
+
+    if (s >= 3600)
+        os << s / 3600 << "h" << std::setw(2) << std::setfill('0') << (s % 3600) / 60 << "m";
+    else if (s >= 60)
+        os << s / 60 << "m" << std::setw(2) << std::setfill('0') << s % 60 << "s";
+    else
+        os << s << "s";
+
+    return os.str();
+}
+
+
+/*-------------------------------------------------------------------------------------------------
+ * PRIVATE METHODS
+ *-----------------------------------------------------------------------------------------------*/
+
+/* report_loop()
+ * Runs in the reporter thread. Reports every interval seconds until stop is set.
+ */
+void Progress::report_loop()
+{
+    std::unique_lock<std::mutex> lock(mtx);
+
+    while (!cv.wait_for(lock, std::chrono::duration<double>(interval), [this] { return stop; }))
+        report();
+}
+
+
+/* report()
+ * Prints one line of progress.
+ */
+void Progress::report()
+{
+    const double t       = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                                         t0).count();
+    const double sweeps  = static_cast<double>(n_sweep.load(std::memory_order_relaxed));
+    const double updates = static_cast<double>(n_update.load(std::memory_order_relaxed));
+    const double total   = static_cast<double>(total_update.load(std::memory_order_relaxed));
+    std::ostringstream line;
+
+    line << "[progress] " << format_time(t);
+    if (total > 0.0)
+        line << "  " << std::fixed << std::setprecision(1) << 100.0 * updates / total << "%";
+    line << std::defaultfloat << std::setprecision(3)
+         << "  " << sweeps / t << " sweeps/s  " << updates / t << " updates/s  tasks "
+         << n_task.load(std::memory_order_relaxed);
+    if (total > 0.0) {
+        line << "/" << total_task.load(std::memory_order_relaxed);
+        if (updates > 0.0)
+            line << "  ETA " << format_time(t * (total - updates) / updates);
+    }
+
+    os << line.str() << std::endl;
+}
+
+
+/*-------------------------------------------------------------------------------------------------
+ * PUBLIC METHODS
+ *-----------------------------------------------------------------------------------------------*/
+
+/* Constructor
+ * Starts the reporter thread, which prints to Os every Interval seconds.
+ */
+Progress::Progress(double Interval, std::ostream &Os) :
+    n_sweep(0), n_update(0), n_task(0), total_update(0), total_task(0), interval(Interval),
+    os(Os), t0(std::chrono::steady_clock::now()), stop(false)
+{
+    active   = this;
+    reporter = std::thread(&Progress::report_loop, this);
+}
+
+
+/* Destructor
+ * Stops the reporter thread and prints the final progress.
+ */
+Progress::~Progress()
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stop = true;
+    }
+    cv.notify_one();
+    reporter.join();
+
+    active = nullptr;
+    report();
+}
+
+
+/* add_total()
+ * Adds work which is about to run to the totals.
+ */
+void Progress::add_total(std::uint64_t updates, std::uint64_t tasks)
+{
+    total_update.fetch_add(updates, std::memory_order_relaxed);
+    total_task.fetch_add(tasks, std::memory_order_relaxed);
+}
@@ -0,0 +1,96 @@
+#include <algorithm>
+
+#include "../include/refine.h"
+
+
+/*-------------------------------------------------------------------------------------------------
+ * HELPER FUNCTIONS
+ *-----------------------------------------------------------------------------------------------*/
+
+/* flag_peak()
+ * Flags the intervals on both sides of the maximum of a field of one L.
+ */
+static void flag_peak(const std::vector<Observables> &obs, double Observables::*field,
+        std::vector<bool> &flag)
+{
+    size_t k_max = 0;
+
+    for (size_t k = 1; k < obs.size(); k++)
+        if (obs[k].*field > obs[k_max].*field)
+            k_max = k;
+
+    if (k_max > 0)
+        flag[k_max - 1] = true;
+    if (k_max + 1 < obs.size())
+        flag[k_max] = true;
+}
+
+
+/*-------------------------------------------------------------------------------------------------
+ * REFINEMENT
+ *-----------------------------------------------------------------------------------------------*/
+
+/* refine_points()
+ * Returns the new temperatures of one refinement of the grid T. obs holds the observables of
+ * every L on T.
+ */
+std::vector<double> refine_points(const std::vector<double> &T,
+        const std::vector<std::vector<Observables>> &obs, double dT_min)
+{
+    std::vector<bool> flag(T.size() > 0 ? T.size() - 1 : 0, false);
+    std::vector<double> pts;
+
+    // Binder crossings of consecutive L
+    for (size_t i = 0; i + 1 < obs.size(); i++) {
+        for (size_t k = 0; k + 1 < T.size(); k++) {
+            double d0   = obs[i][k].binder - obs[i + 1][k].binder;
+            double d1   = obs[i][k + 1].binder - obs[i + 1][k + 1].binder;
+            double mean = 0.25 * (obs[i][k].binder + obs[i + 1][k].binder +
+                                  obs[i][k + 1].binder + obs[i + 1][k + 1].binder);
+
+            if ((d0 < 0.0) != (d1 < 0.0) && mean > binder_floor)
+                flag[k] = true;
+        } // Loop over intervals
+    } // Loop over pairs of L
+
+    // Peaks of the specific heat and the susceptibility
+    for (auto &&curve : obs) {
+        flag_peak(curve, &Observables::C, flag);
+        flag_peak(curve, &Observables::chi, flag);
+    } // Loop over L
+
+    for (size_t k = 0; k < flag.size(); k++)
+        if (flag[k] && T[k + 1] - T[k] > dT_min)
+            pts.push_back(0.5 * (T[k] + T[k + 1]));
+
+    return pts;
+}
+
+
+/* merge_grid()
+ * Merges new temperatures and their observables into a sorted grid.
+ */
+void merge_grid(std::vector<double> &T, std::vector<std::vector<Observables>> &obs,
+        const std::vector<double> &T_new, const std::vector<std::vector<Observables>> &obs_new)
+{
+    std::vector<size_t> idx(T.size() + T_new.size());
+    std::vector<double> T_all(T);
+
+    T_all.insert(T_all.end(), T_new.begin(), T_new.end());
+    for (size_t k = 0; k < idx.size(); k++)
+        idx[k] = k;
+    std::stable_sort(idx.begin(), idx.end(),
+            [&T_all](size_t a, size_t b) { return T_all[a] < T_all[b]; });
+
+    for (size_t i = 0; i < obs.size(); i++) {
+        std::vector<Observables> merged;
+
+        for (auto k : idx)
+            merged.push_back(k < T.size() ? obs[i][k] : obs_new[i][k - T.size()]);
+        obs[i] = merged;
+    } // Loop over L
+
+    T.resize(idx.size());
+    for (size_t k = 0; k < idx.size(); k++)
+        T[k] = T_all[idx[k]];
+}
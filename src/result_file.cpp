@@ -0,0 +1,232 @@
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "../include/result_file.h"
+
+
+// Identifies result files
+static const char magic[8] = {'D', 'C', 'R', 'E', 'S', '0', '1', '\0'};
+static const size_t head_len  = 40;
+static const size_t alignment = 64;
+
+
+/*-------------------------------------------------------------------------------------------------
+ * RESULT HEADER
+ *-----------------------------------------------------------------------------------------------*/
+
+/* add_column()
+ * Adds the name of the next column.
+ */
+void Result_header::add_column(const std::string &name)
+{
+    column.push_back(name);
+}
+
+
+/* get_columns()
+ * Returns the column names.
+ */
+const std::vector<std::string>& Result_header::get_columns() const
+{
+    return column;
+}
+
+
+/* get_params()
+ * Returns the run parameters as key / value pairs.
+ */
+const std::vector<std::pair<std::string, std::string>>& Result_header::get_params() const
+{
+    return param;
+}
+
+
+/*-------------------------------------------------------------------------------------------------
+ * WRITER
+ *-----------------------------------------------------------------------------------------------*/
+
+/* write_result()
+ * Writes the data with its header in the binary result format. The columns are taken from the
+ * header, or from the names of the data if the header has none. The columns of the data are
+ * already contiguous, so the whole file is produced with a few large writes.
+ */
+void write_result(const std::string &filename, const Data_matrix &data,
+        const Result_header &header)
+{
+    const size_t n_row = data.rows();
+    const size_t n_col = data.cols();
+    std::vector<std::string> column = header.get_columns();
+
+    if (column.empty() && data.has_names())
+        for (size_t j = 0; j < n_col; j++)
+            column.push_back(data.get_name(j));
+
+    if (column.size() != n_col) {
+        std::cerr << "Error: " << filename << " needs " << n_col << " column names." << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    std::string meta;
+    for (const auto &ele : column)
+        meta += "column\t" + ele + '\n';
+    for (const auto &ele : header.get_params())
+        meta += "param\t" + ele.first + '\t' + ele.second + '\n';
+
+    const std::uint64_t offset = (head_len + meta.size() + alignment - 1) / alignment * alignment;
+    const std::uint64_t head[4] = {offset, n_row, n_col, meta.size()};
+
+    std::ofstream of(filename, std::ios::binary | std::ios::trunc);
+    of.write(magic, sizeof(magic));
+    of.write(reinterpret_cast<const char *>(head), sizeof(head));
+    of.write(meta.data(), meta.size());
+
+    const std::string pad(offset - head_len - meta.size(), '\0');
+    of.write(pad.data(), pad.size());
+
+    if (n_col > 0)
+        of.write(reinterpret_cast<const char *>(data.column(0)), n_row * n_col * sizeof(double));
+
+    of.close();
+    if (!of) {
+        std::cerr << "Error: Could not write " << filename << std::endl;
+        exit(EXIT_FAILURE);
+    }
+}
+
+
+/*-------------------------------------------------------------------------------------------------
+ * READER
+ *-----------------------------------------------------------------------------------------------*/
+
+/* Constructor
+ * Maps the file and parses its header.
+ */
+Result_file::Result_file(const std::string &filename) : map(nullptr), map_len(0)
+{
+    int fd = open(filename.c_str(), O_RDONLY);
+    struct stat st;
+
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        std::cerr << "Error: Could not open " << filename << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    map_len = static_cast<size_t>(st.st_size);
+    if (map_len >= head_len)
+        map = mmap(nullptr, map_len, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (map == nullptr || map == MAP_FAILED) {
+        std::cerr << "Error: Could not map " << filename << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    const char *base = static_cast<const char *>(map);
+    std::uint64_t head[4];
+    std::memcpy(head, base + sizeof(magic), sizeof(head));
+    N_row = head[1];
+    N_col = head[2];
+
+    if (std::memcmp(base, magic, sizeof(magic)) != 0 || head[0] % alignment != 0 ||
+            head_len + head[3] > head[0] || head[0] + N_row * N_col * sizeof(double) > map_len) {
+        std::cerr << "Error: " << filename << " is not a valid result file." << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    // Parse column names and parameters
+    std::istringstream meta(std::string(base + head_len, head[3]));
+    std::string line;
+    while (std::getline(meta, line)) {
+        size_t tab1 = line.find('\t');
+        size_t tab2 = line.find('\t', tab1 + 1);
+
+        if (line.compare(0, tab1, "column") == 0)
+            header.add_column(line.substr(tab1 + 1));
+        else if (line.compare(0, tab1, "param") == 0 && tab2 != std::string::npos)
+            header.set_param(line.substr(tab1 + 1, tab2 - tab1 - 1), line.substr(tab2 + 1));
+    }
+}
+
+
+/* Destructor
+ */
+Result_file::~Result_file()
+{
+    if (map)
+        munmap(map, map_len);
+}
+
+
+/* rows()
+ * Returns the number of rows.
+ */
+size_t Result_file::rows() const
+{
+    return N_row;
+}
+
+
+/* cols()
+ * Returns the number of columns.
+ */
+size_t Result_file::cols() const
+{
+    return N_col;
+}
+
+
+/* column()
+ * Returns a pointer to the first value of a column.
+ */
+const double* Result_file::column(size_t col) const
+{
+    std::uint64_t offset;
+    std::memcpy(&offset, static_cast<const char *>(map) + sizeof(magic), sizeof(offset));
+
+    return reinterpret_cast<const double *>(static_cast<const char *>(map) + offset) +
+        col * N_row;
+}
+
+
+/* column()
+ * Returns a pointer to the first value of a named column, or nullptr if there is no such column.
+ */
+const double* Result_file::column(const std::string &name) const
+{
+    const auto &names = header.get_columns();
+
+    for (size_t j = 0; j < names.size(); j++)
+        if (names[j] == name)
+            return column(j);
+
+    return nullptr;
+}
+
+
+/* get_header()
+ * Returns the column names and run parameters.
+ */
+const Result_header& Result_file::get_header() const
+{
+    return header;
+}
+
+
+/* get_param()
+ * Returns the value of a run parameter, or an empty string if it was not set.
+ */
+std::string Result_file::get_param(const std::string &key) const
+{
+    for (const auto &ele : header.get_params())
+        if (ele.first == key)
+            return ele.second;
+
+    return std::string();
+}
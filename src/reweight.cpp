@@ -0,0 +1,264 @@
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <limits>
+#include <map>
+
+#include "../include/reweight.h"
+
+
+/*-------------------------------------------------------------------------------------------------
+ * PRIVATE METHODS
+ *-----------------------------------------------------------------------------------------------*/
+
+/* solve()
+ * Iterates the WHAM equations until the free energies change by less than tol.
+ */
+void Reweight::solve(double tol, size_t max_iter)
+{
+    const size_t K = beta.size();
+    const long n   = static_cast<long>(E.size());
+    std::vector<double> log_N(K), f_new(K);
+
+    for (size_t k = 0; k < K; k++)
+        log_N[k] = log(static_cast<double>(first[k + 1] - first[k]));
+
+    f.assign(K, 0.0);
+    log_den.resize(E.size());
+
+    for (size_t iter = 0; iter < max_iter; iter++) {
+        // Denominator of every sample
+        #pragma omp parallel for
+        for (long i = 0; i < n; i++) {
+            double a_max = -std::numeric_limits<double>::infinity();
+            for (size_t k = 0; k < K; k++)
+                a_max = std::max(a_max, log_N[k] + f[k] - beta[k] * E[i]);
+
+            double sum = 0.0;
+            for (size_t k = 0; k < K; k++)
+                sum += exp(log_N[k] + f[k] - beta[k] * E[i] - a_max);
+
+            log_den[i] = a_max + log(sum);
+        } // Loop over samples
+
+        // New free energies
+        for (size_t k = 0; k < K; k++) {
+            double a_max = -std::numeric_limits<double>::infinity();
+            #pragma omp parallel for reduction(max:a_max)
+            for (long i = 0; i < n; i++)
+                a_max = std::max(a_max, -beta[k] * E[i] - log_den[i]);
+
+            double sum = 0.0;
+            #pragma omp parallel for reduction(+:sum)
+            for (long i = 0; i < n; i++)
+                sum += exp(-beta[k] * E[i] - log_den[i] - a_max);
+
+            f_new[k] = -(a_max + log(sum));
+        } // Loop over simulations
+
+        double diff = 0.0;
+        for (size_t k = 0; k < K; k++) {
+            f_new[k] -= f_new[0];
+            diff      = std::max(diff, fabs(f_new[k] - f[k]));
+        }
+
+        f.swap(f_new);
+        if (diff < tol)
+            break;
+    } // WHAM iterations
+
+    solved = true;
+}
+
+
+/* average()
+ * Reweighted averages at T. Uses the samples of simulation k, or every sample with the WHAM
+ * weights if k < 0.
+ */
+Rw_point Reweight::average(double T, int k) const
+{
+    const double b = 1.0 / T;
+    const size_t begin = (k < 0) ? 0 : first[k];
+    const size_t end   = (k < 0) ? E.size() : first[k + 1];
+
+    // Log weight of sample i
+    auto log_w = [&](size_t i) {
+        return (k < 0) ? -b * E[i] - log_den[i] : -(b - beta[k]) * E[i];
+    };
+
+    double a_max = -std::numeric_limits<double>::infinity();
+    for (size_t i = begin; i < end; i++)
+        a_max = std::max(a_max, log_w(i));
+
+    double W = 0.0, sE = 0.0, sE2 = 0.0, sM = 0.0, sM2 = 0.0, sM4 = 0.0;
+    for (size_t i = begin; i < end; i++) {
+        double w = exp(log_w(i) - a_max);
+        W   += w;
+        sE  += w * E[i];
+        sE2 += w * E[i] * E[i];
+        sM  += w * M[i];
+        sM2 += w * M2[i];
+        sM4 += w * M2[i] * M2[i];
+    } // Loop over samples
+
+    sE /= W; sE2 /= W; sM /= W; sM2 /= W; sM4 /= W;
+
+    const double N = static_cast<double>(n_site);
+    Rw_point pt;
+    pt.T      = T;
+    pt.E      = sE / N;
+    pt.C      = b * b * (sE2 - sE * sE) / N;
+    pt.chi    = b * (sM2 - sM * sM) / N;
+    pt.binder = 1.0 - (sM4 / (3.0 * sM2 * sM2));
+
+    return pt;
+}
+
+
+/*-------------------------------------------------------------------------------------------------
+ * PUBLIC METHODS
+ *-----------------------------------------------------------------------------------------------*/
+
+/* Constructor
+ * N_site is the number of lattice sites, used to give E, C and chi per site.
+ */
+Reweight::Reweight(size_t N_site) : n_site(N_site), first(1, 0), solved(false)
+{
+}
+
+
+/* add_series()
+ * Adds the samples of a simulation at Beta. E_s, M_s and M2_s are the total energy, |M| and M^2
+ * of every measurement sweep.
+ */
+void Reweight::add_series(double Beta, const std::vector<double> &E_s,
+        const std::vector<double> &M_s, const std::vector<double> &M2_s)
+{
+    if (E_s.empty() || E_s.size() != M_s.size() || E_s.size() != M2_s.size()) {
+        std::cerr << "Error: Reweighting needs the same number of E, |M| and M^2 samples."
+                  << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    beta.push_back(Beta);
+    E.insert(E.end(), E_s.begin(), E_s.end());
+    M.insert(M.end(), M_s.begin(), M_s.end());
+    M2.insert(M2.end(), M2_s.begin(), M2_s.end());
+    first.push_back(E.size());
+    solved = false;
+}
+
+
+/* add_series()
+ * Adds a series read from a time series file.
+ */
+void Reweight::add_series(const Ts_series &series)
+{
+    add_series(series.beta, series.E, series.M, series.M2);
+}
+
+
+/* single()
+ * Single histogram reweighting from the simulation closest in beta.
+ */
+Rw_point Reweight::single(double T) const
+{
+    int k_best = 0;
+
+    for (size_t k = 1; k < beta.size(); k++)
+        if (fabs(beta[k] - 1.0 / T) < fabs(beta[k_best] - 1.0 / T))
+            k_best = static_cast<int>(k);
+
+    return average(T, k_best);
+}
+
+
+/* multi()
+ * Multiple histogram reweighting. The WHAM equations are solved on the first call after
+ * series were added.
+ */
+Rw_point Reweight::multi(double T, double tol, size_t max_iter)
+{
+    if (!solved)
+        solve(tol, max_iter);
+
+    return average(T, -1);
+}
+
+
+/* single()
+ * Single histogram reweighting on a grid of temperatures.
+ */
+std::vector<Rw_point> Reweight::single(const std::vector<double> &T) const
+{
+    std::vector<Rw_point> out(T.size());
+
+    #pragma omp parallel for
+    for (long i = 0; i < static_cast<long>(T.size()); i++)
+        out[i] = single(T[i]);
+
+    return out;
+}
+
+
+/* multi()
+ * Multiple histogram reweighting on a grid of temperatures.
+ */
+std::vector<Rw_point> Reweight::multi(const std::vector<double> &T, double tol, size_t max_iter)
+{
+    std::vector<Rw_point> out(T.size());
+
+    if (!solved)
+        solve(tol, max_iter);
+
+    #pragma omp parallel for
+    for (long i = 0; i < static_cast<long>(T.size()); i++)
+        out[i] = average(T[i], -1);
+
+    return out;
+}
+
+
+/*-------------------------------------------------------------------------------------------------
+ * DISORDER AVERAGE
+ *-----------------------------------------------------------------------------------------------*/
+
+/* reweight_disorder()
+ * Reweights the series of every disorder realization (grouped by run) on the grid T and averages
+ * the results over the realizations, like compute_energy() and compute_binder() do.
+ */
+std::vector<Rw_point> reweight_disorder(const std::vector<Ts_series> &series, size_t n_site,
+        const std::vector<double> &T, bool multi)
+{
+    std::map<int, Reweight> real;
+
+    for (const auto &ele : series) {
+        if (ele.E.empty())
+            continue;
+        real.emplace(ele.run, Reweight(n_site)).first->second.add_series(ele);
+    } // Group series by realization
+
+    std::vector<Rw_point> out(T.size(), Rw_point{0.0, 0.0, 0.0, 0.0, 0.0});
+
+    for (auto &&ele : real) {
+        auto pts = multi ? ele.second.multi(T) : ele.second.single(T);
+
+        for (size_t i = 0; i < T.size(); i++) {
+            out[i].E      += pts[i].E;
+            out[i].C      += pts[i].C;
+            out[i].chi    += pts[i].chi;
+            out[i].binder += pts[i].binder;
+        }
+    } // Loop over realizations
+
+    for (size_t i = 0; i < T.size(); i++) {
+        const double n_real = static_cast<double>(real.size());
+        out[i].T       = T[i];
+        out[i].E      /= n_real;
+        out[i].C      /= n_real;
+        out[i].chi    /= n_real;
+        out[i].binder /= n_real;
+    }
+
+    return out;
+}
@@ -0,0 +1,615 @@
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <random>
+#include <algorithm>
+#include <numeric>
+#include <omp.h>
+#ifdef USE_MPI
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <mpi.h>
+#endif
+
+#include "../include/scheduler.h"
+#include "../include/disorder_cooling.h"
+#include "../include/instrument.h"
+#include "../include/progress.h"
+#include "../include/placement.h"
+
+
+/*-------------------------------------------------------------------------------------------------
+ * HELPER FUNCTIONS
+ *-----------------------------------------------------------------------------------------------*/
+
+/* is_batched()
+ * Checks if the disordered runs of a job use the batched engines.
+ */
+static bool is_batched(const Job &job, double delta)
+{
+    return delta > 0.0 && job.model.compare(0, 5, "ising") != 0;
+}
+
+
+/* task_engine()
+ * Returns the engine of a stream of a task. Stream 0 draws the exchange table, which all
+ * temperatures of a realization share, stream 1 + T draws the spins and sweeps.
+ */
+static std::mt19937 task_engine(const Job &job, const Task &task, size_t stream)
+{
+    std::seed_seq seq{job.seed, static_cast<unsigned>(job.L[task.L]),
+                      static_cast<unsigned>(task.delta), static_cast<unsigned>(task.run),
+                      static_cast<unsigned>(stream)};
+
+    return std::mt19937(seq);
+}
+
+
+/* lane_values()
+ * Returns the observables of a scalar model.
+ */
+static std::vector<Observables> lane_values(const Observables &obs, int)
+{
+    return {obs};
+}
+
+
+/* lane_values()
+ * Returns the observables of the first n_real lanes of a batch.
+ */
+template <size_t N>
+static std::vector<Observables> lane_values(const std::array<Observables, N> &obs, int n_real)
+{
+    return std::vector<Observables>(obs.begin(), obs.begin() + n_real);
+}
+
+
+/* sweep_task()
+ * Runs a task on a model (or batch) with its run parameters set. Returns the observables of every
+ * realization of the task.
+ */
+template <typename Model>
+static std::vector<Observables> sweep_task(const Job &job, const Task &task, Model model,
+        Time_series *ts)
+{
+    const double delta = job.delta[task.delta];
+    const double beta  = 1.0 / job.T[task.T];
+    std::mt19937 engine = task_engine(job, task, 1 + task.T);
+
+    if (delta > 0.0) {
+        std::mt19937 ex_engine = task_engine(job, task, 0);
+        model.set_exchange(delta, ex_engine);
+    }
+
+    model.set_spin(engine);
+    note_placement(model.get_lattice());
+    if (ts)
+        model.set_time_series(ts, omp_get_thread_num(), beta, task.run,
+                static_cast<int>(task.T));
+
+    std::vector<Observables> obs = lane_values(model.sweep_observables(beta, engine),
+            task.n_real);
+    instrument_record(job_tag(job, delta), job.L[task.L], job.T[task.T], task.run,
+            model.get_counters());
+
+    return obs;
+}
+
+
+/* run_task()
+ * Builds the model of a task and runs it. The thread pins itself first, so the model is
+ * allocated on its node (see placement.h).
+ */
+static std::vector<Observables> run_task(const Job &job, const Task &task, Time_series *ts)
+{
+    pin_thread();
+
+    const int L         = job.L[task.L];
+    const bool batched  = is_batched(job, job.delta[task.delta]);
+
+    if (job.model == "ising2") {
+        Ising2 model(L);
+        model.set_run_param(job.warmup, job.measure);
+        model.set_site_order(job.order);
+        model.set_visit(job.visit);
+        return sweep_task(job, task, model, ts);
+    } else if (job.model == "ising3") {
+        Ising3 model(L);
+        model.set_run_param(job.warmup, job.measure);
+        model.set_site_order(job.order);
+        model.set_visit(job.visit);
+        return sweep_task(job, task, model, ts);
+    } else if (job.model == "clock2") {
+        Clock2 model(L, job.q);
+        model.set_run_param(job.warmup, job.measure);
+        model.set_site_order(job.order);
+        model.set_visit(job.visit);
+        model.set_overrelax(job.overrelax);
+        return batched ? sweep_task(job, task, Clock_batch<2>(model), ts) :
+                         sweep_task(job, task, model, ts);
+    } else if (job.model == "clock3") {
+        Clock3 model(L, job.q);
+        model.set_run_param(job.warmup, job.measure);
+        model.set_site_order(job.order);
+        model.set_visit(job.visit);
+        model.set_overrelax(job.overrelax);
+        return batched ? sweep_task(job, task, Clock_batch<3>(model), ts) :
+                         sweep_task(job, task, model, ts);
+    } else if (job.model == "xy2") {
+        XY2 model(L);
+        model.set_run_param(job.warmup, job.measure);
+        model.set_site_order(job.order);
+        model.set_visit(job.visit);
+        model.set_overrelax(job.overrelax);
+        return batched ? sweep_task(job, task, XY_batch<2>(model), ts) :
+                         sweep_task(job, task, model, ts);
+    } else {
+        XY3 model(L);
+        model.set_run_param(job.warmup, job.measure);
+        model.set_site_order(job.order);
+        model.set_visit(job.visit);
+        model.set_overrelax(job.overrelax);
+        return batched ? sweep_task(job, task, XY_batch<3>(model), ts) :
+                         sweep_task(job, task, model, ts);
+    }
+}
+
+
+/*-------------------------------------------------------------------------------------------------
+ * SCHEDULER
+ *-----------------------------------------------------------------------------------------------*/
+
+/* task_cost()
+ * Estimates the cost of n_real realizations of one temperature. The model factors are the rough
+ * cost of a site update relative to Ising, a lane of a batch costs about half of a scalar run.
+ */
+double task_cost(const Job &job, int L, int n_real)
+{
+    const bool is_3d = job.model.back() == '3';
+    double factor    = 1.0;
+
+    if (job.model.compare(0, 5, "clock") == 0)
+        factor = 1.5 * (1.0 + 0.5 * static_cast<double>(job.overrelax));
+    else if (job.model.compare(0, 2, "xy") == 0)
+        factor = 2.0 * (1.0 + 0.5 * static_cast<double>(job.overrelax));
+
+    const double sites = pow(static_cast<double>(L), is_3d ? 3.0 : 2.0);
+    const double lanes = (n_real > 1) ? 0.5 * static_cast<double>(n_real) : 1.0;
+
+    return sites * static_cast<double>(job.warmup + job.measure) * factor * lanes;
+}
+
+
+/* task_work()
+ * Returns the site updates of a task. A batch updates every lane, used or not.
+ */
+std::uint64_t task_work(const Job &job, const Task &task)
+{
+    const bool is_3d     = job.model.back() == '3';
+    const std::uint64_t L = static_cast<std::uint64_t>(job.L[task.L]);
+    const std::uint64_t n = is_batched(job, job.delta[task.delta]) ? Batch<2>::n_lane : 1;
+
+    return (is_3d ? L * L * L : L * L) * (job.warmup + job.measure) * n;
+}
+
+
+/* add_progress_total()
+ * Adds the work of the tasks to the totals of the progress reporter, if there is one.
+ */
+void add_progress_total(const std::vector<Job> &jobs, const std::vector<Task> &tasks)
+{
+    if (!Progress::active)
+        return;
+
+    std::uint64_t work = 0;
+    for (auto &&task : tasks)
+        work += task_work(jobs[task.job], task);
+
+    Progress::active->add_total(work, tasks.size());
+}
+
+
+/* expand_tasks()
+ * Returns every task of the jobs.
+ */
+std::vector<Task> expand_tasks(const std::vector<Job> &jobs)
+{
+    std::vector<Task> tasks;
+
+    for (size_t j = 0; j < jobs.size(); j++) {
+        const Job &job = jobs[j];
+
+        for (size_t d = 0; d < job.delta.size(); d++) {
+            const bool batched = is_batched(job, job.delta[d]);
+            const int n_run    = job.delta[d] > 0.0 ? job.n_run : 1;
+            const int n_step   = batched ? static_cast<int>(Batch<2>::n_lane) : 1;
+
+            for (size_t l = 0; l < job.L.size(); l++) {
+                for (int run = 0; run < n_run; run += n_step) {
+                    const int n_real  = std::min(n_step, n_run - run);
+                    const double cost = task_cost(job, job.L[l], batched ? n_real : 1);
+
+                    for (size_t t = 0; t < job.T.size(); t++)
+                        tasks.push_back(Task{j, d, l, t, run, n_real, cost});
+                } // Loop over realizations
+            } // Loop over L
+        } // Loop over delta
+    } // Loop over jobs
+
+    return tasks;
+}
+
+
+/* check_jobs()
+ * Fails on adaptive jobs, whose grids are not known up front, on jobs which split each lattice
+ * over all threads and on jobs which do not run Metropolis sweeps.
+ */
+static void check_jobs(const std::vector<Job> &jobs)
+{
+    for (auto &&job : jobs) {
+        if (job.refine > 0 || job.decompose || job.method != Method::metropolis) {
+            std::cerr << "Error: Job '" << job.name << "' " << (job.refine > 0 ?
+                         "refines its grid" : job.decompose ? "decomposes its lattices" :
+                         "does not run Metropolis sweeps") << " and can not be scheduled. Run "
+                      << "it without --schedule." << std::endl;
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+
+/* struct : Queue
+ * The tasks of a list of jobs and their results. Tasks of a (job, delta) are contiguous in the
+ * order of expand_tasks(), which is also the order their results are summed in, so the sums do
+ * not depend on the order the tasks finish in. order is the order the tasks are handed out in.
+ */
+struct Queue
+{
+    std::vector<Task> tasks;
+    std::vector<size_t> order;
+    std::vector<std::vector<Observables>> result;   // Every realization of every task
+    std::vector<std::vector<size_t>> first;     // First task of every (job, delta)
+    std::vector<std::vector<size_t>> n_open;    // Unfinished tasks of every (job, delta)
+};
+
+
+/* make_queue()
+ * Expands the jobs into a queue, most expensive task first.
+ */
+static Queue make_queue(const std::vector<Job> &jobs)
+{
+    Queue queue;
+
+    queue.tasks = expand_tasks(jobs);
+    queue.order.resize(queue.tasks.size());
+    std::iota(queue.order.begin(), queue.order.end(), 0);
+    std::stable_sort(queue.order.begin(), queue.order.end(), [&queue](size_t a, size_t b) {
+            return queue.tasks[a].cost > queue.tasks[b].cost;
+    });
+    queue.result.resize(queue.tasks.size());
+
+    queue.first.resize(jobs.size());
+    queue.n_open.resize(jobs.size());
+    for (size_t j = 0; j < jobs.size(); j++) {
+        queue.first[j].assign(jobs[j].delta.size(), 0);
+        queue.n_open[j].assign(jobs[j].delta.size(), 0);
+    }
+    for (size_t i = queue.tasks.size(); i-- > 0;) {
+        queue.first[queue.tasks[i].job][queue.tasks[i].delta] = i;
+        queue.n_open[queue.tasks[i].job][queue.tasks[i].delta]++;
+    }
+
+    return queue;
+}
+
+
+/* finish_task()
+ * Stores the result of a task. Writes the result file of its (job, delta), with the Binder
+ * crossings bootstrapped over the realizations, if it was the last open task. Callers serialize
+ * the calls.
+ */
+static void finish_task(const std::vector<Job> &jobs, Queue &queue, size_t idx,
+        const std::vector<Observables> &val)
+{
+    const Task &task = queue.tasks[idx];
+    const Job &job   = jobs[task.job];
+
+    queue.result[idx] = val;
+    if (--queue.n_open[task.job][task.delta] > 0)
+        return;
+
+    const int n_run = job.delta[task.delta] > 0.0 ? job.n_run : 1;
+    std::vector<std::vector<Observables>> obs(job.L.size(),
+            std::vector<Observables>(job.T.size(), Observables{}));
+    std::vector<std::vector<std::vector<Observables>>> runs(job.L.size(),
+            std::vector<std::vector<Observables>>(n_run, obs[0]));
+
+    for (size_t k = queue.first[task.job][task.delta]; k < queue.tasks.size() &&
+            queue.tasks[k].job == task.job && queue.tasks[k].delta == task.delta; k++) {
+        const Task &t = queue.tasks[k];
+
+        for (int r = 0; r < t.n_real; r++) {
+            obs[t.L][t.T] += queue.result[k][r];
+            runs[t.L][t.run + r][t.T] = queue.result[k][r];
+        }
+    } // Loop over the tasks of the (job, delta)
+    for (auto &&row : obs)
+        for (auto &&ele : row)
+            ele /= static_cast<double>(n_run);
+
+    write_realizations(job, job.delta[task.delta], obs, runs);
+    instrument_write(job_tag(job, job.delta[task.delta]),
+            job_tag(job, job.delta[task.delta]) + ".instrument.json");
+    std::cout << "\tWrote " << job_tag(job, job.delta[task.delta]) << ".bin\n" << std::flush;
+}
+
+
+/* run_scheduled()
+ * Runs every task of the jobs on the threads of this process, the most expensive first, and
+ * writes the result file of every (job, delta) as soon as it is complete.
+ */
+void run_scheduled(std::vector<Job> jobs, Time_series *ts)
+{
+    check_jobs(jobs);
+
+    std::random_device rd;
+    for (auto &&job : jobs)
+        if (job.seed == 0)
+            job.seed = rd();
+
+    Queue queue = make_queue(jobs);
+
+    std::cout << "Scheduling " << queue.tasks.size() << " tasks of " << jobs.size()
+              << " jobs on " << omp_get_max_threads() << " threads\n";
+    add_progress_total(jobs, queue.tasks);
+
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (long i = 0; i < static_cast<long>(queue.order.size()); i++) {
+        const size_t idx = queue.order[i];
+        const std::vector<Observables> val = run_task(jobs[queue.tasks[idx].job],
+                queue.tasks[idx], ts);
+        report_task();
+
+        #pragma omp critical(scheduler_result)
+        finish_task(jobs, queue, idx, val);
+    } // Loop over tasks
+}
+
+
+#ifdef USE_MPI
+/*-------------------------------------------------------------------------------------------------
+ * MPI
+ *-----------------------------------------------------------------------------------------------*/
+
+static const int tag_result = 1;
+static const int tag_work   = 2;
+
+
+/* dispatch()
+ * Hands out the tasks on rank 0. A worker sends the number of tasks it wants followed by the
+ * index and the observables of every realization of every task it finished since its last
+ * message, and gets up to that many tasks, largest first. An empty reply tells the worker that
+ * no tasks are left. A worker which wants no tasks sends its last results and stops.
+ */
+static void dispatch(const std::vector<Job> &jobs, Queue &queue, int n_rank)
+{
+    size_t next  = 0;
+    int n_active = n_rank - 1;
+    std::vector<double> msg;
+    std::vector<unsigned long> chunk;
+
+    while (n_active > 0) {
+        MPI_Status status;
+        int count;
+
+        MPI_Probe(MPI_ANY_SOURCE, tag_result, MPI_COMM_WORLD, &status);
+        MPI_Get_count(&status, MPI_DOUBLE, &count);
+        msg.resize(count);
+        MPI_Recv(msg.data(), count, MPI_DOUBLE, status.MPI_SOURCE, tag_result, MPI_COMM_WORLD,
+                MPI_STATUS_IGNORE);
+
+        for (size_t k = 1; k < msg.size();) {
+            const size_t idx = static_cast<size_t>(msg[k++]);
+            const Job &job   = jobs[queue.tasks[idx].job];
+            std::vector<Observables> val(queue.tasks[idx].n_real);
+
+            for (auto &&ele : val)
+                k += read_acc(ele, &msg[k]);
+            if (Progress::active) {
+                Progress::active->add_sweeps(job.warmup + job.measure,
+                        task_work(job, queue.tasks[idx]));
+                Progress::active->finish_task();
+            }
+            finish_task(jobs, queue, idx, val);
+        } // Loop over returned tasks
+
+        if (msg[0] < 1.0) {
+            n_active--;
+            continue;
+        }
+
+        chunk.clear();
+        for (size_t n = static_cast<size_t>(msg[0]); n > 0 && next < queue.order.size(); n--)
+            chunk.push_back(queue.order[next++]);
+
+        MPI_Send(chunk.data(), static_cast<int>(chunk.size()), MPI_UNSIGNED_LONG,
+                status.MPI_SOURCE, tag_work, MPI_COMM_WORLD);
+    } // Serve workers
+}
+
+
+/* struct : Local_queue
+ * The tasks a worker rank holds and the results it has not sent yet, shared by its threads.
+ */
+struct Local_queue
+{
+    std::mutex mtx;
+    std::condition_variable cond;
+    std::deque<unsigned long> tasks;
+    std::vector<double> done;           // Index and observables of every finished task
+    size_t n_running = 0;
+    bool last        = false;           // Rank 0 has no tasks left
+};
+
+
+/* request()
+ * Sends the finished tasks of a worker to rank 0 with a request for n_want more, and queues the
+ * tasks it gets. With n_want 0 the results are the last ones and there is no reply. Only the
+ * master thread calls MPI.
+ */
+static void request(Local_queue &local, size_t n_want)
+{
+    std::vector<double> msg = {static_cast<double>(n_want)};
+    {
+        std::lock_guard<std::mutex> lock(local.mtx);
+        msg.insert(msg.end(), local.done.begin(), local.done.end());
+        local.done.clear();
+    }
+
+    MPI_Send(msg.data(), static_cast<int>(msg.size()), MPI_DOUBLE, 0, tag_result,
+            MPI_COMM_WORLD);
+    if (n_want == 0)
+        return;
+
+    MPI_Status status;
+    int count;
+    std::vector<unsigned long> chunk;
+
+    MPI_Probe(0, tag_work, MPI_COMM_WORLD, &status);
+    MPI_Get_count(&status, MPI_UNSIGNED_LONG, &count);
+    chunk.resize(count);
+    MPI_Recv(chunk.data(), count, MPI_UNSIGNED_LONG, 0, tag_work, MPI_COMM_WORLD,
+            MPI_STATUS_IGNORE);
+
+    {
+        std::lock_guard<std::mutex> lock(local.mtx);
+        local.tasks.insert(local.tasks.end(), chunk.begin(), chunk.end());
+        local.last = chunk.empty();
+    }
+    local.cond.notify_all();
+}
+
+
+/* run_local()
+ * Runs tasks of the local queue on the calling thread. With wait set the thread waits for more
+ * tasks while the queue is empty and returns once rank 0 has none left, else it returns as soon
+ * as the queue is empty.
+ */
+static void run_local(const std::vector<Job> &jobs, const Queue &queue, Local_queue &local,
+        Time_series *ts, bool wait)
+{
+    while (true) {
+        unsigned long idx;
+        {
+            std::unique_lock<std::mutex> lock(local.mtx);
+            if (wait)
+                local.cond.wait(lock, [&local] { return !local.tasks.empty() || local.last; });
+            if (local.tasks.empty())
+                return;
+
+            idx = local.tasks.front();
+            local.tasks.pop_front();
+            local.n_running++;
+        }
+
+        const std::vector<Observables> val = run_task(jobs[queue.tasks[idx].job],
+                queue.tasks[idx], ts);
+
+        {
+            std::lock_guard<std::mutex> lock(local.mtx);
+            local.done.push_back(static_cast<double>(idx));
+            for (auto &&ele : val)
+                append_acc(local.done, ele);
+            local.n_running--;
+        }
+        local.cond.notify_all();
+    } // Loop over tasks
+}
+
+
+/* work()
+ * Runs the tasks handed out by rank 0 on the threads of a worker until none are left. The master
+ * thread keeps a task queued for every other thread: whenever threads take tasks from the local
+ * queue it sends the finished ones to rank 0 and asks for as many new ones, so no thread waits
+ * for the others to finish. A worker with a single thread asks for one task at a time.
+ */
+static void work(const std::vector<Job> &jobs, const Queue &queue, Time_series *ts)
+{
+    Local_queue local;
+
+    #pragma omp parallel
+    {
+        const size_t n_worker = static_cast<size_t>(omp_get_num_threads() - 1);
+
+        if (omp_get_thread_num() != 0) {
+            run_local(jobs, queue, local, ts, true);
+        } else if (n_worker == 0) {
+            while (!local.last) {
+                request(local, 1);
+                run_local(jobs, queue, local, ts, false);
+            }
+            request(local, 0);
+        } else {
+            while (!local.last) {
+                size_t n_want;
+                {
+                    std::unique_lock<std::mutex> lock(local.mtx);
+                    local.cond.wait(lock, [&] { return local.tasks.size() < n_worker; });
+                    n_want = 2 * n_worker - local.tasks.size();
+                }
+                request(local, n_want);
+            } // Refill the local queue
+
+            {
+                std::unique_lock<std::mutex> lock(local.mtx);
+                local.cond.wait(lock, [&local] {
+                        return local.tasks.empty() && local.n_running == 0;
+                });
+            }
+            request(local, 0);
+        }
+    } // Parallel region
+}
+
+
+/* run_distributed()
+ * Runs every task of the jobs on the ranks of MPI_COMM_WORLD. Every rank must hold the same
+ * jobs. Rank 0 hands out the tasks, collects the results and writes the result files, the other
+ * ranks run the tasks on their threads. With a single rank this is run_scheduled().
+ */
+void run_distributed(std::vector<Job> jobs, Time_series *ts)
+{
+    int rank, n_rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &n_rank);
+
+    if (n_rank == 1) {
+        run_scheduled(jobs, ts);
+        return;
+    }
+    check_jobs(jobs);
+
+    // Rank 0 draws the missing master seeds, so every rank expands the same tasks
+    std::vector<unsigned> seed(jobs.size());
+    if (rank == 0) {
+        std::random_device rd;
+        for (size_t j = 0; j < jobs.size(); j++)
+            seed[j] = jobs[j].seed == 0 ? rd() : jobs[j].seed;
+    }
+    MPI_Bcast(seed.data(), static_cast<int>(seed.size()), MPI_UNSIGNED, 0, MPI_COMM_WORLD);
+    for (size_t j = 0; j < jobs.size(); j++)
+        jobs[j].seed = seed[j];
+
+    Queue queue = make_queue(jobs);
+
+    if (rank == 0) {
+        std::cout << "Scheduling " << queue.tasks.size() << " tasks of " << jobs.size()
+                  << " jobs on " << n_rank - 1 << " ranks\n";
+        add_progress_total(jobs, queue.tasks);
+        dispatch(jobs, queue, n_rank);
+    } else {
+        work(jobs, queue, ts);
+    }
+}
+#endif
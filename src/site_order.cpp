@@ -0,0 +1,199 @@
+#include <iostream>
+#include <algorithm>
+#include <array>
+#include <utility>
+#include <cstdint>
+#include <cstdlib>
+
+#include "../include/site_order.h"
+
+
+/*-------------------------------------------------------------------------------------------------
+ * HELPER FUNCTIONS
+ *-----------------------------------------------------------------------------------------------*/
+
+typedef std::array<std::uint32_t, 3> Coord;    // Slowest axis first (z, y, x in 3D)
+
+
+/* interleave()
+ * Returns the bits of the coordinates interleaved from the most significant down, the first axis
+ * leading at every level.
+ */
+static std::uint64_t interleave(const Coord &X, std::size_t dim, int bits)
+{
+    std::uint64_t key = 0;
+
+    for (int b = bits - 1; b >= 0; b--)
+        for (std::size_t i = 0; i < dim; i++)
+            key = (key << 1) | ((X[i] >> b) & 1u);
+
+    return key;
+}
+
+
+/* hilbert_key()
+ * Returns the position of a site along the Hilbert curve. The coordinates are transformed to the
+ * transposed Hilbert index (J. Skilling, AIP Conf. Proc. 707, 381 (2004)) and interleaved.
+ */
+static std::uint64_t hilbert_key(Coord X, std::size_t dim, int bits)
+{
+    const std::uint32_t M = 1u << (bits - 1);
+
+    // Undo the excess work, from the top level down
+    for (std::uint32_t Q = M; Q > 1; Q >>= 1) {
+        const std::uint32_t P = Q - 1;
+
+        for (std::size_t i = 0; i < dim; i++) {
+            if (X[i] & Q) {
+                X[0] ^= P;
+            } else {
+                const std::uint32_t t = (X[0] ^ X[i]) & P;
+                X[0] ^= t;
+                X[i] ^= t;
+            }
+        } // Loop over axes
+    } // Loop over levels
+
+    // Gray encode
+    for (std::size_t i = 1; i < dim; i++)
+        X[i] ^= X[i - 1];
+
+    std::uint32_t t = 0;
+    for (std::uint32_t Q = M; Q > 1; Q >>= 1)
+        if (X[dim - 1] & Q)
+            t ^= Q - 1;
+    for (std::size_t i = 0; i < dim; i++)
+        X[i] ^= t;
+
+    return interleave(X, dim, bits);
+}
+
+
+/*-------------------------------------------------------------------------------------------------
+ * SITE ORDERINGS
+ *-----------------------------------------------------------------------------------------------*/
+
+/* parse_site_order()
+ * Reads the name of an ordering. Returns false if it is unknown.
+ */
+bool parse_site_order(const std::string &name, Site_order &order)
+{
+    if (name == "row_major")
+        order = Site_order::row_major;
+    else if (name == "morton")
+        order = Site_order::morton;
+    else if (name == "hilbert")
+        order = Site_order::hilbert;
+    else
+        return false;
+
+    return true;
+}
+
+
+/* site_order_name()
+ * Returns the name of an ordering, as read by parse_site_order().
+ */
+std::string site_order_name(Site_order order)
+{
+    switch (order) {
+        case Site_order::morton:
+            return "morton";
+        case Site_order::hilbert:
+            return "hilbert";
+        default:
+            return "row_major";
+    }
+}
+
+
+/* site_index()
+ * Returns where the site with row major index r is stored, for every r of a lattice of dim
+ * dimensions. Returns an empty table for the row major order, where the two are the same.
+ */
+std::vector<std::size_t> site_index(int L, std::size_t dim, Site_order order)
+{
+    if (order == Site_order::row_major)
+        return std::vector<std::size_t>();
+
+    int bits = 1;
+    while ((1 << bits) < L)
+        bits++;
+
+    if (dim < 2 || dim > 3 || L < 1 || bits * static_cast<int>(dim) > 63) {
+        std::cerr << "Error: No site ordering for " << dim << "D lattices of L = " << L << "."
+                  << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    const std::size_t n = static_cast<std::size_t>(L);
+    std::size_t size    = 1;
+    for (std::size_t i = 0; i < dim; i++)
+        size *= n;
+
+    std::vector<std::pair<std::uint64_t, std::size_t>> key(size);
+    for (std::size_t r = 0; r < size; r++) {
+        Coord X = {{0, 0, 0}};
+        std::size_t rest = r;
+
+        for (std::size_t i = dim; i-- > 0;) {
+            X[i]  = static_cast<std::uint32_t>(rest % n);
+            rest /= n;
+        }
+
+        key[r].first  = order == Site_order::morton ? interleave(X, dim, bits) :
+                                                      hilbert_key(X, dim, bits);
+        key[r].second = r;
+    } // Loop over sites
+
+    // Number the sites in the order the curve visits them
+    std::sort(key.begin(), key.end());
+
+    std::vector<std::size_t> index(size);
+    for (std::size_t k = 0; k < size; k++)
+        index[key[k].second] = k;
+
+    return index;
+}
+
+
+/*-------------------------------------------------------------------------------------------------
+ * VISITING ORDERS
+ *-----------------------------------------------------------------------------------------------*/
+
+/* parse_visit()
+ * Reads the name of a visiting order. Returns false if it is unknown.
+ */
+bool parse_visit(const std::string &name, Visit &visit)
+{
+    if (name == "random")
+        visit = Visit::random;
+    else if (name == "sequential")
+        visit = Visit::sequential;
+    else if (name == "blocks")
+        visit = Visit::blocks;
+    else if (name == "prefetch")
+        visit = Visit::prefetch;
+    else
+        return false;
+
+    return true;
+}
+
+
+/* visit_name()
+ * Returns the name of a visiting order, as read by parse_visit().
+ */
+std::string visit_name(Visit visit)
+{
+    switch (visit) {
+        case Visit::sequential:
+            return "sequential";
+        case Visit::blocks:
+            return "blocks";
+        case Visit::prefetch:
+            return "prefetch";
+        default:
+            return "random";
+    }
+}
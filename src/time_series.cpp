@@ -0,0 +1,299 @@
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <chrono>
+#include <cstring>
+#include <map>
+
+#include "../include/time_series.h"
+
+
+// Identifies time series files
+static const char magic[8] = {'D', 'C', 'T', 'S', '0', '1', '\0', '\0'};
+
+
+/*-------------------------------------------------------------------------------------------------
+ * TS CHANNEL
+ *-----------------------------------------------------------------------------------------------*/
+
+/* Constructor
+ * The ring holds n_record records, rounded up to a power of two.
+ */
+Ts_channel::Ts_channel(std::size_t n_record) : head(0), tail(0), drop_series(0), n_drop(0),
+    n_lost(0)
+{
+    std::size_t n = 1;
+    while (n < n_record)
+        n <<= 1;
+
+    ring.resize(n);
+    mask = n - 1;
+}
+
+
+/* try_push()
+ * Adds a record if the ring has room. Returns false if it is full. Called only by the producer
+ * thread.
+ */
+bool Ts_channel::try_push(const Ts_record &rec)
+{
+    const std::size_t pos = tail.load(std::memory_order_relaxed);
+
+    if (pos - head.load(std::memory_order_acquire) > mask)
+        return false;
+
+    ring[pos & mask] = rec;
+    tail.store(pos + 1, std::memory_order_release);
+
+    return true;
+}
+
+
+/* drop_record()
+ * Returns the record which counts the pending drops.
+ */
+Ts_record Ts_channel::drop_record() const
+{
+    return Ts_record{drop_series, Ts_record::dropped, {static_cast<double>(n_drop), 0.0, 0.0}};
+}
+
+
+/* push()
+ * Adds a record, waiting for room if the ring is full. The pending drops go first. Called only
+ * by the producer thread.
+ */
+void Ts_channel::push(const Ts_record &rec)
+{
+    while (n_drop > 0 && !try_push(drop_record()))
+        std::this_thread::yield();
+    n_drop = 0;
+
+    while (!try_push(rec))
+        std::this_thread::yield();
+}
+
+
+/* offer()
+ * Adds a sample of the current series, or drops and counts it if the ring is full. Returns false
+ * if the sample was dropped. Called only by the producer thread.
+ */
+bool Ts_channel::offer(const Ts_record &rec)
+{
+    if (n_drop > 0 && try_push(drop_record()))
+        n_drop = 0;
+    if (n_drop == 0 && try_push(rec))
+        return true;
+
+    drop_series = rec.series;
+    n_drop++;
+    n_lost++;
+
+    return false;
+}
+
+
+/* pop()
+ * Moves up to n_max records to out and returns their number. Called only by the consumer thread.
+ */
+std::size_t Ts_channel::pop(Ts_record *out, std::size_t n_max)
+{
+    const std::size_t pos = head.load(std::memory_order_relaxed);
+    const std::size_t end = tail.load(std::memory_order_acquire);
+    std::size_t n = 0;
+
+    for (; n < n_max && pos + n != end; n++)
+        out[n] = ring[(pos + n) & mask];
+
+    head.store(pos + n, std::memory_order_release);
+
+    return n;
+}
+
+
+/* take_drops()
+ * Moves the pending drops to rec and returns true if there are any. Called once the producer
+ * has stopped.
+ */
+bool Ts_channel::take_drops(Ts_record &rec)
+{
+    if (n_drop == 0)
+        return false;
+
+    rec    = drop_record();
+    n_drop = 0;
+
+    return true;
+}
+
+
+/* get_lost()
+ * Returns the number of dropped samples. Called once the producer has stopped.
+ */
+std::size_t Ts_channel::get_lost() const
+{
+    return n_lost;
+}
+
+
+/*-------------------------------------------------------------------------------------------------
+ * TIME SERIES
+ *-----------------------------------------------------------------------------------------------*/
+
+/* write_loop()
+ * Runs in the background thread. Drains the channels to the file until stop is set and every
+ * channel is empty.
+ */
+void Time_series::write_loop()
+{
+    std::vector<Ts_record> buf(4096);
+
+    while (true) {
+        const bool last = stop.load(std::memory_order_acquire);
+        std::size_t n_tot = 0;
+
+        for (auto &&chan : channel) {
+            std::size_t n;
+            while ((n = chan->pop(buf.data(), buf.size())) > 0) {
+                std::fwrite(buf.data(), sizeof(Ts_record), n, file);
+                n_tot += n;
+            }
+        } // Drain channels
+
+        if (last)
+            break;
+        if (n_tot == 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+
+/* Constructor
+ * Opens the file and starts the writer thread. Use one channel per sweep thread.
+ */
+Time_series::Time_series(const std::string &filename, std::size_t n_channel,
+        std::size_t n_record) :
+    file(std::fopen(filename.c_str(), "wb")), n_series(0), stop(false)
+{
+    if (!file) {
+        std::cerr << "Error: Could not open " << filename << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    const std::uint64_t rec_size = sizeof(Ts_record);
+    std::fwrite(magic, sizeof(magic), 1, file);
+    std::fwrite(&rec_size, sizeof(rec_size), 1, file);
+
+    for (std::size_t i = 0; i < n_channel; i++)
+        channel.emplace_back(new Ts_channel(n_record));
+
+    writer = std::thread(&Time_series::write_loop, this);
+}
+
+
+/* Destructor
+ * Writes the remaining records and drops and closes the file. Warns if samples were dropped.
+ */
+Time_series::~Time_series()
+{
+    stop.store(true, std::memory_order_release);
+    writer.join();
+
+    std::size_t n_lost = 0;
+    for (auto &&chan : channel) {
+        Ts_record rec;
+        if (chan->take_drops(rec))
+            std::fwrite(&rec, sizeof(Ts_record), 1, file);
+        n_lost += chan->get_lost();
+    }
+    std::fclose(file);
+
+    if (n_lost > 0)
+        std::cerr << "Warning: Dropped " << n_lost << " time series samples, the disk could not "
+                  << "keep up." << std::endl;
+}
+
+
+/* begin_series()
+ * Opens n series (one per batch lane) for a temperature and returns the id of the first. Lane l
+ * belongs to realization run + l.
+ */
+std::uint32_t Time_series::begin_series(int chan, double beta, int run, int idx, int n)
+{
+    if (static_cast<std::size_t>(chan) >= channel.size()) {
+        std::cerr << "Error: Time series has no channel " << chan << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    const std::uint32_t first = n_series.fetch_add(n);
+
+    for (int l = 0; l < n; l++)
+        channel[chan]->push(Ts_record{first + l, Ts_record::begin,
+                {beta, static_cast<double>(run + l), static_cast<double>(idx)}});
+
+    return first;
+}
+
+
+/* push()
+ * Adds the observables of one measurement sweep to a series. Dropped if the channel is full.
+ */
+void Time_series::push(int chan, std::uint32_t series, std::size_t sweep, double E, double M2)
+{
+    channel[chan]->offer(Ts_record{series, static_cast<std::uint32_t>(sweep),
+            {E, std::sqrt(M2), M2}});
+}
+
+
+/*-------------------------------------------------------------------------------------------------
+ * READER
+ *-----------------------------------------------------------------------------------------------*/
+
+/* read_time_series()
+ * Reads every series of a time series file, ordered by id. The samples of a series are written
+ * by one thread, so they are stored in the order of the sweeps.
+ */
+std::vector<Ts_series> read_time_series(const std::string &filename)
+{
+    std::FILE *in = std::fopen(filename.c_str(), "rb");
+    char head[sizeof(magic)];
+    std::uint64_t rec_size = 0;
+
+    if (!in || std::fread(head, sizeof(head), 1, in) != 1 ||
+            std::fread(&rec_size, sizeof(rec_size), 1, in) != 1 ||
+            std::memcmp(head, magic, sizeof(magic)) != 0 || rec_size != sizeof(Ts_record)) {
+        std::cerr << "Error: " << filename << " is not a time series file." << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    std::map<std::uint32_t, Ts_series> series;
+    std::vector<Ts_record> buf(4096);
+    std::size_t n;
+
+    while ((n = std::fread(buf.data(), sizeof(Ts_record), buf.size(), in)) > 0) {
+        for (std::size_t i = 0; i < n; i++) {
+            const Ts_record &rec = buf[i];
+            Ts_series &ser       = series[rec.series];
+
+            if (rec.sweep == Ts_record::begin) {
+                ser.id   = rec.series;
+                ser.beta = rec.v[0];
+                ser.run  = static_cast<int>(rec.v[1]);
+                ser.idx  = static_cast<int>(rec.v[2]);
+            } else if (rec.sweep == Ts_record::dropped) {
+                ser.n_dropped += static_cast<std::size_t>(rec.v[0]);
+            } else {
+                ser.E.push_back(rec.v[0]);
+                ser.M.push_back(rec.v[1]);
+                ser.M2.push_back(rec.v[2]);
+            }
+        }
+    } // Read records
+
+    std::fclose(in);
+
+    std::vector<Ts_series> out;
+    for (auto &&ele : series)
+        out.push_back(std::move(ele.second));
+
+    return out;
+}
@@ -1,4 +1,271 @@
+#include <cmath>
+#include <algorithm>
+
 #include "../include/xy2.h"
+#include "../include/sincos.h"
+
+
+/*-------------------------------------------------------------------------------------------------
+ * PRIVATE METHODS
+ *-----------------------------------------------------------------------------------------------*/
+
+/* set_proposal()
+ * Draws the rotation angles for the next sweep and computes their sine and cosine in one
+ * vectorized pass.
+ */
+void XY2::set_proposal(std::mt19937 &engine)
+{
+    for (size_t i = 0; i < size; i++)
+        d_angle[i] = window * (2.0 * rand0(engine) - 1.0);
+
+    sincos_array(d_angle.data(), d_sin.data(), d_cos.data(), size);
+}
+
+
+/* tune_window()
+ * Scales the proposal window by the ratio of the measured and the target acceptance rate. The
+ * change is bounded to a factor of 2 and the window can not exceed pi.
+ */
+void XY2::tune_window()
+{
+    double acc = static_cast<double>(n_accept) / static_cast<double>(tune_every * size);
+
+    window  *= std::min(2.0, std::max(0.5, acc / target_acc));
+    window   = std::min(window, M_PI);
+    n_accept = 0;
+}
+
+
+/* sweep_lattice_clean()
+ * Performans Monte Carlo sweeps. Sweeps the lattice once by choosing a position (at random or in
+ * order, see visit_site()) and proposing a rotation of the spin using the Meteropolis Algorithm.
+ * This is done for the lattice size.
+ */
+template <Visit V>
+void XY2::sweep_lattice_clean(float beta, std::mt19937 &engine)
+{
+    set_proposal(engine);
+
+    for (size_t i = 0; i < size; i++) {
+        size_t pos = visit_site<V>(i, engine);
+
+        // Compute local field
+        double hx = 0.0, hy = 0.0;
+        for (size_t j = 0; j < n_neigh; j++) {
+            hx += sx[neigh[pos].neighbor[j]];
+            hy += sy[neigh[pos].neighbor[j]];
+        }
+
+        // Rotate spin
+        double new_x = d_cos[i] * sx[pos] - d_sin[i] * sy[pos];
+        double new_y = d_sin[i] * sx[pos] + d_cos[i] * sy[pos];
+
+        float delta_E = (sx[pos] - new_x) * hx + (sy[pos] - new_y) * hy;
+
+        // Accept / reject new spin
+        if (rand0(engine) < exp(-beta * delta_E)) {
+            sx[pos] = new_x;
+            sy[pos] = new_y;
+            n_accept++;
+            INSTRUMENT_ADD(counters, accepted, 1);
+        }
+    } // Loop over sites
+}
+
+
+/* sweep_lattice_disorder()
+ * Performans Monte Carlo sweeps. Sweeps the lattice once by choosing a position (at random or in
+ * order, see visit_site()) and proposing a rotation of the spin using the Meteropolis Algorithm.
+ * This is done for the lattice size.
+ */
+template <Visit V>
+void XY2::sweep_lattice_disorder(float beta, std::mt19937 &engine)
+{
+    set_proposal(engine);
+
+    for (size_t i = 0; i < size; i++) {
+        size_t pos = visit_site<V>(i, engine);
+
+        // Compute local field
+        double hx = 0.0, hy = 0.0;
+        for (size_t j = 0; j < n_neigh; j++) {
+            hx += J[pos].J_arr[j] * sx[neigh[pos].neighbor[j]];
+            hy += J[pos].J_arr[j] * sy[neigh[pos].neighbor[j]];
+        }
+
+        // Rotate spin
+        double new_x = d_cos[i] * sx[pos] - d_sin[i] * sy[pos];
+        double new_y = d_sin[i] * sx[pos] + d_cos[i] * sy[pos];
+
+        float delta_E = (sx[pos] - new_x) * hx + (sy[pos] - new_y) * hy;
+
+        // Accept / reject new spin
+        if (rand0(engine) < exp(-beta * delta_E)) {
+            sx[pos] = new_x;
+            sy[pos] = new_y;
+            n_accept++;
+            INSTRUMENT_ADD(counters, accepted, 1);
+        }
+    } // Loop over sites
+}
+
+
+/* sweep_overrelax_clean()
+ * Performs an over-relaxation sweep. Each spin is reflected about its local field, which leaves
+ * the energy unchanged, so the move needs no random numbers and no exponential. The sites are
+ * visited in order.
+ */
+void XY2::sweep_overrelax_clean()
+{
+    for (size_t pos = 0; pos < size; pos++) {
+        // Compute local field
+        double hx = 0.0, hy = 0.0;
+        for (size_t j = 0; j < n_neigh; j++) {
+            hx += sx[neigh[pos].neighbor[j]];
+            hy += sy[neigh[pos].neighbor[j]];
+        }
+
+        double h2 = hx * hx + hy * hy;
+        if (h2 > 0.0) {
+            double proj = 2.0 * (sx[pos] * hx + sy[pos] * hy) / h2;
+            sx[pos] = proj * hx - sx[pos];
+            sy[pos] = proj * hy - sy[pos];
+        } // Reflect spin (field free spins are left alone)
+    } // Loop over sites
+}
+
+
+/* sweep_overrelax_disorder()
+ * Performs an over-relaxation sweep with the disordered exchange table.
+ */
+void XY2::sweep_overrelax_disorder()
+{
+    for (size_t pos = 0; pos < size; pos++) {
+        // Compute local field
+        double hx = 0.0, hy = 0.0;
+        for (size_t j = 0; j < n_neigh; j++) {
+            hx += J[pos].J_arr[j] * sx[neigh[pos].neighbor[j]];
+            hy += J[pos].J_arr[j] * sy[neigh[pos].neighbor[j]];
+        }
+
+        double h2 = hx * hx + hy * hy;
+        if (h2 > 0.0) {
+            double proj = 2.0 * (sx[pos] * hx + sy[pos] * hy) / h2;
+            sx[pos] = proj * hx - sx[pos];
+            sy[pos] = proj * hy - sy[pos];
+        } // Reflect spin (field free spins are left alone)
+    } // Loop over sites
+}
+
+
+/* sweep_lattice()
+ * Performs one Metropolis sweep followed by n_overrelax over-relaxation sweeps.
+ */
+void XY2::sweep_lattice(float beta, std::mt19937 &engine)
+{
+    if (isClean) {
+        dispatch_visit([&](auto v) { sweep_lattice_clean<decltype(v)::value>(beta, engine); });
+        for (size_t i = 0; i < n_overrelax; i++)
+            sweep_overrelax_clean();
+    } else {
+        dispatch_visit([&](auto v) { sweep_lattice_disorder<decltype(v)::value>(beta, engine); });
+        for (size_t i = 0; i < n_overrelax; i++)
+            sweep_overrelax_disorder();
+    }
+}
+
+
+/* tune_lattice()
+ * Tunes the proposal window every tune_every warmup sweeps. The acceptance counter is reset
+ * before the first sweep of a temperature.
+ */
+void XY2::tune_lattice(size_t n_sweep)
+{
+    if (n_sweep == 0)
+        n_accept = 0;
+    else if (n_sweep % tune_every == 0)
+        tune_window();
+}
+
+
+/* propose()
+ * Proposes rotating the spin at pos by a random angle in [-window, window] and returns the
+ * energy change.
+ */
+double XY2::propose(size_t pos, std::mt19937 &engine)
+{
+    double angle = window * (2.0 * rand0(engine) - 1.0);
+    double c = cos(angle), s = sin(angle);
+
+    prop_x = c * sx[pos] - s * sy[pos];
+    prop_y = s * sx[pos] + c * sy[pos];
+
+    // Compute local field
+    double hx = 0.0, hy = 0.0;
+    for (size_t j = 0; j < n_neigh; j++) {
+        double J_val = isClean ? 1.0 : J[pos].J_arr[j];
+        hx += J_val * sx[neigh[pos].neighbor[j]];
+        hy += J_val * sy[neigh[pos].neighbor[j]];
+    }
+
+    return (sx[pos] - prop_x) * hx + (sy[pos] - prop_y) * hy;
+}
+
+
+/* accept()
+ * Sets the spin at pos to the last proposed spin.
+ */
+void XY2::accept(size_t pos)
+{
+    sx[pos] = prop_x;
+    sy[pos] = prop_y;
+}
+
+
+/* energy()
+ * Returns the total energy of the lattice.
+ */
+double XY2::energy() const
+{
+    double E_tot = 0.0;
+
+    if (isClean) {
+        #pragma omp simd reduction(+:E_tot)
+        for (size_t j = 0; j < size; j++) {
+            size_t neigh1 = neigh[j].neighbor[1];
+            size_t neigh2 = neigh[j].neighbor[2];
+
+            E_tot += -(sx[j] * (sx[neigh1] + sx[neigh2]) + sy[j] * (sy[neigh1] + sy[neigh2]));
+        } // Compute energy of lattice
+    } else {
+        #pragma omp simd reduction(+:E_tot)
+        for (size_t j = 0; j < size; j++) {
+            size_t neigh1 = neigh[j].neighbor[1];
+            size_t neigh2 = neigh[j].neighbor[2];
+
+            E_tot += -(J[j].J_arr[1] * (sx[j] * sx[neigh1] + sy[j] * sy[neigh1]) +
+                       J[j].J_arr[2] * (sx[j] * sx[neigh2] + sy[j] * sy[neigh2]));
+        } // Compute energy of lattice
+    } // Choose if there is or isn't disorder
+
+    return E_tot;
+}
+
+
+/* magnetization2()
+ * Returns the square of the total magnetization of the lattice.
+ */
+double XY2::magnetization2() const
+{
+    double Mx = 0.0, My = 0.0;
+    #pragma omp simd reduction(+:Mx, My)
+    for (size_t j = 0; j < size; j++) {
+        Mx += sx[j];
+        My += sy[j];
+    }
+
+    return Mx * Mx + My * My;
+}
 
 
 /*-------------------------------------------------------------------------------------------------
@@ -7,40 +274,112 @@
 
 /* Constructor with arguments
  */
-XY2::XY2(const int L) : Clock2(L, 50)
+XY2::XY2(const int L) : Model2(L), window(M_PI), target_acc(0.5), n_accept(0), n_overrelax(0)
 {
+    sx.resize(size);
+    sy.resize(size);
+    d_angle.resize(size);
+    d_cos.resize(size);
+    d_sin.resize(size);
 }
 
 
 /* Copy constructor
  */
-XY2::XY2(const XY2 &rhs) : Clock2(rhs)
+XY2::XY2(const XY2 &rhs) :
+    Model2(rhs), window(rhs.window), target_acc(rhs.target_acc), n_accept(rhs.n_accept),
+    n_overrelax(rhs.n_overrelax), sx(rhs.sx), sy(rhs.sy), d_angle(rhs.d_angle), d_cos(rhs.d_cos),
+    d_sin(rhs.d_sin)
 {
 }
 
 
 /* set_spin()
- * Calss clock model set_spin()
+ * Sets the spins to random angles and resets the proposal window.
+ */
+void XY2::set_spin(std::mt19937 &engine)
+{
+    for (size_t i = 0; i < size; i++) {
+        double angle = 2.0 * M_PI * rand0(engine);
+        sx[i] = cos(angle);
+        sy[i] = sin(angle);
+    }
+
+    window   = M_PI;
+    n_accept = 0;
+}
+
+
+/* set_target_acceptance()
+ * Sets the acceptance rate the proposal window is tuned towards.
+ */
+void XY2::set_target_acceptance(double acc)
+{
+    target_acc = acc;
+}
+
+
+/* set_overrelax()
+ * Sets the number of over-relaxation sweeps performed after each Metropolis sweep.
+ */
+void XY2::set_overrelax(size_t n_over)
+{
+    n_overrelax = n_over;
+}
+
+
+/* get_target_acceptance()
+ * Returns the acceptance rate the proposal window is tuned towards.
+ */
+double XY2::get_target_acceptance() const
+{
+    return target_acc;
+}
+
+
+/* get_overrelax()
+ * Returns the number of over-relaxation sweeps performed after each Metropolis sweep.
+ */
+size_t XY2::get_overrelax() const
+{
+    return n_overrelax;
+}
+
+
+/* get_window()
+ * Returns the current proposal window.
  */
-void XY2::set_spin()
+double XY2::get_window() const
 {
-    Clock2::set_spin();
+    return window;
 }
 
 
-/* sweep_energy()
- * Calls clock mode sweep_energy()
+/* save()
+ * Writes the model and its spins in binary.
  */
-double XY2::sweep_energy(double beta, std::mt19937 &engine)
+void XY2::save(std::ostream &os) const
 {
-    return Clock2::sweep_energy(beta, engine);
+    Model2::save(os);
+    write_binary(os, window);
+    write_binary(os, target_acc);
+    write_binary(os, n_accept);
+    write_binary(os, n_overrelax);
+    write_binary(os, sx);
+    write_binary(os, sy);
 }
 
 
-/* sweep_binder()
- * Calls clock model sweep_binder()
+/* load()
+ * Reads back the data written by save().
  */
-double XY2::sweep_binder(double beta, std::mt19937 &engine)
+void XY2::load(std::istream &is)
 {
-    return Clock2::sweep_binder(beta, engine);
+    Model2::load(is);
+    read_binary(is, window);
+    read_binary(is, target_acc);
+    read_binary(is, n_accept);
+    read_binary(is, n_overrelax);
+    read_binary(is, sx);
+    read_binary(is, sy);
 }
@@ -1,4 +1,346 @@
+#include <cmath>
+#include <algorithm>
+
 #include "../include/xy3.h"
+#include "../include/sincos.h"
+
+
+/*-------------------------------------------------------------------------------------------------
+ * PRIVATE METHODS
+ *-----------------------------------------------------------------------------------------------*/
+
+/* set_proposal()
+ * Draws the rotation angles for the next sweep and computes their sine and cosine in one
+ * vectorized pass.
+ */
+void XY3::set_proposal(std::mt19937 &engine)
+{
+    for (size_t i = 0; i < size; i++)
+        d_angle[i] = window * (2.0 * rand0(engine) - 1.0);
+
+    sincos_array(d_angle.data(), d_sin.data(), d_cos.data(), size);
+}
+
+
+/* tune_window()
+ * Scales the proposal window by the ratio of the measured and the target acceptance rate. The
+ * change is bounded to a factor of 2 and the window can not exceed pi.
+ */
+void XY3::tune_window()
+{
+    double acc = static_cast<double>(n_accept) / static_cast<double>(tune_every * size);
+
+    window  *= std::min(2.0, std::max(0.5, acc / target_acc));
+    window   = std::min(window, M_PI);
+    n_accept = 0;
+}
+
+
+/* local_field()
+ * Computes the local field of the spin at pos. clean selects the uniform couplings at compile
+ * time.
+ */
+template <bool clean>
+void XY3::local_field(size_t pos, double &hx, double &hy) const
+{
+    hx = 0.0;
+    hy = 0.0;
+    for (size_t j = 0; j < n_neigh; j++) {
+        double J_val = clean ? 1.0 : J[pos].J_arr[j];
+        hx += J_val * sx[neigh[pos].neighbor[j]];
+        hy += J_val * sy[neigh[pos].neighbor[j]];
+    }
+}
+
+
+/* rotate_energy()
+ * Rotates the spin at pos by the angle of cosine c and sine s into (new_x, new_y) and returns the
+ * energy change.
+ */
+template <bool clean>
+double XY3::rotate_energy(size_t pos, double c, double s, double &new_x, double &new_y) const
+{
+    double hx, hy;
+    local_field<clean>(pos, hx, hy);
+
+    new_x = c * sx[pos] - s * sy[pos];
+    new_y = s * sx[pos] + c * sy[pos];
+
+    return (sx[pos] - new_x) * hx + (sy[pos] - new_y) * hy;
+}
+
+
+/* rotate_site()
+ * Proposes rotating the spin at pos by the angle of cosine c and sine s with the Metropolis
+ * Algorithm. Returns true if it was accepted.
+ */
+template <bool clean>
+bool XY3::rotate_site(size_t pos, double c, double s, float beta, std::mt19937 &engine)
+{
+    double new_x, new_y;
+    float delta_E = rotate_energy<clean>(pos, c, s, new_x, new_y);
+
+    if (rand0(engine) < exp(-beta * delta_E)) {
+        sx[pos] = new_x;
+        sy[pos] = new_y;
+        return true;
+    }
+
+    return false;
+}
+
+
+/* reflect_site()
+ * Reflects the spin at pos about its local field, which leaves the energy unchanged, so the move
+ * needs no random numbers and no exponential.
+ */
+template <bool clean>
+void XY3::reflect_site(size_t pos)
+{
+    double hx, hy;
+    local_field<clean>(pos, hx, hy);
+
+    double h2 = hx * hx + hy * hy;
+    if (h2 > 0.0) {
+        double proj = 2.0 * (sx[pos] * hx + sy[pos] * hy) / h2;
+        sx[pos] = proj * hx - sx[pos];
+        sy[pos] = proj * hy - sy[pos];
+    } // Reflect spin (field free spins are left alone)
+}
+
+
+/* sweep_lattice_clean()
+ * Performans Monte Carlo sweeps. Sweeps the lattice once by choosing a position (at random or in
+ * order, see visit_site()) and proposing a rotation of the spin using the Meteropolis Algorithm.
+ * This is done for the lattice size.
+ */
+template <Visit V>
+void XY3::sweep_lattice_clean(float beta, std::mt19937 &engine)
+{
+    set_proposal(engine);
+
+    for (size_t i = 0; i < size; i++) {
+        if (rotate_site<true>(visit_site<V>(i, engine), d_cos[i], d_sin[i], beta, engine)) {
+            n_accept++;
+            INSTRUMENT_ADD(counters, accepted, 1);
+        }
+    } // Loop over sites
+}
+
+
+/* sweep_lattice_disorder()
+ * Performans Monte Carlo sweeps. Sweeps the lattice once by choosing a position (at random or in
+ * order, see visit_site()) and proposing a rotation of the spin using the Meteropolis Algorithm.
+ * This is done for the lattice size.
+ */
+template <Visit V>
+void XY3::sweep_lattice_disorder(float beta, std::mt19937 &engine)
+{
+    set_proposal(engine);
+
+    for (size_t i = 0; i < size; i++) {
+        if (rotate_site<false>(visit_site<V>(i, engine), d_cos[i], d_sin[i], beta, engine)) {
+            n_accept++;
+            INSTRUMENT_ADD(counters, accepted, 1);
+        }
+    } // Loop over sites
+}
+
+
+/* sweep_overrelax_clean()
+ * Performs an over-relaxation sweep (see reflect_site()). The sites are visited in order.
+ */
+void XY3::sweep_overrelax_clean()
+{
+    for (size_t pos = 0; pos < size; pos++)
+        reflect_site<true>(pos);
+}
+
+
+/* sweep_overrelax_disorder()
+ * Performs an over-relaxation sweep with the disordered exchange table.
+ */
+void XY3::sweep_overrelax_disorder()
+{
+    for (size_t pos = 0; pos < size; pos++)
+        reflect_site<false>(pos);
+}
+
+
+/* sweep_lattice()
+ * Performs one Metropolis sweep followed by n_overrelax over-relaxation sweeps.
+ */
+void XY3::sweep_lattice(float beta, std::mt19937 &engine)
+{
+    if (isClean) {
+        dispatch_visit([&](auto v) { sweep_lattice_clean<decltype(v)::value>(beta, engine); });
+        for (size_t i = 0; i < n_overrelax; i++)
+            sweep_overrelax_clean();
+    } else {
+        dispatch_visit([&](auto v) { sweep_lattice_disorder<decltype(v)::value>(beta, engine); });
+        for (size_t i = 0; i < n_overrelax; i++)
+            sweep_overrelax_disorder();
+    }
+}
+
+
+/* tune_lattice()
+ * Tunes the proposal window every tune_every warmup sweeps. The acceptance counter is reset
+ * before the first sweep of a temperature.
+ */
+void XY3::tune_lattice(size_t n_sweep)
+{
+    if (n_sweep == 0)
+        n_accept = 0;
+    else if (n_sweep % tune_every == 0)
+        tune_window();
+}
+
+
+/* propose()
+ * Proposes rotating the spin at pos by a random angle in [-window, window] and returns the
+ * energy change.
+ */
+double XY3::propose(size_t pos, std::mt19937 &engine)
+{
+    double angle = window * (2.0 * rand0(engine) - 1.0);
+    double c = cos(angle), s = sin(angle);
+
+    if (isClean)
+        return rotate_energy<true>(pos, c, s, prop_x, prop_y);
+    else
+        return rotate_energy<false>(pos, c, s, prop_x, prop_y);
+}
+
+
+/* accept()
+ * Sets the spin at pos to the last proposed spin.
+ */
+void XY3::accept(size_t pos)
+{
+    sx[pos] = prop_x;
+    sy[pos] = prop_y;
+}
+
+
+/* energy()
+ * Returns the total energy of the lattice.
+ */
+double XY3::energy() const
+{
+    return energy_sites(0, size);
+}
+
+
+/* magnetization2()
+ * Returns the square of the total magnetization of the lattice.
+ */
+double XY3::magnetization2() const
+{
+    double Mx, My;
+    magnetization_sites(0, size, Mx, My);
+
+    return Mx * Mx + My * My;
+}
+
+
+/* energy_sites()
+ * Returns the energy of the bonds 1, 2 and 4 of the sites in [first, last).
+ */
+double XY3::energy_sites(size_t first, size_t last) const
+{
+    double E_tot = 0.0;
+
+    if (isClean) {
+        #pragma omp simd reduction(+:E_tot)
+        for (size_t j = first; j < last; j++) {
+            // Compute energy using the 1, 2, and 4 neighboring bonds
+            size_t neigh1 = neigh[j].neighbor[1];
+            size_t neigh2 = neigh[j].neighbor[2];
+            size_t neigh3 = neigh[j].neighbor[4];
+
+            E_tot += -(sx[j] * (sx[neigh1] + sx[neigh2] + sx[neigh3]) +
+                       sy[j] * (sy[neigh1] + sy[neigh2] + sy[neigh3]));
+        } // Compute energy of lattice
+    } else {
+        #pragma omp simd reduction(+:E_tot)
+        for (size_t j = first; j < last; j++) {
+            // Compute energy using the 1, 2, and 4 neighboring bonds
+            size_t neigh1 = neigh[j].neighbor[1];
+            size_t neigh2 = neigh[j].neighbor[2];
+            size_t neigh3 = neigh[j].neighbor[4];
+
+            E_tot += -(J[j].J_arr[1] * (sx[j] * sx[neigh1] + sy[j] * sy[neigh1]) +
+                       J[j].J_arr[2] * (sx[j] * sx[neigh2] + sy[j] * sy[neigh2]) +
+                       J[j].J_arr[4] * (sx[j] * sx[neigh3] + sy[j] * sy[neigh3]));
+        } // Compute energy of lattice
+    } // Choose if there is or isn't disorder
+
+    return E_tot;
+}
+
+
+/* magnetization_sites()
+ * Computes the magnetization of the sites in [first, last).
+ */
+void XY3::magnetization_sites(size_t first, size_t last, double &Mx, double &My) const
+{
+    double mx = 0.0, my = 0.0;
+    #pragma omp simd reduction(+:mx, my)
+    for (size_t j = first; j < last; j++) {
+        mx += sx[j];
+        my += sy[j];
+    }
+
+    Mx = mx;
+    My = my;
+}
+
+
+/* update_site()
+ * Proposes rotating the spin at pos by a random angle in [-window, window] with the Metropolis
+ * Algorithm (see rotate_site()). Returns true if it was accepted.
+ */
+bool XY3::update_site(size_t pos, float beta, std::mt19937 &engine)
+{
+    double angle = window * (2.0 * rand0(engine) - 1.0);
+    double c = cos(angle), s = sin(angle);
+
+    if (isClean)
+        return rotate_site<true>(pos, c, s, beta, engine);
+    else
+        return rotate_site<false>(pos, c, s, beta, engine);
+}
+
+
+/* overrelax_site()
+ * Over-relaxes the spin at pos (see reflect_site()).
+ */
+void XY3::overrelax_site(size_t pos, float, std::mt19937 &)
+{
+    if (isClean)
+        reflect_site<true>(pos);
+    else
+        reflect_site<false>(pos);
+}
+
+
+/* overrelax_sweeps()
+ * Returns the number of over-relaxation sweeps after each Metropolis sweep.
+ */
+size_t XY3::overrelax_sweeps() const
+{
+    return n_overrelax;
+}
+
+
+/* count_accepted()
+ * Adds the accepted moves of a slab sweep for the tuning of the window.
+ */
+void XY3::count_accepted(size_t n_acc)
+{
+    n_accept += n_acc;
+}
 
 
 /*-------------------------------------------------------------------------------------------------
@@ -7,39 +349,112 @@
 
 /* Constructor with arguments
  */
-XY3::XY3(const int L) : Clock3(L, 50)
+XY3::XY3(const int L) : Model3(L), window(M_PI), target_acc(0.5), n_accept(0), n_overrelax(0)
 {
+    sx.resize(size);
+    sy.resize(size);
+    d_angle.resize(size);
+    d_cos.resize(size);
+    d_sin.resize(size);
 }
 
 
 /* Copy constructor
  */
-XY3::XY3(const XY3 &rhs) : Clock3(rhs)
+XY3::XY3(const XY3 &rhs) :
+    Model3(rhs), window(rhs.window), target_acc(rhs.target_acc), n_accept(rhs.n_accept),
+    n_overrelax(rhs.n_overrelax), sx(rhs.sx), sy(rhs.sy), d_angle(rhs.d_angle), d_cos(rhs.d_cos),
+    d_sin(rhs.d_sin)
 {
 }
 
 
 /* set_spin()
- * Calss clock model set_spin()
+ * Sets the spins to random angles and resets the proposal window.
+ */
+void XY3::set_spin(std::mt19937 &engine)
+{
+    for (size_t i = 0; i < size; i++) {
+        double angle = 2.0 * M_PI * rand0(engine);
+        sx[i] = cos(angle);
+        sy[i] = sin(angle);
+    }
+
+    window   = M_PI;
+    n_accept = 0;
+}
+
+
+/* set_target_acceptance()
+ * Sets the acceptance rate the proposal window is tuned towards.
  */
-void XY3::set_spin()
+void XY3::set_target_acceptance(double acc)
 {
-    Clock3::set_spin();
+    target_acc = acc;
 }
 
 
-/* sweep_energy()
- * Calls clock mode sweep_energy()
+/* set_overrelax()
+ * Sets the number of over-relaxation sweeps performed after each Metropolis sweep.
  */
-double XY3::sweep_energy(double beta, std::mt19937 &engine)
+void XY3::set_overrelax(size_t n_over)
 {
-    return Clock3::sweep_energy(beta, engine);
+    n_overrelax = n_over;
 }
 
-/* sweep_binder()
- * Calls clock model sweep_binder()
+
+/* get_target_acceptance()
+ * Returns the acceptance rate the proposal window is tuned towards.
+ */
+double XY3::get_target_acceptance() const
+{
+    return target_acc;
+}
+
+
+/* get_overrelax()
+ * Returns the number of over-relaxation sweeps performed after each Metropolis sweep.
+ */
+size_t XY3::get_overrelax() const
+{
+    return n_overrelax;
+}
+
+
+/* get_window()
+ * Returns the current proposal window.
+ */
+double XY3::get_window() const
+{
+    return window;
+}
+
+
+/* save()
+ * Writes the model and its spins in binary.
+ */
+void XY3::save(std::ostream &os) const
+{
+    Model3::save(os);
+    write_binary(os, window);
+    write_binary(os, target_acc);
+    write_binary(os, n_accept);
+    write_binary(os, n_overrelax);
+    write_binary(os, sx);
+    write_binary(os, sy);
+}
+
+
+/* load()
+ * Reads back the data written by save().
  */
-double XY3::sweep_binder(double beta, std::mt19937 &engine)
+void XY3::load(std::istream &is)
 {
-    return Clock3::sweep_binder(beta, engine);
+    Model3::load(is);
+    read_binary(is, window);
+    read_binary(is, target_acc);
+    read_binary(is, n_accept);
+    read_binary(is, n_overrelax);
+    read_binary(is, sx);
+    read_binary(is, sy);
 }
@@ -0,0 +1,303 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cstring>
+#include <cstdlib>
+
+#include "../include/ising2.h"
+#include "../include/clock2.h"
+#include "../include/xy2.h"
+#include "../include/ising3.h"
+#include "../include/clock3.h"
+#include "../include/xy3.h"
+#include "../include/batch.h"
+
+
+/* Kernel microbenchmarks
+ *
+ * Times the Metropolis sweeps of every model, dimension and L on the clean and the disordered
+ * lattice (the latter also with the other visiting orders, see site_order.h), the
+ * measurement loop (sweep_observables(), which includes its sweeps), set_exchange() and, for the
+ * clock and XY models, the disordered sweeps of the lane batches. Every kernel runs with a
+ * doubling number of sweeps until one run takes --min-time seconds, and the best of n_rep runs of
+ * that length is reported.
+ *
+ * The results go to stdout (or --out FILE) as JSON, one record per kernel, with the site updates
+ * per second and ns per update. A batch sweep updates n_lane sites per site. For set_exchange()
+ * an update is the draw of the bonds of one site. Progress goes to stderr.
+ */
+
+
+/*-------------------------------------------------------------------------------------------------
+ * GLOBAL CONSTANTS
+ *-----------------------------------------------------------------------------------------------*/
+const std::vector<int> L_2D = {16, 32, 64, 128};
+const std::vector<int> L_3D = {8, 16, 32};
+const double delta          = 0.5;
+const int n_rep             = 3;
+double min_time             = 0.2;
+
+
+/* struct : Bench_result
+ * Timing of one kernel.
+ */
+struct Bench_result
+{
+    std::string model;
+    int dim;
+    int L;
+    std::string kernel;
+    size_t n_update;            // Site updates of the best run
+    double seconds;             // Time of the best run
+};
+
+std::vector<Bench_result> results;
+
+
+/*-------------------------------------------------------------------------------------------------
+ * FORWARD DECLARATIONS
+ *-----------------------------------------------------------------------------------------------*/
+template <typename Make>
+void bench_model(const std::string &name, int dim, double T, const std::vector<int> &L,
+        Make make);
+template <typename Make, typename Make_batch>
+void bench_batch(const std::string &name, int dim, double T, const std::vector<int> &L,
+        Make make, Make_batch make_batch);
+void write_json(std::ostream &os);
+
+
+/*-------------------------------------------------------------------------------------------------
+ * MAIN
+ *-----------------------------------------------------------------------------------------------*/
+int main(int argc, char *argv[])
+{
+    std::string out_file, only;
+
+    // --out writes the JSON to a file, --min-time sets the length of a timed run in seconds,
+    // --model only runs one model (e.g. "clock3")
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            out_file = argv[++i];
+        } else if (std::strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) {
+            min_time = std::strtod(argv[++i], nullptr);
+        } else if (std::strcmp(argv[i], "--model") == 0 && i + 1 < argc) {
+            only = argv[++i];
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--out FILE] [--min-time SEC] [--model NAME]"
+                      << std::endl;
+            return EXIT_FAILURE;
+        }
+    } // Parse arguments
+
+    // Every model runs close to its transition, where the acceptance rate is typical
+    if (only.empty() || only == "ising2")
+        bench_model("ising2", 2, 2.27, L_2D, [](int L) { return Ising2(L); });
+    if (only.empty() || only == "ising3")
+        bench_model("ising3", 3, 4.5, L_3D, [](int L) { return Ising3(L); });
+    if (only.empty() || only == "clock2") {
+        auto make = [](int L) { return Clock2(L, 6); };
+        bench_model("clock2", 2, 0.9, L_2D, make);
+        bench_batch("clock2", 2, 0.9, L_2D, make,
+                [](const Clock2 &model) { return Clock_batch<2>(model); });
+    }
+    if (only.empty() || only == "clock3") {
+        auto make = [](int L) { return Clock3(L, 6); };
+        bench_model("clock3", 3, 2.2, L_3D, make);
+        bench_batch("clock3", 3, 2.2, L_3D, make,
+                [](const Clock3 &model) { return Clock_batch<3>(model); });
+    }
+    if (only.empty() || only == "xy2") {
+        auto make = [](int L) { return XY2(L); };
+        bench_model("xy2", 2, 0.9, L_2D, make);
+        bench_batch("xy2", 2, 0.9, L_2D, make,
+                [](const XY2 &model) { return XY_batch<2>(model); });
+    }
+    if (only.empty() || only == "xy3") {
+        auto make = [](int L) { return XY3(L); };
+        bench_model("xy3", 3, 2.2, L_3D, make);
+        bench_batch("xy3", 3, 2.2, L_3D, make,
+                [](const XY3 &model) { return XY_batch<3>(model); });
+    }
+
+    if (out_file.empty()) {
+        write_json(std::cout);
+    } else {
+        std::ofstream os(out_file);
+        if (!os) {
+            std::cerr << "Error: Could not open " << out_file << std::endl;
+            return EXIT_FAILURE;
+        }
+        write_json(os);
+    }
+
+    return EXIT_SUCCESS;
+}
+
+
+/*-------------------------------------------------------------------------------------------------
+ * FUNCTIONS
+ *-----------------------------------------------------------------------------------------------*/
+
+/* seconds_since()
+ * Returns the seconds since t0.
+ */
+static double seconds_since(std::chrono::steady_clock::time_point t0)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+
+/* time_kernel()
+ * Times run(n), which performs n repetitions of a kernel and returns their time. Doubles n until
+ * a run takes min_time, then stores the best of n_rep runs of n repetitions of n_update site
+ * updates each.
+ */
+template <typename Run>
+static void time_kernel(const std::string &model, int dim, int L, const std::string &kernel,
+        size_t n_update, Run run)
+{
+    size_t n    = 1;
+    double best = run(n);
+
+    while (best < min_time) {
+        n *= 2;
+        best = run(n);
+    } // Calibrate
+
+    for (int i = 1; i < n_rep; i++)
+        best = std::min(best, run(n));
+
+    results.push_back(Bench_result{model, dim, L, kernel, n * n_update, best});
+    std::cerr << model << " L=" << L << " " << kernel << ": "
+              << 1e9 * best / static_cast<double>(n * n_update) << " ns/update\n";
+}
+
+
+/* bench_model()
+ * Times the clean and disordered sweeps, the disordered sweeps of the other visiting orders, the
+ * measurement loop and set_exchange() of a model made by make(L) for every L.
+ */
+template <typename Make>
+void bench_model(const std::string &name, int dim, double T, const std::vector<int> &L,
+        Make make)
+{
+    const double beta = 1.0 / T;
+
+    for (auto l : L) {
+        const size_t n_site = make(l).get_size();
+
+        for (bool disorder : {false, true}) {
+            time_kernel(name, dim, l, disorder ? "sweep_disorder" : "sweep_clean", n_site,
+                    [&](size_t n) {
+                auto model = make(l);
+                std::mt19937 engine(7);
+
+                model.set_run_param(n, 1);
+                if (disorder)
+                    model.set_exchange(delta, engine);
+                model.set_spin(engine);
+
+                auto t0 = std::chrono::steady_clock::now();
+                model.sweep_energy(beta, engine);
+                return seconds_since(t0);
+            });
+        } // Clean and disorder
+
+        for (Visit visit : {Visit::sequential, Visit::blocks, Visit::prefetch}) {
+            time_kernel(name, dim, l, "sweep_disorder_" + visit_name(visit), n_site,
+                    [&](size_t n) {
+                auto model = make(l);
+                std::mt19937 engine(7);
+
+                model.set_run_param(n, 1);
+                model.set_visit(visit);
+                model.set_exchange(delta, engine);
+                model.set_spin(engine);
+
+                auto t0 = std::chrono::steady_clock::now();
+                model.sweep_energy(beta, engine);
+                return seconds_since(t0);
+            });
+        } // Visiting orders
+
+        time_kernel(name, dim, l, "sweep_observables", n_site, [&](size_t n) {
+            auto model = make(l);
+            std::mt19937 engine(7);
+
+            model.set_run_param(0, n);
+            model.set_exchange(delta, engine);
+            model.set_spin(engine);
+
+            auto t0 = std::chrono::steady_clock::now();
+            model.sweep_observables(beta, engine);
+            return seconds_since(t0);
+        });
+
+        time_kernel(name, dim, l, "set_exchange", n_site, [&](size_t n) {
+            auto model = make(l);
+            std::mt19937 engine(7);
+
+            auto t0 = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < n; i++)
+                model.set_exchange(delta, engine);
+            return seconds_since(t0);
+        });
+    } // Loop over L
+}
+
+
+/* bench_batch()
+ * Times the disordered sweeps of the lane batch made by make_batch() from the model made by
+ * make(L) for every L.
+ */
+template <typename Make, typename Make_batch>
+void bench_batch(const std::string &name, int dim, double T, const std::vector<int> &L,
+        Make make, Make_batch make_batch)
+{
+    const double beta = 1.0 / T;
+
+    for (auto l : L) {
+        auto model = make(l);
+        const size_t n_update = model.get_size() * Batch<2>::n_lane;
+
+        time_kernel(name, dim, l, "batch_sweep_disorder", n_update, [&](size_t n) {
+            std::mt19937 engine(7);
+
+            model.set_run_param(n, 1);
+            auto batch = make_batch(model);
+            batch.set_exchange(delta, engine);
+            batch.set_spin(engine);
+
+            auto t0 = std::chrono::steady_clock::now();
+            batch.sweep_energy(beta, engine);
+            return seconds_since(t0);
+        });
+    } // Loop over L
+}
+
+
+/* write_json()
+ * Writes the results as JSON.
+ */
+void write_json(std::ostream &os)
+{
+    os << "{\n  \"min_time\": " << min_time << ",\n  \"n_lane\": " << Batch<2>::n_lane
+       << ",\n  \"results\": [\n";
+
+    for (size_t i = 0; i < results.size(); i++) {
+        const Bench_result &res = results[i];
+        const double n          = static_cast<double>(res.n_update);
+
+        os << "    {\"model\": \"" << res.model << "\", \"dim\": " << res.dim
+           << ", \"L\": " << res.L << ", \"kernel\": \"" << res.kernel
+           << "\", \"updates\": " << res.n_update << ", \"seconds\": " << res.seconds
+           << ", \"updates_per_sec\": " << n / res.seconds
+           << ", \"ns_per_update\": " << 1e9 * res.seconds / n << "}"
+           << (i + 1 < results.size() ? ",\n" : "\n");
+    } // Loop over results
+
+    os << "  ]\n}\n";
+}
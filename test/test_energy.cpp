@@ -6,6 +6,7 @@
 #include <limits>
 
 #include "../include/neighbor.h"
+#include "../include/site_order.h"
 #include "../include/exchange.h"
 #include "../include/ising2.h"
 #include "../include/clock2.h"
@@ -24,6 +25,7 @@ const int N_pts = 200;
 const int n_run = 10;
 const double dT = 0.1;
 const double delta = 5.0;
+const std::vector<int> L_order = {3, 4, 5, 6};   // Sizes tested in the space filling orders
 
 
 /*-------------------------------------------------------------------------------------------------
@@ -31,6 +33,8 @@ const double delta = 5.0;
  *-----------------------------------------------------------------------------------------------*/
 void test_neighbor_2D();
 void test_neighbor_3D();
+template <std::size_t Dim> bool check_order(int L, Site_order order);
+template <std::size_t Dim> void test_neighbor_order(Site_order order);
 void test_exchange_2D();
 void test_exchange_3D();
 void test_ising(const std::array<double, N_pts> &T);
@@ -46,6 +50,10 @@ int main(void)
     std::cout << "Testing Neighbor class implementation for correct neighbor indices\n";
     test_neighbor_2D();
     test_neighbor_3D();
+    for (auto order : {Site_order::morton, Site_order::hilbert}) {
+        test_neighbor_order<2>(order);
+        test_neighbor_order<3>(order);
+    }
 
     std::cout << "\nTesting for equality of exchange table\n";
     test_exchange_2D();
@@ -270,6 +278,65 @@ void test_neighbor_3D()
 }
 
 
+/* check_order()
+ * Builds the neighbor table of an L^Dim lattice stored in a space filling order the way the models
+ * do. site_index() has to be a permutation, every neighbor pair mutual (neighbor 0 of a site has
+ * the site as neighbor 2, 1 as 3 and 4 as 5) and every stored site has the neighbors of its row
+ * major site, renamed.
+ */
+template <std::size_t Dim>
+bool check_order(int L, Site_order order)
+{
+    const std::size_t N = Dim == 2 ? L * L : L * L * L;
+    const std::vector<std::size_t> index = site_index(L, Dim, order);
+    std::vector<std::size_t> row(N, N);           // Row major site of every stored site
+    std::vector<Neighbor<Dim>> table(N);
+
+    if (index.size() != N)
+        return false;
+    for (std::size_t r = 0; r < N; r++) {
+        if (index[r] >= N || row[index[r]] != N)
+            return false;
+        row[index[r]] = r;
+        table[index[r]].set_neighbors(r, L, index);
+    } // Loop over row major sites
+
+    for (std::size_t s = 0; s < N; s++) {
+        Neighbor<Dim> expected;
+        expected.set_neighbors(row[s], L);
+
+        for (std::size_t k = 0; k < 2 * Dim; k++) {
+            const std::size_t back = k < 4 ? (k + 2) % 4 : 9 - k;
+            const int t            = table[s].neighbor[k];
+
+            if (row[t] != static_cast<std::size_t>(expected.neighbor[k]) ||
+                    table[t].neighbor[back] != static_cast<int>(s))
+                return false;
+        } // Loop over neighbors
+    } // Loop over stored sites
+
+    return true;
+}
+
+
+/* test_neighbor_order()
+ * Tests the neighbor tables of the lattices in a space filling order, of sizes which are and
+ * which are not powers of 2.
+ */
+template <std::size_t Dim>
+void test_neighbor_order(Site_order order)
+{
+    std::cout << "  Testing " << Dim << "D Neighbors in " << site_order_name(order) << " order... ";
+
+    bool isEqual = true;
+    for (auto L_i : L_order)
+        isEqual = isEqual && check_order<Dim>(L_i, order);
+
+    if (isEqual) std::cout << "Passed\n";
+    else         std::cout << "Failed\n";
+}
+
+
 /* test_ising()
  * Performs Monte carlo simulation for 2D clean system.
  */
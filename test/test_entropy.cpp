@@ -0,0 +1,277 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+
+#include "../include/entropy.h"
+#include "../include/disorder_cooling.h"
+
+
+/*-------------------------------------------------------------------------------------------------
+ * GLOBAL CONSTANTS
+ *-----------------------------------------------------------------------------------------------*/
+const double T_lo  = 0.5;
+const double T_hi  = 5.0;
+const double S_inf = log(2.0);
+const size_t N_coarse = 21;                     // Points of the coarse grid, the fine one doubles
+const std::vector<Quadrature> rules = {Quadrature::trapezoid, Quadrature::simpson,
+                                       Quadrature::cubic};
+const std::vector<std::string> rule_names = {"trapezoid", "simpson", "cubic"};
+
+
+/*-------------------------------------------------------------------------------------------------
+ * FORWARD DECLARATIONS
+ *-----------------------------------------------------------------------------------------------*/
+std::vector<double> stretched_grid(size_t n);
+double chain_energy(double T);
+double chain_entropy(double T);
+double max_error(size_t n, Quadrature rule);
+bool report(const std::string &name, bool passed, const std::string &detail);
+bool test_order();
+bool test_polynomial();
+bool test_error();
+bool test_compute_entropy();
+
+
+/*-------------------------------------------------------------------------------------------------
+ * MAIN
+ *-----------------------------------------------------------------------------------------------*/
+int main(void)
+{
+    char dir[] = "/tmp/test_entropy_XXXXXX";
+
+    if (!mkdtemp(dir) || chdir(dir) != 0) {
+        std::cerr << "Error: Could not create a scratch directory." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "Testing the thermodynamic integration of the entropy\n";
+    bool passed = test_order();
+    passed      = test_polynomial() && passed;
+    passed      = test_error() && passed;
+    passed      = test_compute_entropy() && passed;
+
+    if (chdir("/") != 0 || rmdir(dir) != 0)
+        std::cerr << "Warning: Could not remove " << dir << std::endl;
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
+/*-------------------------------------------------------------------------------------------------
+ * FUNCTIONS
+ *-----------------------------------------------------------------------------------------------*/
+
+/* stretched_grid()
+ * Returns n points from T_lo to T_hi, log spaced and perturbed so that no two neighboring
+ * intervals have the same ratio.
+ */
+std::vector<double> stretched_grid(size_t n)
+{
+    std::vector<double> T(n);
+
+    for (size_t k = 0; k < n; k++) {
+        const double u = static_cast<double>(k) / static_cast<double>(n - 1);
+        T[k] = T_lo * pow(T_hi / T_lo, u + 0.05 * sin(M_PI * u));
+    }
+
+    return T;
+}
+
+
+/* chain_energy()
+ * Returns the energy per site of the Ising chain, -tanh(1/T).
+ */
+double chain_energy(double T)
+{
+    return -tanh(1.0 / T);
+}
+
+
+/* chain_entropy()
+ * Returns the entropy per site of the Ising chain, ln 2 + ln cosh(1/T) - tanh(1/T) / T, less the
+ * part of the integral above T_hi which entropy() neglects.
+ */
+double chain_entropy(double T)
+{
+    return S_inf + log(cosh(1.0 / T)) - tanh(1.0 / T) / T - log(cosh(1.0 / T_hi));
+}
+
+
+/* max_error()
+ * Returns the largest deviation of S from the Ising chain on the grid of n points.
+ */
+double max_error(size_t n, Quadrature rule)
+{
+    const std::vector<double> T = stretched_grid(n);
+    std::vector<double> E(n);
+
+    for (size_t k = 0; k < n; k++)
+        E[k] = chain_energy(T[k]);
+
+    double err = 0.0;
+    for (auto &&pt : entropy(T, E, std::vector<double>(), S_inf, rule))
+        err = std::max(err, fabs(pt.S - chain_entropy(pt.T)));
+
+    return err;
+}
+
+
+/* report()
+ * Prints the outcome of one test.
+ */
+bool report(const std::string &name, bool passed, const std::string &detail)
+{
+    std::cout << "  Testing " << name << "... ";
+    if (passed) std::cout << "Passed\n";
+    else        std::cout << "Failed (" << detail << ")\n";
+
+    return passed;
+}
+
+
+/* test_order()
+ * Integrates the Ising chain on a non-uniform grid and on one with twice the points. The errors
+ * shrink at least with the order of each rule: 2 for trapezoid, 3 for simpson and 4 for cubic.
+ */
+bool test_order()
+{
+    bool passed = true;
+
+    for (size_t r = 0; r < rules.size(); r++) {
+        const double order  = 2.0 + static_cast<double>(r);
+        const double coarse = max_error(N_coarse, rules[r]);
+        const double fine   = max_error(2 * N_coarse - 1, rules[r]);
+        const double rate   = log2(coarse / fine);
+
+        passed = report(rule_names[r] + " convergence", rate > order - 0.3 && fine < 1e-2,
+                "errors " + std::to_string(coarse) + " and " + std::to_string(fine) +
+                ", order " + std::to_string(rate)) && passed;
+    } // Loop over rules
+
+    return passed;
+}
+
+
+/* test_polynomial()
+ * Integrates E / T^2 which is a polynomial of the degree each rule is exact for. S then matches
+ * the analytic integral to round off on the non-uniform grid.
+ */
+bool test_polynomial()
+{
+    const std::vector<double> T = stretched_grid(N_coarse);
+    const double c[4]           = {0.3, -0.7, 0.2, -0.05};     // Coefficients of y = E / T^2
+    bool passed = true;
+
+    for (size_t r = 0; r < rules.size(); r++) {
+        const size_t deg = r + 1;
+        std::vector<double> E(T.size());
+
+        for (size_t k = 0; k < T.size(); k++) {
+            double y = 0.0;
+            for (size_t d = deg + 1; d-- > 0;)
+                y = y * T[k] + c[d];
+            E[k] = y * T[k] * T[k];
+        }
+
+        const std::vector<Entropy_point> S = entropy(T, E, std::vector<double>(), S_inf,
+                rules[r]);
+        double err = 0.0;
+
+        for (size_t k = 0; k < T.size(); k++) {
+            double I = 0.0;                 // Integral of y from T_k to T_hi
+            for (size_t d = 0; d <= deg; d++)
+                I += c[d] * (pow(T_hi, d + 1) - pow(T[k], d + 1)) / static_cast<double>(d + 1);
+
+            err = std::max(err, fabs(S[k].S - (S_inf + E[k] / T[k] - I)));
+        } // Loop over temperatures
+
+        passed = report(rule_names[r] + " on a degree " + std::to_string(deg) + " polynomial",
+                err < 1e-12, "error " + std::to_string(err)) && passed;
+    } // Loop over rules
+
+    return passed;
+}
+
+
+/* test_error()
+ * S is linear in E, so its variance is sum_j (dS_i / dE_j)^2 E_err_j^2 for independent errors.
+ * The derivatives are the entropies of unit energies at single points, which gives the variance
+ * S_err has to match without the cumulative sums of entropy().
+ */
+bool test_error()
+{
+    const std::vector<double> T = stretched_grid(N_coarse);
+    const size_t n_pt = T.size();
+    std::vector<double> E(n_pt), E_err(n_pt);
+    bool passed = true;
+
+    for (size_t k = 0; k < n_pt; k++) {
+        E[k]     = chain_energy(T[k]);
+        E_err[k] = 0.01 * (1.0 + 0.5 * sin(3.0 * static_cast<double>(k)));
+    }
+
+    for (size_t r = 0; r < rules.size(); r++) {
+        const std::vector<Entropy_point> S = entropy(T, E, E_err, S_inf, rules[r]);
+        std::vector<double> var(n_pt, 0.0);
+
+        for (size_t j = 0; j < n_pt; j++) {
+            std::vector<double> unit(n_pt, 0.0);
+            unit[j] = 1.0;
+
+            const std::vector<Entropy_point> dS = entropy(T, unit, std::vector<double>(), 0.0,
+                    rules[r]);
+            for (size_t i = 0; i < n_pt; i++)
+                var[i] += dS[i].S * dS[i].S * E_err[j] * E_err[j];
+        } // Loop over perturbed points
+
+        double err = 0.0;
+        for (size_t i = 0; i < n_pt; i++)
+            err = std::max(err, fabs(S[i].err - sqrt(var[i])) / sqrt(var[i]));
+
+        passed = report(rule_names[r] + " S_err", err < 1e-10,
+                "relative error " + std::to_string(err)) && passed;
+    } // Loop over rules
+
+    return passed;
+}
+
+
+/* test_compute_entropy()
+ * Writes the entropy of the Ising chain with compute_entropy() and reads it back. The file holds
+ * every temperature but the last with the trapezoid S of entropy().
+ */
+bool test_compute_entropy()
+{
+    const std::string file = "test_entropy.dat";
+    const std::vector<double> grid = stretched_grid(N_coarse);
+    std::array<double, N_coarse> T, E;
+
+    for (size_t k = 0; k < N_coarse; k++) {
+        T[k] = grid[k];
+        E[k] = chain_energy(grid[k]);
+    }
+    compute_entropy(E, T, 2, file);
+
+    const std::vector<Entropy_point> S = entropy(grid, std::vector<double>(E.begin(), E.end()),
+            std::vector<double>(), S_inf, Quadrature::trapezoid);
+    std::ifstream is(file);
+    double T_k, S_k, err = 0.0;
+    size_t n_line = 0;
+
+    while (is >> T_k >> S_k) {
+        if (n_line < N_coarse)
+            err = std::max(err, fabs(T_k - T[n_line]) + fabs(S_k - S[n_line].S));
+        n_line++;
+    }
+    is.close();
+    std::remove(file.c_str());
+
+    return report("compute_entropy", n_line == N_coarse - 1 && err < 1e-5,
+            std::to_string(n_line) + " lines, deviation " + std::to_string(err));
+}
@@ -0,0 +1,142 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+
+#include "../include/job.h"
+#include "../include/result_file.h"
+
+
+/*-------------------------------------------------------------------------------------------------
+ * GLOBAL CONSTANTS
+ *-----------------------------------------------------------------------------------------------*/
+const int L = 8;
+const std::vector<double> T_list = {2.2, 2.5, 2.8};
+
+
+/*-------------------------------------------------------------------------------------------------
+ * FORWARD DECLARATIONS
+ *-----------------------------------------------------------------------------------------------*/
+Job ising_job(const std::string &name, size_t measure);
+std::vector<std::vector<double>> run_quiet(const Job &job);
+bool test_muca();
+
+
+/*-------------------------------------------------------------------------------------------------
+ * MAIN
+ *-----------------------------------------------------------------------------------------------*/
+int main(void)
+{
+    char dir[] = "/tmp/test_muca_XXXXXX";
+
+    if (!mkdtemp(dir) || chdir(dir) != 0) {
+        std::cerr << "Error: Could not create a scratch directory." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "Testing multicanonical jobs against a canonical simulation\n";
+    bool passed = test_muca();
+
+    if (chdir("/") != 0 || rmdir(dir) != 0)
+        std::cerr << "Warning: Could not remove " << dir << std::endl;
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
+/*-------------------------------------------------------------------------------------------------
+ * FUNCTIONS
+ *-----------------------------------------------------------------------------------------------*/
+
+/* ising_job()
+ * Returns a job of the clean L x L Ising model on T_list.
+ */
+Job ising_job(const std::string &name, size_t measure)
+{
+    Job job;
+
+    job.name    = name;
+    job.model   = "ising2";
+    job.L       = {L};
+    job.T       = T_list;
+    job.warmup  = 5000;
+    job.measure = measure;
+    job.seed    = 5;
+
+    return job;
+}
+
+
+/* run_quiet()
+ * Runs a job without its output and returns E, C, chi and the binder ratio at every temperature
+ * of its result file, which is removed.
+ */
+std::vector<std::vector<double>> run_quiet(const Job &job)
+{
+    const std::string bin    = job_tag(job, 0.0) + ".bin";
+    const std::string suffix = "_L=" + std::to_string(L);
+    std::streambuf *cout_buf = std::cout.rdbuf();
+    std::ostringstream log;
+
+    std::cout.rdbuf(log.rdbuf());
+    run_job(job, false, nullptr);
+    std::cout.rdbuf(cout_buf);
+
+    std::vector<std::vector<double>> val(T_list.size());
+    {
+        Result_file res(bin);
+        for (auto &&name : {"E", "C", "chi", "binder"}) {
+            const double *col = res.column(name + suffix);
+            for (size_t i = 0; i < T_list.size(); i++)
+                val[i].push_back(col[i]);
+        }
+    }
+    std::remove(bin.c_str());
+    std::remove((job_tag(job, 0.0) + "_L" + std::to_string(L) + ".ckpt").c_str());
+
+    return val;
+}
+
+
+/* test_muca()
+ * Runs a multicanonical job of the clean Ising model over [2, 3] and compares E, C, chi and the
+ * binder ratio at every temperature to a canonical job. E and the binder ratio agree within
+ * 0.01, C and chi within 5%.
+ */
+bool test_muca()
+{
+    std::cout << "  Running the jobs... " << std::flush;
+    Job muca       = ising_job("muca", 200000);
+    muca.method    = Method::muca;
+    muca.muca_lo   = 2.0;
+    muca.muca_hi   = 3.0;
+    muca.muca_bins = 20;
+    muca.muca_iter = 10;
+    const std::vector<std::vector<double>> val = run_quiet(muca);
+    const std::vector<std::vector<double>> ref = run_quiet(ising_job("direct", 400000));
+    std::cout << "Done\n";
+
+    bool passed = true;
+    for (size_t i = 0; i < T_list.size(); i++) {
+        const std::vector<double> &v = val[i], &r = ref[i];
+        const bool ok = fabs(v[0] - r[0]) < 0.01 && fabs(v[1] - r[1]) < 0.05 * r[1] &&
+                        fabs(v[2] - r[2]) < 0.05 * r[2] && fabs(v[3] - r[3]) < 0.01;
+
+        std::cout << "  Testing T = " << T_list[i] << "... ";
+        if (ok) {
+            std::cout << "Passed\n";
+        } else {
+            std::cout << "Failed (E, C, chi, binder";
+            for (size_t k = 0; k < v.size(); k++)
+                std::cout << (k ? ", " : " ") << v[k] << " vs " << r[k];
+            std::cout << ")\n";
+            passed = false;
+        }
+    } // Loop over temperatures
+
+    return passed;
+}
@@ -0,0 +1,181 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <csignal>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "../include/job.h"
+#include "../include/checkpoint.h"
+
+
+/*-------------------------------------------------------------------------------------------------
+ * GLOBAL CONSTANTS
+ *-----------------------------------------------------------------------------------------------*/
+const int L        = 12;
+const int n_run    = 4;
+const double delta = 1.0;
+
+
+/*-------------------------------------------------------------------------------------------------
+ * FORWARD DECLARATIONS
+ *-----------------------------------------------------------------------------------------------*/
+Job restart_job();
+std::string read_file(const std::string &file);
+bool interrupt_job(const Job &job);
+bool test_restart();
+
+
+/*-------------------------------------------------------------------------------------------------
+ * MAIN
+ *-----------------------------------------------------------------------------------------------*/
+int main(void)
+{
+    char dir[] = "/tmp/test_restart_XXXXXX";
+
+    if (!mkdtemp(dir) || chdir(dir) != 0) {
+        std::cerr << "Error: Could not create a scratch directory." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "Testing checkpoint / restart of a disorder averaged run\n";
+    bool passed = test_restart();
+
+    if (chdir("/") != 0 || rmdir(dir) != 0)
+        std::cerr << "Warning: Could not remove " << dir << std::endl;
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
+/*-------------------------------------------------------------------------------------------------
+ * FUNCTIONS
+ *-----------------------------------------------------------------------------------------------*/
+
+/* restart_job()
+ * Returns a small checkpointed job of several realizations.
+ */
+Job restart_job()
+{
+    Job job;
+
+    job.name       = "restart";
+    job.model      = "ising2";
+    job.L          = {L};
+    job.T          = linear_grid(1.5, 3.5, 5);
+    job.delta      = {delta};
+    job.n_run      = n_run;
+    job.warmup     = 2000;
+    job.measure    = 20000;
+    job.seed       = 11;
+    job.ckpt_every = 200;
+
+    return job;
+}
+
+
+/* read_file()
+ * Returns the bytes of a file.
+ */
+std::string read_file(const std::string &file)
+{
+    std::ifstream is(file, std::ios::binary);
+    std::ostringstream ss;
+
+    ss << is.rdbuf();
+
+    return ss.str();
+}
+
+
+/* interrupt_job()
+ * Runs the job in a child process and kills it once the checkpoint is in the middle of the
+ * second realization. Returns false if the run finished before it could be interrupted.
+ */
+bool interrupt_job(const Job &job)
+{
+    const std::string ckpt_file = job_tag(job, delta) + "_L" + std::to_string(L) + ".ckpt";
+
+    std::cout.flush();
+    pid_t pid = fork();
+    if (pid == 0) {
+        if (!freopen("/dev/null", "w", stdout))
+            _exit(EXIT_FAILURE);
+        run_job(job, false, nullptr);
+        _exit(EXIT_SUCCESS);
+    }
+
+    int status;
+    while (waitpid(pid, &status, WNOHANG) == 0) {
+        if (access(ckpt_file.c_str(), R_OK) == 0) {
+            Checkpoint ckpt(ckpt_file, job.ckpt_every, true, job.seed);
+            // The checkpoint holds the average and every realization
+            const size_t n_acc = (1 + n_run) * job.T.size() * Observables::n_value;
+
+            std::string slot;
+
+            if (ckpt.load(n_acc) && !ckpt.is_complete() && ckpt.get_run() >= 1 &&
+                    ckpt.get_slot(0, slot)) {
+                kill(pid, SIGKILL);
+                waitpid(pid, &status, 0);
+                return WIFSIGNALED(status);
+            }
+        } // Wait for a checkpoint inside the second realization
+        usleep(1000);
+    } // Poll the checkpoint of the child
+
+    return false;
+}
+
+
+/* test_restart()
+ * Kills a checkpointed run in the middle, resumes it and compares the result file byte for byte
+ * to the one of an uninterrupted run.
+ */
+bool test_restart()
+{
+    const Job job            = restart_job();
+    const std::string bin    = job_tag(job, delta) + ".bin";
+    const std::string ckpt   = job_tag(job, delta) + "_L" + std::to_string(L) + ".ckpt";
+    std::streambuf *cout_buf = std::cout.rdbuf();
+    std::ostringstream log;
+
+    std::cout << "  Interrupting the run... ";
+    if (!interrupt_job(job)) {
+        std::cout << "Failed (the run ended before it was killed)\n";
+        return false;
+    }
+    std::cout << "Done\n";
+
+    std::cout << "  Resuming the run... " << std::flush;
+    std::cout.rdbuf(log.rdbuf());
+    run_job(job, true, nullptr);
+    std::cout.rdbuf(cout_buf);
+    const std::string resumed = read_file(bin);
+    std::remove(bin.c_str());
+    std::remove(ckpt.c_str());
+    std::remove((ckpt + ".tmp").c_str());       // Left behind if the kill hit a write
+    std::remove((ckpt + ".slot0.tmp").c_str());
+    std::cout << "Done\n";
+
+    std::cout << "  Running without interruption... " << std::flush;
+    std::cout.rdbuf(log.rdbuf());
+    run_job(job, false, nullptr);
+    std::cout.rdbuf(cout_buf);
+    const std::string straight = read_file(bin);
+    std::remove(bin.c_str());
+    std::remove(ckpt.c_str());
+    std::cout << "Done\n";
+
+    std::cout << "  Comparing the result files... ";
+    bool passed = !resumed.empty() && resumed == straight;
+
+    if (passed) std::cout << "Passed\n";
+    else        std::cout << "Failed\n";
+
+    return passed;
+}
@@ -0,0 +1,335 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "../include/result_file.h"
+
+
+/*-------------------------------------------------------------------------------------------------
+ * GLOBAL CONSTANTS
+ *-----------------------------------------------------------------------------------------------*/
+const size_t n_row = 7;
+const std::vector<std::string> names = {"T", "E_L=8", "binder_L=8"};
+const std::string good_file = "good.bin";
+
+// Malformed copies of good_file, see write_malformed()
+const std::vector<std::string> bad_files = {"short.bin", "magic.bin", "offset.bin", "meta.bin",
+                                            "truncated.bin"};
+
+
+/*-------------------------------------------------------------------------------------------------
+ * FORWARD DECLARATIONS
+ *-----------------------------------------------------------------------------------------------*/
+Data_matrix make_data();
+std::string read_file(const std::string &file);
+void write_file(const std::string &file, const std::string &bytes);
+std::uint64_t head_value(const std::string &bytes, size_t i);
+bool same_value(double a, double b);
+bool report(const std::string &name, bool passed);
+bool test_round_trip();
+bool test_header_columns();
+void write_malformed();
+bool rejects(const std::string &file);
+bool test_malformed();
+bool test_python(const std::string &script_dir);
+
+
+/*-------------------------------------------------------------------------------------------------
+ * MAIN
+ *-----------------------------------------------------------------------------------------------*/
+int main(void)
+{
+    char dir[] = "/tmp/test_result_file_XXXXXX";
+    char repo[4096];
+
+    if (!getcwd(repo, sizeof(repo)) || !mkdtemp(dir) || chdir(dir) != 0) {
+        std::cerr << "Error: Could not create a scratch directory." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "Testing the binary result files\n";
+    bool passed = test_round_trip();
+    passed      = test_header_columns() && passed;
+    write_malformed();
+    passed      = test_malformed() && passed;
+    passed      = test_python(std::string(repo) + "/script") && passed;
+
+    std::remove(good_file.c_str());
+    for (auto &&file : bad_files)
+        std::remove(file.c_str());
+
+    if (chdir("/") != 0 || rmdir(dir) != 0)
+        std::cerr << "Warning: Could not remove " << dir << std::endl;
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
+/*-------------------------------------------------------------------------------------------------
+ * FUNCTIONS
+ *-----------------------------------------------------------------------------------------------*/
+
+/* make_data()
+ * Returns named columns of values which are not exact in decimal.
+ */
+Data_matrix make_data()
+{
+    Data_matrix data(n_row, names.size());
+
+    for (size_t j = 0; j < names.size(); j++) {
+        std::vector<double> col(n_row);
+        for (size_t i = 0; i < n_row; i++)
+            col[i] = (static_cast<double>(i) + 0.1) / static_cast<double>(3 * j + 7) - 0.3 * j;
+        data.insert_array(col.data(), names[j]);
+    }
+
+    return data;
+}
+
+
+/* read_file()
+ * Returns the bytes of a file.
+ */
+std::string read_file(const std::string &file)
+{
+    std::ifstream is(file, std::ios::binary);
+    std::ostringstream ss;
+
+    ss << is.rdbuf();
+
+    return ss.str();
+}
+
+
+/* write_file()
+ * Writes bytes to a file.
+ */
+void write_file(const std::string &file, const std::string &bytes)
+{
+    std::ofstream of(file, std::ios::binary | std::ios::trunc);
+    of.write(bytes.data(), bytes.size());
+}
+
+
+/* head_value()
+ * Returns the 64 bit header entry i (data_offset, n_row, n_col, meta_len) of a result file.
+ */
+std::uint64_t head_value(const std::string &bytes, size_t i)
+{
+    std::uint64_t val;
+    std::memcpy(&val, bytes.data() + 8 + 8 * i, sizeof(val));
+
+    return val;
+}
+
+
+/* same_value()
+ * Returns true if two doubles are the same bit for bit.
+ */
+bool same_value(double a, double b)
+{
+    return std::memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+
+/* report()
+ * Prints the outcome of one test.
+ */
+bool report(const std::string &name, bool passed)
+{
+    std::cout << "  Testing " << name << "... " << (passed ? "Passed" : "Failed") << '\n';
+
+    return passed;
+}
+
+
+/* test_round_trip()
+ * Writes the data with 0 to 8 extra parameters, so the metadata ends at different offsets within
+ * the blocks of 64 bytes, and reads it back. The columns, their names and values and the
+ * parameters come back exactly, and the data starts at a multiple of 64 bytes.
+ */
+bool test_round_trip()
+{
+    const Data_matrix data = make_data();
+    bool passed = true, aligned = true;
+
+    for (size_t n_param = 0; n_param <= 8; n_param++) {
+        Result_header header;
+        for (size_t p = 0; p < n_param; p++)
+            header.set_param("key" + std::string(p, 'x'), 0.1 * static_cast<double>(p + 1));
+        header.set_param("model", "ising2");
+        header.set_param("n_run", 12);
+        write_result(good_file, data, header);
+
+        const std::string bytes = read_file(good_file);
+        aligned = aligned && head_value(bytes, 0) % 64 == 0 && bytes.size() ==
+                  head_value(bytes, 0) + n_row * names.size() * sizeof(double);
+
+        Result_file res(good_file);
+        passed = passed && res.rows() == n_row && res.cols() == names.size() &&
+                 res.get_header().get_columns() == names && res.get_param("model") == "ising2" &&
+                 res.get_param("n_run") == "12" && res.get_param("missing").empty() &&
+                 res.column("missing") == nullptr;
+        aligned = aligned && reinterpret_cast<std::uintptr_t>(res.column(size_t(0))) % 64 == 0;
+
+        for (size_t p = 0; p < n_param; p++)
+            passed = passed && same_value(std::strtod(res.get_param("key" +
+                    std::string(p, 'x')).c_str(), nullptr), 0.1 * static_cast<double>(p + 1));
+        for (size_t j = 0; j < names.size(); j++)
+            passed = passed && std::memcmp(res.column(names[j]), data.column(j),
+                    n_row * sizeof(double)) == 0;
+    } // Loop over parameter counts
+
+    passed = report("the round trip", passed);
+
+    return report("the 64 byte alignment", aligned) && passed;
+}
+
+
+/* test_header_columns()
+ * Column names in the header take the place of the names of the data.
+ */
+bool test_header_columns()
+{
+    Result_header header;
+    for (auto &&name : {"a", "b", "c"})
+        header.add_column(name);
+    write_result(good_file, make_data(), header);
+
+    Result_file res(good_file);
+    const bool passed = res.get_header().get_columns() == std::vector<std::string>{"a", "b", "c"}
+                        && res.column("b") == res.column(1);
+
+    return report("column names from the header", passed);
+}
+
+
+/* write_malformed()
+ * Writes good_file with its header and copies of it which break one rule of the format each:
+ * shorter than the header, a wrong magic, an unaligned data offset, metadata running into the
+ * data and a missing last value.
+ */
+void write_malformed()
+{
+    Result_header header;
+    header.set_param("model", "ising2");
+    write_result(good_file, make_data(), header);
+
+    const std::string good = read_file(good_file);
+    std::string bad;
+
+    write_file(bad_files[0], good.substr(0, 20));
+
+    bad    = good;
+    bad[5] = '2';
+    write_file(bad_files[1], bad);
+
+    bad = good;
+    const std::uint64_t offset = head_value(good, 0) + 8;
+    std::memcpy(&bad[8], &offset, sizeof(offset));
+    write_file(bad_files[2], bad);
+
+    bad = good;
+    const std::uint64_t meta_len = head_value(good, 0);
+    std::memcpy(&bad[32], &meta_len, sizeof(meta_len));
+    write_file(bad_files[3], bad);
+
+    write_file(bad_files[4], good.substr(0, good.size() - sizeof(double)));
+}
+
+
+/* rejects()
+ * Opens a file in a child process and returns true if Result_file exits with an error.
+ */
+bool rejects(const std::string &file)
+{
+    std::cout.flush();
+    pid_t pid = fork();
+    if (pid == 0) {
+        if (!freopen("/dev/null", "w", stderr))
+            _exit(EXIT_SUCCESS);
+        Result_file res(file);
+        _exit(EXIT_SUCCESS);
+    }
+
+    int status;
+    waitpid(pid, &status, 0);
+
+    return WIFEXITED(status) && WEXITSTATUS(status) == EXIT_FAILURE;
+}
+
+
+/* test_malformed()
+ * Result_file rejects every malformed copy and accepts the original.
+ */
+bool test_malformed()
+{
+    bool passed = !rejects(good_file);
+
+    for (auto &&file : bad_files)
+        passed = report("rejecting " + file, rejects(file)) && passed;
+
+    return passed;
+}
+
+
+/* test_python()
+ * Reads good_file and the malformed copies with script/result_file.py, which needs no numpy.
+ * The columns and parameters match Result_file and every malformed copy raises ValueError.
+ * Skipped where there is no python3.
+ */
+bool test_python(const std::string &script_dir)
+{
+    if (system("python3 -c '' > /dev/null 2>&1") != 0) {
+        std::cout << "  Testing script/result_file.py... Skipped (no python3)\n";
+        return true;
+    }
+
+    std::string cmd = "python3 -c \"import sys\nsys.path.insert(0, '" + script_dir + "')\n"
+        "from result_file import load_result\n"
+        "cols, params = load_result('" + good_file + "')\n"
+        "for name, col in cols.items(): print('column', name, *[repr(float(v)) for v in col])\n"
+        "for key, val in params.items(): print('param', key, val)\n"
+        "for file in sys.argv[1:]:\n"
+        "    try: load_result(file)\n"
+        "    except ValueError: print('rejected', file)\n\"";
+    for (auto &&file : bad_files)
+        cmd += " " + file;
+
+    FILE *pipe = popen(cmd.c_str(), "r");
+    std::vector<std::string> lines;
+    char buf[4096];
+    while (pipe && fgets(buf, sizeof(buf), pipe))
+        lines.push_back(buf);
+    bool passed = pipe && pclose(pipe) == 0 && lines.size() == names.size() + 1 + bad_files.size();
+
+    // Python prints the shortest form which reads back exactly, so the values are parsed
+    Result_file res(good_file);
+    for (size_t j = 0; passed && j < names.size(); j++) {
+        std::istringstream ss(lines[j]);
+        std::string tag, name;
+        ss >> tag >> name;
+        passed = tag == "column" && name == names[j];
+
+        for (size_t i = 0; passed && i < n_row; i++) {
+            std::string val;
+            passed = (ss >> val) && same_value(std::strtod(val.c_str(), nullptr),
+                                               res.column(j)[i]);
+        }
+        passed = passed && (ss >> std::ws).eof();
+    } // Loop over columns
+
+    passed = passed && lines[names.size()] == "param model ising2\n";
+    for (size_t k = 0; passed && k < bad_files.size(); k++)
+        passed = lines[names.size() + 1 + k] == "rejected " + bad_files[k] + "\n";
+
+    return report("script/result_file.py", passed);
+}
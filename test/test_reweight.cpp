@@ -0,0 +1,182 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+
+#include "../include/job.h"
+#include "../include/result_file.h"
+
+
+/*-------------------------------------------------------------------------------------------------
+ * GLOBAL CONSTANTS
+ *-----------------------------------------------------------------------------------------------*/
+const int L          = 8;
+const double T_mid   = 2.3;                     // Between the simulated temperatures
+const std::string series_file = "test_reweight.ts";
+
+
+/*-------------------------------------------------------------------------------------------------
+ * FORWARD DECLARATIONS
+ *-----------------------------------------------------------------------------------------------*/
+Job ising_job(const std::string &name, const std::vector<double> &T, size_t measure);
+void remove_result(const Job &job);
+std::vector<double> read_point(const Job &job);
+void run_quiet(const Job &job, Time_series *ts);
+bool compare(const std::string &name, const std::vector<double> &val,
+        const std::vector<double> &ref);
+bool test_reweight();
+
+
+/*-------------------------------------------------------------------------------------------------
+ * MAIN
+ *-----------------------------------------------------------------------------------------------*/
+int main(void)
+{
+    char dir[] = "/tmp/test_reweight_XXXXXX";
+
+    if (!mkdtemp(dir) || chdir(dir) != 0) {
+        std::cerr << "Error: Could not create a scratch directory." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "Testing histogram reweighting against a direct simulation\n";
+    bool passed = test_reweight();
+
+    if (chdir("/") != 0 || rmdir(dir) != 0)
+        std::cerr << "Warning: Could not remove " << dir << std::endl;
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
+/*-------------------------------------------------------------------------------------------------
+ * FUNCTIONS
+ *-----------------------------------------------------------------------------------------------*/
+
+/* ising_job()
+ * Returns a job of the clean L x L Ising model.
+ */
+Job ising_job(const std::string &name, const std::vector<double> &T, size_t measure)
+{
+    Job job;
+
+    job.name    = name;
+    job.model   = "ising2";
+    job.L       = {L};
+    job.T       = T;
+    job.warmup  = 5000;
+    job.measure = measure;
+    job.seed    = 9;
+
+    return job;
+}
+
+
+/* remove_result()
+ * Removes the result and checkpoint files of a job.
+ */
+void remove_result(const Job &job)
+{
+    std::remove((job_tag(job, 0.0) + ".bin").c_str());
+    std::remove((job_tag(job, 0.0) + "_L" + std::to_string(L) + ".ckpt").c_str());
+}
+
+
+/* read_point()
+ * Returns E, C, chi and the binder ratio at the first temperature of the result file of a job,
+ * and removes its files.
+ */
+std::vector<double> read_point(const Job &job)
+{
+    const std::string bin    = job_tag(job, 0.0) + ".bin";
+    const std::string suffix = "_L=" + std::to_string(L);
+    std::vector<double> val;
+    {
+        Result_file res(bin);
+        for (auto &&name : {"E", "C", "chi", "binder"})
+            val.push_back(res.column(name + suffix)[0]);
+    }
+    remove_result(job);
+
+    return val;
+}
+
+
+/* run_quiet()
+ * Runs a job, or reweights the series file for a reweight job, without its output.
+ */
+void run_quiet(const Job &job, Time_series *ts)
+{
+    std::streambuf *cout_buf = std::cout.rdbuf();
+    std::ostringstream log;
+
+    std::cout.rdbuf(log.rdbuf());
+    if (job.method == Method::reweight)
+        reweight_job(job, series_file);
+    else
+        run_job(job, false, ts);
+    std::cout.rdbuf(cout_buf);
+}
+
+
+/* compare()
+ * Compares E, C, chi and the binder ratio to the direct simulation. E and the binder ratio agree
+ * within 0.01, C and chi within 5%.
+ */
+bool compare(const std::string &name, const std::vector<double> &val,
+        const std::vector<double> &ref)
+{
+    const bool passed = fabs(val[0] - ref[0]) < 0.01 && fabs(val[1] - ref[1]) < 0.05 * ref[1] &&
+                        fabs(val[2] - ref[2]) < 0.05 * ref[2] && fabs(val[3] - ref[3]) < 0.01;
+
+    std::cout << "  Testing " << name << "... ";
+    if (passed) {
+        std::cout << "Passed\n";
+    } else {
+        std::cout << "Failed (E, C, chi, binder";
+        for (size_t i = 0; i < val.size(); i++)
+            std::cout << (i ? ", " : " ") << val[i] << " vs " << ref[i];
+        std::cout << ")\n";
+    }
+
+    return passed;
+}
+
+
+/* test_reweight()
+ * Simulates the clean Ising model at temperatures around T_mid with a time series, reweights the
+ * series to T_mid with single and multiple histograms, and compares both to a direct simulation
+ * at T_mid.
+ */
+bool test_reweight()
+{
+    const Job series = ising_job("series", {2.1, 2.2, 2.4, 2.5}, 100000);
+
+    std::cout << "  Running the simulations... " << std::flush;
+    {
+        Time_series ts(series_file);
+        run_quiet(series, &ts);
+        remove_result(series);
+    } // Writes every record of the series
+    const Job direct = ising_job("direct", {T_mid}, 400000);
+    run_quiet(direct, nullptr);
+    const std::vector<double> ref = read_point(direct);
+    std::cout << "Done\n";
+
+    bool passed = true;
+    for (auto &&kind : {"single", "multi"}) {
+        Job job      = ising_job(std::string("reweight_") + kind, {T_mid}, 0);
+        job.method   = Method::reweight;
+        job.rw_multi = std::string(kind) == "multi";
+
+        run_quiet(job, nullptr);
+        passed = compare(std::string(kind) + " histogram", read_point(job), ref) && passed;
+    } // Loop over reweighting kinds
+    std::remove(series_file.c_str());
+
+    return passed;
+}
@@ -0,0 +1,215 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <random>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <omp.h>
+
+#include "../include/ising3.h"
+#include "../include/clock3.h"
+#include "../include/observables.h"
+
+
+/*-------------------------------------------------------------------------------------------------
+ * GLOBAL CONSTANTS
+ *-----------------------------------------------------------------------------------------------*/
+const int L          = 8;
+const int q          = 6;
+const double delta   = 0.5;
+const unsigned seed  = 13;
+const std::vector<int> n_thread  = {1, 2, 3, 4};
+const std::vector<double> T_list = {1.5, 3.0};      // Ordered and disordered clock3
+
+
+/*-------------------------------------------------------------------------------------------------
+ * FORWARD DECLARATIONS
+ *-----------------------------------------------------------------------------------------------*/
+Clock3 clock_model(int n_over);
+std::mt19937 make_engine(int run, unsigned stream);
+bool same_obs(const Observables &a, const Observables &b);
+bool report(const std::string &name, bool passed, const std::string &detail);
+template <typename Model> bool test_threads(const std::string &name, Model model);
+bool test_odd_L();
+bool test_serial();
+
+
+/*-------------------------------------------------------------------------------------------------
+ * MAIN
+ *-----------------------------------------------------------------------------------------------*/
+int main(void)
+{
+    Ising3 ising(L);
+    ising.set_run_param(200, 500);
+
+    std::cout << "Testing the slab sweeps of the 3D models\n";
+    bool passed = test_threads("ising3", ising);
+    passed      = test_threads("clock3", clock_model(1)) && passed;
+    passed      = test_odd_L() && passed;
+    passed      = test_serial() && passed;
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
+/*-------------------------------------------------------------------------------------------------
+ * FUNCTIONS
+ *-----------------------------------------------------------------------------------------------*/
+
+/* clock_model()
+ * Returns the L^3 clock model with disorder and n_over over-relaxation sweeps.
+ */
+Clock3 clock_model(int n_over)
+{
+    Clock3 model(L, q);
+    std::mt19937 engine = make_engine(0, 0);
+
+    model.set_run_param(200, 500);
+    model.set_overrelax(n_over);
+    model.set_exchange(delta, engine);
+
+    return model;
+}
+
+
+/* make_engine()
+ * Returns the engine of a stream of a realization.
+ */
+std::mt19937 make_engine(int run, unsigned stream)
+{
+    std::seed_seq seq{seed, static_cast<unsigned>(run), stream};
+
+    return std::mt19937(seq);
+}
+
+
+/* same_obs()
+ * Returns true if two sets of observables are the same bit for bit.
+ */
+bool same_obs(const Observables &a, const Observables &b)
+{
+    return std::memcmp(&a, &b, sizeof(Observables)) == 0;
+}
+
+
+/* report()
+ * Prints the outcome of one test.
+ */
+bool report(const std::string &name, bool passed, const std::string &detail)
+{
+    std::cout << "  Testing " << name << "... ";
+    if (passed) std::cout << "Passed\n";
+    else        std::cout << "Failed (" << detail << ")\n";
+
+    return passed;
+}
+
+
+/* test_threads()
+ * Runs the same seeded slab sweeps on teams of every size in n_thread. Every slab draws from an
+ * engine of its own, so the observables are the same bit for bit.
+ */
+template <typename Model>
+bool test_threads(const std::string &name, Model model)
+{
+    Observables ref{};
+    std::string detail;
+    bool passed = true;
+
+    for (size_t k = 0; k < n_thread.size(); k++) {
+        Model replica(model);
+        std::mt19937 engine = make_engine(0, 1);
+
+        omp_set_num_threads(n_thread[k]);
+        replica.set_spin(engine);
+        const Observables obs = replica.sweep_observables_slabs(1.0 / T_list[0], engine);
+
+        if (k == 0) {
+            ref = obs;
+        } else if (!same_obs(obs, ref)) {
+            passed  = false;
+            detail += (detail.empty() ? "" : ", ") + std::to_string(n_thread[k]) + " threads";
+        }
+    } // Loop over team sizes
+    omp_set_num_threads(n_thread[0]);
+
+    return report(name + " with 1 to " + std::to_string(n_thread.back()) + " threads", passed,
+            detail + " differ from 1 thread");
+}
+
+
+/* test_odd_L()
+ * Runs the slab sweeps of an odd lattice in a child process, which exits with an error.
+ */
+bool test_odd_L()
+{
+    std::cout.flush();
+    pid_t pid = fork();
+    if (pid == 0) {
+        if (!freopen("/dev/null", "w", stderr))
+            _exit(EXIT_SUCCESS);
+        Ising3 model(L - 1);
+        std::mt19937 engine = make_engine(0, 1);
+        model.set_run_param(10, 10);
+        model.set_spin(engine);
+        model.sweep_observables_slabs(1.0, engine);
+        _exit(EXIT_SUCCESS);
+    }
+
+    int status;
+    waitpid(pid, &status, 0);
+
+    return report("rejecting an odd L", WIFEXITED(status) && WEXITSTATUS(status) == EXIT_FAILURE,
+            "the sweeps ran");
+}
+
+
+/* test_serial()
+ * Runs clock3 with disorder and over-relaxation with slab sweeps and with the serial sweeps of
+ * sweep_observables() on the same realizations. The averages agree within their statistical
+ * errors: E within 0.01, C, |M| and the binder ratio within 5%.
+ */
+bool test_serial()
+{
+    const int n_run = 4;
+    bool passed     = true;
+
+    for (auto T : T_list) {
+        Observables slab{}, serial{};
+
+        for (int run = 0; run < n_run; run++) {
+            Clock3 model(L, q);
+            std::mt19937 ex_engine = make_engine(run, 0);
+            std::mt19937 engine    = make_engine(run, 1);
+
+            model.set_run_param(2000, 20000);
+            model.set_overrelax(1);
+            model.set_exchange(delta, ex_engine);
+
+            Clock3 replica(model);
+            model.set_spin(engine);
+            slab += model.sweep_observables_slabs(1.0 / T, engine);
+            replica.set_spin(engine);
+            serial += replica.sweep_observables(1.0 / T, engine);
+        } // Loop over realizations
+        slab   /= static_cast<double>(n_run);
+        serial /= static_cast<double>(n_run);
+
+        const bool ok = fabs(slab.E - serial.E) < 0.01 && fabs(slab.C - serial.C) < 0.05 *
+                        serial.C && fabs(slab.M - serial.M) < 0.05 * serial.M &&
+                        fabs(slab.binder - serial.binder) < 0.05 * fabs(serial.binder);
+
+        passed = report("slab against serial sweeps at T = " + std::to_string(T).substr(0, 3),
+                ok, "E, C, |M|, binder " + std::to_string(slab.E) + ", " +
+                std::to_string(slab.C) + ", " + std::to_string(slab.M) + ", " +
+                std::to_string(slab.binder) + " vs " + std::to_string(serial.E) + ", " +
+                std::to_string(serial.C) + ", " + std::to_string(serial.M) + ", " +
+                std::to_string(serial.binder)) && passed;
+    } // Loop over temperatures
+
+    return passed;
+}
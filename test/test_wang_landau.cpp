@@ -0,0 +1,244 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include "../include/job.h"
+#include "../include/result_file.h"
+
+
+/*-------------------------------------------------------------------------------------------------
+ * GLOBAL CONSTANTS
+ *-----------------------------------------------------------------------------------------------*/
+const int L        = 4;
+const double tol   = 3e-3;
+const double delta = 1.5;
+const int n_run    = 4;
+const std::vector<double> T_list     = {1.0, 1.5, 2.0, 2.27, 2.5, 3.0, 4.0};
+const std::vector<double> T_disorder = {1.0, 2.0, 3.0};
+
+
+/*-------------------------------------------------------------------------------------------------
+ * FORWARD DECLARATIONS
+ *-----------------------------------------------------------------------------------------------*/
+std::vector<double> exact_histogram();
+Wl_point exact_thermo(const std::vector<double> &hist, double T);
+std::vector<std::vector<double>> run_quiet(const Job &job);
+bool test_wang_landau();
+bool test_disorder();
+
+
+/*-------------------------------------------------------------------------------------------------
+ * MAIN
+ *-----------------------------------------------------------------------------------------------*/
+int main(void)
+{
+    std::cout << "Testing Wang-Landau jobs against exact enumeration\n";
+    bool passed = test_wang_landau();
+
+    std::cout << "Testing disordered Wang-Landau jobs against a canonical simulation\n";
+    passed = test_disorder() && passed;
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
+/*-------------------------------------------------------------------------------------------------
+ * FUNCTIONS
+ *-----------------------------------------------------------------------------------------------*/
+
+/* exact_histogram()
+ * Enumerates the 2^(L*L) states of the clean periodic L x L Ising model. Returns the number of
+ * states of energy E at index E + 2 L^2.
+ */
+std::vector<double> exact_histogram()
+{
+    const int N = L * L;
+    std::vector<double> hist(4 * N + 1, 0.0);
+
+    for (unsigned long state = 0; state < (1ul << N); state++) {
+        int E = 0;
+
+        for (int y = 0; y < L; y++) {
+            for (int x = 0; x < L; x++) {
+                const int s     = (state >> (y * L + x)) & 1ul ? 1 : -1;
+                const int right = (state >> (y * L + (x + 1) % L)) & 1ul ? 1 : -1;
+                const int down  = (state >> (((y + 1) % L) * L + x)) & 1ul ? 1 : -1;
+                E -= s * (right + down);
+            }
+        } // Loop over sites
+
+        hist[E + 2 * N] += 1.0;
+    } // Loop over states
+
+    return hist;
+}
+
+
+/* exact_thermo()
+ * Returns the free energy, energy, entropy and specific heat per site at T from the exact
+ * histogram of the energies.
+ */
+Wl_point exact_thermo(const std::vector<double> &hist, double T)
+{
+    const int N = L * L;
+    double Z = 0.0, U = 0.0, U2 = 0.0;
+
+    // Shifted by the ground state energy -2N to keep the weights finite
+    for (size_t k = 0; k < hist.size(); k++) {
+        const double E = static_cast<double>(static_cast<int>(k) - 2 * N);
+        const double p = hist[k] * exp(-(E + 2.0 * N) / T);
+        Z  += p;
+        U  += p * E;
+        U2 += p * E * E;
+    }
+    U  /= Z;
+    U2 /= Z;
+
+    Wl_point pt;
+    pt.T = T;
+    pt.F = (-2.0 * N - T * log(Z)) / N;
+    pt.E = U / N;
+    pt.S = (pt.E - pt.F) / T;
+    pt.C = (U2 - U * U) / (T * T * N);
+
+    return pt;
+}
+
+
+/* run_quiet()
+ * Runs the disordered job without its output and returns E and C at every temperature of its
+ * result file, which is removed with the checkpoint of a canonical job.
+ */
+std::vector<std::vector<double>> run_quiet(const Job &job)
+{
+    const std::string bin    = job_tag(job, delta) + ".bin";
+    const std::string suffix = "_L=" + std::to_string(L);
+    std::streambuf *cout_buf = std::cout.rdbuf();
+    std::ostringstream log;
+
+    std::cout.rdbuf(log.rdbuf());
+    run_job(job, false, nullptr);
+    std::cout.rdbuf(cout_buf);
+
+    std::vector<std::vector<double>> val(job.T.size());
+    {
+        Result_file res(bin);
+        for (auto &&name : {"E", "C"}) {
+            const double *col = res.column(name + suffix);
+            for (size_t i = 0; i < job.T.size(); i++)
+                val[i].push_back(col[i]);
+        }
+    }
+    std::remove(bin.c_str());
+    std::remove((job_tag(job, delta) + "_L" + std::to_string(L) + ".ckpt").c_str());
+
+    return val;
+}
+
+
+/* test_wang_landau()
+ * Runs a Wang-Landau job of the clean 4 x 4 Ising model and compares F, E, S and C of its result
+ * file to exact enumeration.
+ */
+bool test_wang_landau()
+{
+    Job job;
+    job.name     = "test_wl";
+    job.model    = "ising2";
+    job.L        = {L};
+    job.T        = T_list;
+    job.seed     = 2;
+    job.method   = Method::wang_landau;
+    job.n_window = 1;           // The lattice has only 15 energy levels
+
+    std::streambuf *cout_buf = std::cout.rdbuf();
+    std::ostringstream log;
+    std::cout << "  Running the job... " << std::flush;
+    std::cout.rdbuf(log.rdbuf());
+    run_job(job, false, nullptr);
+    std::cout.rdbuf(cout_buf);
+    std::cout << "Done\n";
+
+    const std::string bin = job_tag(job, 0.0) + ".bin";
+    const std::vector<double> hist = exact_histogram();
+    bool passed = true;
+    {
+        Result_file res(bin);
+        const std::string suffix = "_L=" + std::to_string(L);
+        const double *F = res.column("F" + suffix);
+        const double *E = res.column("E" + suffix);
+        const double *S = res.column("S" + suffix);
+        const double *C = res.column("C" + suffix);
+
+        for (size_t i = 0; i < T_list.size(); i++) {
+            const Wl_point ex = exact_thermo(hist, T_list[i]);
+            const bool ok     = fabs(F[i] - ex.F) < tol && fabs(E[i] - ex.E) < tol &&
+                                fabs(S[i] - ex.S) < tol * 3.0 && fabs(C[i] - ex.C) < tol;
+
+            std::cout << "  Testing T = " << T_list[i] << "... ";
+            if (ok) {
+                std::cout << "Passed\n";
+            } else {
+                std::cout << "Failed (F " << F[i] << " vs " << ex.F << ", E " << E[i] << " vs "
+                          << ex.E << ", S " << S[i] << " vs " << ex.S << ", C " << C[i]
+                          << " vs " << ex.C << ")\n";
+                passed = false;
+            }
+        } // Loop over temperatures
+    }
+    std::remove(bin.c_str());
+
+    return passed;
+}
+
+
+/* test_disorder()
+ * Runs a Wang-Landau job of the 4 x 4 Ising model with disorder and a canonical job of the same
+ * realizations, which both draw from seed_seq{seed, run, 0}. The bins spread over several
+ * energies, so this checks the slices of the bins. E agrees within 0.005 and C within 5%.
+ */
+bool test_disorder()
+{
+    Job wl;
+    wl.name     = "test_wl_disorder";
+    wl.model    = "ising2";
+    wl.L        = {L};
+    wl.T        = T_disorder;
+    wl.delta    = {delta};
+    wl.n_run    = n_run;
+    wl.seed     = 7;
+    wl.method   = Method::wang_landau;
+    wl.n_window = 1;
+
+    Job mc     = wl;
+    mc.name    = "test_mc_disorder";
+    mc.method  = Method::metropolis;
+    mc.warmup  = 5000;
+    mc.measure = 200000;
+
+    std::cout << "  Running the jobs... " << std::flush;
+    const std::vector<std::vector<double>> val = run_quiet(wl);
+    const std::vector<std::vector<double>> ref = run_quiet(mc);
+    std::cout << "Done\n";
+
+    bool passed = true;
+    for (size_t i = 0; i < T_disorder.size(); i++) {
+        const std::vector<double> &v = val[i], &r = ref[i];
+        const bool ok = fabs(v[0] - r[0]) < 0.005 && fabs(v[1] - r[1]) < 0.05 * r[1];
+
+        std::cout << "  Testing T = " << T_disorder[i] << "... ";
+        if (ok) {
+            std::cout << "Passed\n";
+        } else {
+            std::cout << "Failed (E " << v[0] << " vs " << r[0] << ", C " << v[1] << " vs "
+                      << r[1] << ")\n";
+            passed = false;
+        }
+    } // Loop over temperatures
+
+    return passed;
+}